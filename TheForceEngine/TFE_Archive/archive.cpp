@@ -6,7 +6,9 @@
 #include "labArchive.h"
 #include "zipArchive.h"
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filestream.h>
 #include <assert.h>
+#include <algorithm>
 #include <string>
 #include <map>
 
@@ -14,6 +16,7 @@ namespace
 {
 	typedef std::map<std::string, Archive*> ArchiveMap;
 	static ArchiveMap s_archives[ARCHIVE_COUNT];
+	static bool s_memoryMapping = true;
 }
 
 static const char* c_archiveExt[ARCHIVE_COUNT]=
@@ -180,3 +183,62 @@ void Archive::deleteCustomArchive(Archive* archive)
 	}
 	delete archive;
 }
+
+void Archive::setMemoryMapping(bool enable)
+{
+	s_memoryMapping = enable;
+}
+
+bool Archive::getMemoryMapping()
+{
+	return s_memoryMapping;
+}
+
+const u8* Archive::readFileView(const FilePath* filePath, std::vector<u8>& buffer, size_t* size)
+{
+	if (filePath->archive && filePath->index != INVALID_FILE)
+	{
+		const u8* data = filePath->archive->getFileData(filePath->index);
+		if (data)
+		{
+			*size = filePath->archive->getFileLength(filePath->index);
+			return data;
+		}
+	}
+
+	FileStream file;
+	if (!file.open(filePath, Stream::MODE_READ))
+	{
+		return nullptr;
+	}
+	*size = file.getSize();
+	buffer.resize(*size);
+	file.readBuffer(buffer.data(), (u32)*size);
+	file.close();
+	return buffer.data();
+}
+
+size_t Archive::readMappedFile(void* data, size_t size, size_t fileStart, size_t fileLength)
+{
+	const size_t offset = (size_t)m_fileOffset;
+	const size_t remaining = offset < fileLength ? fileLength - offset : 0;
+	const size_t sizeToRead = std::min(size, remaining);
+	// Guard against truncated archives.
+	if (fileStart + offset + sizeToRead > m_mapping.getSize())
+	{
+		return 0;
+	}
+
+	memcpy(data, m_mapping.getData() + fileStart + offset, sizeToRead);
+	m_fileOffset += (s32)sizeToRead;
+	return sizeToRead;
+}
+
+const u8* Archive::getMappedData(size_t fileStart, size_t fileLength)
+{
+	if (!m_mapping.isOpen() || fileStart + fileLength > m_mapping.getSize())
+	{
+		return nullptr;
+	}
+	return m_mapping.getData() + fileStart;
+}
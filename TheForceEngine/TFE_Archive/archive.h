@@ -1,9 +1,11 @@
 #pragma once
 #include <cstdio>
 #include <cstring>
+#include <vector>
 
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/paths.h>
+#include "mappedFile.h"
 
 enum ArchiveType
 {
@@ -29,6 +31,13 @@ public:
 	static void deleteCustomArchive(Archive* archive);
 
 	static ArchiveType getArchiveTypeFromName(const char* path);
+
+	// Memory mapping, only affects archives opened after the change.
+	static void setMemoryMapping(bool enable);
+	static bool getMemoryMapping();
+	// Returns the contents of 'filePath' - a view into the archive if it is memory mapped,
+	// otherwise the file is read into 'buffer'. Returns null if the file cannot be read.
+	static const u8* readFileView(const FilePath* filePath, std::vector<u8>& buffer, size_t* size);
 	
 	// Public Archive API
 public:
@@ -66,14 +75,23 @@ public:
 	virtual const char* getFileName(u32 index) = 0;
 	virtual size_t getFileLength(u32 index) = 0;
 
+	// Zero-copy access: read-only view of the file data, valid until the archive is closed.
+	// Returns null if the archive is not memory mapped.
+	virtual const u8* getFileData(u32 index) { return nullptr; }
+
 	// Edit
 	virtual void addFile(const char* fileName, const char* filePath) = 0;
 
 	// Shared Private State
 protected:
+	// Reads from the current file through the memory mapping.
+	size_t readMappedFile(void* data, size_t size, size_t fileStart, size_t fileLength);
+	const u8* getMappedData(size_t fileStart, size_t fileLength);
+
 	ArchiveType m_type;
 	char m_name[TFE_MAX_PATH];
 	char m_archivePath[TFE_MAX_PATH];
 
 	s32 m_fileOffset;
+	MappedFile m_mapping;
 };
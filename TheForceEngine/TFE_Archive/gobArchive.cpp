@@ -2,6 +2,7 @@
 
 #include <TFE_System/system.h>
 #include "gobArchive.h"
+#include <TFE_FileSystem/paths.h>
 #include <assert.h>
 #include <algorithm>
 #include <vector>
@@ -77,12 +78,22 @@ bool GobArchive::open(const char *archivePath)
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
 
+	// Map the archive for in-place access, reads fall back to the file if this fails.
+	if (getMemoryMapping())
+	{
+		m_mapping.open(archivePath);
+	}
+
+	// Names resolved through this archive may have changed.
+	TFE_Paths::invalidateArchiveIndex();
 	return true;
 }
 
 void GobArchive::close()
 {
+	TFE_Paths::invalidateArchiveIndex();
 	m_file.close();
+	m_mapping.close();
 	m_archiveOpen = false;
 	delete[] m_fileList.entries;
 	m_fileList.entries = nullptr;
@@ -93,7 +104,10 @@ bool GobArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -112,7 +126,7 @@ bool GobArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_mapping.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -125,8 +139,11 @@ bool GobArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_fileList.entries[m_curFile].IX);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_fileList.entries[m_curFile].IX);
+	}
 	return true;
 }
 
@@ -185,6 +202,11 @@ size_t GobArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_fileList.entries[m_curFile].LEN; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LEN);
 
+	if (m_mapping.isOpen())
+	{
+		return readMappedFile(data, sizeToRead, m_fileList.entries[m_curFile].IX, m_fileList.entries[m_curFile].LEN);
+	}
+
 	u32 bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -217,7 +239,10 @@ bool GobArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_mapping.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -245,6 +270,12 @@ size_t GobArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LEN;
 }
 
+const u8* GobArchive::getFileData(u32 index)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	return getMappedData(m_fileList.entries[index].IX, m_fileList.entries[index].LEN);
+}
+
 // Edit
 void GobArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -254,6 +285,8 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		return;
 	}
 	const size_t len = file.getSize();
+	// The archive file is rewritten below, so release the mapping first.
+	m_mapping.close();
 	const u32 newId = m_fileList.MASTERN;
 	m_fileList.MASTERN++;
 	GOB_Entry_t* newEntries = new GOB_Entry_t[m_fileList.MASTERN];
@@ -297,4 +330,10 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		m_file.writeBuffer(m_fileList.entries, sizeof(GOB_Entry_t), m_fileList.MASTERN);
 		m_file.close();
 	}
+
+	if (getMemoryMapping())
+	{
+		m_mapping.open(m_archivePath);
+	}
+	TFE_Paths::invalidateArchiveIndex();
 }
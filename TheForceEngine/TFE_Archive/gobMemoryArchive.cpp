@@ -1,6 +1,7 @@
 #include <cstring>
 
 #include "gobMemoryArchive.h"
+#include <TFE_FileSystem/paths.h>
 #include <TFE_System/system.h>
 #include <TFE_Game/igame.h>
 #include <assert.h>
@@ -50,11 +51,14 @@ bool GobMemoryArchive::open(const u8* buffer, size_t size)
 
 	m_archiveOpen = true;
 
+	// Names resolved through this archive may have changed.
+	TFE_Paths::invalidateArchiveIndex();
 	return true;
 }
 
 void GobMemoryArchive::close()
 {
+	TFE_Paths::invalidateArchiveIndex();
 	m_archiveOpen = false;
 	free((void*)m_buffer);
 	m_buffer = nullptr;
@@ -2,6 +2,7 @@
 
 #include <TFE_System/system.h>
 #include "labArchive.h"
+#include <TFE_FileSystem/paths.h>
 #include <assert.h>
 #include <algorithm>
 
@@ -37,12 +38,22 @@ bool LabArchive::open(const char *archivePath)
 		
 	strcpy(m_archivePath, archivePath);
 	
+	// Map the archive for in-place access, reads fall back to the file if this fails.
+	if (getMemoryMapping())
+	{
+		m_mapping.open(archivePath);
+	}
+
+	// Names resolved through this archive may have changed.
+	TFE_Paths::invalidateArchiveIndex();
 	return true;
 }
 
 void LabArchive::close()
 {
+	TFE_Paths::invalidateArchiveIndex();
 	m_file.close();
+	m_mapping.close();
 	m_archiveOpen = false;
 	delete[] m_entries;
 	delete[] m_stringTable;
@@ -53,7 +64,10 @@ bool LabArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -72,7 +86,7 @@ bool LabArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_mapping.isOpen())
 	{
 		m_file.seek(m_entries[m_curFile].dataOffset);
 	}
@@ -85,8 +99,11 @@ bool LabArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_entries[m_curFile].dataOffset);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_entries[m_curFile].dataOffset);
+	}
 	return true;
 }
 
@@ -146,6 +163,11 @@ size_t LabArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_entries[m_curFile].len; }
 	const size_t sizeToRead = std::min(size, (size_t)m_entries[m_curFile].len);
 
+	if (m_mapping.isOpen())
+	{
+		return readMappedFile(data, sizeToRead, m_entries[m_curFile].dataOffset, m_entries[m_curFile].len);
+	}
+
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -178,7 +200,10 @@ bool LabArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	if (!m_mapping.isOpen())
+	{
+		m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	}
 	return true;
 }
 
@@ -206,6 +231,12 @@ size_t LabArchive::getFileLength(u32 index)
 	return m_entries[index].len;
 }
 
+const u8* LabArchive::getFileData(u32 index)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	return getMappedData(m_entries[index].dataOffset, m_entries[index].len);
+}
+
 // Edit
 void LabArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -33,6 +33,7 @@ public:
 	u32 getFileCount() override;
 	const char* getFileName(u32 index) override;
 	size_t getFileLength(u32 index) override;
+	const u8* getFileData(u32 index) override;
 
 	// Edit
 	void addFile(const char* fileName, const char* filePath) override;
@@ -2,6 +2,7 @@
 
 #include <TFE_System/system.h>
 #include "lfdArchive.h"
+#include <TFE_FileSystem/paths.h>
 #include <assert.h>
 #include <algorithm>
 
@@ -63,12 +64,22 @@ bool LfdArchive::open(const char *archivePath)
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
 
+	// Map the archive for in-place access, reads fall back to the file if this fails.
+	if (getMemoryMapping())
+	{
+		m_mapping.open(archivePath);
+	}
+
+	// Names resolved through this archive may have changed.
+	TFE_Paths::invalidateArchiveIndex();
 	return true;
 }
 
 void LfdArchive::close()
 {
+	TFE_Paths::invalidateArchiveIndex();
 	m_file.close();
+	m_mapping.close();
 	m_archiveOpen = false;
 
 	if (m_fileList.entries)
@@ -83,7 +94,10 @@ bool LfdArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+	}
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -102,7 +116,7 @@ bool LfdArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "LFD", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_mapping.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -115,8 +129,11 @@ bool LfdArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_fileList.entries[m_curFile].IX);
+	if (!m_mapping.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_fileList.entries[m_curFile].IX);
+	}
 	return true;
 }
 
@@ -176,6 +193,11 @@ size_t LfdArchive::readFile(void *data, size_t size)
 	if (size == 0) { size = m_fileList.entries[m_curFile].LENGTH; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LENGTH);
 
+	if (m_mapping.isOpen())
+	{
+		return readMappedFile(data, sizeToRead, m_fileList.entries[m_curFile].IX, m_fileList.entries[m_curFile].LENGTH);
+	}
+
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
 	return bytesRead;
@@ -208,7 +230,10 @@ bool LfdArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_mapping.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -236,6 +261,12 @@ size_t LfdArchive::getFileLength(u32 index)
 	return m_fileList.entries[index].LENGTH;
 }
 
+const u8* LfdArchive::getFileData(u32 index)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	return getMappedData(m_fileList.entries[index].IX, m_fileList.entries[index].LENGTH);
+}
+
 // Edit
 void LfdArchive::addFile(const char* fileName, const char* filePath)
 {
@@ -0,0 +1,136 @@
+#include "mappedFile.h"
+#include <TFE_System/system.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#else
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FileUtil
+{
+	extern char* findFileNoCase(const char* fn);
+}
+#endif
+
+MappedFile::MappedFile() : m_data(nullptr), m_size(0)
+{
+#ifdef _WIN32
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		TFE_System::logWrite(LOG_WARNING, "Archive", "Cannot memory map '%s', falling back to file reads.", path);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_data = (const u8*)data;
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mappingHandle)
+	{
+		CloseHandle((HANDLE)m_mappingHandle);
+	}
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle((HANDLE)m_fileHandle);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+	m_mappingHandle = nullptr;
+}
+#else
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		// Match FileStream, which falls back to a case-insensitive search.
+		char* path2 = FileUtil::findFileNoCase(path);
+		if (!path2) { return false; }
+		fd = ::open(path2, O_RDONLY);
+		free(path2);
+		if (fd < 0) { return false; }
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping keeps its own reference to the file.
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		TFE_System::logWrite(LOG_WARNING, "Archive", "Cannot memory map '%s', falling back to file reads.", path);
+		return false;
+	}
+
+	m_data = (const u8*)data;
+	m_size = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data)
+	{
+		munmap((void*)m_data, m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Read-only memory mapped file.
+// Used by archives stored in a single file (GOB, LFD, LAB) so entries
+// can be accessed in place instead of through many small reads.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const { return m_data != nullptr; }
+	const u8* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const u8* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+};
@@ -1,5 +1,6 @@
 #include "zipArchive.h"
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
 #include <TFE_System/system.h>
 #include "zip/zip.h"
 #include <assert.h>
@@ -77,11 +78,14 @@ bool ZipArchive::open(const char *archivePath)
 	strcpy(m_archivePath, archivePath);
 	m_fileHandle = nullptr;
 
+	// Names resolved through this archive may have changed.
+	TFE_Paths::invalidateArchiveIndex();
 	return true;
 }
 
 void ZipArchive::close()
 {
+	TFE_Paths::invalidateArchiveIndex();
 	closeFile();
 
 	delete[] m_entries;
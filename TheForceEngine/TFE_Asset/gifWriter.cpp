@@ -2,6 +2,8 @@
 #include <TFE_System/system.h>
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/paths.h>
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
 #include <assert.h>
 #include <algorithm>
 #include <vector>
@@ -13,46 +15,106 @@
 
 namespace TFE_GIF
 {
+	enum GifConst
+	{
+		GIF_QUEUE_SIZE = 8,
+		GIF_MAX_BIT_DEPTH = 16,
+	};
+
+	struct GifFrame
+	{
+		std::vector<u8> pixels;
+		u32 palette[256];
+	};
+
 	static MsfGifState s_gifState;
 	static s32 s_centisecondsPerFrame;
 	static s32 s_width;
 	static s32 s_height;
+	static GifFrameFormat s_format;
 	static char s_path[TFE_MAX_PATH];
 
-	static std::vector<u8> s_tempBuffer;
+	// The previous 8-bit frame, unchanged pixels are written as transparent.
+	static std::vector<u8> s_prevPixels;
+	static u32 s_prevPalette[256];
+	static bool s_prevFrameValid = false;
+
+	// Frame queue, shared with the encoder thread and guarded by s_queueMutex.
+	static GifFrame s_frames[GIF_QUEUE_SIZE];
+	static s32 s_queueHead = 0;
+	static s32 s_queueCount = 0;
+	static bool s_encoderQuit = false;
+	// Main thread only.
+	static SDL_Thread* s_encoderThread = nullptr;
+	static SDL_mutex* s_queueMutex = nullptr;
+	static SDL_cond* s_frameQueued = nullptr;
+	static SDL_cond* s_frameEncoded = nullptr;
+
+	void encodeFrame(GifFrame* frame);
+	bool encodeFramePal8(const u8* pixels, const u32* palette);
+	int  encoderThreadFunc(void* userData);
+	bool startEncoderThread();
+	void stopEncoderThread();
+	GifFrame* beginQueueFrame();
+	void endQueueFrame(GifFrame* frame);
 
-	bool startGif(const char* path, u32 width, u32 height, u32 fps)
+	bool startGif(const char* path, u32 width, u32 height, u32 fps, GifFrameFormat format)
 	{
+		// Finish the previous recording if it was never written.
+		stopEncoderThread();
+
 		memset(&s_gifState, 0, sizeof(MsfGifState));
 		msf_gif_begin(&s_gifState, width, height);
 
 		s_width = width;
 		s_height = height;
+		s_format = format;
 
 		s_centisecondsPerFrame = s32(100.0f/f32(fps) + 0.5f);
 		strcpy(s_path, path);
-		
-		s_tempBuffer.resize(width * height * 4);
-		
+
+		const size_t frameSize = format == GIF_FRAME_PAL8 ? width * height : width * height * 4;
+		for (s32 i = 0; i < GIF_QUEUE_SIZE; i++)
+		{
+			s_frames[i].pixels.resize(frameSize);
+		}
+		s_prevPixels.resize(format == GIF_FRAME_PAL8 ? width * height : 0);
+		s_prevFrameValid = false;
+
+		// Frames are encoded in place if the thread cannot be created.
+		startEncoderThread();
 		return true;
 	}
 
 	void addFrame(const u8* imageData)
 	{
-		// We have to flip the frame vertically.
-		u8* output = s_tempBuffer.data();
-		for (s32 y = 0; y < s_height; y++, output += s_width*4)
-		{
-			memcpy(output, &imageData[(s_height - y - 1) * s_width * 4], s_width * 4);
-		}
+		assert(s_format == GIF_FRAME_RGBA);
+		GifFrame* frame = beginQueueFrame();
+		memcpy(frame->pixels.data(), imageData, s_width * s_height * 4);
+		endQueueFrame(frame);
+	}
 
-		msf_gif_frame(&s_gifState, s_tempBuffer.data(), s_centisecondsPerFrame, 16, s_width * 4);
+	void addFramePal8(const u8* pixels, const u32* palette)
+	{
+		assert(s_format == GIF_FRAME_PAL8);
+		GifFrame* frame = beginQueueFrame();
+		memcpy(frame->pixels.data(), pixels, s_width * s_height);
+		memcpy(frame->palette, palette, sizeof(u32) * 256);
+		endQueueFrame(frame);
 	}
 
 	bool write()
 	{
+		// Wait for the queued frames to be encoded.
+		stopEncoderThread();
+
 		MsfGifResult result = msf_gif_end(&s_gifState);
-		
+		if (!result.data)
+		{
+			TFE_System::logWrite(LOG_ERROR, "GIF", "Failed to encode '%s'.", s_path);
+			return false;
+		}
+
 		FileStream file;
 		if (!file.open(s_path, Stream::MODE_WRITE))
 		{
@@ -65,4 +127,259 @@ namespace TFE_GIF
 		msf_gif_free(result);
 		return true;
 	}
-}
\ No newline at end of file
+
+	////////////////////////////////////////////////////////
+	// Frame Queue
+	////////////////////////////////////////////////////////
+	// Returns the next free frame, waiting for the encoder if the queue is full.
+	GifFrame* beginQueueFrame()
+	{
+		if (!s_encoderThread) { return &s_frames[0]; }
+
+		SDL_LockMutex(s_queueMutex);
+		while (s_queueCount >= GIF_QUEUE_SIZE)
+		{
+			SDL_CondWait(s_frameEncoded, s_queueMutex);
+		}
+		// The encoder does not touch the frame until it is queued.
+		GifFrame* frame = &s_frames[(s_queueHead + s_queueCount) % GIF_QUEUE_SIZE];
+		SDL_UnlockMutex(s_queueMutex);
+		return frame;
+	}
+
+	void endQueueFrame(GifFrame* frame)
+	{
+		if (!s_encoderThread)
+		{
+			encodeFrame(frame);
+			return;
+		}
+
+		SDL_LockMutex(s_queueMutex);
+		s_queueCount++;
+		SDL_CondSignal(s_frameQueued);
+		SDL_UnlockMutex(s_queueMutex);
+	}
+
+	// Runs on the encoder thread, so nothing here can log.
+	int encoderThreadFunc(void* userData)
+	{
+		SDL_LockMutex(s_queueMutex);
+		while (1)
+		{
+			while (!s_encoderQuit && !s_queueCount)
+			{
+				SDL_CondWait(s_frameQueued, s_queueMutex);
+			}
+			// Only quit once every queued frame has been encoded.
+			if (!s_queueCount) { break; }
+
+			GifFrame* frame = &s_frames[s_queueHead];
+			SDL_UnlockMutex(s_queueMutex);
+
+			encodeFrame(frame);
+
+			SDL_LockMutex(s_queueMutex);
+			s_queueHead = (s_queueHead + 1) % GIF_QUEUE_SIZE;
+			s_queueCount--;
+			SDL_CondSignal(s_frameEncoded);
+		}
+		SDL_UnlockMutex(s_queueMutex);
+		return 0;
+	}
+
+	bool startEncoderThread()
+	{
+		if (s_encoderThread) { return true; }
+
+		s_queueMutex = SDL_CreateMutex();
+		s_frameQueued = SDL_CreateCond();
+		s_frameEncoded = SDL_CreateCond();
+		s_queueHead = 0;
+		s_queueCount = 0;
+		s_encoderQuit = false;
+		if (s_queueMutex && s_frameQueued && s_frameEncoded)
+		{
+			s_encoderThread = SDL_CreateThread(encoderThreadFunc, "TFE_GifEncoderThread", nullptr);
+		}
+		if (!s_encoderThread)
+		{
+			TFE_System::logWrite(LOG_WARNING, "GIF", "Cannot create the GIF encoder thread, frames will be encoded on the main thread.");
+			if (s_queueMutex)   { SDL_DestroyMutex(s_queueMutex); }
+			if (s_frameQueued)  { SDL_DestroyCond(s_frameQueued); }
+			if (s_frameEncoded) { SDL_DestroyCond(s_frameEncoded); }
+			s_queueMutex = nullptr;
+			s_frameQueued = nullptr;
+			s_frameEncoded = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	void stopEncoderThread()
+	{
+		if (!s_encoderThread) { return; }
+
+		SDL_LockMutex(s_queueMutex);
+		s_encoderQuit = true;
+		SDL_CondSignal(s_frameQueued);
+		SDL_UnlockMutex(s_queueMutex);
+		SDL_WaitThread(s_encoderThread, nullptr);
+
+		SDL_DestroyMutex(s_queueMutex);
+		SDL_DestroyCond(s_frameQueued);
+		SDL_DestroyCond(s_frameEncoded);
+		s_encoderThread = nullptr;
+		s_queueMutex = nullptr;
+		s_frameQueued = nullptr;
+		s_frameEncoded = nullptr;
+	}
+
+	////////////////////////////////////////////////////////
+	// Encoding
+	////////////////////////////////////////////////////////
+	void encodeFrame(GifFrame* frame)
+	{
+		if (s_format == GIF_FRAME_PAL8)
+		{
+			encodeFramePal8(frame->pixels.data(), frame->palette);
+		}
+		else
+		{
+			// The frame is stored bottom-up, so flip it with a negative pitch.
+			msf_gif_frame(&s_gifState, frame->pixels.data(), s_centisecondsPerFrame, GIF_MAX_BIT_DEPTH, -s_width * 4);
+		}
+	}
+
+	// Writes the frame using the palette as its local color table, in the same format as msf_gif_frame() so that
+	// msf_gif_end() can assemble the file. Pixels that have not changed since the previous frame are transparent,
+	// unless all 256 colors are used.
+	bool encodeFramePal8(const u8* pixels, const u32* palette)
+	{
+		if (!s_gifState.listHead) { return false; }
+		const s32 width = s_width;
+		const s32 height = s_height;
+		const s32 pixelCount = width * height;
+
+		u8 used[256] = { 0 };
+		for (s32 i = 0; i < pixelCount; i++)
+		{
+			used[pixels[i]] = 1;
+		}
+		s32 usedCount = 0;
+		for (s32 i = 0; i < 256; i++)
+		{
+			usedCount += used[i];
+		}
+
+		// Map the used colors to the color table, index 0 is transparent if there is room for it.
+		const bool transparent = usedCount < 256;
+		u8 tlb[256];
+		u8 table[256 * 3] = { 0 };
+		s32 tableIdx = transparent ? 1 : 0;
+		for (s32 i = 0; i < 256; i++)
+		{
+			if (!used[i]) { continue; }
+			tlb[i] = tableIdx;
+			table[tableIdx * 3 + 0] = palette[i] & 0xff;
+			table[tableIdx * 3 + 1] = (palette[i] >> 8) & 0xff;
+			table[tableIdx * 3 + 2] = (palette[i] >> 16) & 0xff;
+			tableIdx++;
+		}
+		const bool checkPrev = transparent && s_prevFrameValid;
+
+		// See msf_compress_frame() for the details of the format.
+		const s32 maxBufSize = sizeof(MsfBufferHeader) + 32 + 256 * 3 + pixelCount * 3 / 2 + pixelCount / 128 + 512;
+		u8* allocation = (u8*)MSF_GIF_MALLOC(s_gifState.customAllocatorContext, maxBufSize);
+		if (!allocation) { return false; }
+		u8* writeBase = allocation + sizeof(MsfBufferHeader);
+		u8* writeHead = writeBase;
+		const s32 lzwAllocSize = 4096 * tableIdx * sizeof(int16_t);
+		MsfStridedList lzw = { (int16_t*)MSF_GIF_MALLOC(s_gifState.customAllocatorContext, lzwAllocSize) };
+		if (!lzw.data)
+		{
+			MSF_GIF_FREE(s_gifState.customAllocatorContext, allocation, maxBufSize);
+			return false;
+		}
+
+		const s32 tableBits = std::max(2, msf_bit_log(tableIdx - 1));
+		const s32 tableSize = 1 << tableBits;
+
+		// Graphic control extension (do not dispose, optionally transparent) and image descriptor with a local color table.
+		char headerBytes[19] = "\x21\xF9\x04\x05\0\0\0\0" "\x2C\0\0\0\0\0\0\0\0\x80";
+		if (!transparent) { headerBytes[3] = 0x04; }
+		memcpy(&headerBytes[4], &s_centisecondsPerFrame, 2);
+		memcpy(&headerBytes[13], &width, 2);
+		memcpy(&headerBytes[15], &height, 2);
+		headerBytes[17] |= tableBits - 1;
+		memcpy(writeHead, headerBytes, 18);
+		writeHead += 18;
+
+		memcpy(writeHead, table, tableSize * 3);
+		writeHead += tableSize * 3;
+		*writeHead++ = tableBits;
+
+		memset(writeHead, 0, 260);
+		writeHead[0] = 255;
+		uint32_t blockBits = 8;
+
+		msf_lzw_reset(&lzw, tableSize, tableIdx);
+		msf_put_code(&writeHead, &blockBits, msf_bit_log(lzw.len - 1), tableSize);
+
+		const u8* prevPixels = s_prevPixels.data();
+		s32 lastCode = checkPrev && palette[pixels[0]] == s_prevPalette[prevPixels[0]] ? 0 : tlb[pixels[0]];
+		for (s32 i = 1; i < pixelCount; i++)
+		{
+			const s32 color = checkPrev && palette[pixels[i]] == s_prevPalette[prevPixels[i]] ? 0 : tlb[pixels[i]];
+			const s32 code = (&lzw.data[lastCode * lzw.stride])[color];
+			if (code < 0)
+			{
+				const s32 codeBits = msf_bit_log(lzw.len - 1);
+				msf_put_code(&writeHead, &blockBits, codeBits, lastCode);
+				if (lzw.len > 4095)
+				{
+					msf_put_code(&writeHead, &blockBits, codeBits, tableSize);
+					msf_lzw_reset(&lzw, tableSize, tableIdx);
+				}
+				else
+				{
+					(&lzw.data[lastCode * lzw.stride])[color] = lzw.len;
+					++lzw.len;
+				}
+				lastCode = color;
+			}
+			else
+			{
+				lastCode = code;
+			}
+		}
+		MSF_GIF_FREE(s_gifState.customAllocatorContext, lzw.data, lzwAllocSize);
+
+		msf_put_code(&writeHead, &blockBits, msf_imin(12, msf_bit_log(lzw.len - 1)), lastCode);
+		msf_put_code(&writeHead, &blockBits, msf_imin(12, msf_bit_log(lzw.len)), tableSize + 1);
+		if (blockBits > 8)
+		{
+			const s32 bytes = (blockBits + 7) / 8;
+			writeHead[0] = bytes - 1;
+			writeHead += bytes;
+		}
+		*writeHead++ = 0;
+
+		MsfBufferHeader* header = (MsfBufferHeader*)allocation;
+		header->next = nullptr;
+		header->size = writeHead - writeBase;
+		u8* buffer = (u8*)MSF_GIF_REALLOC(s_gifState.customAllocatorContext, allocation, maxBufSize, writeHead - allocation);
+		if (!buffer)
+		{
+			MSF_GIF_FREE(s_gifState.customAllocatorContext, allocation, maxBufSize);
+			return false;
+		}
+		((MsfBufferHeader*)s_gifState.listTail)->next = buffer;
+		s_gifState.listTail = buffer;
+
+		memcpy(s_prevPixels.data(), pixels, pixelCount);
+		memcpy(s_prevPalette, palette, sizeof(u32) * 256);
+		s_prevFrameValid = true;
+		return true;
+	}
+}
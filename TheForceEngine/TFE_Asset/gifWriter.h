@@ -1,14 +1,28 @@
 #pragma once
 //////////////////////////////////////////////////////////////////////
-// The Force Engine Image Loading
-// TODO: Replace DeviL with libPNG? or STB_IMAGE?
-// Can use std_image.h and std_image_write.h for reading and writing.
+// The Force Engine GIF Writer
+// Frames are copied into a small queue and encoded on a worker
+// thread, so recording does not stall the game. If the encoder falls
+// behind, adding a frame waits until there is room in the queue.
+//
+// 8-bit frames are written directly with their palette, skipping the
+// color quantization required for 32-bit frames.
 //////////////////////////////////////////////////////////////////////
 #include <TFE_System/types.h>
 
 namespace TFE_GIF
 {
-	bool startGif(const char* path, u32 width, u32 height, u32 fps);
+	enum GifFrameFormat
+	{
+		GIF_FRAME_RGBA = 0,	// 32-bit RGBA frames, bottom-up as read back from the GPU.
+		GIF_FRAME_PAL8,		// 8-bit frames with a 256 color RGBA palette, top-down.
+	};
+
+	bool startGif(const char* path, u32 width, u32 height, u32 fps, GifFrameFormat format = GIF_FRAME_RGBA);
+	// Add a GIF_FRAME_RGBA frame.
 	void addFrame(const u8* imageData);
+	// Add a GIF_FRAME_PAL8 frame.
+	void addFramePal8(const u8* pixels, const u32* palette);
+	// Finish encoding the queued frames and write the file.
 	bool write();
 }
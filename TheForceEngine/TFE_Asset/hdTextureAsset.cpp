@@ -0,0 +1,196 @@
+#include <cstring>
+#include <algorithm>
+
+#include "hdTextureAsset.h"
+#include <TFE_Archive/zstdCompression.h>
+
+namespace TFE_HdTexture
+{
+	static s32 getMipDim(s32 dim, s32 mip)
+	{
+		return std::max(dim >> mip, 1);
+	}
+
+	static const HdTextureChunk* getChunks(const u8* data)
+	{
+		return (const HdTextureChunk*)(data + sizeof(HdTextureHeader));
+	}
+
+	// Same 2x2 box filter as the texture packer, odd edges are clamped.
+	static void buildMip(const u32* src, s32 srcWidth, s32 srcHeight, u32* dst, s32 dstWidth, s32 dstHeight)
+	{
+		for (s32 y = 0; y < dstHeight; y++)
+		{
+			const u32* row0 = &src[std::min(y * 2,     srcHeight - 1) * srcWidth];
+			const u32* row1 = &src[std::min(y * 2 + 1, srcHeight - 1) * srcWidth];
+			for (s32 x = 0; x < dstWidth; x++)
+			{
+				const s32 x0 = std::min(x * 2,     srcWidth - 1);
+				const s32 x1 = std::min(x * 2 + 1, srcWidth - 1);
+				const u32 c[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+
+				u32 result = 0;
+				for (s32 shift = 0; shift < 32; shift += 8)
+				{
+					const u32 sum = ((c[0] >> shift) & 0xff) + ((c[1] >> shift) & 0xff) + ((c[2] >> shift) & 0xff) + ((c[3] >> shift) & 0xff);
+					result |= (sum >> 2) << shift;
+				}
+				dst[x] = result;
+			}
+			dst += dstWidth;
+		}
+	}
+
+	bool isHdTexture(const u8* data, size_t size)
+	{
+		if (!data || size < sizeof(HdTextureHeader)) { return false; }
+
+		const HdTextureHeader* header = getHeader(data);
+		if (header->magic != HDT_MAGIC || header->version != HDT_VERSION || !header->width || !header->height ||
+			!header->frameCount || !header->mipCount || !header->scaleFactor)
+		{
+			return false;
+		}
+		const size_t chunkCount = size_t(header->mipCount) * size_t(header->frameCount);
+		return size >= sizeof(HdTextureHeader) + chunkCount * sizeof(HdTextureChunk);
+	}
+
+	const HdTextureHeader* getHeader(const u8* data)
+	{
+		return (const HdTextureHeader*)data;
+	}
+
+	size_t getMipSize(const HdTextureHeader* header, s32 mip)
+	{
+		return size_t(getMipDim(header->width, mip)) * size_t(getMipDim(header->height, mip)) * 4;
+	}
+
+	bool readMip(const u8* data, size_t size, s32 mip, u8* output)
+	{
+		if (!isHdTexture(data, size)) { return false; }
+		const HdTextureHeader* header = getHeader(data);
+		if (mip < 0 || mip >= header->mipCount) { return false; }
+
+		const size_t mipSize = getMipSize(header, mip);
+		const HdTextureChunk* chunk = getChunks(data) + mip * header->frameCount;
+		for (s32 f = 0; f < header->frameCount; f++, chunk++, output += mipSize)
+		{
+			if (chunk->uncompressedSize != mipSize || size_t(chunk->offset) + size_t(chunk->size) > size)
+			{
+				return false;
+			}
+
+			const u8* src = data + chunk->offset;
+			if (chunk->size == chunk->uncompressedSize)
+			{
+				memcpy(output, src, mipSize);
+			}
+			else if (!zstd_decompress(output, (u32)mipSize, src, chunk->size))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool write(const u8* frames, s32 width, s32 height, s32 frameCount, s32 scaleFactor, s32 mipCount, s32 compressionLevel, std::vector<u8>& output)
+	{
+		if (!frames || width <= 0 || height <= 0 || width > 0xffff || height > 0xffff ||
+			frameCount <= 0 || frameCount > 0xffff || scaleFactor <= 0 || scaleFactor > 0xff)
+		{
+			return false;
+		}
+
+		s32 fullMipCount = 1;
+		while ((width >> fullMipCount) > 0 || (height >> fullMipCount) > 0) { fullMipCount++; }
+		mipCount = (mipCount <= 0) ? fullMipCount : std::min(mipCount, fullMipCount);
+
+		HdTextureHeader header = {};
+		header.magic = HDT_MAGIC;
+		header.version = HDT_VERSION;
+		header.frameCount = u16(frameCount);
+		header.width = u16(width);
+		header.height = u16(height);
+		header.mipCount = u8(mipCount);
+		header.scaleFactor = u8(scaleFactor);
+
+		const size_t chunkCount = size_t(mipCount) * size_t(frameCount);
+		const size_t dataStart = sizeof(HdTextureHeader) + chunkCount * sizeof(HdTextureChunk);
+		output.resize(dataStart);
+		memcpy(output.data(), &header, sizeof(HdTextureHeader));
+
+		std::vector<HdTextureChunk> chunks(chunkCount);
+		std::vector<u32> mipImages;
+		std::vector<u8> compressed;
+		const size_t frameSize = size_t(width) * size_t(height) * 4;
+
+		// Build the mip chain of every frame, mip images are stored contiguously per frame.
+		std::vector<size_t> mipOffsets(mipCount);
+		size_t chainSize = 0;
+		for (s32 m = 0; m < mipCount; m++)
+		{
+			mipOffsets[m] = chainSize;
+			chainSize += size_t(getMipDim(width, m)) * size_t(getMipDim(height, m));
+		}
+		mipImages.resize(chainSize * frameCount);
+		for (s32 f = 0; f < frameCount; f++)
+		{
+			u32* chain = &mipImages[chainSize * f];
+			memcpy(chain, frames + frameSize * f, frameSize);
+			for (s32 m = 1; m < mipCount; m++)
+			{
+				buildMip(chain + mipOffsets[m - 1], getMipDim(width, m - 1), getMipDim(height, m - 1),
+					chain + mipOffsets[m], getMipDim(width, m), getMipDim(height, m));
+			}
+		}
+
+		for (s32 m = 0; m < mipCount; m++)
+		{
+			const u32 mipSize = u32(getMipSize(&header, m));
+			for (s32 f = 0; f < frameCount; f++)
+			{
+				const u8* image = (const u8*)&mipImages[chainSize * f + mipOffsets[m]];
+				HdTextureChunk* chunk = &chunks[m * frameCount + f];
+				chunk->offset = u32(output.size());
+				chunk->uncompressedSize = mipSize;
+
+				// Store the chunk uncompressed if compression does not help.
+				if (zstd_compress(compressed, image, mipSize, compressionLevel) && compressed.size() < mipSize)
+				{
+					chunk->size = u32(compressed.size());
+					output.insert(output.end(), compressed.begin(), compressed.end());
+				}
+				else
+				{
+					chunk->size = mipSize;
+					output.insert(output.end(), image, image + mipSize);
+				}
+			}
+		}
+		memcpy(output.data() + sizeof(HdTextureHeader), chunks.data(), chunkCount * sizeof(HdTextureChunk));
+		return true;
+	}
+
+	bool convertRaw(const u8* rawData, size_t rawSize, s32 width, s32 height, s32 frameCount, s32 scaleFactor, std::vector<u8>& output)
+	{
+		const size_t rowSize = size_t(width) * 4;
+		const size_t frameSize = rowSize * size_t(height);
+		if (!rawData || frameCount <= 0 || rawSize != frameSize * size_t(frameCount))
+		{
+			return false;
+		}
+
+		// Flip the frames once here instead of on every load.
+		std::vector<u8> frames(rawSize);
+		for (s32 f = 0; f < frameCount; f++)
+		{
+			const u8* src = rawData + frameSize * f;
+			u8* dst = frames.data() + frameSize * f;
+			for (s32 y = 0; y < height; y++)
+			{
+				memcpy(&dst[y * rowSize], &src[(height - y - 1) * rowSize], rowSize);
+			}
+		}
+		return write(frames.data(), width, height, frameCount, scaleFactor, 0, 9, output);
+	}
+}
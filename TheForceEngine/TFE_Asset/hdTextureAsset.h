@@ -0,0 +1,63 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine HD Texture Container (.hdt)
+// Packed replacement for the raw RGBA .raw HD texture files.
+//
+// The texels are stored top-down, in the layout used by
+// TextureData::hdAssetData, so they can be decompressed directly into
+// place. Each frame has a prebuilt mip chain and every (mip, frame)
+// image is compressed as a separate chunk, which is located through
+// the chunk directory after the header:
+//
+// HdTextureHeader
+// HdTextureChunk[mipCount * frameCount]   (mip major, then frame)
+// Chunk data
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+
+namespace TFE_HdTexture
+{
+	enum
+	{
+		HDT_MAGIC   = 0x54444854,	// "THDT"
+		HDT_VERSION = 1,
+	};
+
+	#pragma pack(push)
+	#pragma pack(1)
+	struct HdTextureHeader
+	{
+		u32 magic;
+		u16 version;
+		u16 frameCount;
+		u16 width;			// Size of mip 0 of each frame.
+		u16 height;
+		u8  mipCount;
+		u8  scaleFactor;	// HD size relative to the base texture.
+		u16 pad16;
+	};
+
+	struct HdTextureChunk
+	{
+		u32 offset;			// From the start of the file.
+		u32 size;			// Stored size, equal to 'uncompressedSize' if the chunk is not compressed.
+		u32 uncompressedSize;
+	};
+	#pragma pack(pop)
+
+	// Returns true if 'data' starts with a valid header and the chunk directory fits.
+	bool isHdTexture(const u8* data, size_t size);
+	const HdTextureHeader* getHeader(const u8* data);
+	size_t getMipSize(const HdTextureHeader* header, s32 mip);
+
+	// Decompress mip 'mip' of every frame into 'output', which must hold getMipSize() * frameCount bytes.
+	// This may be called from any thread.
+	bool readMip(const u8* data, size_t size, s32 mip, u8* output);
+
+	// Build a container from top-down RGBA frames.
+	// mipCount = 0 builds the full mip chain.
+	bool write(const u8* frames, s32 width, s32 height, s32 frameCount, s32 scaleFactor, s32 mipCount, s32 compressionLevel, std::vector<u8>& output);
+	// Convert the contents of a .raw file, which stores the frames bottom-up.
+	bool convertRaw(const u8* rawData, size_t rawSize, s32 width, s32 height, s32 frameCount, s32 scaleFactor, std::vector<u8>& output);
+}
@@ -2,6 +2,7 @@
 
 #include "spriteAsset_Jedi.h"
 #include <TFE_System/system.h>
+#include <TFE_Archive/archive.h>
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/paths.h>
@@ -45,85 +46,64 @@ namespace TFE_Sprite_Jedi
 	static NameList    s_frameNames[POOL_COUNT];
 	static NameList    s_spriteNames[POOL_COUNT];
 	static std::vector<u8> s_buffer;
+	static std::vector<u8> s_hdBuffer;
 
-	bool loadFrameHd(const char* name, const JediFrame* frame, AssetPool pool, HdWax* hdWax, const WaxCell* cell)
+	static void freeHdWax(HdWax* hdWax)
 	{
-		char hdPath[TFE_MAX_PATH];
-		FileUtil::replaceExtension(name, "fxx", hdPath);
-
-		// If the file doesn't exist, just return - there is no HD asset.
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(hdPath, &filepath))
+		if (!hdWax) { return; }
+		for (s32 e = 0; e < hdWax->entryCount; e++)
 		{
-			return false;
+			free(hdWax->cells[e].data);
 		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		free(hdWax->cells);
+		free(hdWax);
+	}
+
+	bool getHdFilePath(const char* name, bool isWax, AssetPool pool, FilePath* filePath)
+	{
+		// Verify that the HD asset *can* be loaded first.
+		if (pool == POOL_LEVEL && !TFE_Settings::isHdAssetValid(name, isWax ? HD_ASSET_TYPE_WAX : HD_ASSET_TYPE_FME))
 		{
 			return false;
 		}
 
-		// Load the raw data from disk.
-		size_t fileSize = file.getSize();
-		s_buffer.resize(fileSize);
-		file.readBuffer(s_buffer.data(), (u32)fileSize);
-		file.close();
+		// If the file doesn't exist, there is no HD asset.
+		char hdPath[TFE_MAX_PATH];
+		FileUtil::replaceExtension(name, isWax ? "wxx" : "fxx", hdPath);
+		return TFE_Paths::getFilePath(hdPath, filePath);
+	}
 
-		const u8* data = s_buffer.data();
+	static HdWax* decodeFrameHd(const u8* data, size_t size, const WaxCell* cell)
+	{
+		if (size < 8) { return nullptr; }
 		const s32 entryCount = *((s32*)data); data += 4;
 		assert(entryCount == 1);
 
+		// Verify that the pixel count is double the original.
+		const u32 pixelCount = *((u32*)data); data += 4 * entryCount;
+		const u32 targetPixelCount = u32(cell->sizeX * cell->sizeY * 4);
+		const u32 imageSize = sizeof(u32) * pixelCount;
+		if (targetPixelCount != pixelCount || size < 4 + 4 * entryCount + imageSize)
+		{
+			return nullptr;
+		}
+
+		HdWax* hdWax = (HdWax*)malloc(sizeof(HdWax));
 		hdWax->entryCount = 1;
 		hdWax->cells = (HdWaxCell*)malloc(sizeof(HdWaxCell));
 		assert(hdWax->cells);
 
-		hdWax->cells[0].pixelCount = *((u32*)data); data += 4 * entryCount;
+		hdWax->cells[0].pixelCount = pixelCount;
 		hdWax->cells[0].id = 0;
 
-		// Verify that the pixel count is double the original.
-		const s32 targetPixelCount = cell->sizeX * cell->sizeY * 4;
-		if (targetPixelCount != hdWax->cells[0].pixelCount)
-		{
-			free(hdWax->cells);
-			hdWax->cells = nullptr;
-			return false;
-		}
-
 		// Image data.
-		const u32 size = sizeof(u32) * hdWax->cells[0].pixelCount;
-		hdWax->cells[0].data = (u32*)malloc(size);
-		memcpy(hdWax->cells[0].data, data, size);
-		data += size;
-
-		return true;
+		hdWax->cells[0].data = (u32*)malloc(imageSize);
+		memcpy(hdWax->cells[0].data, data, imageSize);
+		return hdWax;
 	}
 
-	JediFrame* getFrame(const char* name, AssetPool pool)
+	JediFrame* decodeFrame(const u8* data, size_t len, const u8* hdData, size_t hdSize, AssetPool pool, HdWax** hdWax)
 	{
-		FrameMap::iterator iFrame = s_frames[pool].find(name);
-		if (iFrame != s_frames[pool].end())
-		{
-			return iFrame->second;
-		}
-
-		// It doesn't exist yet, try to load the frame.
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(name, &filePath))
-		{
-			return nullptr;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		const u8* data = s_buffer.data();
-
 		// Determine ahead of time how much we need to allocate.
 		const WaxFrame* base_frame = (WaxFrame*)data;
 		const WaxCell* base_cell = WAX_CellPtr(data, base_frame);
@@ -131,10 +111,10 @@ namespace TFE_Sprite_Jedi
 
 		// This is a "load in place" format in the original code.
 		// We are going to allocate new memory and copy the data.
-		u8* assetPtr = (u8*)malloc(s_buffer.size() + columnSize);
+		u8* assetPtr = (u8*)malloc(len + columnSize);
 		JediFrame* asset = (JediFrame*)assetPtr;
 		
-		memcpy(asset, data, s_buffer.size());
+		memcpy(asset, data, len);
 
 		WaxFrame* frame = asset;
 		WaxCell* cell = WAX_CellPtr(asset, frame);
@@ -158,7 +138,7 @@ namespace TFE_Sprite_Jedi
 		}
 		else
 		{
-			u32* columns = (u32*)((u8*)asset + s_buffer.size());
+			u32* columns = (u32*)((u8*)asset + len);
 			// Local pointer.
 			cell->columnOffset = u32((u8*)columns - (u8*)asset);
 			// Calculate column offsets.
@@ -167,31 +147,66 @@ namespace TFE_Sprite_Jedi
 				columns[c] = cell->sizeY * c;
 			}
 		}
-		
-		s_frames[pool][name] = asset;
-		s_frameList[pool].push_back(asset);
-		s_frameNames[pool].push_back(name);
 
 		// HD Version
-		bool canUseHdAsset = true;
-		if (pool == POOL_LEVEL && !TFE_Settings::isHdAssetValid(name, HD_ASSET_TYPE_FME))
+		*hdWax = hdData ? decodeFrameHd(hdData, hdSize, cell) : nullptr;
+		return asset;
+	}
+
+	JediFrame* commitFrame(const char* name, JediFrame* frame, HdWax* hdWax, AssetPool pool)
+	{
+		// The same frame may have been committed since it was decoded.
+		FrameMap::iterator iFrame = s_frames[pool].find(name);
+		if (iFrame != s_frames[pool].end())
 		{
-			canUseHdAsset = false;
+			freeDecoded(frame, hdWax);
+			return iFrame->second;
 		}
-		if (canUseHdAsset)
+
+		s_frames[pool][name] = frame;
+		s_frameList[pool].push_back(frame);
+		s_frameNames[pool].push_back(name);
+		if (hdWax)
 		{
-			HdWax* hdWax = (HdWax*)malloc(sizeof(HdWax));
-			if (loadFrameHd(name, asset, pool, hdWax, cell))
-			{
-				s_hdSpriteList[pool].push_back(hdWax);
-				s_hdSprites[pool][asset] = hdWax;
-			}
-			else
-			{
-				free(hdWax);
-			}
+			s_hdSpriteList[pool].push_back(hdWax);
+			s_hdSprites[pool][frame] = hdWax;
 		}
-		return asset;
+		return frame;
+	}
+
+	JediFrame* getFrame(const char* name, AssetPool pool)
+	{
+		FrameMap::iterator iFrame = s_frames[pool].find(name);
+		if (iFrame != s_frames[pool].end())
+		{
+			return iFrame->second;
+		}
+
+		// It doesn't exist yet, try to load the frame.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(name, &filePath))
+		{
+			return nullptr;
+		}
+		// The source data is only read, so use the archive data in place when possible.
+		size_t len = 0;
+		const u8* data = Archive::readFileView(&filePath, s_buffer, &len);
+		if (!data)
+		{
+			return nullptr;
+		}
+
+		FilePath hdPath;
+		size_t hdSize = 0;
+		const u8* hdData = nullptr;
+		if (getHdFilePath(name, false, pool, &hdPath))
+		{
+			hdData = Archive::readFileView(&hdPath, s_hdBuffer, &hdSize);
+		}
+
+		HdWax* hdWax;
+		JediFrame* frame = decodeFrame(data, len, hdData, hdSize, pool, &hdWax);
+		return commitFrame(name, frame, hdWax, pool);
 	}
 
 	JediFrame* loadFrameFromMemory(const u8* data, size_t size, bool transformOffsets)
@@ -243,17 +258,15 @@ namespace TFE_Sprite_Jedi
 		return asset;
 	}
 
-	static std::vector<u32> s_cellOffsets;
-
-	bool isUniqueCell(u32 offset)
+	static bool isUniqueCell(std::vector<u32>& cellOffsets, u32 offset)
 	{
-		const size_t count = s_cellOffsets.size();
-		const u32* offsetList = s_cellOffsets.data();
+		const size_t count = cellOffsets.size();
+		const u32* offsetList = cellOffsets.data();
 		for (u32 i = 0; i < count; i++)
 		{
 			if (offsetList[i] == offset) { return false; }
 		}
-		s_cellOffsets.push_back(offset);
+		cellOffsets.push_back(offset);
 
 		return true;
 	}
@@ -320,57 +333,47 @@ namespace TFE_Sprite_Jedi
 		}
 	}
 		
-	bool loadWaxHd(const char* name, const JediWax* wax, AssetPool pool, HdWax* hdWax)
+	static HdWax* decodeWaxHd(const u8* data, size_t size, const JediWax* wax, const std::vector<u32>& cellOffsets)
 	{
-		char hdPath[TFE_MAX_PATH];
-		FileUtil::replaceExtension(name, "wxx", hdPath);
+		if (size < 4) { return nullptr; }
+		const u8* end = data + size;
+		const s32 entryCount = *((s32*)data); data += 4;
+		assert(entryCount > 0);
 
-		// If the file doesn't exist, just return - there is no HD asset.
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(hdPath, &filepath))
-		{
-			return false;
-		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+		// Verify that the number of cells is correct.
+		if (entryCount != (s32)cellOffsets.size() || size < 4 + 4 * size_t(entryCount))
 		{
-			return false;
+			return nullptr;
 		}
 
-		// Load the raw data from disk.
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
-		const u8* data = s_buffer.data();
-		const s32 entryCount = *((s32*)data); data += 4;
-		assert(entryCount > 0);
+		// Image data size x entryCount.
+		size_t imageSize = 0;
+		for (s32 i = 0; i < entryCount; i++)
+		{
+			const u32 pixelCount = ((u32*)data)[i];
+			imageSize += sizeof(u32) * pixelCount;
 
-		// Verify that the number of cells is correct.
-		if (entryCount != (s32)s_cellOffsets.size())
+			// Verify that the sizes match expectations.
+			const WaxCell* cell = (WaxCell*)((u8*)wax + cellOffsets[i]);
+			const u32 targetPixelCount = u32(4 * cell->sizeX * cell->sizeY);
+			if (targetPixelCount != pixelCount)
+			{
+				return nullptr;
+			}
+		}
+		if (data + 4 * entryCount + imageSize > end)
 		{
-			return false;
+			return nullptr;
 		}
 
+		HdWax* hdWax = (HdWax*)malloc(sizeof(HdWax));
 		hdWax->entryCount = entryCount;
 		hdWax->cells = (HdWaxCell*)malloc(sizeof(HdWaxCell) * entryCount);
 		assert(hdWax->cells);
-		// Image data size x entryCount.
 		for (s32 i = 0; i < entryCount; i++)
 		{
 			hdWax->cells[i].pixelCount = *((u32*)data); data += 4;
 			hdWax->cells[i].id = i;
-
-			// Verify that the sizes match expectations.
-			WaxCell* cell = (WaxCell*)((u8*)wax + s_cellOffsets[i]);
-			s32 targetPixelCount = 4 * cell->sizeX * cell->sizeY;
-			if (targetPixelCount != hdWax->cells[i].pixelCount)
-			{
-				free(hdWax->cells);
-				hdWax->cells = nullptr;
-				return false;
-			}
 		}
 		// Image data.
 		for (s32 i = 0; i < entryCount; i++)
@@ -380,46 +383,23 @@ namespace TFE_Sprite_Jedi
 			memcpy(hdWax->cells[i].data, data, size);
 			data += size;
 		}
-		return true;
+		return hdWax;
 	}
 
-	JediWax* getWax(const char* name, AssetPool pool)
+	JediWax* decodeWax(const u8* data, size_t len, const u8* hdData, size_t hdSize, AssetPool pool, HdWax** hdWax)
 	{
-		SpriteMap::iterator iSprite = s_sprites[pool].find(name);
-		if (iSprite != s_sprites[pool].end())
-		{
-			return iSprite->second;
-		}
-
-		// It doesn't exist yet, try to load the frame.
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(name, &filePath))
-		{
-			return nullptr;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		u8* data = s_buffer.data();
-		Wax* srcWax = (Wax*)data;
+		*hdWax = nullptr;
+		const Wax* srcWax = (const Wax*)data;
 		
 		// every animation is filled out until the end, so no animations = no wax.
 		if (!srcWax->animOffsets[0])
 		{
 			return nullptr;
 		}
-		s_cellOffsets.clear();
+		std::vector<u32> cellOffsets;
 
 		// First determine the size to allocate (note that this will overallocate a bit because cells are shared).
-		u32 cellId = 0;
-		u32 sizeToAlloc = sizeof(JediWax) + (u32)s_buffer.size();
+		u32 sizeToAlloc = sizeof(JediWax) + (u32)len;
 		const s32* animOffset = srcWax->animOffsets;
 		for (s32 animIdx = 0; animIdx < 32 && animOffset[animIdx]; animIdx++)
 		{
@@ -431,18 +411,13 @@ namespace TFE_Sprite_Jedi
 				const s32* frameOffset = view->frameOffsets;
 				for (s32 f = 0; f < 32 && frameOffset[f]; f++)
 				{
-					WaxFrame* frame = (WaxFrame*)(data + frameOffset[f]);
-					WaxCell* cell = frame->cellOffset ? (WaxCell*)(data + frame->cellOffset) : nullptr;
-					bool unique = cell && isUniqueCell(frame->cellOffset);
+					const WaxFrame* frame = (const WaxFrame*)(data + frameOffset[f]);
+					const WaxCell* cell = frame->cellOffset ? (const WaxCell*)(data + frame->cellOffset) : nullptr;
+					bool unique = cell && isUniqueCell(cellOffsets, frame->cellOffset);
 					if (unique && cell->compressed == 0)
 					{
 						sizeToAlloc += cell->sizeX * sizeof(u32);
 					}
-					if (unique)
-					{
-						cell->id = cellId;
-						cellId++;
-					}
 				}
 			}
 		}
@@ -450,7 +425,15 @@ namespace TFE_Sprite_Jedi
 		// Allocate and copy the data (this is a "copy in place" format... mostly.
 		JediWax* asset = (JediWax*)malloc(sizeToAlloc);
 		Wax* dstWax = asset;
-		memcpy(dstWax, srcWax, s_buffer.size());
+		memcpy(dstWax, srcWax, len);
+
+		// Assign cell IDs in the copy, the source data may be a read-only view into the archive.
+		const s32 cellCount = (s32)cellOffsets.size();
+		for (s32 i = 0; i < cellCount; i++)
+		{
+			WaxCell* cell = (WaxCell*)((u8*)asset + cellOffsets[i]);
+			cell->id = i;
+		}
 
 		// Loop through animation list until we reach 32 (maximum count) or a null animation.
 		// This means that animations are contiguous.
@@ -512,7 +495,7 @@ namespace TFE_Sprite_Jedi
 							}
 							else
 							{
-								u32* columns = (u32*)((u8*)asset + s_buffer.size() + cellOffsetPtr);
+								u32* columns = (u32*)((u8*)asset + len + cellOffsetPtr);
 								cellOffsetPtr += dstCell->sizeX * sizeof(u32);
 
 								// Local pointer.
@@ -540,32 +523,75 @@ namespace TFE_Sprite_Jedi
 		asset->animCount = animIdx;
 		asset->pool = u32(pool);
 
-		s_sprites[pool][name] = asset;
-		s_spriteList[pool].push_back(asset);
+		// HD Version
+		*hdWax = hdData ? decodeWaxHd(hdData, hdSize, asset, cellOffsets) : nullptr;
+		return asset;
+	}
+
+	JediWax* commitWax(const char* name, JediWax* wax, HdWax* hdWax, AssetPool pool)
+	{
+		// The same sprite may have been committed since it was decoded.
+		SpriteMap::iterator iSprite = s_sprites[pool].find(name);
+		if (iSprite != s_sprites[pool].end())
+		{
+			freeDecoded(wax, hdWax);
+			return iSprite->second;
+		}
+
+		s_sprites[pool][name] = wax;
+		s_spriteList[pool].push_back(wax);
 		s_spriteNames[pool].push_back(name);
+		if (hdWax)
+		{
+			s_hdSpriteList[pool].push_back(hdWax);
+			s_hdSprites[pool][wax] = hdWax;
+		}
+		return wax;
+	}
+
+	void freeDecoded(void* asset, HdWax* hdWax)
+	{
+		free(asset);
+		freeHdWax(hdWax);
+	}
 
-		bool canUseHdAsset = true;
-		if (pool == POOL_LEVEL && !TFE_Settings::isHdAssetValid(name, HD_ASSET_TYPE_WAX))
+	JediWax* getWax(const char* name, AssetPool pool)
+	{
+		SpriteMap::iterator iSprite = s_sprites[pool].find(name);
+		if (iSprite != s_sprites[pool].end())
 		{
-			canUseHdAsset = false;
+			return iSprite->second;
 		}
 
-		// HD Version
-		if (canUseHdAsset)
+		// It doesn't exist yet, try to load the sprite.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(name, &filePath))
 		{
-			HdWax* hdWax = (HdWax*)malloc(sizeof(HdWax));
-			if (loadWaxHd(name, asset, pool, hdWax))
-			{
-				s_hdSpriteList[pool].push_back(hdWax);
-				s_hdSprites[pool][asset] = hdWax;
-			}
-			else
-			{
-				free(hdWax);
-			}
+			return nullptr;
+		}
+		// The source data is only read, so use the archive data in place when possible.
+		size_t len = 0;
+		const u8* data = Archive::readFileView(&filePath, s_buffer, &len);
+		if (!data)
+		{
+			return nullptr;
 		}
 
-		return asset;
+		FilePath hdPath;
+		size_t hdSize = 0;
+		const u8* hdData = nullptr;
+		if (getHdFilePath(name, true, pool, &hdPath))
+		{
+			hdData = Archive::readFileView(&hdPath, s_hdBuffer, &hdSize);
+		}
+
+		HdWax* hdWax;
+		JediWax* wax = decodeWax(data, len, hdData, hdSize, pool, &hdWax);
+		if (!wax)
+		{
+			return nullptr;
+		}
+		return commitWax(name, wax, hdWax, pool);
 	}
 		
 	const HdWax* getHdWaxData(const void* srcData)
@@ -590,7 +616,7 @@ namespace TFE_Sprite_Jedi
 		{
 			return nullptr;
 		}
-		s_cellOffsets.clear();
+		std::vector<u32> cellOffsets;
 
 		// First determine the size to allocate (note that this will overallocate a bit because cells are shared).
 		u32 sizeToAlloc = sizeof(JediWax) + (u32)size;
@@ -607,7 +633,7 @@ namespace TFE_Sprite_Jedi
 				{
 					const WaxFrame* frame = (WaxFrame*)(data + frameOffset[f]);
 					const WaxCell* cell = frame->cellOffset ? (WaxCell*)(data + frame->cellOffset) : nullptr;
-					if (cell && cell->compressed == 0 && isUniqueCell(frame->cellOffset))
+					if (cell && cell->compressed == 0 && isUniqueCell(cellOffsets, frame->cellOffset))
 					{
 						sizeToAlloc += cell->sizeX * sizeof(u32);
 					}
@@ -760,12 +786,7 @@ namespace TFE_Sprite_Jedi
 		HdWax** hdWaxList = s_hdSpriteList[pool].data();
 		for (size_t i = 0; i < hdWaxCount; i++)
 		{
-			for (s32 e = 0; e < hdWaxList[i]->entryCount; e++)
-			{
-				free(hdWaxList[i]->cells[e].data);
-			}
-			free(hdWaxList[i]->cells);
-			free(hdWaxList[i]);
+			freeHdWax(hdWaxList[i]);
 		}
 		s_hdSpriteList[pool].clear();
 		s_hdSprites[pool].clear();
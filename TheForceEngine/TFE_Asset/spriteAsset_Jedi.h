@@ -6,6 +6,7 @@
 //////////////////////////////////////////////////////////////////////
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/stream.h>
+#include <TFE_FileSystem/paths.h>
 #include <vector>
 
 // The original DOS code relied on 32-bit pointers and just swapped offsets for pointers at load time.
@@ -109,6 +110,17 @@ namespace TFE_Sprite_Jedi
 	void freeAll();
 	void freeLevelData();
 
+	// Staged loading, used to decode level sprites on worker threads.
+	// decodeFrame() and decodeWax() are thread safe and return unregistered assets (and optional HD data),
+	// getHdFilePath() and commit*() must be called on the main thread. Commit in the order the assets
+	// would have been loaded to keep the asset indices deterministic.
+	bool getHdFilePath(const char* name, bool isWax, AssetPool pool, FilePath* filePath);
+	JediFrame* decodeFrame(const u8* data, size_t size, const u8* hdData, size_t hdSize, AssetPool pool, HdWax** hdWax);
+	JediWax*   decodeWax(const u8* data, size_t size, const u8* hdData, size_t hdSize, AssetPool pool, HdWax** hdWax);
+	JediFrame* commitFrame(const char* name, JediFrame* frame, HdWax* hdWax, AssetPool pool = POOL_LEVEL);
+	JediWax*   commitWax(const char* name, JediWax* wax, HdWax* hdWax, AssetPool pool = POOL_LEVEL);
+	void freeDecoded(void* asset, HdWax* hdWax);
+
 	JediFrame* loadFrameFromMemory(const u8* data, size_t size, bool transformOffsets = true);
 	JediWax* loadWaxFromMemory(const u8* data, size_t size, bool transformOffsets = true);
 
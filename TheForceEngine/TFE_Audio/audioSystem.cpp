@@ -2,14 +2,15 @@
 #include "audioSystem.h"
 #include "audioDevice.h"
 #include "midiPlayer.h"
-#include <SDL_mutex.h>
 #include <TFE_System/system.h>
 #include <TFE_System/math.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_System/profiler.h>
+#include <TFE_System/spscQueue.h>
 #include <assert.h>
 #include <algorithm>
+#include <thread>
 
 // Comment out the desired sigmoid function and comment all of the others.
 //#define AUDIO_SIGMOID_CLIP 1
@@ -31,13 +32,15 @@ enum SoundSourceFlags
 	SND_FLAG_FINISHED = (1 << 4),
 };
 
+// Sources are owned by the audio thread, they are only changed by the game thread through commands.
 struct SoundSource
 {
 	SoundType type;
 	f32 volume;
 	u32 sampleIndex;
-	u32 flags;
+	volatile u32 flags;
 	s32 slot;
+	u32 generation;	// Matches the client generation when the source was started, stale commands are ignored.
 
 	// Sound data.
 	const SoundBuffer* buffer;
@@ -60,20 +63,83 @@ namespace TFE_Audio
 		AUDIO_FRAME_SIZE = 1024,
 		AUDIO_CALLBACK_BUFFER_SIZE = 256,	// 256
 		BUFFERED_SILENT_FRAME_COUNT = 16,
+		AUDIO_COMMAND_CAPACITY = 256,
+		AUDIO_FINISHED_CAPACITY = 2 * MAX_SOUND_SOURCES,
+	};
+
+	// Commands sent from the game thread to the audio callback, which applies them at the start of each buffer.
+	enum AudioCommandType
+	{
+		ACMD_START = 0,		// Initialize a newly allocated source.
+		ACMD_PLAY,
+		ACMD_STOP,
+		ACMD_FREE,
+		ACMD_VOLUME,
+		ACMD_BUFFER,
+		ACMD_PAUSE,
+		ACMD_RESUME,
+		ACMD_STOP_ALL,
+	};
+
+	struct AudioCommand
+	{
+		AudioCommandType type;
+		s32 slot;
+		u32 generation;
+		u32 flags;
+		SoundType soundType;
+		f32 volume;
+		const SoundBuffer* buffer;
+		SoundFinishedCallback finishedCallback;
+		void* finishedUserData;
+		s32 finishedArg;
+	};
+
+	// Sent from the audio callback back to the game thread when a source finishes playing.
+	// The game thread runs the finished callback and reuses the slot if it was a one shot.
+	struct SourceFinished
+	{
+		s32 slot;
+		u32 generation;
+		bool release;
+		SoundFinishedCallback callback;
+		void* userData;
+		s32 arg;
+	};
+
+	// Game thread view of each source slot.
+	struct SourceClientState
+	{
+		bool allocated;
+		bool playing;	// Cleared by stopSource() or when the audio thread reports that the source finished.
+		u32 generation;
+		f32 volume;
 	};
 
 	// Client volume controls, ranging from [0, 1]
 	static f32 s_soundFxVolume = 1.0f;
 
+	// Audio thread state.
 	static u32 s_sourceCount;
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
-	static SDL_mutex* s_mutex;
 	static bool s_paused = false;
+	// Game thread state.
+	static SourceClientState s_clientSources[MAX_SOUND_SOURCES];
+
+	static SpscQueue<AudioCommand, AUDIO_COMMAND_CAPACITY> s_commands;
+	static SpscQueue<SourceFinished, AUDIO_FINISHED_CAPACITY> s_finished;
 	static bool s_nullDevice = false;
 	static volatile s32 s_silentAudioFrames = 0;
 
 	static AudioUpsampleFilter s_upsampleFilter = AUF_DEFAULT;
-	static AudioThreadCallback s_audioThreadCallback = nullptr;
+	static std::atomic<AudioThreadCallback> s_audioThreadCallback(nullptr);
+	// Incremented before and after the audio thread callback runs, so it is odd while the callback is running.
+	static atomic_u32 s_audioThreadCallbackCount(0);
+
+	// Counters
+	static atomic_s32 s_audioXruns(0);		// Written by the audio thread, copied to s_audioXrunCount in update().
+	static s32 s_audioXrunCount = 0;		// Buffers that took longer to generate than to play.
+	static s32 s_audioCmdDropCount = 0;		// Commands dropped because the queue was full.
 
 	static void audioCallback(void*, unsigned char*, int);
 	void setSoundVolumeConsole(const ConsoleArgList& args);
@@ -86,14 +152,25 @@ namespace TFE_Audio
 	static s32 s_soundIterAve = 0;
 #endif
 
+	void resetSources()
+	{
+		s_sourceCount = 0u;
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		{
+			s_sources[i] = SoundSource();
+			s_sources[i].slot = i;
+		}
+	}
+
 	bool init(bool useNullDevice/*=false*/, s32 outputId/*=-1*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
-		s_sourceCount = 0u;
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
 
+		TFE_COUNTER(s_audioXrunCount, "AudioXruns");
+		TFE_COUNTER(s_audioCmdDropCount, "AudioCmdDropped");
 	#if AUDIO_TIMING == 1
 		TFE_COUNTER(s_soundIterMax, "SoundIterMax-MicroSec");
 		TFE_COUNTER(s_soundIterAve, "SoundIterAve-MicroSec");
@@ -102,11 +179,13 @@ namespace TFE_Audio
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
 
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
-		{
-			s_sources[i].slot = i;
-		}
+		// The device is not running yet, so it is safe to reset both sides.
+		resetSources();
+		memset(s_clientSources, 0, sizeof(SourceClientState) * MAX_SOUND_SOURCES);
+		s_commands.clear();
+		s_finished.clear();
+		s_paused = false;
+		s_audioXruns = 0;
 
 		bool audDev = TFE_AudioDevice::init(AUDIO_FRAME_SIZE, outputId, useNullDevice);
 		if (!audDev)
@@ -124,15 +203,6 @@ namespace TFE_Audio
 			return false;
 		}
 
-		s_mutex = SDL_CreateMutex();
-		if (!s_mutex)
-		{
-			TFE_System::logWrite(LOG_ERROR, "Audio", "Cannot init SDL_mutex.");
-			TFE_AudioDevice::destroy();
-			s_nullDevice = true;
-			return false;
-		}
-
 		s_nullDevice = false;
 		return true;
 	}
@@ -145,21 +215,90 @@ namespace TFE_Audio
 		stopAllSounds();
 
 		TFE_AudioDevice::destroy();
-		SDL_DestroyMutex(s_mutex);
+	}
+
+	// Game thread: run the finished callbacks sent by the audio thread and pick up released slots.
+	static void processFinishedSources()
+	{
+		SourceFinished finished;
+		while (s_finished.pop(&finished))
+		{
+			// Skip sources that were freed, stopped or reused after the event was sent, their callback data may be stale.
+			SourceClientState* client = &s_clientSources[finished.slot];
+			if (!client->allocated || client->generation != finished.generation)
+			{
+				continue;
+			}
+
+			const bool playing = client->playing;
+			client->playing = false;
+			if (finished.release)
+			{
+				client->allocated = false;
+			}
+			if (playing && finished.callback)
+			{
+				finished.callback(finished.userData, finished.arg);
+			}
+		}
+	}
+
+	void update()
+	{
+		if (s_nullDevice) { return; }
+
+		processFinishedSources();
+		s_audioXrunCount = s_audioXruns.load(std::memory_order_relaxed);
+	}
+
+	// Game thread: queue a command for the audio callback, this never blocks.
+	static bool pushCommand(const AudioCommand& cmd)
+	{
+		if (!s_commands.push(cmd))
+		{
+			s_audioCmdDropCount++;
+			return false;
+		}
+		return true;
+	}
+
+	static bool pushCommand(AudioCommandType type, SoundSource* source = nullptr)
+	{
+		AudioCommand cmd = {};
+		cmd.type = type;
+		cmd.slot = source ? source->slot : -1;
+		cmd.generation = source ? s_clientSources[source->slot].generation : 0;
+		return pushCommand(cmd);
+	}
+
+	// Game thread: pick up slots released by the audio thread and return the first free slot, or -1.
+	static s32 allocateSource()
+	{
+		processFinishedSources();
+		for (s32 s = 0; s < MAX_SOUND_SOURCES; s++)
+		{
+			SourceClientState* client = &s_clientSources[s];
+			if (!client->allocated)
+			{
+				client->allocated = true;
+				client->playing = false;
+				client->generation++;
+				return s;
+			}
+		}
+		return -1;
 	}
 
 	void stopAllSounds()
 	{
 		if (s_nullDevice) { return; }
 
-		SDL_LockMutex(s_mutex);
-		s_sourceCount = 0u;
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		for (s32 s = 0; s < MAX_SOUND_SOURCES; s++)
 		{
-			s_sources[i].slot = i;
+			s_clientSources[s].allocated = false;
+			s_clientSources[s].playing = false;
 		}
-		SDL_UnlockMutex(s_mutex);
+		pushCommand(ACMD_STOP_ALL);
 	}
 
 	void selectDevice(s32 id)
@@ -198,16 +337,14 @@ namespace TFE_Audio
 
 	void pause()
 	{
-		SDL_LockMutex(s_mutex);
-		s_paused = true;
-		SDL_UnlockMutex(s_mutex);
+		if (s_nullDevice) { return; }
+		pushCommand(ACMD_PAUSE);
 	}
 
 	void resume()
 	{
-		SDL_LockMutex(s_mutex);
-		s_paused = false;
-		SDL_UnlockMutex(s_mutex);
+		if (s_nullDevice) { return; }
+		pushCommand(ACMD_RESUME);
 	}
 
 	// Really the buffered audio will continue to process so time advances properly.
@@ -218,30 +355,60 @@ namespace TFE_Audio
 		s_silentAudioFrames = BUFFERED_SILENT_FRAME_COUNT;
 	}
 		
+	// The caller may free the data used by the previous callback as soon as this returns.
 	void setAudioThreadCallback(AudioThreadCallback callback)
 	{
 		if (s_nullDevice) { return; }
 
-		SDL_LockMutex(s_mutex);
-		s_audioThreadCallback = callback;
-		SDL_UnlockMutex(s_mutex);
+		s_audioThreadCallback.store(callback);
+		waitForAudioThreadCallback();
 	}
 
-	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput)
+	// Game thread: wait until a callback that may have started before this call returns.
+	// Any callback that starts later sees everything the game thread wrote before calling this.
+	void waitForAudioThreadCallback()
 	{
-		return TFE_AudioDevice::getOutputDeviceList(count, curOutput);
+		if (s_nullDevice) { return; }
+
+		const u32 count = s_audioThreadCallbackCount.load();
+		if (!(count & 1)) { return; }
+		while (s_audioThreadCallbackCount.load() == count)
+		{
+			std::this_thread::yield();
+		}
 	}
 
-	void lock()
+	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput)
 	{
-		if (s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
+		return TFE_AudioDevice::getOutputDeviceList(count, curOutput);
 	}
 
-	void unlock()
-	{
-		if (s_nullDevice) { return; }
-		SDL_UnlockMutex(s_mutex);
+	static SoundSource* startSource(SoundType type, f32 volume, const SoundBuffer* buffer, u32 flags, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	{
+		const s32 slot = allocateSource();
+		if (slot < 0) { return nullptr; }
+
+		SourceClientState* client = &s_clientSources[slot];
+		client->volume = volume;
+		client->playing = (flags & SND_FLAG_PLAYING) != 0u;
+
+		AudioCommand cmd;
+		cmd.type = ACMD_START;
+		cmd.slot = slot;
+		cmd.generation = client->generation;
+		cmd.flags = flags;
+		cmd.soundType = type;
+		cmd.volume = volume;
+		cmd.buffer = buffer;
+		cmd.finishedCallback = finishedCallback;
+		cmd.finishedUserData = cbUserData;
+		cmd.finishedArg = cbArg;
+		if (!pushCommand(cmd))
+		{
+			client->allocated = false;
+			return nullptr;
+		}
+		return &s_sources[slot];
 	}
 
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
@@ -250,42 +417,12 @@ namespace TFE_Audio
 	{
 		if (!buffer || s_nullDevice) { return false; }
 
-		SDL_LockMutex(s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+		u32 flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | SND_FLAG_ONE_SHOT;
+		if (looping)
 		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
+			flags |= SND_FLAG_LOOPING;
 		}
-
-		if (newSource)
-		{
-			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | SND_FLAG_ONE_SHOT;
-			if (looping)
-			{
-				newSource->flags |= SND_FLAG_LOOPING;
-			}
-			newSource->volume = type == SOUND_3D ? 0.0f : volume;
-			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
-			newSource->finishedCallback = finishedCallback;
-			newSource->finishedUserData = cbUserData;
-			newSource->finishedArg = cbArg;
-		}
-		SDL_UnlockMutex(s_mutex);
-
-		return newSource != nullptr;
+		return startSource(type, type == SOUND_3D ? 0.0f : volume, buffer, flags, finishedCallback, cbUserData, cbArg) != nullptr;
 	}
 
 	// Sound source that the client holds onto.
@@ -294,37 +431,7 @@ namespace TFE_Audio
 		if (!buffer || s_nullDevice) { return nullptr; }
 		assert(volume >= 0.0f && volume <= 1.0f);
 
-		SDL_LockMutex(s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
-		if (newSource)
-		{
-			newSource->type = type;
-			newSource->flags = SND_FLAG_ACTIVE;
-			newSource->volume = volume;
-			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
-			newSource->finishedCallback = callback;
-			newSource->finishedUserData = userData;
-		}
-		SDL_UnlockMutex(s_mutex);
-
-		return newSource;
+		return startSource(type, volume, buffer, SND_FLAG_ACTIVE, callback, userData, 0);
 	}
 
 	s32 getSourceSlot(SoundSource* source)
@@ -341,7 +448,7 @@ namespace TFE_Audio
 		{
 			return nullptr;
 		}
-		if (!(s_sources[slot].flags & SND_FLAG_ACTIVE))
+		if (!s_clientSources[slot].allocated)
 		{
 			return nullptr;
 		}
@@ -351,80 +458,171 @@ namespace TFE_Audio
 
 	void playSource(SoundSource* source, bool looping)
 	{
-		if (!source || (source->flags & SND_FLAG_PLAYING) || s_nullDevice)
+		if (!source || s_nullDevice || s_clientSources[source->slot].playing)
 		{
 			return;
 		}
-		
-		SDL_LockMutex(s_mutex);
-			source->flags |= SND_FLAG_PLAYING;
-			if (looping) { source->flags |= SND_FLAG_LOOPING; }
-			source->sampleIndex = 0u;
-		SDL_UnlockMutex(s_mutex);
+		s_clientSources[source->slot].playing = true;
+
+		AudioCommand cmd = {};
+		cmd.type = ACMD_PLAY;
+		cmd.slot = source->slot;
+		cmd.generation = s_clientSources[source->slot].generation;
+		cmd.flags = looping ? SND_FLAG_LOOPING : 0;
+		pushCommand(cmd);
 	}
 
 	void stopSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-		SDL_UnlockMutex(s_mutex);
+		s_clientSources[source->slot].playing = false;
+		pushCommand(ACMD_STOP, source);
 	}
 	
 	void freeSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-			source->flags &= ~SND_FLAG_ACTIVE;
-			source->buffer = nullptr;
-		SDL_UnlockMutex(s_mutex);
+		// The slot may be reused right away, the free command is applied before any new start command.
+		pushCommand(ACMD_FREE, source);
+		s_clientSources[source->slot].allocated = false;
+		s_clientSources[source->slot].playing = false;
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
 	{
-		if (s_nullDevice) { return; }
-		source->volume = std::max(0.0f, std::min(1.0f, volume));
+		if (!source || s_nullDevice) { return; }
+
+		volume = std::max(0.0f, std::min(1.0f, volume));
+		s_clientSources[source->slot].volume = volume;
+
+		AudioCommand cmd = {};
+		cmd.type = ACMD_VOLUME;
+		cmd.slot = source->slot;
+		cmd.generation = s_clientSources[source->slot].generation;
+		cmd.volume = volume;
+		pushCommand(cmd);
 	}
 
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
-		if (s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->sampleIndex = 0u;
-			source->buffer = buffer;
-		SDL_UnlockMutex(s_mutex);
+		if (!source || s_nullDevice) { return; }
+
+		AudioCommand cmd = {};
+		cmd.type = ACMD_BUFFER;
+		cmd.slot = source->slot;
+		cmd.generation = s_clientSources[source->slot].generation;
+		cmd.buffer = buffer;
+		pushCommand(cmd);
 	}
 
 	bool isSourcePlaying(SoundSource* source)
 	{
 		if (s_nullDevice) { return false; }
-		return (source->flags & SND_FLAG_PLAYING) != 0u;
+		return s_clientSources[source->slot].playing;
 	}
 
 	f32 getSourceVolume(SoundSource* source)
 	{
 		if (s_nullDevice) { return 0.0f; }
-		return source->volume;
+		return s_clientSources[source->slot].volume;
 	}
 
 	// Internal
 	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
 	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
 
+	// Audio thread: apply the commands queued by the game thread since the last buffer.
+	void processCommands()
+	{
+		AudioCommand cmd;
+		while (s_commands.pop(&cmd))
+		{
+			SoundSource* snd = cmd.slot >= 0 ? &s_sources[cmd.slot] : nullptr;
+			// Ignore commands meant for a previous owner of the slot.
+			if (snd && cmd.type != ACMD_START && snd->generation != cmd.generation)
+			{
+				continue;
+			}
+
+			switch (cmd.type)
+			{
+				case ACMD_START:
+				{
+					snd->type = cmd.soundType;
+					snd->flags = cmd.flags;
+					snd->volume = cmd.volume;
+					snd->buffer = cmd.buffer;
+					snd->sampleIndex = 0u;
+					snd->generation = cmd.generation;
+					snd->finishedCallback = cmd.finishedCallback;
+					snd->finishedUserData = cmd.finishedUserData;
+					snd->finishedArg = cmd.finishedArg;
+					s_sourceCount = std::max(s_sourceCount, u32(cmd.slot + 1));
+				} break;
+				case ACMD_PLAY:
+				{
+					// playSource() only sends this when the source is not playing as seen by the game thread,
+					// so restart it even if it has not been stopped yet on this side.
+					snd->flags |= SND_FLAG_PLAYING | cmd.flags;
+					snd->sampleIndex = 0u;
+				} break;
+				case ACMD_STOP:
+				{
+					snd->flags &= ~SND_FLAG_PLAYING;
+				} break;
+				case ACMD_FREE:
+				{
+					snd->flags = 0;
+					snd->buffer = nullptr;
+				} break;
+				case ACMD_VOLUME:
+				{
+					snd->volume = cmd.volume;
+				} break;
+				case ACMD_BUFFER:
+				{
+					snd->sampleIndex = 0u;
+					snd->buffer = cmd.buffer;
+				} break;
+				case ACMD_PAUSE:
+				{
+					s_paused = true;
+				} break;
+				case ACMD_RESUME:
+				{
+					s_paused = false;
+				} break;
+				case ACMD_STOP_ALL:
+				{
+					resetSources();
+				} break;
+			}
+		}
+	}
+
 	void cleanupSources()
 	{
-		// call any finished callbacks.
+		// Send finished sources to the game thread, which runs the finished callbacks.
 		for (u32 s = 0; s < s_sourceCount; s++)
 		{
-			if (s_sources[s].flags&SND_FLAG_FINISHED)
+			SoundSource* snd = &s_sources[s];
+			if (snd->flags&SND_FLAG_FINISHED)
 			{
-				s_sources[s].flags = 0;
-				s_sources[s].buffer = nullptr;
-				if (s_sources[s].finishedCallback)
+				// Client held sources stay allocated until freeSource() is called.
+				const bool oneShot = (snd->flags&SND_FLAG_ONE_SHOT) != 0u;
+				const SourceFinished finished = { s32(s), snd->generation, oneShot, snd->finishedCallback, snd->finishedUserData, snd->finishedArg };
+				if (!s_finished.push(finished))
 				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
+					// The game thread has not caught up, try again on the next buffer.
+					continue;
+				}
+
+				snd->flags &= ~SND_FLAG_FINISHED;
+				if (oneShot)
+				{
+					snd->flags = 0;
+					snd->buffer = nullptr;
 				}
 			}
 		}
@@ -460,20 +658,23 @@ namespace TFE_Audio
 		f32* buffer = (f32*)outputBuffer;
 		u32 bufferSize = (u32)bufsize;
 		u32 frames = bufferSize / (AUDIO_CHANNEL_COUNT * sizeof(f32));
-
-	#if AUDIO_TIMING == 1
-		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
-	#endif
+		const u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
+		TFE_THREAD_NAME("Audio");
+		TFE_ZONE("Audio Callback");
 
 		// First clear samples
 		memset(buffer, 0, bufferSize);
+
+		// Apply game thread changes, this replaces locking around every source operation.
+		processCommands();
 			   
-		SDL_LockMutex(s_mutex);
-		// Then call the audio thread callback
-		if (s_audioThreadCallback && !s_paused)
+		// Then call the audio thread callback (iMuse), which also only talks to the game thread through queues.
+		s_audioThreadCallbackCount++;
+		const AudioThreadCallback threadCallback = s_audioThreadCallback.load();
+		if (threadCallback && !s_paused)
 		{
 			static f32 callbackBuffer[(AUDIO_CALLBACK_BUFFER_SIZE + 2)*AUDIO_CHANNEL_COUNT];	// 256 stereo + oversampling.
-			s_audioThreadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
+			threadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
 			// The audio buffer is 1/4 as large as it should be.
 			// This means that in-between samples must be interpolated.
 			if (!s_silentAudioFrames)
@@ -488,6 +689,7 @@ namespace TFE_Audio
 				}
 			}
 		}
+		s_audioThreadCallbackCount++;
 
 		// Then loop through the sources.
 		// Note: this is no longer used by Dark Forces. However I decided to keep direct sound support around
@@ -495,7 +697,7 @@ namespace TFE_Audio
 		SoundSource* snd = s_sources;
 		for (u32 s = 0; s < s_sourceCount && !s_paused; s++, snd++)
 		{
-			if (!(snd->flags&SND_FLAG_PLAYING)) { continue; }
+			if (!(snd->flags&SND_FLAG_PLAYING) || !snd->buffer) { continue; }
 			assert(snd->buffer->data);
 
 			// Skip sound sample processing the sound is too quiet...
@@ -554,7 +756,6 @@ namespace TFE_Audio
 				snd->sampleIndex = sIndex;
 			}
 		}
-		// Cleanup sound sources while we are still in the mutex.
 		cleanupSources();
 		
 		// Handle midi synthesis results.
@@ -563,7 +764,6 @@ namespace TFE_Audio
 			TFE_MidiPlayer::synthesizeMidi((f32*)outputBuffer, frames, !s_silentAudioFrames);
 		}
 		if (s_silentAudioFrames > 0) { s_silentAudioFrames--; }
-		SDL_UnlockMutex(s_mutex);
 
 		// Handle out of range audio samples.
 		buffer = (f32*)outputBuffer;
@@ -590,9 +790,15 @@ namespace TFE_Audio
 		}
 
 		// Timing
+		// The device does not report underruns directly, so count the buffers that took longer to mix than to play.
+		const u64 soundIterEnd = TFE_System::getCurrentTimeInTicks();
+		const f64 soundIterDelta = TFE_System::convertFromTicksToSeconds(soundIterEnd - soundIterStart);
+		if (soundIterDelta * f64(AUDIO_FREQ) > f64(frames))
+		{
+			s_audioXruns.fetch_add(1, std::memory_order_relaxed);
+		}
 	#if AUDIO_TIMING == 1
-		u64 soundIterEnd = TFE_System::getCurrentTimeInTicks();
-		f64 soundIterDeltaMS = 1000000.0 * TFE_System::convertFromTicksToSeconds(soundIterEnd - soundIterStart);
+		f64 soundIterDeltaMS = 1000000.0 * soundIterDelta;
 		s_soundIterAveF = soundIterDeltaMS * 0.01 + s_soundIterAveF * 0.99;
 		s_soundIterMaxF = std::max(s_soundIterMaxF, soundIterDeltaMS);
 		s_soundIterAve = s32(s_soundIterAveF);
@@ -70,12 +70,14 @@ namespace TFE_Audio
 	void pause();
 	void resume();
 
-	void lock();
-	void unlock();
+	// Game thread, call once per frame to run sound finished callbacks and update the counters.
+	void update();
 
 	void bufferedAudioClear();
 
+	// The audio thread callback never blocks, it must only share data with the game thread through lock-free queues or atomics.
 	void setAudioThreadCallback(AudioThreadCallback callback = nullptr);
+	void waitForAudioThreadCallback();
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput);
 
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
@@ -6,8 +6,11 @@
 #endif
 #include <SDL_mutex.h>
 #include <SDL_thread.h>
+#include <SDL_timer.h>
 #include <TFE_Asset/gmidAsset.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/spscQueue.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_Audio/MidiSynth/soundFontDevice.h>
@@ -26,12 +29,22 @@ using namespace TFE_Audio;
 
 namespace TFE_MidiPlayer
 {
+	// Midi Scheduling
+	// -----------------
+	// When the device synthesizes audio (SF2, OPL3), the midi callback runs inside the audio callback.
+	// Each callback tick is placed at its exact sample offset in the audio buffer, and the messages it
+	// sends are applied as the device renders up to that offset - so note timing does not depend on
+	// thread wake-ups or on the audio buffer size.
+	// Devices that do not render (System Midi) are driven by the midi thread using the wall clock, which
+	// also takes over if the audio callback stops running (such as with no audio output device).
 	enum MidiPlayerCmd
 	{
 		MIDI_PAUSE,
 		MIDI_RESUME,
 		MIDI_CHANGE_VOL,
+		MIDI_APPLY_VOL,
 		MIDI_STOP_NOTES,
+		MIDI_SEND_MSG,
 		MIDI_COUNT
 	};
 
@@ -39,13 +52,52 @@ namespace TFE_MidiPlayer
 	{
 		MidiPlayerCmd cmd;
 		f32 newVolume;
+		u8  msg[3];
 	};
 
-	enum { MAX_MIDI_CMD = 256 };
-	static MidiCmd s_midiCmdBuffer[MAX_MIDI_CMD];
-	static u32 s_midiCmdCount = 0;
+	// Raw midi message applied 'offset' stereo samples into the audio buffer being synthesized.
+	struct MidiEvent
+	{
+		u32 offset;
+		u8  msg[3];
+		u8  len;
+	};
+
+	enum
+	{
+		MIDI_CMD_CAPACITY = 1024,
+		MAX_MIDI_EVENTS = 2048,
+		MIDI_SAMPLE_RATE = 44100,	// Matches the audio output and the synthesized midi devices.
+		MIDI_MAX_CATCHUP_SAMPLES = MIDI_SAMPLE_RATE / 4,	// Limit on the skipped time applied once the scheduler runs again.
+	};
+
+	enum MidiSchedulerThread
+	{
+		MIDI_SCHED_NONE = 0,	// Game thread, messages are queued when the audio callback drives the device.
+		MIDI_SCHED_AUDIO,		// Messages are scheduled at sample offsets in the current audio buffer.
+		MIDI_SCHED_MIDI,		// Messages are sent to the device immediately.
+	};
+
+	// Commands from the game thread, consumed by whichever thread runs the scheduler (holding s_midiThreadMutex).
+	static SpscQueue<MidiCmd, MIDI_CMD_CAPACITY> s_midiCommands;
+	static s32 s_midiCmdDropCount = 0;
 	static f64 s_maxNoteLength = 16.0;		// defaults to 16 seconds.
 
+	static MidiEvent s_midiEvents[MAX_MIDI_EVENTS];
+	static u32 s_midiEventCount = 0;
+	static u32 s_midiEventOffset = 0;
+	static s32 s_midiEventDropCount = 0;
+	// Audio thread only: time in stereo samples that was rendered as silence because the scheduler was busy.
+	static u32 s_midiSkippedSamples = 0;
+	static s32 s_midiSkippedBufferCount = 0;
+
+	static const f64 c_audioSchedulerTimeout = 0.25;	// seconds without audio callbacks before the midi thread takes over.
+	static std::atomic<u64> s_lastAudioSchedule(0);
+	static thread_local MidiSchedulerThread s_schedulerThread = MIDI_SCHED_NONE;
+	// Set when the device changes, so the midi thread can check it without holding s_deviceChangeMutex.
+	static atomic_bool s_deviceRenders(false);
+	static bool s_midiPaused = false;
+
 	struct MidiCallback
 	{
 		void(*callback)(void) = nullptr;	// callback function to call.
@@ -80,9 +132,13 @@ namespace TFE_MidiPlayer
 	static f64 s_curNoteTime = 0.0;
 
 	int midiUpdateFunc(void* userData);
+	void processCommands();
+	void advanceCallback(f64 dt, u32 sampleCount);
+	void detectHangingNotes();
 	void stopAllNotes();
 	void changeVolume();
 	void allocateMidiDevice(MidiDeviceType type);
+	void updateDeviceRenders();
 
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args);
@@ -131,6 +187,7 @@ namespace TFE_MidiPlayer
 					}
 				}
 			}
+			updateDeviceRenders();
 		}
 		SDL_UnlockMutex(s_deviceChangeMutex);
 
@@ -144,6 +201,9 @@ namespace TFE_MidiPlayer
 
 		CCMD("setMusicVolume", setMusicVolumeConsole, 1, "Sets the music volume, range is 0.0 to 1.0");
 		CCMD("getMusicVolume", getMusicVolumeConsole, 0, "Get the current music volume where 0 = silent, 1 = maximum.");
+		TFE_COUNTER(s_midiCmdDropCount, "MidiCmdDropped");
+		TFE_COUNTER(s_midiEventDropCount, "MidiEventsDropped");
+		TFE_COUNTER(s_midiSkippedBufferCount, "MidiBuffersSkipped");
 
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->musicVolume);
@@ -189,6 +249,7 @@ namespace TFE_MidiPlayer
 					TFE_System::logWrite(LOG_ERROR, "Midi", "Cannot select midi output.");
 				}
 			}
+			updateDeviceRenders();
 		}
 		SDL_UnlockMutex(s_deviceChangeMutex);
 	}
@@ -204,6 +265,7 @@ namespace TFE_MidiPlayer
 					TFE_System::logWrite(LOG_ERROR, "Midi", "Cannot select midi output.");
 				}
 			}
+			updateDeviceRenders();
 		}
 		SDL_UnlockMutex(s_deviceChangeMutex);
 	}
@@ -220,17 +282,14 @@ namespace TFE_MidiPlayer
 	//////////////////////////////////////////////////
 	// Command Buffer
 	//////////////////////////////////////////////////
-	MidiCmd* midiAllocCmd()
-	{
-		if (s_midiCmdCount >= MAX_MIDI_CMD) { return nullptr; }
-		MidiCmd* cmd = &s_midiCmdBuffer[s_midiCmdCount];
-		s_midiCmdCount++;
-		return cmd;
-	}
-
-	void midiClearCmdBuffer()
+	// Only called from the game thread.
+	void pushCommand(MidiPlayerCmd type, f32 volume = 0.0f, u8 type0 = 0, u8 arg1 = 0, u8 arg2 = 0)
 	{
-		s_midiCmdCount = 0;
+		MidiCmd cmd = { type, volume, { type0, arg1, arg2 } };
+		if (!s_midiCommands.push(cmd))
+		{
+			s_midiCmdDropCount++;
+		}
 	}
 
 	//////////////////////////////////////////////////
@@ -238,14 +297,7 @@ namespace TFE_MidiPlayer
 	//////////////////////////////////////////////////
 	void setVolume(f32 volume)
 	{
-		SDL_LockMutex(s_midiThreadMutex);
-		MidiCmd* midiCmd = midiAllocCmd();
-		if (midiCmd)
-		{
-			midiCmd->cmd = MIDI_CHANGE_VOL;
-			midiCmd->newVolume = volume;
-		}
-		SDL_UnlockMutex(s_midiThreadMutex);
+		pushCommand(MIDI_CHANGE_VOL, volume);
 	}
 	
 	// Set the length in seconds that a note is allowed to play for in seconds.
@@ -274,42 +326,51 @@ namespace TFE_MidiPlayer
 
 	void pause()
 	{
-		SDL_LockMutex(s_midiThreadMutex);
-		MidiCmd* midiCmd = midiAllocCmd();
-		if (midiCmd)
-		{
-			midiCmd->cmd = MIDI_PAUSE;
-		}
-		SDL_UnlockMutex(s_midiThreadMutex);
+		pushCommand(MIDI_PAUSE);
 	}
 
 	void resume()
 	{
-		SDL_LockMutex(s_midiThreadMutex);
-		MidiCmd* midiCmd = midiAllocCmd();
-		if (midiCmd)
-		{
-			midiCmd->cmd = MIDI_RESUME;
-		}
-		SDL_UnlockMutex(s_midiThreadMutex);
+		pushCommand(MIDI_RESUME);
 	}
 
 	void stopMidiSound()
 	{
-		SDL_LockMutex(s_midiThreadMutex);
-		MidiCmd* midiCmd = midiAllocCmd();
-		if (midiCmd)
-		{
-			midiCmd->cmd = MIDI_STOP_NOTES;
-		}
-		SDL_UnlockMutex(s_midiThreadMutex);
+		pushCommand(MIDI_STOP_NOTES);
+	}
+
+	// Called when the audio callback cannot take the scheduler locks: the buffer is left silent, but the time is
+	// remembered so the sequencer clock catches up on the next buffer and the tempo does not slip.
+	void skipMidiBuffer(u32 stereoSampleCount)
+	{
+		s_midiSkippedSamples = std::min(s_midiSkippedSamples + stereoSampleCount, u32(MIDI_MAX_CATCHUP_SAMPLES));
+		s_midiSkippedBufferCount++;
 	}
 
 	void synthesizeMidi(f32* buffer, u32 stereoSampleCount, bool updateBuffer)
 	{
+		// Keep the midi thread from taking over while the audio callback is still running, even if this buffer is skipped.
+		if (s_deviceRenders)
+		{
+			s_lastAudioSchedule.store(TFE_System::getCurrentTimeInTicks(), std::memory_order_relaxed);
+		}
+
+		// Render silence rather than wait if the device is being changed or the scheduler is busy elsewhere,
+		// the audio callback should never block on the game thread.
+		if (SDL_TryLockMutex(s_deviceChangeMutex) != 0)
+		{
+			skipMidiBuffer(stereoSampleCount);
+			return;
+		}
+		if (SDL_TryLockMutex(s_midiThreadMutex) != 0)
+		{
+			SDL_UnlockMutex(s_deviceChangeMutex);
+			skipMidiBuffer(stereoSampleCount);
+			return;
+		}
+
 		// In some cases, such as when using the System Midi Device, the midi audio is generated externally so
 		// rendering is not required.
-		SDL_LockMutex(s_deviceChangeMutex);  // Make sure we don't synthesize when the device is being changed.
 		if (s_midiDevice && s_midiDevice->canRender())
 		{
 			// Stereo samples -> actual samples.
@@ -321,8 +382,37 @@ namespace TFE_MidiPlayer
 				s_sampleBufferPtr = s_sampleBuffer.data();
 			}
 
+			// Run the scheduler for this buffer, which fills in s_midiEvents.
+			s_schedulerThread = MIDI_SCHED_AUDIO;
+			s_midiEventCount = 0;
+			s_midiEventOffset = 0;
+			processCommands();
+			if (s_midiSkippedSamples)
+			{
+				// Catch up on skipped buffers first, the late ticks are all applied at the start of this buffer.
+				advanceCallback(f64(s_midiSkippedSamples) / f64(MIDI_SAMPLE_RATE), 0);
+				s_midiSkippedSamples = 0;
+			}
+			advanceCallback(f64(stereoSampleCount) / f64(MIDI_SAMPLE_RATE), stereoSampleCount);
+			s_schedulerThread = MIDI_SCHED_NONE;
+
+			// Render the buffer in segments, applying each event at its sample offset.
 			// The midi device takes the number of stereo samples.
-			s_midiDevice->render(s_sampleBufferPtr, stereoSampleCount);
+			u32 offset = 0;
+			for (u32 e = 0; e < s_midiEventCount; e++)
+			{
+				const MidiEvent* midiEvent = &s_midiEvents[e];
+				if (midiEvent->offset > offset)
+				{
+					s_midiDevice->render(s_sampleBufferPtr + offset * 2, midiEvent->offset - offset);
+					offset = midiEvent->offset;
+				}
+				s_midiDevice->message(midiEvent->msg, midiEvent->len);
+			}
+			if (offset < stereoSampleCount)
+			{
+				s_midiDevice->render(s_sampleBufferPtr + offset * 2, stereoSampleCount - offset);
+			}
 			// Accumulate midi samples with existing audio samples (from soundFX).
 			if (updateBuffer)
 			{
@@ -332,6 +422,7 @@ namespace TFE_MidiPlayer
 				}
 			}
 		}
+		SDL_UnlockMutex(s_midiThreadMutex);
 		SDL_UnlockMutex(s_deviceChangeMutex);
 	}
 
@@ -351,8 +442,9 @@ namespace TFE_MidiPlayer
 		{
 			s_channelSrcVolume[i] = CHANNEL_MAX_VOLUME;
 		}
-		changeVolume();
 		SDL_UnlockMutex(s_midiThreadMutex);
+		// Let the scheduler apply the channel volumes, so the device is only touched from one thread.
+		pushCommand(MIDI_APPLY_VOL);
 	}
 
 	void midiClearCallback()
@@ -413,6 +505,13 @@ namespace TFE_MidiPlayer
 		
 	void sendMessageDirect(u8 type, u8 arg1, u8 arg2)
 	{
+		// Messages sent from the game thread go through the scheduler when the audio callback drives the device.
+		if (s_schedulerThread == MIDI_SCHED_NONE && s_deviceRenders)
+		{
+			pushCommand(MIDI_SEND_MSG, 0.0f, type, arg1, arg2);
+			return;
+		}
+
 		u8 msg[] = { type, arg1, arg2 };
 		u8 msgType = (type & 0xf0);
 		u8 len;
@@ -425,7 +524,24 @@ namespace TFE_MidiPlayer
 			s_channelSrcVolume[channelIndex] = arg2;
 			msg[2] = u8(s_channelSrcVolume[channelIndex] * s_masterVolumeScaled);
 		}
-		if (s_midiDevice) { s_midiDevice->message(msg, len); }
+		if (s_schedulerThread == MIDI_SCHED_AUDIO)
+		{
+			if (s_midiEventCount < MAX_MIDI_EVENTS)
+			{
+				MidiEvent* midiEvent = &s_midiEvents[s_midiEventCount++];
+				midiEvent->offset = s_midiEventOffset;
+				midiEvent->len = len;
+				memcpy(midiEvent->msg, msg, 3);
+			}
+			else
+			{
+				s_midiEventDropCount++;
+			}
+		}
+		else if (s_midiDevice)
+		{
+			s_midiDevice->message(msg, len);
+		}
 
 		// Record currently playing instruments and the note-on times.
 		if (msgType == MID_NOTE_OFF || msgType == MID_NOTE_ON)
@@ -469,70 +585,103 @@ namespace TFE_MidiPlayer
 		}
 	}
 
+	// Apply the commands queued by the game thread, called by the thread running the scheduler.
+	void processCommands()
+	{
+		MidiCmd midiCmd;
+		while (s_midiCommands.pop(&midiCmd))
+		{
+			switch (midiCmd.cmd)
+			{
+				case MIDI_PAUSE:
+				{
+					s_midiPaused = true;
+					stopAllNotes();
+				} break;
+				case MIDI_RESUME:
+				{
+					s_midiPaused = false;
+				} break;
+				case MIDI_CHANGE_VOL:
+				{
+					s_masterVolume = midiCmd.newVolume;
+					s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
+					changeVolume();
+				} break;
+				case MIDI_APPLY_VOL:
+				{
+					changeVolume();
+				} break;
+				case MIDI_STOP_NOTES:
+				{
+					stopAllNotes();
+					// Reset callback time.
+					s_midiCallback.accumulator = 0.0;
+				} break;
+				case MIDI_SEND_MSG:
+				{
+					sendMessageDirect(midiCmd.msg[0], midiCmd.msg[1], midiCmd.msg[2]);
+				} break;
+			}
+		}
+	}
+
+	// Run the midi callback for every tick that falls within the next 'dt' seconds.
+	// When scheduling for the audio callback, 'sampleCount' is the buffer length and messages sent
+	// by each tick are placed at the tick's sample offset.
+	void advanceCallback(f64 dt, u32 sampleCount)
+	{
+		// Process the midi callback, if it exists.
+		if (!s_midiCallback.callback || s_midiPaused) { return; }
+
+		TFE_ZONE("Midi Callback");
+		f64 time = 0.0;
+		while (s_midiCallback.callback && s_midiCallback.accumulator + dt - time >= s_midiCallback.timeStep)
+		{
+			const f64 wait = std::max(0.0, s_midiCallback.timeStep - s_midiCallback.accumulator);
+			time += wait;
+			s_midiCallback.accumulator += wait - s_midiCallback.timeStep;
+			if (sampleCount)
+			{
+				s_midiEventOffset = std::min(u32(time * f64(MIDI_SAMPLE_RATE)), sampleCount - 1);
+			}
+
+			s_midiCallback.callback();
+			s_curNoteTime += s_midiCallback.timeStep;
+		}
+		s_midiCallback.accumulator += dt - time;
+
+		// Check for hanging notes.
+		detectHangingNotes();
+	}
+
 	// Thread Function
+	// The midi thread drives devices that do not render audio, and acts as a fallback when the
+	// audio callback is not running.
 	int midiUpdateFunc(void* userData)
 	{
-		bool runThread  = true;
-		bool wasPlaying = false;
-		bool isPlaying  = false;
-		bool isPaused = false;
-		s32 loopStart = -1;
-		u64 localTime = 0;
+		bool runThread = true;
 		u64 localTimeCallback = 0;
-		f64 dt = 0.0;
+		TFE_THREAD_NAME("Midi");
+		s_schedulerThread = MIDI_SCHED_MIDI;
 		while (runThread)
 		{
-			SDL_LockMutex(s_midiThreadMutex);
-						
-			// Read from the command buffer.
-			MidiCmd* midiCmd = s_midiCmdBuffer;
-			for (u32 i = 0; i < s_midiCmdCount; i++, midiCmd++)
+			const u64 lastAudioSchedule = s_lastAudioSchedule.load(std::memory_order_relaxed);
+			const bool audioDriven = s_deviceRenders && lastAudioSchedule &&
+				TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - lastAudioSchedule) < c_audioSchedulerTimeout;
+			if (audioDriven)
 			{
-				switch (midiCmd->cmd)
-				{
-					case MIDI_PAUSE:
-					{
-						localTimeCallback = 0;
-						isPaused = true;
-						stopAllNotes();
-					} break;
-					case MIDI_RESUME:
-					{
-						isPaused = false;
-					} break;
-					case MIDI_CHANGE_VOL:
-					{
-						s_masterVolume = midiCmd->newVolume;
-						s_masterVolumeScaled = s_masterVolume * c_musicVolumeScale;
-						changeVolume();
-					} break;
-					case MIDI_STOP_NOTES:
-					{
-						stopAllNotes();
-						// Reset callback time.
-						localTimeCallback = 0;
-						s_midiCallback.accumulator = 0.0;
-					} break;
-				}
+				localTimeCallback = 0;
+				SDL_Delay(5);
 			}
-			s_midiCmdCount = 0;
-
-			// Process the midi callback, if it exists.
-			if (s_midiCallback.callback && !isPaused)
+			else
 			{
-				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&localTimeCallback);
-				while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
-				{
-					s_midiCallback.callback();
-					s_midiCallback.accumulator -= s_midiCallback.timeStep;
-					s_curNoteTime += s_midiCallback.timeStep;
-				}
-
-				// Check for hanging notes.
-				detectHangingNotes();
+				SDL_LockMutex(s_midiThreadMutex);
+				processCommands();
+				const f64 dt = TFE_System::updateThreadLocal(&localTimeCallback);
+				advanceCallback(s_midiPaused ? 0.0 : dt, 0);
+				SDL_UnlockMutex(s_midiThreadMutex);
 			}
-
-			SDL_UnlockMutex(s_midiThreadMutex);
 			runThread = s_runMusicThread.load();
 		};
 		
@@ -558,6 +707,12 @@ namespace TFE_MidiPlayer
 		TFE_Console::addToHistory(res);
 	}
 
+	// Called with s_deviceChangeMutex held.
+	void updateDeviceRenders()
+	{
+		s_deviceRenders.store(s_midiDevice && s_midiDevice->canRender());
+	}
+
 	void allocateMidiDevice(MidiDeviceType type)
 	{
 		if (s_midiDevice && s_midiDevice->getType() == type) { return; }
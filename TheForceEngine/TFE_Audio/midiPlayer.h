@@ -16,7 +16,9 @@ namespace TFE_MidiPlayer
 	
 	///////////////////////////////////////////////////////////
 	// Commands
-	//   Commands are queued for processing by the midi thread.
+	//   Commands are queued for processing by the midi scheduler, which
+	//   runs in the audio callback for synthesized devices and on the
+	//   midi thread otherwise.
 	///////////////////////////////////////////////////////////
 		
 	// Change the overall music volume.
@@ -25,7 +27,8 @@ namespace TFE_MidiPlayer
 	void setMaximumNoteLength(f32 dt = 16.0f);
 
 	// Send a direct midi message.
-	// Note: this should be called from the midi thread.
+	// Note: when called from the midi callback the message is applied at the callback's sample
+	// offset, otherwise it is queued for the next audio buffer (synthesized devices).
 	void sendMessageDirect(u8 type, u8 arg1=0, u8 arg2=0);
 
 	// Callback
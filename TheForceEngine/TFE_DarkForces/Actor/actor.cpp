@@ -1,4 +1,5 @@
 #include <cstring>
+#include <vector>
 
 #include "actor.h"
 #include "actorInternal.h"
@@ -25,6 +26,8 @@
 #include <TFE_Jedi/Level/rsector.h>
 #include <TFE_Jedi/Level/rwall.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
+#include <TFE_Jedi/Collision/lineOfSight.h>
 #include <TFE_Jedi/InfSystem/message.h>
 #include <TFE_Jedi/Memory/list.h>
 #include <TFE_Jedi/Memory/allocator.h>
@@ -49,6 +52,8 @@ namespace TFE_DarkForces
 	SoundSourceId s_stormAlertSndSrc[STORM_ALERT_COUNT];
 	SoundSourceId s_agentSndSrc[AGENTSND_COUNT];
 
+	static std::vector<LosRequest> s_visibilityRequests;
+
 	///////////////////////////////////////////
 	// Forward Declarations
 	///////////////////////////////////////////
@@ -1584,22 +1589,29 @@ namespace TFE_DarkForces
 
 	JBool actor_canSeeObject(SecObject* actorObj, SecObject* obj)
 	{
+		// Skip both traces if the object's sector cannot be seen from the actor's sector at all.
+		if (!pvs_isVisible(actorObj->sector, obj->sector))
+		{
+			return JFALSE;
+		}
 		vec3_fixed p0 = { actorObj->posWS.x, actorObj->posWS.y - actorObj->worldHeight, actorObj->posWS.z };
 		vec3_fixed p1 = { obj->posWS.x, obj->posWS.y, obj->posWS.z };
-		if (collision_canHitObject(actorObj->sector, obj->sector, p0, p1, 0))
+		JBool wallHit;
+		if (los_canHitObject(actorObj->sector, obj->sector, p0, p1, 0, &wallHit))
 		{
 			return JTRUE;
 		}
-		if (s_collision_wallHit)
+		if (wallHit)
 		{
 			return JFALSE;
 		}
 
 		vec3_fixed p2 = { obj->posWS.x, obj->posWS.y - obj->worldHeight, obj->posWS.z };
-		return collision_canHitObject(actorObj->sector, obj->sector, p0, p2, 0);
+		return los_canHitObject(actorObj->sector, obj->sector, p0, p2, 0);
 	}
-	   
-	JBool actor_canSeeObjFromDist(SecObject* actorObj, SecObject* obj)
+
+	// Returns the approximate distance to 'obj', adjusted for how hard it is to see.
+	fixed16_16 actor_getVisibilityDist(SecObject* actorObj, SecObject* obj)
 	{
 		fixed16_16 approxDist = distApprox(actorObj->posWS.x, actorObj->posWS.z, obj->posWS.x, obj->posWS.z);
 		// Crouching makes the target harder to see.
@@ -1622,7 +1634,12 @@ namespace TFE_DarkForces
 		{
 			approxDist -= s_baseAtten * 2;
 		}
-
+		return approxDist;
+	}
+	   
+	JBool actor_canSeeObjFromDist(SecObject* actorObj, SecObject* obj)
+	{
+		const fixed16_16 approxDist = actor_getVisibilityDist(actorObj, obj);
 		if (approxDist < FIXED(256))
 		{
 			// Since random() is unsigned, the real visible range is [200, 256) because of the conditional above.
@@ -1635,12 +1652,13 @@ namespace TFE_DarkForces
 		return JFALSE;
 	}
 
-	JBool actor_isObjectVisible(SecObject* actorObj, SecObject* obj, angle14_32 fov, fixed16_16 closeDist)
+	// Returns JTRUE if 'obj' is close to the actor or inside of its field of view.
+	JBool actor_isInViewCone(SecObject* actorObj, SecObject* obj, angle14_32 fov, fixed16_16 closeDist)
 	{
 		fixed16_16 approxDist = distApprox(actorObj->posWS.x, actorObj->posWS.z, obj->posWS.x, obj->posWS.z);
 		if (approxDist <= closeDist)
 		{
-			return actor_canSeeObjFromDist(actorObj, obj);
+			return JTRUE;
 		}
 
 		fixed16_16 dx = obj->posWS.x - actorObj->posWS.x;
@@ -1650,13 +1668,50 @@ namespace TFE_DarkForces
 		angle14_32 angleDiff = getAngleDifference(obj0To1Angle, yaw0);
 		angle14_32 right = fov >> 1;
 		angle14_32 left = -(fov >> 1);
-		if (angleDiff > left && angleDiff < right)
+		return (angleDiff > left && angleDiff < right) ? JTRUE : JFALSE;
+	}
+
+	JBool actor_isObjectVisible(SecObject* actorObj, SecObject* obj, angle14_32 fov, fixed16_16 closeDist)
+	{
+		if (actor_isInViewCone(actorObj, obj, fov, closeDist))
 		{
 			return actor_canSeeObjFromDist(actorObj, obj);
 		}
 		return JFALSE;
 	}
 
+	// Traces the line of sight for every sleeping actor that will look for the player this tick as a single batch.
+	// The checks in actorLogicTaskFunc() still run in order and get the same results, but from the cache.
+	// Only deterministic tests are done here, random() is left for the actual visibility check.
+	// Actors in sectors that cannot see the player's sector are skipped, so they do not take up a batch slot.
+	void actor_queueVisibilityChecks()
+	{
+		if (!s_playerObject || !s_playerObject->sector) { return; }
+
+		s_visibilityRequests.clear();
+		ActorDispatch* dispatch = (ActorDispatch*)allocator_getHead(s_istate.actorDispatch);
+		while (dispatch)
+		{
+			SecObject* obj = dispatch->logic.obj;
+			const u32 flags = dispatch->flags;
+			if ((flags & 1) && (flags & 4) && dispatch->nextTick < s_curTick && obj->sector &&
+				pvs_isVisible(obj->sector, s_playerObject->sector) &&
+				actor_isInViewCone(obj, s_playerObject, dispatch->fov, dispatch->awareRange) &&
+				actor_getVisibilityDist(obj, s_playerObject) < FIXED(256))
+			{
+				LosRequest request;
+				request.sector0 = obj->sector;
+				request.sector1 = s_playerObject->sector;
+				request.p0 = { obj->posWS.x, obj->posWS.y - obj->worldHeight, obj->posWS.z };
+				request.p1 = s_playerObject->posWS;
+				request.exclWallFlags3 = 0;
+				s_visibilityRequests.push_back(request);
+			}
+			dispatch = (ActorDispatch*)allocator_getNext(s_istate.actorDispatch);
+		}
+		los_queryBatch(s_visibilityRequests.data(), (s32)s_visibilityRequests.size());
+	}
+
 	MovementModule* actor_createMovementModule(ActorDispatch* dispatch)
 	{
 		MovementModule* moveMod = (MovementModule*)level_alloc(sizeof(MovementModule));
@@ -2049,6 +2104,8 @@ namespace TFE_DarkForces
 			entity_yield(TASK_NO_DELAY);
 			if (msg == MSG_RUN_TASK)
 			{
+				actor_queueVisibilityChecks();
+
 				ActorDispatch* dispatch = (ActorDispatch*)allocator_getHead(s_istate.actorDispatch);
 				while (dispatch)
 				{
@@ -0,0 +1,508 @@
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include <TFE_Game/igame.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Settings/settings.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_Jedi/Level/level.h>
+#include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/rsector.h>
+#include <TFE_Jedi/Level/rwall.h>
+#include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <TFE_Jedi/Renderer/rdrawKernels.h>
+#include <TFE_Jedi/Renderer/rlimits.h>
+#include <TFE_Jedi/Renderer/virtualFramebuffer.h>
+
+using namespace TFE_Jedi;
+
+namespace TFE_DarkForces
+{
+	enum BenchmarkConstants
+	{
+		BENCH_WARMUP_FRAMES = 10,		// Frames rendered at the start of the path before timing, to warm up caches.
+		BENCH_MAX_WAYPOINTS = 256,
+		BENCH_EYE_HEIGHT = FIXED(6),	// Roughly the player eye height.
+	};
+
+	struct CameraWaypoint
+	{
+		vec3_fixed pos;
+		RSector* sector;
+	};
+
+	struct ZoneStats
+	{
+		std::string name;
+		u32 level;
+		f64 totalTime;
+		f64 maxTime;
+	};
+
+	// Frame times when rendering with a given number of threads, see benchmark_measureScaling().
+	struct ScalingResult
+	{
+		s32 threadCount;
+		f64 meanTime;
+		f64 p99Time;
+	};
+
+	static std::vector<CameraWaypoint> s_benchPath;
+	static std::vector<ScalingResult> s_scaling;
+	static std::vector<ZoneStats> s_zoneStats;
+	static std::map<std::string, size_t> s_zoneStatsMap;
+	static u8 s_benchLightRamp[LIGHT_SOURCE_LEVELS];
+	static u8* s_benchColorMapBase = nullptr;
+	static u8* s_benchColorMap = nullptr;
+	static RSector* s_benchCameraSector = nullptr;
+
+	// Defined in darkForcesMain.cpp and mission.cpp.
+	void buildSearchPaths();
+	bool openGobFiles();
+	u8*  color_loadMap(FilePath* path, u8* lightRamp, u8** basePtr);
+
+	/////////////////////////////////////////////
+	// Camera path
+	/////////////////////////////////////////////
+	// Places the camera at eye height above the floor near the center of the sector, returns false if there is no valid position.
+	bool benchmark_getSectorViewPos(RSector* sector, CameraWaypoint* waypoint)
+	{
+		if (sector->vertexCount <= 0) { return false; }
+
+		fixed16_16 y = sector->floorHeight - BENCH_EYE_HEIGHT;
+		if (y <= sector->ceilingHeight)
+		{
+			y = sector->ceilingHeight + ((sector->floorHeight - sector->ceilingHeight) >> 1);
+		}
+
+		// Try the vertex average first, then the center of the bounds.
+		s64 sumX = 0, sumZ = 0;
+		for (s32 v = 0; v < sector->vertexCount; v++)
+		{
+			sumX += sector->verticesWS[v].x;
+			sumZ += sector->verticesWS[v].z;
+		}
+		const vec2_fixed candidates[] =
+		{
+			{ fixed16_16(sumX / sector->vertexCount), fixed16_16(sumZ / sector->vertexCount) },
+			{ sector->boundsMin.x + ((sector->boundsMax.x - sector->boundsMin.x) >> 1), sector->boundsMin.z + ((sector->boundsMax.z - sector->boundsMin.z) >> 1) },
+		};
+		for (u32 i = 0; i < TFE_ARRAYSIZE(candidates); i++)
+		{
+			if (sector_which3D(candidates[i].x, y, candidates[i].z) == sector)
+			{
+				waypoint->pos = { candidates[i].x, y, candidates[i].z };
+				waypoint->sector = sector;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Builds a deterministic path by walking the sectors depth first through their adjoins.
+	void benchmark_buildPath()
+	{
+		s_benchPath.clear();
+		const u32 sectorCount = s_levelState.sectorCount;
+		if (!sectorCount) { return; }
+
+		std::vector<u8> visited(sectorCount, 0);
+		std::vector<RSector*> stack;
+		for (u32 s = 0; s < sectorCount && s_benchPath.empty(); s++)
+		{
+			stack.push_back(&s_levelState.sectors[s]);
+			while (!stack.empty() && s_benchPath.size() < BENCH_MAX_WAYPOINTS)
+			{
+				RSector* sector = stack.back();
+				stack.pop_back();
+
+				const s32 index = s32(sector - s_levelState.sectors);
+				if (visited[index]) { continue; }
+				visited[index] = 1;
+
+				CameraWaypoint waypoint;
+				if (benchmark_getSectorViewPos(sector, &waypoint))
+				{
+					s_benchPath.push_back(waypoint);
+				}
+
+				// Push in reverse so the first adjoin is visited first.
+				for (s32 w = sector->wallCount - 1; w >= 0; w--)
+				{
+					RSector* next = sector->walls[w].nextSector;
+					if (next && !visited[next - s_levelState.sectors])
+					{
+						stack.push_back(next);
+					}
+				}
+			}
+			stack.clear();
+		}
+	}
+
+	// Moves along the path at a constant rate of waypoints per frame, looking in the direction of travel.
+	void benchmark_setCamera(s32 frame, s32 frameCount)
+	{
+		const s32 segmentCount = s32(s_benchPath.size()) - 1;
+		const CameraWaypoint* start = &s_benchPath[0];
+		const CameraWaypoint* end = start;
+		f32 blend = 0.0f;
+		if (segmentCount > 0)
+		{
+			const f32 t = f32(frame) * f32(segmentCount) / f32(frameCount);
+			const s32 segment = min(s32(t), segmentCount - 1);
+			start = &s_benchPath[segment];
+			end = &s_benchPath[segment + 1];
+			blend = t - f32(segment);
+		}
+
+		vec3_fixed pos;
+		pos.x = start->pos.x + floatToFixed16(fixed16ToFloat(end->pos.x - start->pos.x) * blend);
+		pos.y = start->pos.y + floatToFixed16(fixed16ToFloat(end->pos.y - start->pos.y) * blend);
+		pos.z = start->pos.z + floatToFixed16(fixed16ToFloat(end->pos.z - start->pos.z) * blend);
+
+		// Consecutive waypoints are not always next to each other, snap to the waypoint if the position leaves the level.
+		RSector* sector = sector_which3D(pos.x, pos.y, pos.z);
+		if (!sector)
+		{
+			pos = start->pos;
+			sector = start->sector;
+		}
+
+		angle14_32 yaw = 0;
+		if (end != start)
+		{
+			yaw = vec2ToAngle(end->pos.x - start->pos.x, end->pos.z - start->pos.z);
+		}
+		else
+		{
+			// Single waypoint, spin in place.
+			yaw = (frame * 64) & ANGLE_MASK;
+		}
+
+		renderer_computeCameraTransform(sector, 0, yaw, pos.x, pos.y, pos.z);
+		renderer_setWorldAmbient(0);
+		s_benchCameraSector = sector;
+	}
+
+	/////////////////////////////////////////////
+	// Results
+	/////////////////////////////////////////////
+	// Called after TFE_FRAME_BEGIN(), at which point the profiler exposes the previous frame.
+	void benchmark_accumulateZones()
+	{
+		const u32 zoneCount = TFE_Profiler::getZoneCount();
+		for (u32 i = 0; i < zoneCount; i++)
+		{
+			TFE_ZoneInfo info;
+			TFE_Profiler::getZoneInfo(i, &info);
+
+			std::map<std::string, size_t>::iterator iZone = s_zoneStatsMap.find(info.name);
+			size_t index;
+			if (iZone == s_zoneStatsMap.end())
+			{
+				index = s_zoneStats.size();
+				s_zoneStatsMap[info.name] = index;
+				s_zoneStats.push_back({ info.name, info.level, 0.0, 0.0 });
+			}
+			else
+			{
+				index = iZone->second;
+			}
+			ZoneStats& stats = s_zoneStats[index];
+			stats.totalTime += info.timeInZone;
+			stats.maxTime = std::max(stats.maxTime, info.timeInZone);
+		}
+	}
+
+	// Nearest rank percentile of a sorted list.
+	f64 benchmark_percentile(const std::vector<f64>& sortedTimes, f64 percent)
+	{
+		const size_t count = sortedTimes.size();
+		size_t rank = size_t(ceil(percent * 0.01 * f64(count)));
+		rank = std::max(size_t(1), std::min(rank, count));
+		return sortedTimes[rank - 1];
+	}
+
+	void benchmark_writeJsonString(FileStream* file, const char* str)
+	{
+		char escaped[TFE_MAX_PATH * 2];
+		size_t len = 0;
+		for (; *str && len < sizeof(escaped) - 2; str++)
+		{
+			if (*str == '"' || *str == '\\') { escaped[len++] = '\\'; }
+			escaped[len++] = (*str == '\n' || *str == '\t') ? ' ' : *str;
+		}
+		escaped[len] = 0;
+		file->writeString("\"%s\"", escaped);
+	}
+
+	bool benchmark_writeReport(const BenchmarkParams* params, const std::vector<f64>& frameTimes, u32 width, u32 height)
+	{
+		std::vector<f64> sorted = frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+
+		f64 totalTime = 0.0;
+		for (size_t i = 0; i < frameTimes.size(); i++)
+		{
+			totalTime += frameTimes[i];
+		}
+		const f64 frameCount = f64(frameTimes.size());
+		const f64 meanTime = totalTime / frameCount;
+
+		FileStream file;
+		if (!file.open(params->outputPath, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Benchmark", "Cannot open '%s' for writing.", params->outputPath);
+			return false;
+		}
+
+		// Times are in milliseconds.
+		file.writeString("{\n");
+		file.writeString("  \"version\": ");
+		benchmark_writeJsonString(&file, TFE_System::getVersionString());
+		file.writeString(",\n  \"level\": ");
+		benchmark_writeJsonString(&file, params->levelName);
+		file.writeString(",\n  \"frames\": %d,\n", s32(frameTimes.size()));
+		file.writeString("  \"warmupFrames\": %d,\n", BENCH_WARMUP_FRAMES);
+		file.writeString("  \"waypoints\": %d,\n", s32(s_benchPath.size()));
+		file.writeString("  \"width\": %u,\n  \"height\": %u,\n", width, height);
+		file.writeString("  \"subRenderer\": \"%s\",\n", getSubRenderer() == TSR_CLASSIC_FIXED ? "Classic_Fixed" : "Classic_Float");
+		file.writeString("  \"drawKernels\": \"%s\",\n", drawKernels_getIsaName(drawKernels_getIsa()));
+		file.writeString("  \"workerThreads\": %d,\n", TFE_Jobs::getWorkerCount());
+		file.writeString("  \"totalTime\": %.4f,\n", totalTime * 1000.0);
+		file.writeString("  \"fps\": %.2f,\n", meanTime > 0.0 ? 1.0 / meanTime : 0.0);
+		file.writeString("  \"frameTime\": {\n");
+		file.writeString("    \"min\": %.4f,\n", sorted.front() * 1000.0);
+		file.writeString("    \"mean\": %.4f,\n", meanTime * 1000.0);
+		file.writeString("    \"p50\": %.4f,\n", benchmark_percentile(sorted, 50.0) * 1000.0);
+		file.writeString("    \"p90\": %.4f,\n", benchmark_percentile(sorted, 90.0) * 1000.0);
+		file.writeString("    \"p95\": %.4f,\n", benchmark_percentile(sorted, 95.0) * 1000.0);
+		file.writeString("    \"p99\": %.4f,\n", benchmark_percentile(sorted, 99.0) * 1000.0);
+		file.writeString("    \"max\": %.4f\n", sorted.back() * 1000.0);
+		file.writeString("  },\n");
+		file.writeString("  \"zones\": [");
+		for (size_t i = 0; i < s_zoneStats.size(); i++)
+		{
+			const ZoneStats& stats = s_zoneStats[i];
+			file.writeString(i == 0 ? "\n    { \"name\": " : ",\n    { \"name\": ");
+			benchmark_writeJsonString(&file, stats.name.c_str());
+			file.writeString(", \"level\": %u, \"total\": %.4f, \"mean\": %.4f, \"max\": %.4f, \"fractOfFrame\": %.4f }",
+				stats.level, stats.totalTime * 1000.0, stats.totalTime * 1000.0 / frameCount, stats.maxTime * 1000.0, totalTime > 0.0 ? stats.totalTime / totalTime : 0.0);
+		}
+		file.writeString("\n  ]");
+		if (!s_scaling.empty())
+		{
+			file.writeString(",\n  \"scaling\": [");
+			for (size_t i = 0; i < s_scaling.size(); i++)
+			{
+				const ScalingResult& scaling = s_scaling[i];
+				file.writeString(i == 0 ? "\n    " : ",\n    ");
+				file.writeString("{ \"threads\": %d, \"mean\": %.4f, \"p99\": %.4f, \"speedup\": %.3f }", scaling.threadCount,
+					scaling.meanTime * 1000.0, scaling.p99Time * 1000.0, scaling.meanTime > 0.0 ? s_scaling[0].meanTime / scaling.meanTime : 0.0);
+			}
+			file.writeString("\n  ]");
+		}
+		file.writeString("\n}\n");
+		file.close();
+
+		TFE_System::logWrite(LOG_MSG, "Benchmark", "%s: %d frames at %ux%u, mean %.3f ms, p99 %.3f ms, report written to '%s'.",
+			params->levelName, s32(frameTimes.size()), width, height, meanTime * 1000.0, benchmark_percentile(sorted, 99.0) * 1000.0, params->outputPath);
+		return true;
+	}
+
+	/////////////////////////////////////////////
+	// Rendering
+	/////////////////////////////////////////////
+	// Renders the camera path after a few warm up frames, the zone times are accumulated if 'recordZones' is true.
+	void benchmark_renderPath(s32 frameCount, std::vector<f64>& frameTimes, bool recordZones)
+	{
+		frameTimes.clear();
+		frameTimes.reserve(frameCount);
+
+		bool prevFrameTimed = false;
+		for (s32 f = -BENCH_WARMUP_FRAMES; f < frameCount; f++)
+		{
+			benchmark_setCamera(max(f, 0), frameCount);
+
+			TFE_FRAME_BEGIN();
+			if (prevFrameTimed && recordZones) { benchmark_accumulateZones(); }
+
+			const u64 frameStart = TFE_System::getCurrentTimeInTicks();
+			beginRender();
+			drawWorld(vfb_getCpuBuffer(), s_benchCameraSector, s_benchColorMap, s_benchLightRamp);
+			endRender();
+			vfb_swap();
+			const f64 frameTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - frameStart);
+
+			TFE_FRAME_END();
+			prevFrameTimed = f >= 0;
+			if (prevFrameTimed) { frameTimes.push_back(frameTime); }
+		}
+		if (recordZones)
+		{
+			// Pick up the zones from the last frame.
+			TFE_FRAME_BEGIN();
+			benchmark_accumulateZones();
+			TFE_FRAME_END();
+		}
+	}
+
+	// Renders the path with 1, 2, 4, ... threads up to the size of the job system, using multithreaded rendering
+	// for more than one thread. The job system is restarted with each thread count and restored afterward.
+	void benchmark_measureScaling(s32 frameCount)
+	{
+		TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+		const bool prevMultithreaded = graphics->multithreadedRendering;
+		const s32 prevWorkerCount = TFE_Jobs::getWorkerCount();
+		const s32 maxThreads = prevWorkerCount + 1;
+
+		std::vector<f64> frameTimes;
+		for (s32 threadCount = 1; ; threadCount = min(threadCount * 2, maxThreads))
+		{
+			graphics->multithreadedRendering = threadCount > 1;
+			if (threadCount > 1 && TFE_Jobs::getWorkerCount() != threadCount - 1)
+			{
+				TFE_Jobs::destroy();
+				TFE_Jobs::init(threadCount - 1);
+			}
+			benchmark_renderPath(frameCount, frameTimes, false);
+
+			f64 totalTime = 0.0;
+			for (size_t i = 0; i < frameTimes.size(); i++)
+			{
+				totalTime += frameTimes[i];
+			}
+			std::sort(frameTimes.begin(), frameTimes.end());
+			const ScalingResult scaling = { threadCount, totalTime / f64(frameTimes.size()), benchmark_percentile(frameTimes, 99.0) };
+			s_scaling.push_back(scaling);
+			TFE_System::logWrite(LOG_MSG, "Benchmark", "%d thread(s): mean %.3f ms, p99 %.3f ms, %.2fx the single thread speed.",
+				threadCount, scaling.meanTime * 1000.0, scaling.p99Time * 1000.0, s_scaling[0].meanTime / scaling.meanTime);
+			if (threadCount == maxThreads) { break; }
+		}
+
+		if (TFE_Jobs::getWorkerCount() != prevWorkerCount)
+		{
+			TFE_Jobs::destroy();
+			TFE_Jobs::init(prevWorkerCount);
+		}
+		graphics->multithreadedRendering = prevMultithreaded;
+	}
+
+	/////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////
+	bool benchmark_loadLevel(const char* levelName)
+	{
+		buildSearchPaths();
+		if (!openGobFiles())
+		{
+			return false;
+		}
+
+		bitmap_setAllocator(s_levelRegion);
+		TFE_Settings::setLevelName(levelName);
+		if (!level_loadGeometry(levelName))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Benchmark", "Cannot load level '%s'.", levelName);
+			return false;
+		}
+		setSkyParallax(s_levelState.parallax0, s_levelState.parallax1);
+
+		FilePath filePath;
+		char colormapName[TFE_MAX_PATH];
+		sprintf(colormapName, "%s.CMP", levelName);
+		if (TFE_Paths::getFilePath(colormapName, &filePath) || TFE_Paths::getFilePath("DEFAULT.CMP", &filePath))
+		{
+			s_benchColorMap = color_loadMap(&filePath, s_benchLightRamp, &s_benchColorMapBase);
+		}
+		if (!s_benchColorMap)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Benchmark", "Cannot load the colormap for level '%s'.", levelName);
+			return false;
+		}
+		return true;
+	}
+
+	bool benchmark_run(const BenchmarkParams* params)
+	{
+		if (!params->levelName || params->frameCount <= 0)
+		{
+			return false;
+		}
+		TFE_System::logWrite(LOG_MSG, "Benchmark", "Level: %s, Frames: %d", params->levelName, params->frameCount);
+
+		// Force the software renderer, the settings are restored afterward so they are not written back to disk.
+		TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+		const TFE_Settings_Graphics prevGraphics = *graphics;
+		if (params->width > 0 && params->height > 0)
+		{
+			graphics->gameResolution.x = params->width;
+			graphics->gameResolution.z = params->height;
+		}
+		graphics->widescreen = false;
+		graphics->rendererIndex = RENDERER_SOFTWARE;
+		graphics->colorMode = COLORMODE_8BIT;
+
+		// Render into the CPU framebuffer only.
+		vfb_setHeadless(JTRUE);
+		setupInitCameraAndLights();
+		renderer_init();
+		renderer_setType(RENDERER_SOFTWARE);
+		renderer_setupCameraLight(JFALSE, JFALSE);
+
+		bool result = benchmark_loadLevel(params->levelName);
+		if (result)
+		{
+			benchmark_buildPath();
+			if (s_benchPath.empty())
+			{
+				TFE_System::logWrite(LOG_ERROR, "Benchmark", "Cannot find a valid camera position in level '%s'.", params->levelName);
+				result = false;
+			}
+		}
+
+		if (result)
+		{
+			u32 width, height;
+			vfb_getResolution(&width, &height);
+
+			std::vector<f64> frameTimes;
+			s_zoneStats.clear();
+			s_zoneStatsMap.clear();
+			benchmark_renderPath(params->frameCount, frameTimes, true);
+
+			s_scaling.clear();
+			if (params->measureScaling)
+			{
+				benchmark_measureScaling(params->frameCount);
+			}
+			result = benchmark_writeReport(params, frameTimes, width, height);
+		}
+
+		// Cleanup
+		bitmap_clearAll();
+		level_clearData();
+		TFE_Paths::clearSearchPaths();
+		TFE_Paths::clearLocalArchives();
+		renderer_destroy();
+		vfb_setHeadless(JFALSE);
+		s_benchPath.clear();
+		s_scaling.clear();
+		s_benchColorMap = nullptr;
+		s_benchColorMapBase = nullptr;
+		s_benchCameraSector = nullptr;
+
+		*graphics = prevGraphics;
+		return result;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Dark Forces
+// Headless renderer benchmark.
+//
+// Loads the level geometry, flies a deterministic camera path through
+// the level and renders each frame with the software renderer into
+// an offscreen virtual framebuffer - no window, GPU or audio device is
+// required. Frame time percentiles and per-zone profiler times are
+// written to a JSON report. Optionally the path is rendered again
+// with 1, 2, 4, ... threads to measure how multithreaded rendering
+// scales.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_DarkForces
+{
+	struct BenchmarkParams
+	{
+		const char* levelName;	// Level name without the extension, such as "SECBASE".
+		s32 frameCount;
+		s32 width;				// Render resolution, 0 = use the game resolution from the settings.
+		s32 height;
+		const char* outputPath;	// JSON report path.
+		bool measureScaling;	// Also render the path with an increasing number of threads.
+	};
+
+	// Returns false if the level cannot be loaded or the report cannot be written.
+	bool benchmark_run(const BenchmarkParams* params);
+}
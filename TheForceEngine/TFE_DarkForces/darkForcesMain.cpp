@@ -400,6 +400,16 @@ namespace TFE_DarkForces
 		return s_gamePaused;
 	}
 
+	u32 DarkForces::getTick()
+	{
+		return s_curTick;
+	}
+
+	u32 DarkForces::getRandomSeed()
+	{
+		return random_getSeed();
+	}
+
 	void DarkForces::pauseSound(bool pause)
 	{
 		if (pause) { pauseLevelSound(); }
@@ -540,6 +550,7 @@ namespace TFE_DarkForces
 	void DarkForces::loopGame()
 	{
 		updateTime();
+		ImUpdateQueued();
 				
 		switch (s_runGameState.state)
 		{
@@ -20,6 +20,8 @@ namespace TFE_DarkForces
 		bool serializeGameState(Stream* stream, const char* filename, bool writeState) override;
 		bool canSave() override;
 		bool isPaused() override;
+		u32  getTick() override;
+		u32  getRandomSeed() override;
 		void getLevelName(char* name) override;
 		void getModList(char* modList) override;
 	};
@@ -0,0 +1,188 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "hdTextureConvert.h"
+#include <TFE_Archive/archive.h>
+#include <TFE_Asset/hdTextureAsset.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/system.h>
+
+using namespace TFE_Jedi;
+
+namespace TFE_DarkForces
+{
+	enum
+	{
+		HD_RAW_SCALE_FACTOR = 2,	// All .raw textures are twice the resolution of the base texture.
+	};
+
+	enum ConvertResult
+	{
+		CONVERT_OK = 0,
+		CONVERT_READ_FAILED,
+		CONVERT_SIZE_MISMATCH,
+		CONVERT_WRITE_FAILED,
+	};
+
+	struct HdConvertJob
+	{
+		std::string srcPath;
+		std::string dstPath;
+		s32 width;
+		s32 height;
+		s32 frameCount;
+		// Results
+		ConvertResult result;
+		size_t srcSize;
+		size_t dstSize;
+	};
+
+	// Defined in darkForcesMain.cpp
+	void buildSearchPaths();
+	bool openGobFiles();
+
+	// Reads the base texture to get the HD frame size and count.
+	bool hdTexture_getBaseSize(const char* rawName, std::vector<u8>& buffer, HdConvertJob* job)
+	{
+		char bmName[TFE_MAX_PATH];
+		FileUtil::replaceExtension(rawName, "BM", bmName);
+
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(bmName, &filePath))
+		{
+			return false;
+		}
+		size_t size = 0;
+		const u8* data = Archive::readFileView(&filePath, buffer, &size);
+		TextureData* texture = data ? bitmap_decode(data, size, 1) : nullptr;
+		if (!texture)
+		{
+			return false;
+		}
+
+		bitmap_getHDSize(texture, HD_RAW_SCALE_FACTOR, &job->width, &job->height, &job->frameCount);
+		bitmap_freeDecoded(texture);
+		return true;
+	}
+
+	// Runs on the job system, so errors are only recorded and logged afterward.
+	void hdTexture_convertJob(s32 index, void* userData)
+	{
+		HdConvertJob* job = &((HdConvertJob*)userData)[index];
+		job->result = CONVERT_READ_FAILED;
+
+		std::vector<u8> rawData;
+		FileStream file;
+		if (!file.open(job->srcPath.c_str(), Stream::MODE_READ))
+		{
+			return;
+		}
+		job->srcSize = file.getSize();
+		rawData.resize(job->srcSize);
+		file.readBuffer(rawData.data(), (u32)job->srcSize);
+		file.close();
+
+		std::vector<u8> output;
+		if (!TFE_HdTexture::convertRaw(rawData.data(), rawData.size(), job->width, job->height, job->frameCount, HD_RAW_SCALE_FACTOR, output))
+		{
+			job->result = CONVERT_SIZE_MISMATCH;
+			return;
+		}
+
+		if (!file.open(job->dstPath.c_str(), Stream::MODE_WRITE))
+		{
+			job->result = CONVERT_WRITE_FAILED;
+			return;
+		}
+		file.writeBuffer(output.data(), (u32)output.size());
+		file.close();
+
+		job->dstSize = output.size();
+		job->result = CONVERT_OK;
+	}
+
+	bool hdTexture_convertDirectory(const char* srcDir, const char* dstDir)
+	{
+		char srcPath[TFE_MAX_PATH], dstPath[TFE_MAX_PATH];
+		strcpy(srcPath, srcDir);
+		strcpy(dstPath, dstDir);
+		TFE_Paths::fixupPathAsDirectory(srcPath);
+		TFE_Paths::fixupPathAsDirectory(dstPath);
+		if (!FileUtil::directoryExits(dstPath))
+		{
+			FileUtil::makeDirectory(dstPath);
+		}
+
+		buildSearchPaths();
+		if (!openGobFiles())
+		{
+			TFE_System::logWrite(LOG_ERROR, "HdConvert", "Cannot open the game data, which is required to size the HD textures.");
+			return false;
+		}
+
+		FileList rawFiles;
+		FileUtil::readDirectory(srcPath, "raw", rawFiles);
+
+		// Gather the texture sizes on the main thread, since archive reads are not thread safe.
+		std::vector<HdConvertJob> jobs;
+		std::vector<u8> buffer;
+		bool result = true;
+		const size_t fileCount = rawFiles.size();
+		for (size_t i = 0; i < fileCount; i++)
+		{
+			const char* rawName = rawFiles[i].c_str();
+			HdConvertJob job = {};
+			if (!hdTexture_getBaseSize(rawName, buffer, &job))
+			{
+				TFE_System::logWrite(LOG_WARNING, "HdConvert", "Skipping '%s', cannot find or read the base texture.", rawName);
+				result = false;
+				continue;
+			}
+
+			char hdtName[TFE_MAX_PATH];
+			FileUtil::replaceExtension(rawName, "hdt", hdtName);
+			job.srcPath = std::string(srcPath) + rawName;
+			job.dstPath = std::string(dstPath) + hdtName;
+			jobs.push_back(job);
+		}
+
+		TFE_Jobs::parallelFor((s32)jobs.size(), hdTexture_convertJob, jobs.data());
+
+		size_t totalSrcSize = 0, totalDstSize = 0;
+		s32 convertCount = 0;
+		const HdConvertJob* job = jobs.data();
+		for (size_t i = 0; i < jobs.size(); i++, job++)
+		{
+			switch (job->result)
+			{
+				case CONVERT_OK:
+					totalSrcSize += job->srcSize;
+					totalDstSize += job->dstSize;
+					convertCount++;
+					break;
+				case CONVERT_READ_FAILED:
+					TFE_System::logWrite(LOG_ERROR, "HdConvert", "Cannot read '%s'.", job->srcPath.c_str());
+					break;
+				case CONVERT_SIZE_MISMATCH:
+					TFE_System::logWrite(LOG_ERROR, "HdConvert", "'%s' does not match the base texture size %dx%d (%d frames).",
+						job->srcPath.c_str(), job->width, job->height, job->frameCount);
+					break;
+				case CONVERT_WRITE_FAILED:
+					TFE_System::logWrite(LOG_ERROR, "HdConvert", "Cannot write '%s'.", job->dstPath.c_str());
+					break;
+			}
+			result &= (job->result == CONVERT_OK);
+		}
+		TFE_System::logWrite(LOG_MSG, "HdConvert", "Converted %d of %d HD textures, %u KB -> %u KB.", convertCount, (s32)fileCount,
+			u32(totalSrcSize >> 10), u32(totalDstSize >> 10));
+
+		TFE_Paths::clearSearchPaths();
+		TFE_Paths::clearLocalArchives();
+		return result;
+	}
+}
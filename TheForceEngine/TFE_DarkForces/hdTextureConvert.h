@@ -0,0 +1,17 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Dark Forces
+// Converts HD texture packs from raw RGBA .raw files to packed .hdt
+// containers (see TFE_Asset/hdTextureAsset.h).
+//
+// The .raw files do not store their dimensions, so the matching base
+// .BM textures are read from the game data to size each file.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_DarkForces
+{
+	// Converts every .raw file in 'srcDir' and writes the .hdt files to 'dstDir'.
+	// Returns false if the game data cannot be opened or any file fails to convert.
+	bool hdTexture_convertDirectory(const char* srcDir, const char* dstDir);
+}
@@ -23,6 +23,7 @@
 #include <TFE_Jedi/Level/rtexture.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Renderer/jediRenderer.h>
@@ -450,6 +451,8 @@ namespace TFE_DarkForces
 			}
 			else // Loading from save.
 			{
+				// The INF state is restored at this point, so the visibility sets can be built.
+				pvs_build(agent_getLevelName());
 				s_missionMode = MISSION_MODE_MAIN;
 				mission_createRenderDisplay();
 				hud_startup(JTRUE);
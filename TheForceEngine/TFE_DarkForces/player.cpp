@@ -19,6 +19,8 @@
 #include <TFE_DarkForces/mission.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/sectorGrid.h>
+#include <TFE_Jedi/Level/stateHash.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Serialization/serialization.h>
@@ -282,6 +284,7 @@ namespace TFE_DarkForces
 	// TFE
 	void player_warp(const ConsoleArgList& args);
 	void player_sector(const ConsoleArgList& args);
+	void player_sectorBench(const ConsoleArgList& args);
 		
 	///////////////////////////////////////////
 	// API Implentation
@@ -317,6 +320,7 @@ namespace TFE_DarkForces
 
 		CCMD("warp", player_warp, 3, "Warp to the specific x, y, z position.");
 		CCMD_NOREPEAT("sector", player_sector, 0, "Get the current sector ID.");
+		CCMD("sectorBench", player_sectorBench, 0, "sectorBench [queryCount] - compare sector_which3D() with and without the sector grid.");
 
 		initPlayerCollision();
 	}
@@ -2165,6 +2169,7 @@ namespace TFE_DarkForces
 
 				// Remove the flag so the secret isn't counted twice.
 				newSector->flags1 &= ~SEC_FLAGS1_SECRET;
+				stateHash_sectorChanged(newSector);
 				s_secretsFound++;
 				level_updateSecretPercent();
 			}
@@ -3050,6 +3055,23 @@ namespace TFE_DarkForces
 			TFE_Console::addToHistory("Invalid sector");
 		}
 	}
+
+	void player_sectorBench(const ConsoleArgList& args)
+	{
+		s32 queryCount = 100000;
+		if (args.size() >= 2)
+		{
+			queryCount = max(1, s32(TFE_Console::getFloatArg(args[1])));
+		}
+
+		f64 linearTimeMs, gridTimeMs;
+		const s32 mismatchCount = sectorGrid_benchmark(queryCount, &linearTimeMs, &gridTimeMs);
+
+		char resultStr[256];
+		sprintf(resultStr, "%d queries, %u sectors: linear %.2fms, grid %.2fms, %d mismatches.", queryCount, s_levelState.sectorCount, linearTimeMs, gridTimeMs, mismatchCount);
+		TFE_Console::addToHistory(resultStr);
+		TFE_System::logWrite(LOG_MSG, "Sector", "%s", resultStr);
+	}
 		
 	// Serialization
 	void playerLogic_serialize(Logic*& logic, SecObject* obj, Stream* stream)
@@ -5,6 +5,7 @@
 #include "levelEditorData.h"
 #include "levelEditorHistory.h"
 #include "sharedState.h"
+#include "sectorBvh.h"
 #include <TFE_Editor/LevelEditor/Rendering/viewport.h>
 #include <TFE_Editor/LevelEditor/Rendering/grid.h>
 #include <TFE_System/math.h>
@@ -24,6 +25,7 @@ namespace LevelEditor
 {
 	static Vec3f s_moveBasePos3d = { 0 };
 	static Vec3f s_moveStartPos3d = { 0 };
+	static std::vector<s32> s_sectorQuery;
 
 	bool pointInsideOBB2d(const Vec2f pt, const Vec3f* bounds, const Vec3f* pos, const Mat3* mtx)
 	{
@@ -50,6 +52,7 @@ namespace LevelEditor
 		obj.transform.m1.y = 1.0f;
 		obj.transform.m2.z = 1.0f;
 		sector->obj.push_back(obj);
+		sectorBvh_markDirty(sector);
 	}
 	
 	void findHoveredEntity2d(Vec2f worldPos)
@@ -168,10 +171,11 @@ namespace LevelEditor
 				{ std::max(worldPos[0].x, worldPos[1].x), 0.0f, std::max(worldPos[0].z, worldPos[1].z) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryBox2d(aabb, 0.0f, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 				if (!aabbOverlap2d(sector->bounds, aabb)) { continue; }
 
@@ -259,13 +263,13 @@ namespace LevelEditor
 				{ bot.x, bot.y, bot.z, -TFE_Math::dot(&bot, &s_camera.pos) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryFrustum(plane, 6, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-				// For now, do them all...
 				const size_t objCount = sector->obj.size();
 				const EditorObject* obj = sector->obj.data();
 				for (size_t v = 0; v < objCount; v++, obj++)
@@ -303,6 +307,7 @@ namespace LevelEditor
 			obj->pos.x += delta.x;
 			obj->pos.y += delta.y;
 			obj->pos.z += delta.z;
+			sectorBvh_markDirty(sector);
 		}
 	}
 
@@ -341,6 +346,7 @@ namespace LevelEditor
 					{
 						obj->pos.y = sector->floorHeight;
 					}
+					sectorBvh_markDirty(sector);
 					if (sector->searchKey != s_searchKey)
 					{
 						s_idList.push_back(sector->id);
@@ -371,6 +377,7 @@ namespace LevelEditor
 					{
 						obj->pos.y = sector->ceilHeight;
 					}
+					sectorBvh_markDirty(sector);
 					if (sector->searchKey != s_searchKey)
 					{
 						s_idList.push_back(sector->id);
@@ -597,6 +604,7 @@ namespace LevelEditor
 					obj = &curObjSector->obj[curObjIndex];
 					obj->pos.y = max(curObjSector->floorHeight, obj->pos.y);
 					obj->pos.y = min(curObjSector->ceilHeight, obj->pos.y);
+					sectorBvh_markDirty(curObjSector);
 				}
 			}
 			else
@@ -13,6 +13,7 @@
 #include "sharedState.h"
 #include "selection.h"
 #include "guidelines.h"
+#include "sectorBvh.h"
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Editor/errorMessages.h>
@@ -33,6 +34,8 @@ using namespace TFE_Jedi;
 
 namespace LevelEditor
 {
+	static std::vector<s32> s_sectorQuery;
+
 	////////////////////////////////////////
 	// API
 	////////////////////////////////////////
@@ -63,10 +66,11 @@ namespace LevelEditor
 				{ std::max(worldPos[0].x, worldPos[1].x), 0.0f, std::max(worldPos[0].z, worldPos[1].z) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryBox2d(aabb, 0.0f, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 				if (!aabbOverlap2d(sector->bounds, aabb)) { continue; }
 
@@ -150,13 +154,13 @@ namespace LevelEditor
 				{ bot.x, bot.y, bot.z, -TFE_Math::dot(&bot, &s_camera.pos) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryFrustum(plane, 6, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-				// For now, do them all...
 				const size_t vertexCount = sector->vtx.size();
 				const Vec2f* vtx = sector->vtx.data();
 				bool inside = true;
@@ -210,6 +214,7 @@ namespace LevelEditor
 				obj->pos.y += delta.y;
 				obj->pos.z += delta.z;
 			}
+			sectorBvh_markDirty(sector);
 		}
 	}
 }
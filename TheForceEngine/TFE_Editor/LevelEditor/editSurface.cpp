@@ -13,6 +13,7 @@
 #include "sharedState.h"
 #include "selection.h"
 #include "guidelines.h"
+#include "sectorBvh.h"
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Editor/errorMessages.h>
@@ -35,6 +36,7 @@ namespace LevelEditor
 {
 	extern SelectionList s_featureList;
 	static Vec2f s_copiedTextureOffset = { 0 };
+	static std::vector<s32> s_sectorQuery;
 
 	void snapSignToCursor(EditorSector* sector, EditorWall* wall, s32 signTexIndex, Vec2f* signOffset);
 	void splitWall(EditorSector* sector, s32 wallIndex, Vec2f newPos, EditorWall* outWalls[]);
@@ -288,10 +290,11 @@ namespace LevelEditor
 				{ std::max(worldPos[0].x, worldPos[1].x), 0.0f, std::max(worldPos[0].z, worldPos[1].z) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryBox2d(aabb, 0.0f, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 				if (!aabbOverlap2d(sector->bounds, aabb)) { continue; }
 
@@ -384,13 +387,13 @@ namespace LevelEditor
 				{ bot.x, bot.y, bot.z, -TFE_Math::dot(&bot, &s_camera.pos) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryFrustum(plane, 6, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-				// For now, do them all...
 				const size_t wallCount = sector->walls.size();
 				const EditorWall* wall = sector->walls.data();
 				const Vec2f* vtx = sector->vtx.data();
@@ -7,6 +7,7 @@
 #include "levelEditorHistory.h"
 #include "editVertex.h"
 #include "sharedState.h"
+#include "sectorBvh.h"
 #include <TFE_Editor/LevelEditor/Rendering/grid.h>
 #include <TFE_Editor/LevelEditor/Rendering/gizmo.h>
 #include <TFE_System/math.h>
@@ -1180,6 +1181,7 @@ namespace LevelEditor
 				}
 			}
 			srcData += objCount;
+			sectorBvh_markDirty(sector);
 		}
 	}
 
@@ -1313,6 +1315,7 @@ namespace LevelEditor
 		s32 newIndex = (s32)newSector->obj.size();
 		selection_entity(SA_ADD, newSector, newIndex);
 		newSector->obj.push_back(objCopy);
+		sectorBvh_markDirty(newSector);
 
 		if (newSector->searchKey != s_searchKey)
 		{
@@ -12,6 +12,7 @@
 #include "sharedState.h"
 #include "selection.h"
 #include "guidelines.h"
+#include "sectorBvh.h"
 #include <TFE_System/math.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Editor/errorMessages.h>
@@ -40,6 +41,7 @@ namespace LevelEditor
 	static std::vector<VertexWallGroup> s_vertexWallGroups;
 	static std::vector<EditorSector> s_sectorSnapshot;
 	static std::vector<s32> s_deltaSectors;
+	static std::vector<s32> s_sectorQuery;
 
 	void findHoveredVertexOutside(Vec3f pos, f32 maxDist, bool use3dCheck);
 	void selectVerticesToDelete(EditorSector* root, s32 featureIndex, const Vec2f* rootVtx);
@@ -315,10 +317,11 @@ namespace LevelEditor
 				{ std::max(worldPos[0].x, worldPos[1].x), 0.0f, std::max(worldPos[0].z, worldPos[1].z) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryBox2d(aabb, 0.0f, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 				if (!aabbOverlap2d(sector->bounds, aabb)) { continue; }
 
@@ -406,13 +409,13 @@ namespace LevelEditor
 				{ bot.x, bot.y, bot.z, -TFE_Math::dot(&bot, &s_camera.pos) }
 			};
 
-			const size_t sectorCount = s_level.sectors.size();
-			EditorSector* sector = s_level.sectors.data();
-			for (size_t s = 0; s < sectorCount; s++, sector++)
+			sectorBvh_queryFrustum(plane, 6, s_sectorQuery);
+			const size_t sectorCount = s_sectorQuery.size();
+			for (size_t s = 0; s < sectorCount; s++)
 			{
+				EditorSector* sector = &s_level.sectors[s_sectorQuery[s]];
 				if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-				// For now, do them all...
 				const size_t vtxCount = sector->vtx.size();
 				const Vec2f* vtx = sector->vtx.data();
 				for (size_t v = 0; v < vtxCount; v++, vtx++)
@@ -693,6 +696,7 @@ namespace LevelEditor
 			// Get the ID and then erase it from the level.
 			s32 delId = sector->id;
 			s_level.sectors.erase(s_level.sectors.begin() + delId);
+			sectorBvh_invalidate();
 
 			// Update Sector IDs
 			const s32 levSectorCount = (s32)s_level.sectors.size();
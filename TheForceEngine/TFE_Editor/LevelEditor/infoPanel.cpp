@@ -10,6 +10,7 @@
 #include "groups.h"
 #include "sharedState.h"
 #include "selection.h"
+#include "sectorBvh.h"
 #include <TFE_Input/input.h>
 #include <TFE_Editor/editor.h>
 #include <TFE_Editor/errorMessages.h>
@@ -1157,6 +1158,12 @@ namespace LevelEditor
 			{
 				sector->ceilHeight = s_sectorChanges.ceilHeight;
 			}
+			if (s_sectorChanges.changes & (SCF_FLOOR_HEIGHT | SCF_CEIL_HEIGHT))
+			{
+				sector->bounds[0].y = std::min(sector->floorHeight, sector->ceilHeight);
+				sector->bounds[1].y = std::max(sector->floorHeight, sector->ceilHeight);
+				sectorBvh_markDirty(sector);
+			}
 			if (s_sectorChanges.changes & SCF_FLAG1_SET)
 			{
 				sector->flags[0] = s_sectorChanges.flags1_set;
@@ -1645,7 +1652,7 @@ namespace LevelEditor
 
 			// Heights
 			infoLabel("##FloorHeightLabel", "Floor", 42);
-			changed |= infoFloatInput("##FloorHeight", 64 + 8, &sector->floorHeight);
+			bool heightChanged = infoFloatInput("##FloorHeight", 64 + 8, &sector->floorHeight);
 			ImGui::SameLine();
 
 			infoLabel("##SecondHeightLabel", "Second", 52);
@@ -1653,7 +1660,14 @@ namespace LevelEditor
 			ImGui::SameLine();
 
 			infoLabel("##CeilHeightLabel", "Ceiling", 60);
-			changed |= infoFloatInput("##CeilHeight", 64, &sector->ceilHeight);
+			heightChanged |= infoFloatInput("##CeilHeight", 64, &sector->ceilHeight);
+			if (heightChanged)
+			{
+				sector->bounds[0].y = std::min(sector->floorHeight, sector->ceilHeight);
+				sector->bounds[1].y = std::max(sector->floorHeight, sector->ceilHeight);
+				sectorBvh_markDirty(sector);
+				changed = true;
+			}
 
 			ImGui::Separator();
 
@@ -2207,7 +2221,10 @@ namespace LevelEditor
 			ImGui::Separator();
 
 			ImGui::Text("%s", "Position"); ImGui::SameLine(0.0f, 8.0f);
-			ImGui::InputFloat3("##Position", &obj->pos.x);
+			if (ImGui::InputFloat3("##Position", &obj->pos.x))
+			{
+				sectorBvh_markDirty(sector);
+			}
 
 			bool orientAdjusted = false;
 			ImGui::Text("%s", "Angle"); ImGui::SameLine(0.0f, 32.0f);
@@ -23,6 +23,7 @@
 #include "editNotes.h"
 #include "editTransforms.h"
 #include "userPreferences.h"
+#include "sectorBvh.h"
 #include <TFE_FrontEndUI/frontEndUi.h>
 #include <TFE_Editor/AssetBrowser/assetBrowser.h>
 #include <TFE_Asset/imageAsset.h>
@@ -109,6 +110,7 @@ namespace LevelEditor
 	// Search
 	u32 s_searchKey = 0;
 	static std::vector<EditorSector*> s_sortedHoverSectors;
+	static std::vector<s32> s_hoverQuery;
 
 	bool s_editMove = false;
 	static SectorList s_workList;
@@ -353,6 +355,7 @@ namespace LevelEditor
 		s_levelNoteIcon = nullptr;
 
 		levHistory_destroy();
+		sectorBvh_destroy();
 		browserFreeIcons();
 	}
 			
@@ -371,11 +374,13 @@ namespace LevelEditor
 
 	EditorSector* findHoverSector2d(Vec2f pos)
 	{
-		const size_t sectorCount = s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
+		const Vec3f ptBounds[] = { { pos.x, 0.0f, pos.z }, { pos.x, 0.0f, pos.z } };
+		sectorBvh_queryBox2d(ptBounds, 0.001f, s_hoverQuery);
+		const size_t sectorCount = s_hoverQuery.size();
 		s_sortedHoverSectors.clear();
-		for (size_t s = 0; s < sectorCount; s++, sector++)
+		for (size_t s = 0; s < sectorCount; s++)
 		{
+			EditorSector* sector = &s_level.sectors[s_hoverQuery[s]];
 			if (isPointInsideSector2d(sector, pos))
 			{
 				// Gather all of the potentially selected sectors in a list.
@@ -490,6 +495,7 @@ namespace LevelEditor
 
 		// Then erase the sector.
 		s_level.sectors.erase(s_level.sectors.begin() + sectorId);
+		sectorBvh_invalidate();
 
 		// Finally fix-up any references.
 		sectorCount = (s32)s_level.sectors.size();
@@ -1124,6 +1130,7 @@ namespace LevelEditor
 		if (sector && index >= 0 && index < (s32)sector->obj.size())
 		{
 			sector->obj.erase(sector->obj.begin() + index);
+			sectorBvh_markDirty(sector);
 			clearEntityChanges();
 		}
 	}
@@ -2613,6 +2620,7 @@ namespace LevelEditor
 			EditorSector* sector = sectorList[i];
 			sector->bounds[0].y = std::min(sector->floorHeight, sector->ceilHeight);
 			sector->bounds[1].y = std::max(sector->floorHeight, sector->ceilHeight);
+			sectorBvh_markDirty(sector);
 		}
 	}
 	
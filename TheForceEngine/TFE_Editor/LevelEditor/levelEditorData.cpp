@@ -7,6 +7,7 @@
 #include "shell.h"
 #include "levelEditorInf.h"
 #include "sharedState.h"
+#include "sectorBvh.h"
 #include <TFE_Editor/snapshotReaderWriter.h>
 #include <TFE_Editor/history.h>
 #include <TFE_Editor/errorMessages.h>
@@ -91,6 +92,7 @@ namespace LevelEditor
 
 	static s32 s_curSnapshotId = -1;
 	static EditorLevel s_curSnapshot;
+	static std::vector<s32> s_sectorQuery;
 
 	EditorLevel s_level = {};
 
@@ -830,6 +832,7 @@ namespace LevelEditor
 		}
 		loadLevelObjFromAsset(asset);
 		loadLevelInfFromAsset(asset);
+		sectorBvh_invalidate();
 
 		return true;
 	}
@@ -1953,6 +1956,7 @@ namespace LevelEditor
 		sector->bounds[1] = { poly.bounds[1].x, 0.0f, poly.bounds[1].z };
 		sector->bounds[0].y = min(sector->floorHeight, sector->ceilHeight);
 		sector->bounds[1].y = max(sector->floorHeight, sector->ceilHeight);
+		sectorBvh_markDirty(sector);
 	}
 
 	// Update the sector itself from the sector's polygon.
@@ -2234,8 +2238,6 @@ namespace LevelEditor
 	{
 		EditorLevel* level = &s_level;
 		if (level->sectors.empty()) { return false; }
-		const s32 sectorCount = (s32)level->sectors.size();
-		EditorSector* sector = level->sectors.data();
 
 		f32 maxDist  = ray->maxDist;
 		Vec3f origin = ray->origin;
@@ -2251,14 +2253,15 @@ namespace LevelEditor
 		hitInfo->hitPos = { 0 };
 		hitInfo->dist = FLT_MAX;
 
-		// Loop through sectors in the world.
-		for (s32 s = 0; s < sectorCount; s++, sector++)
+		// Loop through the sectors whose bounds overlap the ray in XZ - walls are hit in XZ and flats inside of the polygon,
+		// so this does not skip any hits.
+		sectorBvh_querySegment2d(p0xz, p1xz, 0.01f, s_sectorQuery);
+		const s32 sectorCount = (s32)s_sectorQuery.size();
+		for (s32 i = 0; i < sectorCount; i++)
 		{
+			EditorSector* sector = &level->sectors[s_sectorQuery[i]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-			// Check the bounds.
-			//if (!rayHitAABB(ray, sector->bounds)) { continue; }
-
 			// Now check against the walls.
 			const u32 wallCount = (u32)sector->walls.size();
 			const EditorWall* wall = sector->walls.data();
@@ -2621,16 +2624,17 @@ namespace LevelEditor
 		return closestId;
 	}
 
-	// TODO: Spatial data structure to handle cases where there are 10k, 100k, etc. sectors.
 	bool getOverlappingSectorsPt(const Vec3f* pos, SectorList* result, f32 padding)
 	{
 		if (!pos || !result) { return false; }
 
 		result->clear();
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		const Vec3f ptBounds[] = { *pos, *pos };
+		sectorBvh_queryBox(ptBounds, padding, s_sectorQuery);
+		const s32 count = (s32)s_sectorQuery.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_sectorQuery[i]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 			// The position has to be within the bounds of the sector.
 			// TODO: Increase the bounds range?
@@ -2653,10 +2657,11 @@ namespace LevelEditor
 
 		result->clear();
 		const f32 padding = 0.1f;
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		sectorBvh_queryBox(bounds, padding, s_sectorQuery);
+		const s32 count = (s32)s_sectorQuery.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_sectorQuery[i]];
 			if (boundsOverlap3D(sector->bounds, bounds, padding)) // Add padding for sectors that are just touching.
 			{
 				result->push_back(sector);
@@ -2755,6 +2760,8 @@ namespace LevelEditor
 			assert(obj->entityId < (s32)entityCount);
 			obj->entityId = remapTableEntity[obj->entityId];
 		}
+		// Objects outside of the sector footprint extend its BVH bounds.
+		sectorBvh_markDirty(&s_level.sectors[sectorId]);
 	}
 
 	bool levelTextureEq(const LevelTexture& a, const LevelTexture& b)
@@ -3249,11 +3256,28 @@ namespace LevelEditor
 			for (s32 i = 0; i < 3; i++) { sector->flags[i] = attrib.flags[i]; }
 			sector->bounds[0].y = std::min(sector->floorHeight, sector->ceilHeight);
 			sector->bounds[1].y = std::max(sector->floorHeight, sector->ceilHeight);
+			sectorBvh_markDirty(sector);
 			sector->floorTex = attrib.floorTex;
 			sector->ceilTex = attrib.ceilTex;
 		}
 	}
 		
+	// Level snapshots are split into chunks so unchanged sectors and entities are shared
+	// between history snapshots, and only changed chunks are read back when unpacking.
+	enum LevelSnapshotChunk
+	{
+		LSC_HEADER = 0,		// Groups, level info and counts.
+		LSC_TEXTURES,
+		LSC_NOTES,
+		LSC_GUIDELINES,
+		LSC_SECTORS,		// One chunk per sector, followed by one chunk per entity.
+	};
+
+	// Chunk keys of the data held in s_curSnapshot.
+	static u64 s_curTexturesKey = 0;
+	static std::vector<u64> s_curSectorKeys;
+	static std::vector<u64> s_curEntityKeys;
+
 	void level_createSnapshot(SnapshotBuffer* buffer)
 	{
 		assert(buffer);
@@ -3281,6 +3305,7 @@ namespace LevelEditor
 		writeU32(entityCount);
 		writeU32(levelNoteCount);
 		writeU32(guidelineCount);
+		history_endSnapshotChunk();
 		
 		// Textures.
 		const LevelTextureAsset* texture = s_level.textures.data();
@@ -3288,12 +3313,30 @@ namespace LevelEditor
 		{
 			writeString(texture->name);
 		}
+		history_endSnapshotChunk();
+
+		// Level Notes.
+		const LevelNote* note = s_level.notes.data();
+		for (u32 n = 0; n < levelNoteCount; n++, note++)
+		{
+			writeLevelNoteToSnapshot(note);
+		}
+		history_endSnapshotChunk();
+
+		// Guidelines.
+		const Guideline* guideline = s_level.guidelines.data();
+		for (u32 g = 0; g < guidelineCount; g++, guideline++)
+		{
+			writeGuidelineToSnapshot(guideline);
+		}
+		history_endSnapshotChunk();
 
 		// Sectors.
 		const EditorSector* sector = s_level.sectors.data();
 		for (u32 s = 0; s < sectorCount; s++, sector++)
 		{
 			writeSectorToSnapshot(sector);
+			history_endSnapshotChunk();
 		}
 
 		// Entities.
@@ -3301,37 +3344,40 @@ namespace LevelEditor
 		for (u32 e = 0; e < entityCount; e++, entity++)
 		{
 			writeEntityToSnapshot(entity);
+			history_endSnapshotChunk();
 		}
+	}
 
-		// Level Notes.
-		const LevelNote* note = s_level.notes.data();
-		for (u32 n = 0; n < levelNoteCount; n++, note++)
-		{
-			writeLevelNoteToSnapshot(note);
-		}
-
-		// Guidelines.
-		const Guideline* guideline = s_level.guidelines.data();
-		for (u32 g = 0; g < guidelineCount; g++, guideline++)
+	bool level_readSnapshotChunk(u32 index)
+	{
+		u32 size = 0;
+		const u8* data = history_getSnapshotChunkData(index, &size);
+		if (!data)
 		{
-			writeGuidelineToSnapshot(guideline);
+			LE_ERROR("Snapshot decompression failed.");
+			return false;
 		}
+		setSnapshotReadBuffer(data, size);
+		return true;
 	}
 
-	void level_unpackSnapshot(s32 id, u32 size, void* data)
+	void level_unpackSnapshot(s32 id, u32 chunkCount)
 	{
 		// Clear the current snapshot ID.
 		if (id < 0)
 		{
 			s_curSnapshotId = -1;
+			s_curTexturesKey = 0;
+			s_curSectorKeys.clear();
+			s_curEntityKeys.clear();
 			return;
 		}
 
 		// Only unpack the snapshot if its not already cached.
-		if (s_curSnapshotId != id)
+		// Sectors and entities that are unchanged from the cached snapshot are not read again.
+		if (s_curSnapshotId != id && chunkCount >= LSC_SECTORS && level_readSnapshotChunk(LSC_HEADER))
 		{
 			s_curSnapshotId = id;
-			setSnapshotReadBuffer((u8*)data, size);
 
 			// Load the group data.
 			groups_loadFromSnapshot();
@@ -3350,18 +3396,52 @@ namespace LevelEditor
 			const u32 entityCount = readU32();
 			const u32 levelNoteCount = readU32();
 			const u32 guidelineCount = readU32();
+			assert(chunkCount == LSC_SECTORS + sectorCount + entityCount);
+
+			const u64 texturesKey = history_getSnapshotChunkKey(LSC_TEXTURES);
+			if ((texturesKey != s_curTexturesKey || s_curSnapshot.textures.size() != texCount) && level_readSnapshotChunk(LSC_TEXTURES))
+			{
+				s_curTexturesKey = texturesKey;
+				s_curSnapshot.textures.resize(texCount);
+				for (u32 i = 0; i < texCount; i++)
+				{
+					readString(s_curSnapshot.textures[i].name);
+					s_curSnapshot.textures[i].handle = loadTexture(s_curSnapshot.textures[i].name.c_str());
+				}
+			}
+
+			// Level Notes.
+			if (level_readSnapshotChunk(LSC_NOTES))
+			{
+				s_curSnapshot.notes.resize(levelNoteCount);
+				LevelNote* note = s_curSnapshot.notes.data();
+				for (u32 n = 0; n < levelNoteCount; n++, note++)
+				{
+					readLevelNoteFromSnapshot(note);
+				}
+			}
 
-			s_curSnapshot.textures.resize(texCount);
-			for (u32 i = 0; i < texCount; i++)
+			// Guidelines.
+			if (level_readSnapshotChunk(LSC_GUIDELINES))
 			{
-				readString(s_curSnapshot.textures[i].name);
-				s_curSnapshot.textures[i].handle = loadTexture(s_curSnapshot.textures[i].name.c_str());
+				s_curSnapshot.guidelines.resize(guidelineCount);
+				Guideline* guideline = s_curSnapshot.guidelines.data();
+				for (u32 g = 0; g < guidelineCount; g++, guideline++)
+				{
+					readGuidelineFromSnapshot(guideline);
+				}
 			}
 
 			s_curSnapshot.sectors.resize(sectorCount);
+			s_curSectorKeys.resize(sectorCount, 0);
 			EditorSector* sector = s_curSnapshot.sectors.data();
 			for (u32 s = 0; s < sectorCount; s++, sector++)
 			{
+				const u32 chunk = LSC_SECTORS + s;
+				const u64 key = history_getSnapshotChunkKey(chunk);
+				if (key == s_curSectorKeys[s] || !level_readSnapshotChunk(chunk)) { continue; }
+
+				s_curSectorKeys[s] = key;
 				readSectorFromSnapshot(sector);
 				// Compute derived data.
 				sectorToPolygon(sector);
@@ -3369,32 +3449,23 @@ namespace LevelEditor
 			}
 
 			s_curSnapshot.entities.resize(entityCount);
+			s_curEntityKeys.resize(entityCount, 0);
 			Entity* entity = s_curSnapshot.entities.data();
 			for (u32 e = 0; e < entityCount; e++, entity++)
 			{
+				const u32 chunk = LSC_SECTORS + sectorCount + e;
+				const u64 key = history_getSnapshotChunkKey(chunk);
+				if (key == s_curEntityKeys[e] || !level_readSnapshotChunk(chunk)) { continue; }
+
+				s_curEntityKeys[e] = key;
 				readEntityFromSnapshot(entity);
 				// Sprite and obj data derived from type + assetName
 				loadSingleEntityData(entity);
 			}
-
-			// Level Notes.
-			s_curSnapshot.notes.resize(levelNoteCount);
-			LevelNote* note = s_curSnapshot.notes.data();
-			for (u32 n = 0; n < levelNoteCount; n++, note++)
-			{
-				readLevelNoteFromSnapshot(note);
-			}
-
-			// Guidelines.
-			s_curSnapshot.guidelines.resize(guidelineCount);
-			Guideline* guideline = s_curSnapshot.guidelines.data();
-			for (u32 g = 0; g < guidelineCount; g++, guideline++)
-			{
-				readGuidelineFromSnapshot(guideline);
-			}
 		}
 		// Then copy the snapshot to the level data itself. Its the new state.
 		s_level = s_curSnapshot;
+		sectorBvh_invalidate();
 
 		// For now until the way snapshot memory is handled is refactored, to avoid duplicate code that will be removed later.
 		// TODO: Handle edit state properly here too.
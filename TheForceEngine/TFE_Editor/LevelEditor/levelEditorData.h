@@ -267,7 +267,7 @@ namespace LevelEditor
 	void level_createLevelSectorSnapshotSameAssets(std::vector<EditorSector>& sectors);
 	void level_getLevelSnapshotDelta(std::vector<s32>& modifiedSectors, const std::vector<EditorSector>& sectorSnapshot);
 
-	void level_unpackSnapshot(s32 id, u32 size, void* data);
+	void level_unpackSnapshot(s32 id, u32 chunkCount);
 	void level_unpackSectorSnapshot(u32 size, void* data);
 	void level_unpackSectorWallSnapshot(u32 size, void* data);
 	void level_unpackSectorAttribSnapshot(u32 size, void* data);
@@ -0,0 +1,363 @@
+#include "sectorBvh.h"
+#include "levelEditorData.h"
+#include "sharedState.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace LevelEditor
+{
+	enum SectorBvhConst
+	{
+		BVH_MAX_LEAF_SIZE = 4,
+		BVH_STACK_SIZE = 64,
+	};
+
+	struct BvhNode
+	{
+		Vec3f bounds[2];
+		s32 first;		// Leaf: first item. Interior: index of the left child, the right child follows it.
+		s32 count;		// Leaf: item count, zero for interior nodes.
+	};
+
+	static std::vector<BvhNode> s_nodes;
+	static std::vector<s32> s_parents;			// Parent node index per node, -1 for the root.
+	static std::vector<s32> s_items;			// Sector indices, referenced by the leaves.
+	static std::vector<s32> s_itemLeaf;			// Leaf node index per sector.
+	static std::vector<Vec3f> s_leafBounds;		// Two per sector.
+	static std::vector<Vec3f> s_centers;
+	static std::vector<s32> s_dirty;			// Sectors changed since the last query.
+	static std::vector<u8> s_dirtyFlag;			// One per sector, set if the sector is in s_dirty.
+	static s32 s_refitCount = 0;
+	static bool s_rebuild = true;
+
+	void computeSectorBounds(const EditorSector* sector, Vec3f* bounds)
+	{
+		bounds[0] = sector->bounds[0];
+		bounds[1] = sector->bounds[1];
+
+		// Objects are not guaranteed to be inside of the sector.
+		const s32 objCount = (s32)sector->obj.size();
+		const EditorObject* obj = sector->obj.data();
+		for (s32 o = 0; o < objCount; o++, obj++)
+		{
+			bounds[0].x = std::min(bounds[0].x, obj->pos.x);
+			bounds[0].y = std::min(bounds[0].y, obj->pos.y);
+			bounds[0].z = std::min(bounds[0].z, obj->pos.z);
+			bounds[1].x = std::max(bounds[1].x, obj->pos.x);
+			bounds[1].y = std::max(bounds[1].y, obj->pos.y);
+			bounds[1].z = std::max(bounds[1].z, obj->pos.z);
+		}
+	}
+
+	void mergeBounds(Vec3f* dst, const Vec3f* src)
+	{
+		dst[0].x = std::min(dst[0].x, src[0].x);
+		dst[0].y = std::min(dst[0].y, src[0].y);
+		dst[0].z = std::min(dst[0].z, src[0].z);
+		dst[1].x = std::max(dst[1].x, src[1].x);
+		dst[1].y = std::max(dst[1].y, src[1].y);
+		dst[1].z = std::max(dst[1].z, src[1].z);
+	}
+
+	void buildNode(s32 nodeIndex, s32 first, s32 count)
+	{
+		Vec3f bounds[2] = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+		Vec3f centerBounds[2] = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+		for (s32 i = first; i < first + count; i++)
+		{
+			const s32 item = s_items[i];
+			mergeBounds(bounds, &s_leafBounds[item * 2]);
+			const Vec3f center[2] = { s_centers[item], s_centers[item] };
+			mergeBounds(centerBounds, center);
+		}
+		s_nodes[nodeIndex].bounds[0] = bounds[0];
+		s_nodes[nodeIndex].bounds[1] = bounds[1];
+
+		if (count <= BVH_MAX_LEAF_SIZE)
+		{
+			s_nodes[nodeIndex].first = first;
+			s_nodes[nodeIndex].count = count;
+			for (s32 i = first; i < first + count; i++)
+			{
+				s_itemLeaf[s_items[i]] = nodeIndex;
+			}
+			return;
+		}
+
+		// Split at the median of the longest axis of the centers.
+		const Vec3f ext = { centerBounds[1].x - centerBounds[0].x, centerBounds[1].y - centerBounds[0].y, centerBounds[1].z - centerBounds[0].z };
+		const s32 axis = (ext.x >= ext.y && ext.x >= ext.z) ? 0 : (ext.y >= ext.z ? 1 : 2);
+		const s32 half = count / 2;
+		std::nth_element(s_items.begin() + first, s_items.begin() + first + half, s_items.begin() + first + count, [axis](s32 a, s32 b)
+		{
+			return s_centers[a].m[axis] < s_centers[b].m[axis];
+		});
+
+		const s32 left = (s32)s_nodes.size();
+		s_nodes.resize(s_nodes.size() + 2);
+		s_parents.resize(s_nodes.size(), nodeIndex);
+		s_nodes[nodeIndex].first = left;
+		s_nodes[nodeIndex].count = 0;
+		buildNode(left, first, half);
+		buildNode(left + 1, first + half, count - half);
+	}
+
+	void sectorBvh_build(s32 sectorCount)
+	{
+		s_nodes.clear();
+		s_parents.clear();
+		s_items.resize(sectorCount);
+		s_itemLeaf.resize(sectorCount);
+		s_centers.resize(sectorCount);
+		s_refitCount = 0;
+		if (!sectorCount) { return; }
+
+		for (s32 s = 0; s < sectorCount; s++)
+		{
+			const Vec3f* bounds = &s_leafBounds[s * 2];
+			s_items[s] = s;
+			// Sectors without vertices have inverted bounds, which never overlap anything.
+			s_centers[s] = bounds[0].x <= bounds[1].x ?
+				Vec3f{ (bounds[0].x + bounds[1].x) * 0.5f, (bounds[0].y + bounds[1].y) * 0.5f, (bounds[0].z + bounds[1].z) * 0.5f } : Vec3f{ 0.0f, 0.0f, 0.0f };
+		}
+		s_nodes.reserve(sectorCount * 2);
+		s_parents.reserve(sectorCount * 2);
+		s_nodes.resize(1);
+		s_parents.resize(1, -1);
+		buildNode(0, 0, sectorCount);
+	}
+
+	void refitNode(BvhNode* node)
+	{
+		node->bounds[0] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		node->bounds[1] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		if (node->count)
+		{
+			for (s32 i = node->first; i < node->first + node->count; i++)
+			{
+				mergeBounds(node->bounds, &s_leafBounds[s_items[i] * 2]);
+			}
+		}
+		else
+		{
+			mergeBounds(node->bounds, s_nodes[node->first].bounds);
+			mergeBounds(node->bounds, s_nodes[node->first + 1].bounds);
+		}
+	}
+
+	// Refit the leaf holding the sector and its ancestors, stopping once a node's bounds are unchanged.
+	void sectorBvh_refit(s32 sectorIndex)
+	{
+		for (s32 n = s_itemLeaf[sectorIndex]; n >= 0; n = s_parents[n])
+		{
+			BvhNode* node = &s_nodes[n];
+			Vec3f prevBounds[2] = { node->bounds[0], node->bounds[1] };
+			refitNode(node);
+			if (memcmp(prevBounds, node->bounds, sizeof(Vec3f) * 2) == 0) { break; }
+		}
+	}
+
+	// Bring the tree up to date with the dirty sectors, or rebuild it if it was invalidated.
+	void sectorBvh_update()
+	{
+		const s32 sectorCount = (s32)s_level.sectors.size();
+		if (s_rebuild || (s32)s_itemLeaf.size() != sectorCount)
+		{
+			s_leafBounds.resize(sectorCount * 2);
+			const EditorSector* sector = s_level.sectors.data();
+			for (s32 s = 0; s < sectorCount; s++, sector++)
+			{
+				computeSectorBounds(sector, &s_leafBounds[s * 2]);
+			}
+			sectorBvh_build(sectorCount);
+
+			s_dirty.clear();
+			s_dirtyFlag.assign(sectorCount, 0);
+			s_rebuild = false;
+			return;
+		}
+		if (s_dirty.empty()) { return; }
+
+		const s32 dirtyCount = (s32)s_dirty.size();
+		for (s32 i = 0; i < dirtyCount; i++)
+		{
+			const s32 s = s_dirty[i];
+			computeSectorBounds(&s_level.sectors[s], &s_leafBounds[s * 2]);
+			s_dirtyFlag[s] = 0;
+		}
+
+		// Refitting keeps the topology, which degrades as sectors move. Rebuild once enough has changed.
+		s_refitCount += dirtyCount;
+		if (s_refitCount > sectorCount / 4)
+		{
+			sectorBvh_build(sectorCount);
+		}
+		else
+		{
+			for (s32 i = 0; i < dirtyCount; i++)
+			{
+				sectorBvh_refit(s_dirty[i]);
+			}
+		}
+		s_dirty.clear();
+	}
+
+	void sectorBvh_markDirty(const EditorSector* sector)
+	{
+		if (s_rebuild) { return; }
+
+		const EditorSector* levelSectors = s_level.sectors.data();
+		const s32 sectorCount = (s32)s_level.sectors.size();
+		if (sector < levelSectors || sector >= levelSectors + sectorCount) { return; }
+
+		const s32 index = s32(sector - levelSectors);
+		if (index >= (s32)s_dirtyFlag.size())
+		{
+			// New sector, the tree is rebuilt anyway since the count changed.
+			return;
+		}
+		if (!s_dirtyFlag[index])
+		{
+			s_dirtyFlag[index] = 1;
+			s_dirty.push_back(index);
+		}
+	}
+
+	void sectorBvh_invalidate()
+	{
+		s_rebuild = true;
+	}
+
+	void sectorBvh_destroy()
+	{
+		s_nodes.clear();
+		s_parents.clear();
+		s_items.clear();
+		s_itemLeaf.clear();
+		s_leafBounds.clear();
+		s_centers.clear();
+		s_dirty.clear();
+		s_dirtyFlag.clear();
+		s_refitCount = 0;
+		s_rebuild = true;
+	}
+
+	template <typename OverlapFunc>
+	void sectorBvh_query(OverlapFunc overlaps, std::vector<s32>& result)
+	{
+		result.clear();
+		sectorBvh_update();
+		if (s_nodes.empty()) { return; }
+
+		s32 stack[BVH_STACK_SIZE];
+		s32 stackCount = 0;
+		stack[stackCount++] = 0;
+		while (stackCount)
+		{
+			const BvhNode* node = &s_nodes[stack[--stackCount]];
+			if (!overlaps(node->bounds)) { continue; }
+
+			if (node->count)
+			{
+				for (s32 i = node->first; i < node->first + node->count; i++)
+				{
+					if (overlaps(&s_leafBounds[s_items[i] * 2]))
+					{
+						result.push_back(s_items[i]);
+					}
+				}
+			}
+			else
+			{
+				assert(stackCount + 2 <= BVH_STACK_SIZE);
+				stack[stackCount++] = node->first;
+				stack[stackCount++] = node->first + 1;
+			}
+		}
+		// Keep the same order as looping over the sectors, so ties resolve the same way.
+		std::sort(result.begin(), result.end());
+	}
+
+	void sectorBvh_queryBox(const Vec3f* bounds, f32 padding, std::vector<s32>& result)
+	{
+		const Vec3f b0 = { bounds[0].x - padding, bounds[0].y - padding, bounds[0].z - padding };
+		const Vec3f b1 = { bounds[1].x + padding, bounds[1].y + padding, bounds[1].z + padding };
+		sectorBvh_query([&](const Vec3f* nb)
+		{
+			return nb[0].x <= b1.x && nb[1].x >= b0.x && nb[0].y <= b1.y && nb[1].y >= b0.y && nb[0].z <= b1.z && nb[1].z >= b0.z;
+		}, result);
+	}
+
+	void sectorBvh_queryBox2d(const Vec3f* bounds, f32 padding, std::vector<s32>& result)
+	{
+		const Vec2f b0 = { bounds[0].x - padding, bounds[0].z - padding };
+		const Vec2f b1 = { bounds[1].x + padding, bounds[1].z + padding };
+		sectorBvh_query([&](const Vec3f* nb)
+		{
+			return nb[0].x <= b1.x && nb[1].x >= b0.x && nb[0].z <= b1.z && nb[1].z >= b0.z;
+		}, result);
+	}
+
+	void sectorBvh_querySegment2d(Vec2f p0, Vec2f p1, f32 padding, std::vector<s32>& result)
+	{
+		const Vec2f dir = { p1.x - p0.x, p1.z - p0.z };
+		const f32 ix = fabsf(dir.x) > FLT_EPSILON ? 1.0f / dir.x : FLT_MAX;
+		const f32 iz = fabsf(dir.z) > FLT_EPSILON ? 1.0f / dir.z : FLT_MAX;
+		sectorBvh_query([&](const Vec3f* nb)
+		{
+			const f32 x0 = nb[0].x - padding, x1 = nb[1].x + padding;
+			const f32 z0 = nb[0].z - padding, z1 = nb[1].z + padding;
+			if (x0 > x1 || z0 > z1) { return false; }
+
+			// Slab test over the segment, t in [0, 1].
+			f32 tmin = 0.0f, tmax = 1.0f;
+			if (ix == FLT_MAX)
+			{
+				if (p0.x < x0 || p0.x > x1) { return false; }
+			}
+			else
+			{
+				const f32 t0 = (x0 - p0.x) * ix, t1 = (x1 - p0.x) * ix;
+				tmin = std::max(tmin, std::min(t0, t1));
+				tmax = std::min(tmax, std::max(t0, t1));
+			}
+			if (iz == FLT_MAX)
+			{
+				if (p0.z < z0 || p0.z > z1) { return false; }
+			}
+			else
+			{
+				const f32 t0 = (z0 - p0.z) * iz, t1 = (z1 - p0.z) * iz;
+				tmin = std::max(tmin, std::min(t0, t1));
+				tmax = std::min(tmax, std::max(t0, t1));
+			}
+			return tmin <= tmax;
+		}, result);
+	}
+
+	void sectorBvh_queryFrustum(const Vec4f* planes, s32 planeCount, std::vector<s32>& result)
+	{
+		sectorBvh_query([&](const Vec3f* nb)
+		{
+			if (nb[0].x > nb[1].x) { return false; }
+			for (s32 p = 0; p < planeCount; p++)
+			{
+				// The corner furthest inside of the plane.
+				const Vec3f corner =
+				{
+					planes[p].x > 0.0f ? nb[0].x : nb[1].x,
+					planes[p].y > 0.0f ? nb[0].y : nb[1].y,
+					planes[p].z > 0.0f ? nb[0].z : nb[1].z
+				};
+				if (planes[p].x*corner.x + planes[p].y*corner.y + planes[p].z*corner.z + planes[p].w > 0.0f)
+				{
+					return false;
+				}
+			}
+			return true;
+		}, result);
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Editor
+// A system built to view and edit Dark Forces data files.
+// The viewing aspect needs to be put in place at the beginning
+// in order to properly test elements in isolation without having
+// to "play" the game as intended.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+
+namespace LevelEditor
+{
+	struct EditorSector;
+
+	// Bounding volume hierarchy over the level sectors, each leaf bounds a sector's walls, flats and objects.
+	// Code that changes a sector's bounds or objects marks it dirty, the next query refits the dirty leaves
+	// and their ancestors. Large changes (loading, undo, removing sectors) invalidate the tree instead, which
+	// rebuilds it on the next query. A change in the sector count also forces a rebuild.
+	//
+	// Queries return the indices of sectors whose bounds may overlap, in ascending order. The caller still
+	// applies its own exact tests and layer filters.
+	void sectorBvh_destroy();
+	// Sectors that are not part of the level, such as snapshot copies, are ignored.
+	void sectorBvh_markDirty(const EditorSector* sector);
+	void sectorBvh_invalidate();
+
+	void sectorBvh_queryBox(const Vec3f* bounds, f32 padding, std::vector<s32>& result);
+	// Ignores the Y axis.
+	void sectorBvh_queryBox2d(const Vec3f* bounds, f32 padding, std::vector<s32>& result);
+	void sectorBvh_querySegment2d(Vec2f p0, Vec2f p1, f32 padding, std::vector<s32>& result);
+	// A point is outside of a plane if dot(plane.xyz, point) + plane.w > 0.
+	void sectorBvh_queryFrustum(const Vec4f* planes, s32 planeCount, std::vector<s32>& result);
+}
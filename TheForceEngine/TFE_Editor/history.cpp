@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cstring>
 #include <string>
+#include <unordered_map>
 
 namespace TFE_Editor
 {
@@ -14,12 +15,21 @@ namespace TFE_Editor
 		CMD_MAX_DEPTH = 64,
 	};
 
+	// Snapshot data, shared by every snapshot that contains it.
+	struct SnapshotChunk
+	{
+		u64 key;
+		u32 refCount;
+		u32 uncompressedSize;
+		u32 compressedSize; // equal to uncompressedSize if uncompressed.
+		std::vector<u8> compressedData;
+	};
+
 	struct Snapshot
 	{
 		std::string name;
 		u32 uncompressedSize;
-		u32 compressedSize; // if zero, then uncompressed.
-		std::vector<u8> compressedData;
+		std::vector<u32> chunks;
 	};
 
 	struct CommandHeader
@@ -41,6 +51,15 @@ namespace TFE_Editor
 	std::vector<u8> s_historyBuffer;
 	std::vector<u8> s_snapshotBuffer;
 
+	std::vector<SnapshotChunk> s_chunks;
+	std::vector<u32> s_freeChunks;
+	std::unordered_map<u64, u32> s_chunkMap;
+	// Chunks of the snapshot being created or unpacked.
+	std::vector<u32> s_pendingChunks;
+	const Snapshot* s_unpackSnapshot = nullptr;
+	std::vector<u8> s_chunkBuffer;
+	u32 s_pendingSize = 0;
+
 	u32 s_curPosInHistory = 0;
 	u32 s_curBufferAddr = 0;
 	u32 s_curSnapshot = 0;
@@ -68,13 +87,16 @@ namespace TFE_Editor
 		s_snapShots.clear();
 		s_history.clear();
 		s_historyBuffer.clear();
+		s_chunks.clear();
+		s_freeChunks.clear();
+		s_chunkMap.clear();
 		s_curPosInHistory = 0;
 		s_curBufferAddr = 0;
 		s_curSnapshot = 0;
 		// Clear the previous snapshot index.
 		if (s_snapshotUnpack)
 		{
-			s_snapshotUnpack(-1, 0, nullptr);
+			s_snapshotUnpack(-1, 0);
 		}
 	}
 
@@ -150,30 +172,143 @@ namespace TFE_Editor
 		s_curBufferAddr = bufferAddr;
 	}
 		
-	// Create new commands and snapshots.
-	s32 history_createSnapshotInternal(u32 size, void* data, const char* name/*=nullptr*/)
+	// 64-bit FNV-1a, the size is included so chunks that only differ by trailing zeroes do not match.
+	u64 history_hashChunk(const u8* data, u32 size)
 	{
-		u16 parentId = u16(s_curPosInHistory);
+		u64 hash = 14695981039346656037ull ^ u64(size);
+		for (u32 i = 0; i < size; i++)
+		{
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
 
-		Snapshot snapshot = {};
-		snapshot.uncompressedSize = size;
+	// The hash alone is not enough to share a chunk, a collision would silently replace the data.
+	bool history_chunkMatches(const SnapshotChunk* chunk, const u8* data, u32 size)
+	{
+		if (chunk->uncompressedSize != size) { return false; }
+		if (chunk->compressedSize == chunk->uncompressedSize)
+		{
+			return memcmp(chunk->compressedData.data(), data, size) == 0;
+		}
+
+		s_chunkBuffer.resize(size);
+		if (!zstd_decompress(s_chunkBuffer.data(), size, chunk->compressedData.data(), chunk->compressedSize))
+		{
+			return false;
+		}
+		return memcmp(s_chunkBuffer.data(), data, size) == 0;
+	}
+
+	void history_releaseChunk(u32 index)
+	{
+		SnapshotChunk* chunk = &s_chunks[index];
+		assert(chunk->refCount > 0);
+		chunk->refCount--;
+		if (chunk->refCount == 0)
+		{
+			s_chunkMap.erase(chunk->key);
+			chunk->compressedData.clear();
+			chunk->compressedData.shrink_to_fit();
+			s_freeChunks.push_back(index);
+		}
+	}
+
+	void history_endSnapshotChunk()
+	{
+		const u32 size = (u32)s_snapshotBuffer.size();
+		const u8* data = s_snapshotBuffer.data();
+		u64 key = history_hashChunk(data, size);
+		s_pendingSize += size;
+
+		// Only new chunks are compressed and stored.
+		// Colliding chunks move to the next free key, so keys stay unique for the stored chunks.
+		std::unordered_map<u64, u32>::iterator iChunk = s_chunkMap.find(key);
+		while (iChunk != s_chunkMap.end())
+		{
+			if (history_chunkMatches(&s_chunks[iChunk->second], data, size))
+			{
+				s_chunks[iChunk->second].refCount++;
+				s_pendingChunks.push_back(iChunk->second);
+				s_snapshotBuffer.clear();
+				return;
+			}
+			key++;
+			iChunk = s_chunkMap.find(key);
+		}
+
+		u32 index;
+		if (!s_freeChunks.empty())
+		{
+			index = s_freeChunks.back();
+			s_freeChunks.pop_back();
+		}
+		else
+		{
+			index = (u32)s_chunks.size();
+			s_chunks.push_back({});
+		}
+		SnapshotChunk* chunk = &s_chunks[index];
+		chunk->key = key;
+		chunk->refCount = 1;
+		chunk->uncompressedSize = size;
 
 		bool useUncompressed = true;
-		if (zstd_compress(snapshot.compressedData, (u8*)data, size, 4))
+		if (zstd_compress(chunk->compressedData, data, size, 4))
 		{
-			if (snapshot.compressedData.size() < size)
+			if (chunk->compressedData.size() < size)
 			{
 				useUncompressed = false;
-				snapshot.compressedSize = (u32)snapshot.compressedData.size();
+				chunk->compressedSize = (u32)chunk->compressedData.size();
 			}
 		}
 		if (useUncompressed)
 		{
-			snapshot.compressedSize = size;
-			snapshot.compressedData.resize(size);
-			memcpy(snapshot.compressedData.data(), data, size);
+			chunk->compressedSize = size;
+			chunk->compressedData.resize(size);
+			memcpy(chunk->compressedData.data(), data, size);
 		}
 
+		s_chunkMap[key] = index;
+		s_pendingChunks.push_back(index);
+		s_snapshotBuffer.clear();
+	}
+
+	u64 history_getSnapshotChunkKey(u32 index)
+	{
+		assert(s_unpackSnapshot && index < s_unpackSnapshot->chunks.size());
+		return s_chunks[s_unpackSnapshot->chunks[index]].key;
+	}
+
+	const u8* history_getSnapshotChunkData(u32 index, u32* size)
+	{
+		assert(s_unpackSnapshot && index < s_unpackSnapshot->chunks.size());
+		SnapshotChunk* chunk = &s_chunks[s_unpackSnapshot->chunks[index]];
+		*size = chunk->uncompressedSize;
+		if (chunk->compressedSize == chunk->uncompressedSize)
+		{
+			return chunk->compressedData.data();
+		}
+
+		s_chunkBuffer.resize(chunk->uncompressedSize);
+		if (!zstd_decompress(s_chunkBuffer.data(), chunk->uncompressedSize, chunk->compressedData.data(), chunk->compressedSize))
+		{
+			*size = 0;
+			return nullptr;
+		}
+		return s_chunkBuffer.data();
+	}
+
+	// Create new commands and snapshots.
+	s32 history_createSnapshotInternal(const char* name/*=nullptr*/)
+	{
+		u16 parentId = u16(s_curPosInHistory);
+
+		Snapshot snapshot = {};
+		snapshot.uncompressedSize = s_pendingSize;
+		snapshot.chunks.swap(s_pendingChunks);
+
 		if (name)
 		{
 			snapshot.name = name;
@@ -201,12 +336,24 @@ namespace TFE_Editor
 		return id;
 	}
 
-	void history_createSnapshot(const char* name/*=nullptr*/)
+	void history_buildSnapshot()
 	{
-		// Callback setup by the client.
 		s_snapshotBuffer.clear();
+		s_pendingChunks.clear();
+		s_pendingSize = 0;
+		// Callback setup by the client.
 		s_snapshotCreate(&s_snapshotBuffer);
-		history_createSnapshotInternal((u32)s_snapshotBuffer.size(), s_snapshotBuffer.data(), name);
+		// Anything written after the last chunk.
+		if (!s_snapshotBuffer.empty())
+		{
+			history_endSnapshotChunk();
+		}
+	}
+
+	void history_createSnapshot(const char* name/*=nullptr*/)
+	{
+		history_buildSnapshot();
+		history_createSnapshotInternal(name);
 	}
 		
 	bool history_createCommand(u16 cmd, u16 name)
@@ -215,10 +362,8 @@ namespace TFE_Editor
 		const CommandHeader prevHeader = *hBuffer_getHeader(parentId);
 		if (prevHeader.depth >= CMD_MAX_DEPTH)
 		{
-			// Callback setup by the client.
-			s_snapshotBuffer.clear();
-			s_snapshotCreate(&s_snapshotBuffer);
-			history_createSnapshotInternal((u32)s_snapshotBuffer.size(), s_snapshotBuffer.data(), s_cmdName[name].c_str());
+			history_buildSnapshot();
+			history_createSnapshotInternal(s_cmdName[name].c_str());
 			// Return false to let the caller know a snapshot was created instead of the command.
 			return false;
 		}
@@ -352,20 +497,11 @@ namespace TFE_Editor
 
 			if (cmdHeader->cmdId == CMD_SNAPSHOT)
 			{
+				// The client reads the chunks it needs.
 				const s32 id = cmdHeader->cmdName;
-				Snapshot* snapshot = &s_snapShots[id];
-				if (snapshot->uncompressedSize > snapshot->compressedSize)
-				{
-					s_snapshotBuffer.resize(snapshot->uncompressedSize);
-					if (zstd_decompress(s_snapshotBuffer.data(), snapshot->uncompressedSize, snapshot->compressedData.data(), snapshot->compressedSize))
-					{
-						s_snapshotUnpack(id, snapshot->uncompressedSize, s_snapshotBuffer.data());
-					}
-				}
-				else
-				{
-					s_snapshotUnpack(id, snapshot->compressedSize, snapshot->compressedData.data());
-				}
+				s_unpackSnapshot = &s_snapShots[id];
+				s_snapshotUnpack(id, (u32)s_unpackSnapshot->chunks.size());
+				s_unpackSnapshot = nullptr;
 			}
 			else
 			{
@@ -427,10 +563,18 @@ namespace TFE_Editor
 		// Then resize the snapshots.
 		if (snapShotMin < 0xffff)
 		{
+			for (size_t i = snapShotMin; i < s_snapShots.size(); i++)
+			{
+				const std::vector<u32>& chunks = s_snapShots[i].chunks;
+				for (size_t c = 0; c < chunks.size(); c++)
+				{
+					history_releaseChunk(chunks[c]);
+				}
+			}
 			s_snapShots.resize(snapShotMin);
 		}
 		// Clear the previous snapshot index.
-		s_snapshotUnpack(-1, 0, nullptr);
+		s_snapshotUnpack(-1, 0);
 	}
 
 	const char* history_getItemNameAndState(u32 index, u32& parentId, bool& isHidden)
@@ -467,10 +611,18 @@ namespace TFE_Editor
 		u32 size = (u32)s_historyBuffer.size();
 		for (s32 i = 0; i < snapshotCount; i++, snapshot++)
 		{
-			size += (u32)snapshot->compressedData.size();
+			size += (u32)snapshot->chunks.size() * sizeof(u32);
 			size += (u32)snapshot->name.length();
 			size += sizeof(Snapshot);
 		}
+		// Shared chunks are only counted once.
+		const s32 chunkCount = (s32)s_chunks.size();
+		const SnapshotChunk* chunk = s_chunks.data();
+		for (s32 i = 0; i < chunkCount; i++, chunk++)
+		{
+			size += (u32)chunk->compressedData.size();
+			size += sizeof(SnapshotChunk);
+		}
 		size += (u32)s_history.size() * sizeof(u32);
 		return size;
 	}
@@ -14,7 +14,9 @@ namespace TFE_Editor
 	typedef std::vector<u8> SnapshotBuffer;
 
 	typedef void(*CmdApplyFunc)(void);
-	typedef void(*UnpackSnapshotFunc)(s32 id, u32 size, void* data);
+	// id = -1 clears any snapshot state cached by the client, otherwise the chunks are read
+	// with history_getSnapshotChunkKey() and history_getSnapshotChunkData().
+	typedef void(*UnpackSnapshotFunc)(s32 id, u32 chunkCount);
 	typedef void(*CreateSnapshotFunc)(SnapshotBuffer* buffer);
 
 	enum
@@ -45,6 +47,12 @@ namespace TFE_Editor
 		
 	// Create new commands and snapshots.
 	void history_createSnapshot(const char* name=nullptr);
+	// Snapshots are stored as chunks, identical chunks are only stored (and compressed) once and
+	// shared between snapshots. Called by the CreateSnapshotFunc to end the chunk written so far.
+	void history_endSnapshotChunk();
+	// Called by the UnpackSnapshotFunc, chunks with the same key have the same contents.
+	u64 history_getSnapshotChunkKey(u32 index);
+	const u8* history_getSnapshotChunkData(u32 index, u32* size);
 	bool history_createCommand(u16 cmd, u16 name);
 	void history_step(s32 count);
 	void history_setPos(s32 pos);
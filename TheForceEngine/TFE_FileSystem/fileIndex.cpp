@@ -0,0 +1,171 @@
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+
+#include "fileIndex.h"
+#include <TFE_Archive/archive.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <Windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace TFE_FileIndex
+{
+	enum SourceClass
+	{
+		SOURCE_MAPPING = 0,
+		SOURCE_SEARCH_PATH,
+		SOURCE_ARCHIVE,
+	};
+
+	struct IndexEntry
+	{
+		u32 rank;			// Lower values have priority.
+		Archive* archive;
+		u32 index;
+		std::string path;
+	};
+	typedef std::unordered_map<std::string, IndexEntry> FileIndexMap;
+
+	static FileIndexMap s_index[LAYER_COUNT];
+	static bool s_dirty[LAYER_COUNT] = { true, true };
+
+	u32 getRank(SourceClass sourceClass, s32 position)
+	{
+		return (u32(sourceClass) << 24u) | (u32(position) & 0x00ffffffu);
+	}
+
+	void makeKey(const char* fileName, std::string& key)
+	{
+		const size_t len = strlen(fileName);
+		key.resize(len);
+		for (size_t i = 0; i < len; i++)
+		{
+			key[i] = (char)tolower((u8)fileName[i]);
+		}
+	}
+
+	void insert(IndexLayer layer, const char* fileName, u32 rank, Archive* archive, u32 index, const char* path)
+	{
+		std::string key;
+		makeKey(fileName, key);
+
+		FileIndexMap& fileIndex = s_index[layer];
+		FileIndexMap::iterator iEntry = fileIndex.find(key);
+		if (iEntry == fileIndex.end())
+		{
+			fileIndex[key] = { rank, archive, index, path ? path : "" };
+		}
+		else if (rank < iEntry->second.rank)
+		{
+			iEntry->second = { rank, archive, index, path ? path : "" };
+		}
+	}
+
+	void invalidate(IndexLayer layer)
+	{
+		s_index[layer].clear();
+		s_dirty[layer] = true;
+	}
+
+	bool isDirty(IndexLayer layer)
+	{
+		return s_dirty[layer];
+	}
+
+	void beginBuild(IndexLayer layer)
+	{
+		s_index[layer].clear();
+		s_dirty[layer] = false;
+	}
+
+	void addMapping(const char* fileName, const char* realPath, s32 position)
+	{
+		if (s_dirty[LAYER_DISK]) { return; }
+		insert(LAYER_DISK, fileName, getRank(SOURCE_MAPPING, position), nullptr, INVALID_FILE, realPath);
+	}
+
+	void addSearchPath(const char* path, s32 position)
+	{
+		if (s_dirty[LAYER_DISK]) { return; }
+		const u32 rank = getRank(SOURCE_SEARCH_PATH, position);
+		char fullPath[TFE_MAX_PATH];
+
+	#ifdef _WIN32
+		char pattern[TFE_MAX_PATH];
+		snprintf(pattern, TFE_MAX_PATH, "%s*", path);
+
+		WIN32_FIND_DATAA findData;
+		HANDLE hFind = FindFirstFileA(pattern, &findData);
+		if (hFind == INVALID_HANDLE_VALUE) { return; }
+		do
+		{
+			if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) { continue; }
+			snprintf(fullPath, TFE_MAX_PATH, "%s%s", path, findData.cFileName);
+			insert(LAYER_DISK, findData.cFileName, rank, nullptr, INVALID_FILE, fullPath);
+		} while (FindNextFileA(hFind, &findData));
+		FindClose(hFind);
+	#else
+		DIR* dir = opendir(path);
+		if (!dir) { return; }
+
+		struct dirent* entry;
+		while (nullptr != (entry = readdir(dir)))
+		{
+			snprintf(fullPath, TFE_MAX_PATH, "%s%s", path, entry->d_name);
+			struct stat st;
+			if (stat(fullPath, &st) != 0 || !S_ISREG(st.st_mode)) { continue; }
+			insert(LAYER_DISK, entry->d_name, rank, nullptr, INVALID_FILE, fullPath);
+		}
+		closedir(dir);
+	#endif
+	}
+
+	void addArchive(Archive* archive, s32 position)
+	{
+		if (s_dirty[LAYER_ARCHIVE] || !archive) { return; }
+		const u32 rank = getRank(SOURCE_ARCHIVE, position);
+		const u32 count = archive->getFileCount();
+		for (u32 i = 0; i < count; i++)
+		{
+			const char* name = archive->getFileName(i);
+			if (name && name[0])
+			{
+				insert(LAYER_ARCHIVE, name, rank, archive, i, nullptr);
+			}
+		}
+	}
+
+	bool canIndex(const char* fileName)
+	{
+		return fileName && fileName[0] && !strchr(fileName, '/') && !strchr(fileName, '\\') && !strchr(fileName, ':');
+	}
+
+	bool find(const char* fileName, FilePath* outPath)
+	{
+		std::string key;
+		makeKey(fileName, key);
+
+		// The disk layer always has priority over the archives.
+		for (s32 layer = 0; layer < LAYER_COUNT; layer++)
+		{
+			FileIndexMap::const_iterator iEntry = s_index[layer].find(key);
+			if (iEntry == s_index[layer].end())
+			{
+				continue;
+			}
+
+			const IndexEntry& entry = iEntry->second;
+			outPath->archive = entry.archive;
+			outPath->index = entry.index;
+			strncpy(outPath->path, entry.path.c_str(), TFE_MAX_PATH);
+			return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// File Index
+// Case-insensitive hash index over the files visible through
+// TFE_Paths::getFilePath() - file mappings, the files directly inside
+// each search path and the archive contents - so lookups are O(1) and
+// do not touch the disk.
+//
+// Each source is ranked by priority (mappings, then search paths, then
+// archives, each in list order) and a name maps to the highest
+// priority source that contains it, matching the order of the linear
+// search. Sources appended to the end of their list are added
+// incrementally, any other change invalidates the index and it is
+// rebuilt on the next lookup. The disk and archive layers are tracked
+// separately, so opening or closing an archive does not require the
+// search path directories to be listed again.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "paths.h"
+
+namespace TFE_FileIndex
+{
+	enum IndexLayer
+	{
+		LAYER_DISK = 0,		// File mappings and search paths.
+		LAYER_ARCHIVE,
+		LAYER_COUNT
+	};
+
+	// Clear a layer and mark it as dirty.
+	void invalidate(IndexLayer layer);
+	bool isDirty(IndexLayer layer);
+	// Start a layer rebuild, its sources are then added in priority order.
+	void beginBuild(IndexLayer layer);
+
+	// 'position' is the index of the source in its list.
+	void addMapping(const char* fileName, const char* realPath, s32 position);
+	void addSearchPath(const char* path, s32 position);
+	void addArchive(Archive* archive, s32 position);
+
+	// Only plain file names are indexed, names with directories must be searched directly.
+	bool canIndex(const char* fileName);
+	bool find(const char* fileName, FilePath* outPath);
+}
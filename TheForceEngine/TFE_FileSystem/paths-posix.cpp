@@ -3,6 +3,7 @@
 #include "paths.h"
 #include "fileutil.h"
 #include "filestream.h"
+#include "fileIndex.h"
 #include <TFE_System/system.h>
 #include <TFE_Archive/archive.h>
 #include <algorithm>
@@ -30,6 +31,34 @@ namespace TFE_Paths
 
 	bool isPortableInstall();
 
+	void rebuildFileIndex()
+	{
+		s32 position;
+		if (TFE_FileIndex::isDirty(TFE_FileIndex::LAYER_DISK)) {
+			TFE_FileIndex::beginBuild(TFE_FileIndex::LAYER_DISK);
+			position = 0;
+			for (auto it = s_fileMappings.begin(); it != s_fileMappings.end(); it++, position++) {
+				TFE_FileIndex::addMapping(it->fileName.c_str(), it->realPath.c_str(), position);
+			}
+			position = 0;
+			for (auto it = s_searchPaths.begin(); it != s_searchPaths.end(); it++, position++) {
+				TFE_FileIndex::addSearchPath(it->c_str(), position);
+			}
+		}
+		if (TFE_FileIndex::isDirty(TFE_FileIndex::LAYER_ARCHIVE)) {
+			TFE_FileIndex::beginBuild(TFE_FileIndex::LAYER_ARCHIVE);
+			position = 0;
+			for (auto it = s_localArchives.begin(); it != s_localArchives.end(); it++, position++) {
+				TFE_FileIndex::addArchive(*it, position);
+			}
+		}
+	}
+
+	void invalidateArchiveIndex()
+	{
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
+	}
+
 	void setPath(TFE_PathType pathType, const char* path)
 	{
 		s_paths[pathType] = path;
@@ -209,6 +238,7 @@ namespace TFE_Paths
 			}
 		}
 		s_searchPaths.push_back(workpath);
+		TFE_FileIndex::addSearchPath(workpath, (s32)s_searchPaths.size() - 1);
 	}
 
 	void addSearchPathToHead(const char *fullPath)
@@ -227,12 +257,14 @@ namespace TFE_Paths
 			}
 		}
 		s_searchPaths.push_front(workpath);
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_DISK);
 	}
 
 	void clearSearchPaths(void)
 	{
 		s_searchPaths.clear();
 		s_fileMappings.clear();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_DISK);
 	}
 
 	void clearLocalArchives(void)
@@ -240,6 +272,7 @@ namespace TFE_Paths
 		std::for_each(s_localArchives.begin(), s_localArchives.end(),
 				[](Archive *a) { Archive::freeArchive(a); });
 		s_localArchives.clear();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	// Add a single file that can be referenced by 'fileName' even though the real name may be different.
@@ -255,6 +288,7 @@ namespace TFE_Paths
 
 		FileMapping mapping = { fileNameLC, filePathFixed };
 		s_fileMappings.push_back(mapping);
+		TFE_FileIndex::addMapping(fileNameLC, filePathFixed, (s32)s_fileMappings.size() - 1);
 	}
 
 	void addLocalSearchPath(const char *locpath)
@@ -287,21 +321,25 @@ namespace TFE_Paths
 	void addLocalArchiveToFront(Archive *a)
 	{
 		s_localArchives.push_front(a);
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	void removeFirstArchive(void)
 	{
 		s_localArchives.pop_front();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	void addLocalArchive(Archive *a)
 	{
 		s_localArchives.push_back(a);
+		TFE_FileIndex::addArchive(a, (s32)s_localArchives.size() - 1);
 	}
 
 	void removeLastArchive(void)
 	{
 		s_localArchives.pop_back();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	bool getFilePath(const char *fileName, FilePath *outPath)
@@ -312,6 +350,12 @@ namespace TFE_Paths
 		outPath->index = INVALID_FILE;
 		outPath->path[0] = 0;
 
+		// Plain file names are resolved through the file index, which follows the same search order.
+		if (TFE_FileIndex::canIndex(fileName)) {
+			rebuildFileIndex();
+			return TFE_FileIndex::find(fileName, outPath);
+		}
+
 		// Search for any filemappings.
 		// This is usually only used with mods and usually limited to 0-3 files.
 		for (auto it = s_fileMappings.begin(); it != s_fileMappings.end(); it++) {
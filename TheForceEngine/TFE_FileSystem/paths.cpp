@@ -2,6 +2,7 @@
 #include "paths.h"
 #include "fileutil.h"
 #include "filestream.h"
+#include "fileIndex.h"
 #include <TFE_System/system.h>
 #include <TFE_Archive/archive.h>
 #include <string>
@@ -35,6 +36,38 @@ namespace TFE_Paths
 	bool insertString(char* text, const char* newFragment, const char* pattern);
 	bool isPortableInstall();
 
+	void rebuildFileIndex()
+	{
+		if (TFE_FileIndex::isDirty(TFE_FileIndex::LAYER_DISK))
+		{
+			TFE_FileIndex::beginBuild(TFE_FileIndex::LAYER_DISK);
+			const s32 mappingCount = (s32)s_fileMappings.size();
+			for (s32 i = 0; i < mappingCount; i++)
+			{
+				TFE_FileIndex::addMapping(s_fileMappings[i].fileName.c_str(), s_fileMappings[i].realPath.c_str(), i);
+			}
+			const s32 pathCount = (s32)s_searchPaths.size();
+			for (s32 i = 0; i < pathCount; i++)
+			{
+				TFE_FileIndex::addSearchPath(s_searchPaths[i].c_str(), i);
+			}
+		}
+		if (TFE_FileIndex::isDirty(TFE_FileIndex::LAYER_ARCHIVE))
+		{
+			TFE_FileIndex::beginBuild(TFE_FileIndex::LAYER_ARCHIVE);
+			const s32 archiveCount = (s32)s_localArchives.size();
+			for (s32 i = 0; i < archiveCount; i++)
+			{
+				TFE_FileIndex::addArchive(s_localArchives[i], i);
+			}
+		}
+	}
+
+	void invalidateArchiveIndex()
+	{
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
+	}
+
 	void setPath(TFE_PathType pathType, const char* path)
 	{
 		s_paths[pathType] = path;
@@ -200,6 +233,7 @@ namespace TFE_Paths
 			}
 
 			s_searchPaths.push_back(fullPath);
+			TFE_FileIndex::addSearchPath(fullPath, (s32)s_searchPaths.size() - 1);
 		}
 	}
 
@@ -219,6 +253,7 @@ namespace TFE_Paths
 			}
 
 			s_searchPaths.insert(s_searchPaths.begin(), fullPath);
+			TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_DISK);
 		}
 	}
 
@@ -226,6 +261,7 @@ namespace TFE_Paths
 	{
 		s_searchPaths.clear();
 		s_fileMappings.clear();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_DISK);
 	}
 
 	void clearLocalArchives()
@@ -237,6 +273,7 @@ namespace TFE_Paths
 			Archive::freeArchive(archive[i]);
 		}
 		s_localArchives.clear();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	// Add a single file that can be referenced by 'fileName' even though the real name may be different.
@@ -252,6 +289,7 @@ namespace TFE_Paths
 
 		FileMapping mapping = { fileNameLC, filePathFixed };
 		s_fileMappings.push_back(mapping);
+		TFE_FileIndex::addMapping(fileNameLC, filePathFixed, (s32)s_fileMappings.size() - 1);
 	}
 
 	void addLocalSearchPath(const char* localSearchPath)
@@ -284,21 +322,25 @@ namespace TFE_Paths
 	void addLocalArchiveToFront(Archive* archive)
 	{
 		s_localArchives.insert(s_localArchives.begin(), archive);
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	void removeFirstArchive()
 	{
 		s_localArchives.erase(s_localArchives.begin());
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	void addLocalArchive(Archive* archive)
 	{
 		s_localArchives.push_back(archive);
+		TFE_FileIndex::addArchive(archive, (s32)s_localArchives.size() - 1);
 	}
 
 	void removeLastArchive()
 	{
 		s_localArchives.pop_back();
+		TFE_FileIndex::invalidate(TFE_FileIndex::LAYER_ARCHIVE);
 	}
 
 	bool getFilePath(const char* fileName, FilePath* outPath)
@@ -307,6 +349,13 @@ namespace TFE_Paths
 		outPath->index = INVALID_FILE;
 		outPath->path[0] = 0;
 
+		// Plain file names are resolved through the file index, which follows the same search order.
+		if (TFE_FileIndex::canIndex(fileName))
+		{
+			rebuildFileIndex();
+			return TFE_FileIndex::find(fileName, outPath);
+		}
+
 		// Search for any filemappings.
 		// This is usually only used with mods and usually limited to 0-3 files.
 		const size_t mappingCount  = s_fileMappings.size();
@@ -54,6 +54,11 @@ namespace TFE_Paths
 	void addLocalArchiveToFront(Archive* archive);
 	void removeFirstArchive();
 	bool getFilePath(const char* fileName, FilePath* path);
+	// Plain file names are looked up in a hash index of the search paths and archives, which is rebuilt when
+	// they change. Files that TFE writes at runtime are either outside of the search paths or added with
+	// addSingleFilePath(), so the directories are not scanned again.
+	// Called by archives when their contents change.
+	void invalidateArchiveIndex();
 	void getAllFilesFromSearchPaths(const char* subdirectory, const char* ext, FileList& allFiles);
 
 	// Add a single file that can be referenced by 'fileName' even though the real name may be different.
@@ -9,6 +9,7 @@
 #include <TFE_Game/igame.h>
 #include <TFE_Game/reticle.h>
 #include <TFE_Game/saveSystem.h>
+#include <TFE_Game/fastForward.h>
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_System/system.h>
 #include <TFE_System/parser.h>
@@ -552,6 +553,52 @@ namespace TFE_FrontEndUI
 		ImGui::PopFont();
 	}
 		
+	// Shown while a save file is being written in the background.
+	void drawSaveStatus(s32 windowWidth, s32 windowHeight)
+	{
+		if (!TFE_SaveSystem::isSaveInProgress()) { return; }
+		const u32 windowFlags = ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings;
+
+		ImFont* font = s_versionFont;
+		ImVec2 size = font->CalcTextSizeA(font->FontSize, 1024.0f, 0.0f, "Saving...");
+		f32 width  = size.x + 8.0f;
+		f32 height = size.y + 8.0f;
+
+		ImGui::PushFont(font);
+		ImGui::SetNextWindowSize(ImVec2(width, height));
+		ImGui::SetNextWindowPos(ImVec2(windowWidth - width, windowHeight - height));
+		ImGui::Begin("##SaveStatus", nullptr, windowFlags);
+		ImGui::Text("Saving...");
+		ImGui::End();
+		ImGui::PopFont();
+	}
+
+	// Shown while the simulation is fast-forwarded.
+	void drawFastForwardStatus(s32 windowHeight)
+	{
+		if (!TFE_FastForward::isEnabled()) { return; }
+		const u32 windowFlags = ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoSavedSettings;
+
+		TFE_FastForward::FastForwardStats stats;
+		TFE_FastForward::getStats(&stats);
+
+		char text[256];
+		sprintf(text, "Fast-forward: %d ticks/s (x%.1f), %d steps/frame", s32(stats.ticksPerSecond + 0.5), stats.speedup, stats.lastStepCount);
+
+		ImFont* font = s_versionFont;
+		ImVec2 size = font->CalcTextSizeA(font->FontSize, 1024.0f, 0.0f, text);
+		f32 width  = size.x + 8.0f;
+		f32 height = size.y + 8.0f;
+
+		ImGui::PushFont(font);
+		ImGui::SetNextWindowSize(ImVec2(width, height));
+		ImGui::SetNextWindowPos(ImVec2(0.0f, windowHeight - height));
+		ImGui::Begin("##FastForwardStatus", nullptr, windowFlags);
+		ImGui::Text("%s", text);
+		ImGui::End();
+		ImGui::PopFont();
+	}
+		
 	void setCurrentGame(IGame* game)
 	{
 		s_game = game;
@@ -593,6 +640,8 @@ namespace TFE_FrontEndUI
 		if (!drawFrontEnd)
 		{
 			if (showFps) { drawFps(w); }
+			drawSaveStatus(w, h);
+			drawFastForwardStatus(h);
 			return;
 		}
 
@@ -1524,6 +1573,7 @@ namespace TFE_FrontEndUI
 	static TextureGpu* s_saveImageView = nullptr;
 	static s32 s_selectedSave = -1;
 	static s32 s_selectedSaveSlot = -1;
+	static s32 s_pendingSaveImage = -1;
 	static bool s_hasQuicksave = false;
 
 	static char s_newSaveName[256];
@@ -1539,9 +1589,23 @@ namespace TFE_FrontEndUI
 		s_saveImageView->update(zero, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
 	}
 
+	// Thumbnails are decoded in the background, so the image stays clear until it is ready.
 	void updateSaveImage(s32 index)
 	{
-		s_saveImageView->update(s_saveDir[index].imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+		const u32* image = TFE_SaveSystem::getSaveThumbnail(&s_saveDir[index]);
+		if (image)
+		{
+			s_saveImageView->update(image, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+			s_pendingSaveImage = -1;
+		}
+		else
+		{
+			if (s_pendingSaveImage != index)
+			{
+				clearSaveImage();
+			}
+			s_pendingSaveImage = index;
+		}
 	}
 
 	void openLoadConfirmPopup()
@@ -1606,6 +1670,7 @@ namespace TFE_FrontEndUI
 			s_saveImageView = TFE_RenderBackend::createTexture(TFE_SaveSystem::SAVE_IMAGE_WIDTH, TFE_SaveSystem::SAVE_IMAGE_HEIGHT, TexFormat::TEX_RGBA8);
 		}
 		TFE_SaveSystem::populateSaveDirectory(s_saveDir);
+		s_pendingSaveImage = -1;
 		s_hasQuicksave = (!s_saveDir.empty() && strcasecmp(s_saveDir[0].saveName, "Quicksave") == 0);
 
 		if (!s_saveDir.empty() && (s_selectedSave > 0 || !save))
@@ -1769,6 +1834,12 @@ namespace TFE_FrontEndUI
 				{
 					s_selectedSave = s32(i);
 				}
+
+				// Start decoding the thumbnails of visible saves so they are ready when hovered.
+				if (i >= size_t(listOffset) && ImGui::IsItemVisible())
+				{
+					TFE_SaveSystem::getSaveThumbnail(&header[i - listOffset]);
+				}
 			}
 			if (prevSelected != s_selectedSave)
 			{
@@ -1779,9 +1850,14 @@ namespace TFE_FrontEndUI
 				}
 				else
 				{
+					s_pendingSaveImage = -1;
 					clearSaveImage();
 				}
 			}
+			else if (s_pendingSaveImage >= 0 && s_pendingSaveImage < (s32)s_saveDir.size())
+			{
+				updateSaveImage(s_pendingSaveImage);
+			}
 			prevSelected = s_selectedSave;
 
 			if (ImGui::BeginPopupModal(s_saveGameConfirmMsg, NULL, ImGuiWindowFlags_AlwaysAutoResize))
@@ -2558,6 +2634,8 @@ namespace TFE_FrontEndUI
 			graphics->asyncFramebuffer = true;
 			graphics->gpuColorConvert = true;
 			ImGui::Checkbox("Extend Adjoin/Portal Limits", &graphics->extendAjoinLimits);
+			ImGui::Checkbox("Multithreaded Rendering", &graphics->multithreadedRendering);
+			Tooltip("Split the view into vertical bands that are drawn in parallel. The band count is the worker thread count plus one, limited to 16 bands at least 64 pixels wide, so it depends on the thread count and screen width. Not used by the fixed-point renderer at exactly 320x200.");
 		}
 		else if (graphics->rendererIndex == 1)
 		{
@@ -2933,6 +3011,21 @@ namespace TFE_FrontEndUI
 		}
 		Tooltip("Appears in upper-left corner of screen. If disabled, a generic 'recording saved' message will be shown instead.");
 
+		bool gifRecordNative = system->gifRecordNative;
+		if (ImGui::Checkbox("Record GIFs at the game resolution", &gifRecordNative))
+		{
+			system->gifRecordNative = gifRecordNative;
+		}
+		Tooltip("With the software renderer, record the game output and its palette directly. This is much faster, but the TFE UI and color correction are not recorded.");
+
+		bool memoryMapArchives = system->memoryMapArchives;
+		if (ImGui::Checkbox("Memory map game archives", &memoryMapArchives))
+		{
+			system->memoryMapArchives = memoryMapArchives;
+			Archive::setMemoryMapping(memoryMapArchives);
+		}
+		Tooltip("Read assets directly from memory mapped GOB, LFD and LAB files. Applies to archives opened after the change.");
+
 	#ifdef _WIN32
 		ImGui::Separator();
 		if (ImGui::Button("Open Log Folder"))
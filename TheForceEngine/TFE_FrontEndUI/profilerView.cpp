@@ -9,18 +9,46 @@
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include <TFE_FrontEndUI/console.h>
 
 #include <algorithm>
+#include <cstdlib>
+#include <cstdio>
 
 namespace TFE_ProfilerView
 {
 	static bool s_open = false;
 
+	void profilerCapture(const ConsoleArgList& args);
+
 	bool init()
 	{
+		CCMD("profilerCapture", profilerCapture, 1, "Capture a Chrome/Perfetto trace of the next N frames to profile_trace.json - profilerCapture 120");
 		return true;
 	}
 
+	void profilerCapture(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+		const s32 frameCount = (s32)strtol(args[1].c_str(), nullptr, 10);
+		if (frameCount <= 0)
+		{
+			TFE_Console::addToHistory("The frame count must be greater than zero.");
+			return;
+		}
+
+		char path[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "profile_trace.json", path);
+		if (!TFE_Profiler::beginCapture(u32(frameCount), path))
+		{
+			TFE_Console::addToHistory("A profiler capture is already in progress.");
+			return;
+		}
+		char msg[TFE_MAX_PATH + 64];
+		sprintf(msg, "Capturing %d frames to '%s'.", frameCount, path);
+		TFE_Console::addToHistory(msg);
+	}
+
 	void destroy()
 	{
 	}
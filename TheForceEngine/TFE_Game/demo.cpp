@@ -0,0 +1,730 @@
+#include "demo.h"
+#include <TFE_Archive/zstdCompression.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/memorystream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_Input/input.h>
+#include <TFE_Input/inputMapping.h>
+#include <TFE_Jedi/Level/stateHash.h>
+#include <TFE_Jedi/Task/task.h>
+#include <TFE_Settings/settings.h>
+#include <TFE_System/system.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace TFE_Input;
+
+namespace TFE_Demo
+{
+	enum DemoVersion
+	{
+		DEMO_VERSION_INIT = 1,
+		DEMO_VERSION_STATE_HASH = 2,
+		DEMO_VERSION_CUR = DEMO_VERSION_STATE_HASH,
+	};
+
+	enum DemoConst
+	{
+		DEMO_COMPRESSION_LEVEL = 6,
+		// Changed bytes separated by at most this many unchanged bytes are stored as a single run.
+		DEMO_RUN_MAX_GAP = 4,
+		// Uncompressed sections larger than this are treated as corrupt, instead of trying a huge allocation.
+		DEMO_MAX_SECTION_SIZE = 256 * 1024 * 1024,
+	};
+
+	enum DemoFrameFlags
+	{
+		DFRAME_TASKS_RAN = FLAG_BIT(0),
+		DFRAME_TIME      = FLAG_BIT(1),	// the frame time changed, followed by the new time.
+		DFRAME_INPUT     = FLAG_BIT(2),	// the input changed, followed by the changed runs.
+		DFRAME_HASH      = FLAG_BIT(3),	// followed by the state hash at the end of the frame.
+	};
+
+	// Game settings that change the simulation, they replace the local settings during playback.
+	struct SimSettings
+	{
+		s32 airControl;
+		s32 pitchLimit;
+		u32 flags;
+	};
+
+	static const char c_demoHeader[4] = { 'T', 'F', 'D', 'M' };
+	static const char* c_demoExt = "tfd";
+
+	static DemoState s_state = DEMO_IDLE;
+	static IGame* s_game = nullptr;
+	static bool s_recordRequest = false;
+	static bool s_playbackRequest = false;
+	static char s_demoPath[TFE_MAX_PATH];
+
+	// Demo data, recorded or loaded from the demo file.
+	static DemoInfo s_info = {};
+	static SimSettings s_settings = {};
+	static MemoryStream s_startState;
+	static MemoryStream s_inputConfig;
+	static std::vector<u8> s_frames;
+
+	// Frame state, the input is stored relative to the previous frame.
+	static InputState s_prevInput;
+	static InputState s_frameInput;
+	static f64 s_prevDt = 0.0;
+	static size_t s_readOffset = 0;
+	static u32 s_frameIndex = 0;
+
+	// Local settings restored when playback ends.
+	static SimSettings s_userSettings = {};
+
+	// State hashes, recorded on frames where the tasks ran and compared during playback if enabled.
+	static bool s_recordStateHash = true;
+	static bool s_checkStateHash = false;
+	static bool s_hashActive = false;
+	static bool s_frameHasHash = false;
+	static bool s_diverged = false;
+	static TFE_Jedi::StateHash s_frameHash;
+
+	void console_demoRecord(const ConsoleArgList& args);
+	void console_demoPlay(const ConsoleArgList& args);
+	void console_demoStop(const ConsoleArgList& args);
+
+	////////////////////////////////////////////////////////
+	// Internal
+	////////////////////////////////////////////////////////
+	s32 getSimulationFlags(TFE_Settings_Game* settings, bool** flags)
+	{
+		flags[0] = &settings->df_bobaFettFacePlayer;
+		flags[1] = &settings->df_smoothVUEs;
+		flags[2] = &settings->df_enableAutoaim;
+		flags[3] = &settings->df_autorun;
+		flags[4] = &settings->df_crouchToggle;
+		flags[5] = &settings->df_ignoreInfLimit;
+		flags[6] = &settings->df_stepSecondAlt;
+		flags[7] = &settings->df_solidWallFlagFix;
+		flags[8] = &settings->df_enableUnusedItem;
+		flags[9] = &settings->df_jsonAiLogics;
+		return 10;
+	}
+
+	void getSimSettings(SimSettings* sim)
+	{
+		TFE_Settings_Game* settings = TFE_Settings::getGameSettings();
+		bool* flags[32];
+		const s32 count = getSimulationFlags(settings, flags);
+
+		sim->airControl = settings->df_airControl;
+		sim->pitchLimit = s32(settings->df_pitchLimit);
+		sim->flags = 0;
+		for (s32 i = 0; i < count; i++)
+		{
+			if (*flags[i]) { sim->flags |= FLAG_BIT(i); }
+		}
+	}
+
+	void setSimSettings(const SimSettings* sim)
+	{
+		TFE_Settings_Game* settings = TFE_Settings::getGameSettings();
+		bool* flags[32];
+		const s32 count = getSimulationFlags(settings, flags);
+
+		settings->df_airControl = sim->airControl;
+		settings->df_pitchLimit = PitchLimit(sim->pitchLimit);
+		for (s32 i = 0; i < count; i++)
+		{
+			*flags[i] = (sim->flags & FLAG_BIT(i)) != 0;
+		}
+	}
+
+	template <typename T>
+	void appendValue(std::vector<u8>& buffer, T value)
+	{
+		const size_t offset = buffer.size();
+		buffer.resize(offset + sizeof(T));
+		memcpy(buffer.data() + offset, &value, sizeof(T));
+	}
+
+	template <typename T>
+	bool readValue(T* value)
+	{
+		if (s_readOffset + sizeof(T) > s_frames.size()) { return false; }
+		memcpy(value, s_frames.data() + s_readOffset, sizeof(T));
+		s_readOffset += sizeof(T);
+		return true;
+	}
+
+	// Appends the runs of bytes that changed between 'prev' and 'cur', returns the number of runs.
+	u32 encodeInputDelta(const InputState* prev, const InputState* cur, std::vector<u8>& buffer)
+	{
+		const u8* src = (const u8*)prev;
+		const u8* dst = (const u8*)cur;
+		const u32 size = sizeof(InputState);
+
+		u32 runCount = 0;
+		u32 i = 0;
+		while (i < size)
+		{
+			if (src[i] == dst[i]) { i++; continue; }
+
+			u32 last = i;
+			for (u32 end = i + 1; end < size && end - last <= DEMO_RUN_MAX_GAP; end++)
+			{
+				if (src[end] != dst[end]) { last = end; }
+			}
+
+			appendValue(buffer, u16(i));
+			appendValue(buffer, u16(last + 1 - i));
+			buffer.insert(buffer.end(), dst + i, dst + last + 1);
+			runCount++;
+			i = last + 1;
+		}
+		return runCount;
+	}
+
+	bool decodeInputDelta(InputState* state)
+	{
+		u8* dst = (u8*)state;
+		u16 runCount;
+		if (!readValue(&runCount)) { return false; }
+		for (u32 r = 0; r < runCount; r++)
+		{
+			u16 offset, length;
+			if (!readValue(&offset) || !readValue(&length)) { return false; }
+			if (u32(offset) + u32(length) > sizeof(InputState) || s_readOffset + length > s_frames.size()) { return false; }
+
+			memcpy(dst + offset, s_frames.data() + s_readOffset, length);
+			s_readOffset += length;
+		}
+		return true;
+	}
+
+	void beginStateHash()
+	{
+		// The cached sector hashes are rebuilt from the start state, so recording and playback match.
+		TFE_Jedi::stateHash_enable(JTRUE);
+		TFE_Jedi::stateHash_clear();
+		s_hashActive = true;
+	}
+
+	void endStateHash()
+	{
+		if (!s_hashActive) { return; }
+		TFE_Jedi::stateHash_enable(JFALSE);
+		s_hashActive = false;
+	}
+
+	void checkStateHash()
+	{
+		TFE_Jedi::StateHash hash;
+		TFE_Jedi::stateHash_compute(&hash, s_game->getRandomSeed());
+		const s32 system = TFE_Jedi::stateHash_compare(&hash, &s_frameHash);
+		if (system < 0) { return; }
+
+		// Only the first divergence is useful, everything after it follows from it.
+		s_diverged = true;
+		char mismatch[256] = "";
+		for (s32 i = 0; i < TFE_Jedi::SHASH_COUNT; i++)
+		{
+			if (hash.value[i] == s_frameHash.value[i]) { continue; }
+			if (mismatch[0]) { strcat(mismatch, ", "); }
+			strcat(mismatch, TFE_Jedi::stateHash_getSystemName(i));
+		}
+		TFE_System::logWrite(LOG_WARNING, "Demo", "Playback diverged at frame %u, tick %u. First diverging subsystem: %s (all: %s).",
+			s_frameIndex, s_game->getTick(), TFE_Jedi::stateHash_getSystemName(system), mismatch);
+	}
+
+	void resetFrameState()
+	{
+		memset(&s_prevInput, 0, sizeof(InputState));
+		memset(&s_frameInput, 0, sizeof(InputState));
+		s_prevDt = 0.0;
+		s_readOffset = 0;
+		s_frameIndex = 0;
+	}
+
+	void writeCompressed(FileStream* file, const void* data, u32 size)
+	{
+		std::vector<u8> compressed;
+		if (size && !zstd_compress(compressed, (const u8*)data, size, DEMO_COMPRESSION_LEVEL))
+		{
+			compressed.clear();
+		}
+		const u32 compressedSize = (u32)compressed.size();
+		file->write(&size);
+		file->write(&compressedSize);
+		file->writeBuffer(compressed.data(), compressedSize);
+	}
+
+	bool readCompressed(FileStream* file, std::vector<u8>& data)
+	{
+		u32 size, compressedSize;
+		file->read(&size);
+		file->read(&compressedSize);
+		if (compressedSize > file->getSize() - file->getLoc()) { return false; }
+		if (size > DEMO_MAX_SECTION_SIZE || (size && !compressedSize)) { return false; }
+
+		std::vector<u8> compressed(compressedSize);
+		file->readBuffer(compressed.data(), compressedSize);
+		data.resize(size);
+		return !size || zstd_decompress(data.data(), size, compressed.data(), compressedSize);
+	}
+
+	void writeString(FileStream* file, const char* str)
+	{
+		const u8 len = (u8)strlen(str);
+		file->write(&len);
+		file->writeBuffer(str, len);
+	}
+
+	void readString(FileStream* file, char* str)
+	{
+		u8 len = 0;
+		file->read(&len);
+		file->readBuffer(str, len);
+		str[len] = 0;
+	}
+
+	bool writeDemo()
+	{
+		FileStream file;
+		if (!file.open(s_demoPath, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Cannot write demo file '%s'.", s_demoPath);
+			return false;
+		}
+
+		const u32 version = DEMO_VERSION_CUR;
+		const u32 gameId = u32(s_info.gameId);
+		const u32 inputStateSize = sizeof(InputState);
+		file.writeBuffer(c_demoHeader, 4);
+		file.write(&version);
+		file.write(&gameId);
+		file.write(&s_info.seed);
+		file.write(&s_info.startTick);
+		file.write(&s_info.frameCount);
+		file.write(&s_info.duration);
+		writeString(&file, s_info.levelName);
+		writeString(&file, s_info.modList);
+
+		file.write(&s_settings.airControl);
+		file.write(&s_settings.pitchLimit);
+		file.write(&s_settings.flags);
+
+		const u32 configSize = (u32)s_inputConfig.getSize();
+		file.write(&inputStateSize);
+		file.write(&configSize);
+		file.writeBuffer(s_inputConfig.data(), configSize);
+
+		writeCompressed(&file, s_startState.data(), (u32)s_startState.getSize());
+		writeCompressed(&file, s_frames.data(), (u32)s_frames.size());
+		file.close();
+		return true;
+	}
+
+	bool readDemo(const char* path)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Cannot open demo file '%s'.", path);
+			return false;
+		}
+
+		char hdr[4];
+		u32 gameId = 0, inputStateSize = 0, configSize = 0;
+		file.readBuffer(hdr, 4);
+		file.read(&s_info.version);
+		if (memcmp(hdr, c_demoHeader, 4) != 0 || s_info.version > DEMO_VERSION_CUR)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "'%s' is not a valid demo file or is from a newer version.", path);
+			file.close();
+			return false;
+		}
+		file.read(&gameId);
+		file.read(&s_info.seed);
+		file.read(&s_info.startTick);
+		file.read(&s_info.frameCount);
+		file.read(&s_info.duration);
+		readString(&file, s_info.levelName);
+		readString(&file, s_info.modList);
+		s_info.gameId = GameID(gameId);
+
+		file.read(&s_settings.airControl);
+		file.read(&s_settings.pitchLimit);
+		file.read(&s_settings.flags);
+
+		file.read(&inputStateSize);
+		file.read(&configSize);
+		if (inputStateSize != sizeof(InputState) || configSize > file.getSize() - file.getLoc())
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "The input layout of demo '%s' does not match this version.", path);
+			file.close();
+			return false;
+		}
+		s_inputConfig.clear();
+		s_inputConfig.allocate(configSize);
+		file.readBuffer(s_inputConfig.data(), configSize);
+
+		std::vector<u8> state;
+		const bool result = readCompressed(&file, state) && readCompressed(&file, s_frames);
+		file.close();
+		if (!result || state.empty())
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Demo file '%s' is corrupt.", path);
+			return false;
+		}
+		s_startState.clear();
+		s_startState.load(state.size(), state.data());
+		return true;
+	}
+
+	void startRecording()
+	{
+		s_recordRequest = false;
+		s_startState.clear();
+		s_startState.open(Stream::MODE_WRITE);
+		const bool stateSaved = s_game->serializeGameState(&s_startState, nullptr, true);
+		s_startState.close();
+		if (!stateSaved)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Cannot capture the game state, the demo is not recorded.");
+			return;
+		}
+
+		s_inputConfig.clear();
+		s_inputConfig.open(Stream::MODE_WRITE);
+		inputMapping_writeConfig(&s_inputConfig);
+		s_inputConfig.close();
+		getSimSettings(&s_settings);
+
+		s_info = {};
+		s_info.version = DEMO_VERSION_CUR;
+		s_info.gameId = s_game->id;
+		s_info.seed = s_game->getRandomSeed();
+		s_info.startTick = s_game->getTick();
+		s_game->getLevelName(s_info.levelName);
+		s_game->getModList(s_info.modList);
+
+		s_frames.clear();
+		resetFrameState();
+		if (s_recordStateHash)
+		{
+			beginStateHash();
+		}
+		s_state = DEMO_RECORDING;
+		TFE_System::logWrite(LOG_MSG, "Demo", "Recording demo '%s'.", s_demoPath);
+	}
+
+	void recordFrame(bool tasksRan)
+	{
+		const f64 dt = TFE_System::getDeltaTime();
+		u8 flags = tasksRan ? DFRAME_TASKS_RAN : 0;
+		if (dt != s_prevDt) { flags |= DFRAME_TIME; }
+		if (memcmp(&s_prevInput, &s_frameInput, sizeof(InputState)) != 0) { flags |= DFRAME_INPUT; }
+		if (tasksRan && s_hashActive) { flags |= DFRAME_HASH; }
+
+		s_frames.push_back(flags);
+		if (flags & DFRAME_TIME)
+		{
+			appendValue(s_frames, dt);
+		}
+		if (flags & DFRAME_INPUT)
+		{
+			// The run count is written once the runs are known.
+			const size_t countOffset = s_frames.size();
+			appendValue(s_frames, u16(0));
+			const u16 runCount = (u16)encodeInputDelta(&s_prevInput, &s_frameInput, s_frames);
+			memcpy(s_frames.data() + countOffset, &runCount, sizeof(u16));
+		}
+		if (flags & DFRAME_HASH)
+		{
+			TFE_Jedi::StateHash hash;
+			TFE_Jedi::stateHash_compute(&hash, s_game->getRandomSeed());
+			appendValue(s_frames, hash);
+		}
+
+		s_prevInput = s_frameInput;
+		s_prevDt = dt;
+		s_info.frameCount++;
+		s_info.duration += dt;
+	}
+
+	// Reads the next frame and applies it, returns false at the end of the demo or if the data is corrupt.
+	bool playFrame()
+	{
+		if (s_frameIndex >= s_info.frameCount) { return false; }
+
+		u8 flags;
+		if (!readValue(&flags)) { return false; }
+		if ((flags & DFRAME_TIME) && !readValue(&s_prevDt)) { return false; }
+		if ((flags & DFRAME_INPUT) && !decodeInputDelta(&s_prevInput)) { return false; }
+		if ((flags & DFRAME_HASH) && !readValue(&s_frameHash)) { return false; }
+		s_frameHasHash = (flags & DFRAME_HASH) != 0;
+		s_frameIndex++;
+
+		setInputState(&s_prevInput);
+		TFE_System::stepTime(s_prevDt);
+		TFE_Jedi::task_overrideTimeLimiter(JTRUE, (flags & DFRAME_TASKS_RAN) ? JTRUE : JFALSE);
+		return true;
+	}
+
+	void beginPlaybackState()
+	{
+		getSimSettings(&s_userSettings);
+		setSimSettings(&s_settings);
+
+		s_inputConfig.open(Stream::MODE_READ);
+		inputMapping_readConfig(&s_inputConfig);
+		s_inputConfig.close();
+		inputMapping_endFrame();
+
+		TFE_System::setManualTime(true);
+		resetFrameState();
+	}
+
+	void endPlaybackState()
+	{
+		endStateHash();
+		TFE_System::setManualTime(false);
+		TFE_Jedi::task_overrideTimeLimiter(JFALSE);
+
+		// Release the recorded input, the system input is read again next frame.
+		InputState emptyInput;
+		memset(&emptyInput, 0, sizeof(InputState));
+		setInputState(&emptyInput);
+
+		setSimSettings(&s_userSettings);
+		if (!inputMapping_restore())
+		{
+			inputMapping_resetToDefaults();
+		}
+	}
+
+	////////////////////////////////////////////////////////
+	// API
+	////////////////////////////////////////////////////////
+	void init()
+	{
+		CCMD("demo_record", console_demoRecord, 1, "Record a demo starting from the current game state, example: demo_record mydemo");
+		CCMD("demo_play", console_demoPlay, 1, "Play back a recorded demo, example: demo_play mydemo");
+		CCMD("demo_stop", console_demoStop, 0, "Stop recording or playing back a demo.");
+		CVAR_BOOL(s_recordStateHash, "g_demoStateHash", CVFLAG_NONE, "Record a hash of the game state every tick, so playback can detect where it diverges.");
+		CVAR_BOOL(s_checkStateHash, "d_demoCheckStateHash", CVFLAG_DO_NOT_SERIALIZE, "Compare the game state against the hashes stored in the demo during playback and log the first divergence.");
+	}
+
+	void destroy()
+	{
+		stop();
+		s_startState.clear();
+		s_inputConfig.clear();
+		s_frames.clear();
+		s_frames.shrink_to_fit();
+		s_game = nullptr;
+	}
+
+	void setCurrentGame(IGame* game)
+	{
+		if (game != s_game && !s_playbackRequest)
+		{
+			stop();
+			s_recordRequest = false;
+		}
+		s_game = game;
+	}
+
+	void beginFrame()
+	{
+		if (s_state == DEMO_RECORDING)
+		{
+			getInputState(&s_frameInput);
+		}
+		else if (s_state == DEMO_PLAYING || s_playbackRequest)
+		{
+			// The first frame is applied before the start state is loaded, in the same frame.
+			// Escape ends the playback early, a press that is not part of the previous recorded frame comes from the system input.
+			if (s_state == DEMO_PLAYING && TFE_Input::keyPressed(KEY_ESCAPE) && !s_prevInput.keyPressed[KEY_ESCAPE])
+			{
+				TFE_Input::clearKeyPressed(KEY_ESCAPE);
+				TFE_System::logWrite(LOG_MSG, "Demo", "Demo playback stopped at frame %u of %u.", s_frameIndex, s_info.frameCount);
+				stop();
+			}
+			else if (!playFrame())
+			{
+				if (s_frameIndex < s_info.frameCount)
+				{
+					TFE_System::logWrite(LOG_ERROR, "Demo", "Demo data is corrupt at frame %u.", s_frameIndex);
+				}
+				stop();
+			}
+		}
+	}
+
+	void endFrame(bool tasksRan)
+	{
+		if (s_state == DEMO_RECORDING)
+		{
+			recordFrame(tasksRan);
+		}
+		else if (s_state == DEMO_PLAYING)
+		{
+			if (tasksRan && s_frameHasHash && s_hashActive && !s_diverged)
+			{
+				checkStateHash();
+			}
+		}
+		else if (s_recordRequest && s_state == DEMO_IDLE && s_game && tasksRan && s_game->canSave() && !s_game->isPaused())
+		{
+			// Only start on frames that end the input frame, so that no input state carries over into the demo.
+			startRecording();
+		}
+	}
+
+	void getDemoPath(const char* name, char* path)
+	{
+		// Names without a path or extension are placed in the Demos/ directory.
+		if (strchr(name, '/') || strchr(name, '\\') || strchr(name, '.'))
+		{
+			strcpy(path, name);
+			return;
+		}
+
+		char demoDir[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "Demos/", demoDir);
+		if (!FileUtil::directoryExits(demoDir))
+		{
+			FileUtil::makeDirectory(demoDir);
+		}
+		sprintf(path, "%s%s.%s", demoDir, name, c_demoExt);
+	}
+
+	bool postRecordRequest(const char* path)
+	{
+		if (s_state != DEMO_IDLE || s_playbackRequest) { return false; }
+		strcpy(s_demoPath, path);
+		s_recordRequest = true;
+		return true;
+	}
+
+	bool postPlaybackRequest(const char* path)
+	{
+		if (s_state != DEMO_IDLE || s_recordRequest) { return false; }
+		if (!readDemo(path)) { return false; }
+		if (s_info.gameId != TFE_Settings::getGame()->id)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Demo '%s' was recorded with a different game.", path);
+			return false;
+		}
+
+		strcpy(s_demoPath, path);
+		s_playbackRequest = true;
+		beginPlaybackState();
+		return true;
+	}
+
+	bool hasPlaybackRequest()
+	{
+		return s_playbackRequest;
+	}
+
+	bool startPlayback()
+	{
+		if (!s_playbackRequest) { return false; }
+		s_playbackRequest = false;
+
+		bool result = false;
+		if (s_game)
+		{
+			s_startState.open(Stream::MODE_READ);
+			result = s_game->serializeGameState(&s_startState, nullptr, false);
+			s_startState.close();
+		}
+		if (!result)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Demo", "Cannot load the start state of demo '%s'.", s_demoPath);
+			endPlaybackState();
+			return false;
+		}
+		if (s_game->getRandomSeed() != s_info.seed)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Demo", "The random seed does not match the demo, playback will not be accurate.");
+		}
+
+		s_diverged = false;
+		if (s_checkStateHash)
+		{
+			beginStateHash();
+		}
+		s_state = DEMO_PLAYING;
+		TFE_System::logWrite(LOG_MSG, "Demo", "Playing demo '%s', level '%s', %u frames.", s_demoPath, s_info.levelName, s_info.frameCount);
+		return true;
+	}
+
+	void stop()
+	{
+		if (s_state == DEMO_RECORDING)
+		{
+			endStateHash();
+			if (writeDemo())
+			{
+				TFE_System::logWrite(LOG_MSG, "Demo", "Wrote demo '%s', %u frames.", s_demoPath, s_info.frameCount);
+			}
+		}
+		else if (s_state == DEMO_PLAYING || s_playbackRequest)
+		{
+			endPlaybackState();
+		}
+		s_state = DEMO_IDLE;
+		s_playbackRequest = false;
+	}
+
+	DemoState getState()
+	{
+		return s_state;
+	}
+
+	void enableStateCheck(bool enable)
+	{
+		s_checkStateHash = enable;
+	}
+
+	bool hasDiverged()
+	{
+		return s_diverged;
+	}
+
+	bool getInfo(DemoInfo* info)
+	{
+		if (s_state == DEMO_IDLE && !s_playbackRequest) { return false; }
+		*info = s_info;
+		return true;
+	}
+
+	void console_demoRecord(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+		char path[TFE_MAX_PATH];
+		getDemoPath(args[1].c_str(), path);
+		if (!postRecordRequest(path))
+		{
+			TFE_Console::addToHistory("A demo is already being recorded or played.");
+		}
+	}
+
+	void console_demoPlay(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+		char path[TFE_MAX_PATH];
+		getDemoPath(args[1].c_str(), path);
+		if (!postPlaybackRequest(path))
+		{
+			TFE_Console::addToHistory("Cannot play the demo, see the log for details.");
+		}
+	}
+
+	void console_demoStop(const ConsoleArgList& args)
+	{
+		s_recordRequest = false;
+		stop();
+	}
+}
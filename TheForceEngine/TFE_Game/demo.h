@@ -0,0 +1,71 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Demo recording and playback.
+// A demo starts from a copy of the game state, captured with the
+// save game serializer, followed by one entry per frame: the change
+// in the raw input state, the frame time and whether the game tasks
+// ran that frame. The input bindings and the game settings that
+// affect the simulation are stored as well and replace the local
+// ones during playback, so the game runs exactly as it was recorded.
+//
+// Frames where the tasks ran may also store a hash of the simulation
+// state (see TFE_Jedi/Level/stateHash.h), so that playback can report
+// the first frame and subsystem where it diverges.
+//
+// Demos can be played back in the game loop or headless at
+// unlimited speed using the --demo command line option.
+//////////////////////////////////////////////////////////////////////
+#include "igame.h"
+
+namespace TFE_Demo
+{
+	enum DemoState
+	{
+		DEMO_IDLE = 0,
+		DEMO_RECORDING,
+		DEMO_PLAYING,
+	};
+
+	struct DemoInfo
+	{
+		u32 version;
+		GameID gameId;
+		u32 seed;				// random seed at the start of the demo.
+		u32 startTick;
+		u32 frameCount;
+		f64 duration;			// sum of the frame times in seconds.
+		char levelName[256];
+		char modList[256];
+	};
+
+	void init();
+	void destroy();
+
+	// Recording or playback is stopped when a different game is started, unless it is loading the demo.
+	void setCurrentGame(IGame* game);
+
+	// Called every frame after the system input is read and before the input mapping is updated.
+	// During playback this replaces the input, frame time and task time limiter with the recorded frame.
+	void beginFrame();
+	// Called after the game update, 'tasksRan' is the result of TFE_Jedi::task_run().
+	void endFrame(bool tasksRan);
+
+	// Recording starts at the end of the next frame in which the game can be saved.
+	bool postRecordRequest(const char* path);
+	// Loads the demo, playback starts once the game has been recreated and startPlayback() is called.
+	bool postPlaybackRequest(const char* path);
+	bool hasPlaybackRequest();
+	// Loads the demo start state into the newly created game.
+	bool startPlayback();
+	// Stops playback, or stops recording and writes the demo file.
+	void stop();
+
+	DemoState getState();
+	// Compare the game state against the hashes stored in the demo during playback, the first divergence is logged.
+	void enableStateCheck(bool enable);
+	// Returns true if the last playback diverged from the recording.
+	bool hasDiverged();
+	// Returns false if no demo is being recorded or played.
+	bool getInfo(DemoInfo* info);
+	void getDemoPath(const char* name, char* path);
+}
@@ -0,0 +1,220 @@
+#include "fastForward.h"
+#include "demo.h"
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <TFE_Jedi/Task/task.h>
+#include <TFE_System/system.h>
+#include <cstdio>
+#include <cstdlib>
+
+namespace TFE_FastForward
+{
+	enum FastForwardConst
+	{
+		FF_DEFAULT_TICKS_PER_FRAME = 16,
+		FF_MAX_TICKS_PER_FRAME = 100000,
+	};
+	// Real time spent on simulation steps per displayed frame when the tick count is unlimited.
+	static const f64 c_unlimitedFrameBudget = 1.0 / 30.0;
+	// Used if the game does not limit the task rate.
+	static const f64 c_defaultStepInterval = 1.0 / 60.0;
+	// The ticks per second are averaged over this much real time.
+	static const f64 c_statsInterval = 0.5;
+
+	static bool s_enabled = false;
+	static s32  s_ticksPerFrame = FF_DEFAULT_TICKS_PER_FRAME;
+	static bool s_drawWorld = true;
+	// True while fast-forward drives the system time, the demo drives it during playback instead.
+	static bool s_ownsTime = false;
+	static bool s_frameActive = false;
+	static bool s_lastStep = false;
+	static u64  s_frameStart = 0;
+
+	// Stats
+	static FastForwardStats s_stats = {};
+	static bool s_statsValid = false;
+	static u64  s_statsStart = 0;
+	static u32  s_statsTick = 0;
+	static f64  s_statsGameTime = 0.0;
+
+	void console_fastForward(const ConsoleArgList& args);
+
+	////////////////////////////////////////////////////////
+	// Internal
+	////////////////////////////////////////////////////////
+	f64 getElapsedTime(u64 start)
+	{
+		return TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+	}
+
+	bool isDemoPlaying()
+	{
+		return TFE_Demo::getState() == TFE_Demo::DEMO_PLAYING || TFE_Demo::hasPlaybackRequest();
+	}
+
+	void releaseTime()
+	{
+		if (s_ownsTime)
+		{
+			TFE_System::setManualTime(false);
+			TFE_Jedi::task_overrideTimeLimiter(JFALSE);
+			s_ownsTime = false;
+		}
+		TFE_Jedi::renderer_setWorldDrawEnabled(JTRUE);
+	}
+
+	////////////////////////////////////////////////////////
+	// API
+	////////////////////////////////////////////////////////
+	void init()
+	{
+		CVAR_INT(s_ticksPerFrame, "g_fastForwardTicks", CVFLAG_NONE, "Simulation steps per displayed frame in fast-forward, 0 = as many as fit in the frame.");
+		CVAR_BOOL(s_drawWorld, "g_fastForwardDraw", CVFLAG_NONE, "Draw the world on the last simulation step of each displayed frame in fast-forward.");
+		CCMD("fastforward", console_fastForward, 0, "Toggle fast-forward, optionally with the number of steps per frame, example: fastforward 64");
+	}
+
+	void destroy()
+	{
+		enable(false, 0);
+	}
+
+	void enable(bool enable, s32 ticksPerFrame)
+	{
+		if (enable)
+		{
+			s_ticksPerFrame = clamp(ticksPerFrame, 0, (s32)FF_MAX_TICKS_PER_FRAME);
+			s_statsValid = false;
+			s_stats = {};
+		}
+		else
+		{
+			releaseTime();
+			s_frameActive = false;
+		}
+		if (enable != s_enabled)
+		{
+			TFE_System::logWrite(LOG_MSG, "FastForward", enable ? "Fast-forward enabled." : "Fast-forward disabled.");
+		}
+		s_enabled = enable;
+	}
+
+	bool isEnabled()
+	{
+		return s_enabled;
+	}
+
+	void beginFrame(bool canRun)
+	{
+		s_frameActive = s_enabled && canRun;
+		if (!s_enabled) { return; }
+
+		if (!s_frameActive)
+		{
+			// Run and draw a single normal step while paused.
+			releaseTime();
+			s_statsValid = false;
+			return;
+		}
+		s_frameStart = TFE_System::getCurrentTimeInTicks();
+	}
+
+	void beginStep(s32 step)
+	{
+		if (!s_frameActive) { return; }
+
+		if (isDemoPlaying())
+		{
+			// The demo sets the frame time and task limiter for each step.
+			s_ownsTime = false;
+		}
+		else
+		{
+			if (!s_ownsTime)
+			{
+				TFE_System::setManualTime(true);
+				s_ownsTime = true;
+			}
+			const f64 interval = TFE_Jedi::task_getMinStepInterval();
+			TFE_System::stepTime(interval > 0.0 ? interval : c_defaultStepInterval);
+			TFE_Jedi::task_overrideTimeLimiter(JTRUE, JTRUE);
+		}
+
+		// Only the last step of the frame is displayed.
+		if (s_ticksPerFrame > 0)
+		{
+			s_lastStep = step + 1 >= s_ticksPerFrame;
+		}
+		else
+		{
+			// Stop when the next step is expected to go over the budget.
+			const f64 elapsed = getElapsedTime(s_frameStart);
+			s_lastStep = step > 0 && elapsed * f64(step + 1) / f64(step) >= c_unlimitedFrameBudget;
+		}
+		TFE_Jedi::renderer_setWorldDrawEnabled((s_lastStep && s_drawWorld) ? JTRUE : JFALSE);
+		s_stats.lastStepCount = step + 1;
+	}
+
+	bool endStep(s32 step, bool canContinue)
+	{
+		if (!s_frameActive) { return false; }
+		return canContinue && !s_lastStep;
+	}
+
+	void endFrame(u32 tick)
+	{
+		if (!s_frameActive) { return; }
+
+		const f64 gameTime = TFE_System::getTime();
+		if (!s_statsValid)
+		{
+			s_statsStart = TFE_System::getCurrentTimeInTicks();
+			s_statsTick = tick;
+			s_statsGameTime = gameTime;
+			s_statsValid = true;
+			return;
+		}
+
+		const f64 elapsed = getElapsedTime(s_statsStart);
+		if (elapsed >= c_statsInterval)
+		{
+			s_stats.ticksPerSecond = f64(tick - s_statsTick) / elapsed;
+			s_stats.speedup = (gameTime - s_statsGameTime) / elapsed;
+			s_statsStart = TFE_System::getCurrentTimeInTicks();
+			s_statsTick = tick;
+			s_statsGameTime = gameTime;
+		}
+	}
+
+	void getStats(FastForwardStats* stats)
+	{
+		*stats = s_stats;
+		stats->ticksPerFrame = s_ticksPerFrame;
+	}
+
+	void console_fastForward(const ConsoleArgList& args)
+	{
+		if (args.size() >= 2)
+		{
+			enable(true, atoi(args[1].c_str()));
+		}
+		else
+		{
+			enable(!s_enabled, s_ticksPerFrame);
+		}
+
+		char res[256];
+		if (!s_enabled)
+		{
+			sprintf(res, "Fast-forward disabled.");
+		}
+		else if (s_ticksPerFrame > 0)
+		{
+			sprintf(res, "Fast-forward enabled, %d steps per frame.", s_ticksPerFrame);
+		}
+		else
+		{
+			sprintf(res, "Fast-forward enabled, unlimited steps per frame.");
+		}
+		TFE_Console::addToHistory(res);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Fast-forward
+// Runs several simulation steps per displayed frame. Each step
+// advances the game time by the task system step interval instead of
+// the real frame time, so the game runs exactly as if it was running
+// at the task rate, only faster. The world is only drawn on the last
+// step of each displayed frame, or not at all.
+//
+// During demo playback the demo provides the frame time instead, and
+// each step plays back one demo frame.
+//////////////////////////////////////////////////////////////////////
+#include "igame.h"
+
+namespace TFE_FastForward
+{
+	struct FastForwardStats
+	{
+		s32 ticksPerFrame;		// 0 = as many as fit in the frame budget.
+		s32 lastStepCount;		// steps run in the last frame.
+		f64 ticksPerSecond;		// game ticks per real second.
+		f64 speedup;			// game time / real time.
+	};
+
+	void init();
+	void destroy();
+
+	// 'ticksPerFrame' = 0 runs as many steps as fit in the frame budget.
+	void enable(bool enable, s32 ticksPerFrame);
+	bool isEnabled();
+
+	// Called before the first simulation step of the frame.
+	// If 'canRun' is false, such as when the game is paused, the frame runs a single normal step.
+	void beginFrame(bool canRun);
+	// Called before each simulation step.
+	void beginStep(s32 step);
+	// Called after each simulation step, returns true if another step should run this frame.
+	// 'canContinue' is false if the step did not run the game tasks or the game is paused.
+	bool endStep(s32 step, bool canContinue);
+	// Called after the last simulation step of the frame, 'tick' is the current game tick.
+	void endFrame(u32 tick);
+
+	void getStats(FastForwardStats* stats);
+}
@@ -29,6 +29,8 @@ struct IGame
 	virtual bool serializeGameState(Stream* stream, const char* filename, bool writeState) { return false; };
 	virtual bool canSave() { return false; }
 	virtual bool isPaused() { return false; }
+	virtual u32  getTick() { return 0; }
+	virtual u32  getRandomSeed() { return 0; }
 	virtual void getLevelName(char* name) {};
 	virtual void getModList(char* modList) {};
 
@@ -0,0 +1,747 @@
+#include "rewind.h"
+#include <TFE_Archive/zstdCompression.h>
+#include <TFE_FileSystem/memorystream.h>
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/system.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace TFE_Rewind
+{
+	enum RewindConst
+	{
+		REWIND_BLOCK_SHIFT = 16,
+		REWIND_BLOCK_SIZE = 1 << REWIND_BLOCK_SHIFT,	// 64Kb blocks, compressed independently.
+		REWIND_KEYFRAME_INTERVAL = 16,					// maximum number of snapshots that share a key frame.
+		REWIND_HASH_SIZE = 16,							// bytes hashed to find a copy in the key frame.
+		REWIND_INDEX_STEP = 8,							// key frame offsets are indexed at this interval.
+		REWIND_MIN_COPY = 16,							// shorter matches are stored as literal bytes.
+		REWIND_COMPRESSION_LEVEL = 1,
+		REWIND_DEFAULT_INTERVAL = 145,					// one snapshot per second.
+		REWIND_DEFAULT_BUDGET_MB = 64,
+	};
+
+	struct Snapshot
+	{
+		u32 id;
+		u32 keyframeId;					// equal to id for key frames.
+		u32 tick;
+		u32 size;						// uncompressed size.
+		// Offsets of each compressed block in 'data', the last offset is the data size.
+		// Delta blocks that are identical to the key frame at the same offset are empty.
+		std::vector<u32> blockOffsets;
+		// Uncompressed size of the delta commands of each block, empty for key frames.
+		std::vector<u32> deltaSizes;
+		std::vector<u8> data;
+	};
+
+	// A delta block is a list of commands, each one followed by 'literalSize' bytes.
+	// The block is rebuilt by appending the literal bytes and then 'copySize' bytes
+	// from the key frame at 'copyOffset'. Copies can come from anywhere in the key frame,
+	// so data that moves when objects are added or removed still matches.
+	struct DeltaCommand
+	{
+		u32 literalSize;
+		u32 copySize;
+		u32 copyOffset;
+	};
+
+	struct CaptureJob
+	{
+		const u8* src;
+		u32 size;
+		bool delta;
+		std::atomic<bool> failed;
+	};
+
+	struct RestoreJob
+	{
+		const Snapshot* snapshot;
+		u8* dst;
+		std::atomic<bool> failed;
+	};
+
+	static std::deque<Snapshot> s_snapshots;
+	static std::vector<std::vector<u8>> s_blockData;
+	// Delta commands per block, before compression.
+	static std::vector<std::vector<u8>> s_deltaData;
+	// Uncompressed copy of the newest key frame, used to encode deltas.
+	static std::vector<u8> s_keyframeState;
+	// Maps a hash of REWIND_HASH_SIZE bytes to the key frame offset + 1 they were found at, 0 = empty.
+	static std::vector<u32> s_keyframeIndex;
+	static u32 s_keyframeIndexShift = 0;
+	static std::vector<u8> s_restoreKey;
+	static MemoryStream s_captureStream;
+	static MemoryStream s_restoreStream;
+
+	static IGame* s_game = nullptr;
+	static size_t s_memoryUsed = 0;
+	static u32 s_nextId = 0;
+	static u32 s_keyframeId = 0;
+	static s32 s_keyframeSnapshots = 0;
+	static u32 s_lastCaptureTick = 0;
+	static bool s_hasCaptureTick = false;
+	static s32 s_restoreCount = 0;
+	static bool s_restorePrepared = false;
+	static u64 s_restoreStartTime = 0;
+	static RewindStats s_stats = { 0 };
+	static u64 s_frameCount = 0;
+	static u64 s_stateBytes = 0;
+	static u64 s_snapshotTotalBytes = 0;
+	static f64 s_totalCaptureTime = 0.0;
+	static f64 s_totalSerializeTime = 0.0;
+
+	// Settings
+	static bool s_enableRewind = false;
+	static s32 s_captureInterval = REWIND_DEFAULT_INTERVAL;
+	static s32 s_memoryBudgetMB = REWIND_DEFAULT_BUDGET_MB;
+
+	// Profiler counters.
+	static s32 s_captureTimeUs = 0;
+	static s32 s_serializeTimeUs = 0;
+	static s32 s_snapshotBytes = 0;
+	static s32 s_memoryUsedKb = 0;
+
+	void console_rewind(const ConsoleArgList& args);
+	void console_rewindStats(const ConsoleArgList& args);
+
+	////////////////////////////////////////////////////////
+	// Internal
+	////////////////////////////////////////////////////////
+	u32 getBlockCount(u32 size)
+	{
+		return (size + REWIND_BLOCK_SIZE - 1) >> REWIND_BLOCK_SHIFT;
+	}
+
+	u32 getBlockSize(u32 size, u32 block)
+	{
+		const u32 start = block << REWIND_BLOCK_SHIFT;
+		return (size - start < REWIND_BLOCK_SIZE) ? size - start : REWIND_BLOCK_SIZE;
+	}
+
+	size_t getMemoryBudget()
+	{
+		return size_t(s_memoryBudgetMB > 0 ? s_memoryBudgetMB : 1) << 20;
+	}
+
+	size_t getSnapshotMemory(const Snapshot& snapshot)
+	{
+		return snapshot.data.size() + (snapshot.blockOffsets.size() + snapshot.deltaSizes.size()) * sizeof(u32);
+	}
+
+	// Memory used to encode deltas against the current key frame.
+	size_t getKeyframeMemory()
+	{
+		return s_keyframeState.size() + s_keyframeIndex.size() * sizeof(u32);
+	}
+
+	f64 getElapsedTime(u64 start)
+	{
+		return TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start);
+	}
+
+	void updateCounters()
+	{
+		s_stats.snapshotCount = (s32)s_snapshots.size();
+		s_stats.keyframeCount = 0;
+		for (size_t i = 0; i < s_snapshots.size(); i++)
+		{
+			if (s_snapshots[i].id == s_snapshots[i].keyframeId) { s_stats.keyframeCount++; }
+		}
+		s_stats.memoryUsed = s_memoryUsed + getKeyframeMemory();
+		s_stats.memoryBudget = getMemoryBudget();
+		s_memoryUsedKb = s32(s_stats.memoryUsed >> 10);
+	}
+
+	const Snapshot* findSnapshot(u32 id)
+	{
+		for (size_t i = 0; i < s_snapshots.size(); i++)
+		{
+			if (s_snapshots[i].id == id) { return &s_snapshots[i]; }
+		}
+		return nullptr;
+	}
+
+	// Drop the oldest snapshots until the buffer fits in the budget. Deltas cannot be restored without
+	// their key frame, so they are dropped along with it. The snapshots using the current key frame are kept.
+	void enforceBudget()
+	{
+		const size_t budget = getMemoryBudget();
+		while (!s_snapshots.empty() && s_memoryUsed + getKeyframeMemory() > budget)
+		{
+			if (s_snapshots.front().keyframeId == s_keyframeId) { break; }
+
+			const u32 keyframeId = s_snapshots.front().keyframeId;
+			while (!s_snapshots.empty() && s_snapshots.front().keyframeId == keyframeId)
+			{
+				s_memoryUsed -= getSnapshotMemory(s_snapshots.front());
+				s_snapshots.pop_front();
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////
+	// Delta encoding
+	////////////////////////////////////////////////////////
+	u32 hashBytes(const u8* data)
+	{
+		u64 v0, v1;
+		memcpy(&v0, data, sizeof(u64));
+		memcpy(&v1, data + sizeof(u64), sizeof(u64));
+		const u64 hash = (v0 * 0x9e3779b97f4a7c15ull ^ v1) * 0xff51afd7ed558ccdull;
+		return u32(hash >> s_keyframeIndexShift);
+	}
+
+	void buildKeyframeIndex()
+	{
+		const u32 keySize = (u32)s_keyframeState.size();
+		u32 indexBits = 10;
+		while ((1u << indexBits) < keySize / REWIND_INDEX_STEP) { indexBits++; }
+		s_keyframeIndexShift = 64 - indexBits;
+		s_keyframeIndex.assign(size_t(1) << indexBits, 0);
+
+		const u8* key = s_keyframeState.data();
+		for (u32 offset = 0; offset + REWIND_HASH_SIZE <= keySize; offset += REWIND_INDEX_STEP)
+		{
+			s_keyframeIndex[hashBytes(key + offset)] = offset + 1;
+		}
+	}
+
+	u32 getMatchLength(const u8* data, const u8* ref, u32 maxLength)
+	{
+		u32 length = 0;
+		for (; length + sizeof(u64) <= maxLength; length += sizeof(u64))
+		{
+			u64 v0, v1;
+			memcpy(&v0, data + length, sizeof(u64));
+			memcpy(&v1, ref + length, sizeof(u64));
+			if (v0 != v1) { break; }
+		}
+		for (; length < maxLength && data[length] == ref[length]; length++);
+		return length;
+	}
+
+	void writeDeltaCommand(std::vector<u8>& out, const u8* literal, u32 literalSize, u32 copySize, u32 copyOffset)
+	{
+		const DeltaCommand cmd = { literalSize, copySize, copyOffset };
+		const size_t pos = out.size();
+		out.resize(pos + sizeof(DeltaCommand) + literalSize);
+		memcpy(out.data() + pos, &cmd, sizeof(DeltaCommand));
+		if (literalSize)
+		{
+			memcpy(out.data() + pos + sizeof(DeltaCommand), literal, literalSize);
+		}
+	}
+
+	// Encode state[start, end) as copies from the key frame and literal bytes.
+	// Most changes do not move the data after them, so the offset of the previous copy is tried first
+	// and the key frame index is only used to find where the data moved to.
+	void encodeDeltaBlock(const u8* state, u32 start, u32 end, std::vector<u8>& out)
+	{
+		const u8* key = s_keyframeState.data();
+		const u32 keySize = (u32)s_keyframeState.size();
+		out.clear();
+
+		s64 shift = 0;	// key frame offset - state offset of the previous copy.
+		u32 pos = start;
+		u32 literalStart = start;
+		while (pos < end)
+		{
+			u32 copyOffset = 0;
+			u32 copySize = 0;
+			const s64 predicted = s64(pos) + shift;
+			if (predicted >= 0 && predicted < s64(keySize))
+			{
+				copyOffset = u32(predicted);
+				copySize = getMatchLength(state + pos, key + copyOffset, min(end - pos, keySize - copyOffset));
+			}
+			if (copySize < REWIND_MIN_COPY && pos + REWIND_HASH_SIZE <= end)
+			{
+				const u32 entry = s_keyframeIndex[hashBytes(state + pos)];
+				if (entry)
+				{
+					const u32 offset = entry - 1;
+					const u32 size = getMatchLength(state + pos, key + offset, min(end - pos, keySize - offset));
+					if (size > copySize)
+					{
+						copyOffset = offset;
+						copySize = size;
+					}
+				}
+			}
+			if (copySize < REWIND_MIN_COPY)
+			{
+				pos++;
+				continue;
+			}
+
+			// Indexed offsets are REWIND_INDEX_STEP apart, so the match may start earlier.
+			while (pos > literalStart && copyOffset > 0 && state[pos - 1] == key[copyOffset - 1])
+			{
+				pos--;
+				copyOffset--;
+				copySize++;
+			}
+			writeDeltaCommand(out, state + literalStart, pos - literalStart, copySize, copyOffset);
+			shift = s64(copyOffset) - s64(pos);
+			pos += copySize;
+			literalStart = pos;
+		}
+		if (literalStart < end)
+		{
+			writeDeltaCommand(out, state + literalStart, end - literalStart, 0, 0);
+		}
+
+		// A block that is unchanged at the same offset is stored as an empty block.
+		DeltaCommand cmd;
+		if (out.size() == sizeof(DeltaCommand))
+		{
+			memcpy(&cmd, out.data(), sizeof(DeltaCommand));
+			if (!cmd.literalSize && cmd.copyOffset == start && cmd.copySize == end - start)
+			{
+				out.clear();
+			}
+		}
+	}
+
+	bool decodeDeltaBlock(const u8* commands, u32 commandSize, u8* dst, u32 size)
+	{
+		const u8* key = s_keyframeState.data();
+		const u64 keySize = s_keyframeState.size();
+		const u8* cmdEnd = commands + commandSize;
+		u32 pos = 0;
+		while (commands < cmdEnd)
+		{
+			DeltaCommand cmd;
+			if (size_t(cmdEnd - commands) < sizeof(DeltaCommand)) { return false; }
+			memcpy(&cmd, commands, sizeof(DeltaCommand));
+			commands += sizeof(DeltaCommand);
+
+			if (size_t(cmdEnd - commands) < cmd.literalSize || u64(pos) + cmd.literalSize + cmd.copySize > size ||
+				u64(cmd.copyOffset) + cmd.copySize > keySize)
+			{
+				return false;
+			}
+			memcpy(dst + pos, commands, cmd.literalSize);
+			commands += cmd.literalSize;
+			pos += cmd.literalSize;
+			memcpy(dst + pos, key + cmd.copyOffset, cmd.copySize);
+			pos += cmd.copySize;
+		}
+		return pos == size;
+	}
+
+	////////////////////////////////////////////////////////
+	// Capture and restore
+	////////////////////////////////////////////////////////
+	void captureBlockJob(s32 index, void* userData)
+	{
+		CaptureJob* job = (CaptureJob*)userData;
+		const u32 start = u32(index) << REWIND_BLOCK_SHIFT;
+		const u32 size = getBlockSize(job->size, index);
+		std::vector<u8>& out = s_blockData[index];
+		if (!job->delta)
+		{
+			if (!zstd_compress(out, job->src + start, size, REWIND_COMPRESSION_LEVEL))
+			{
+				job->failed = true;
+			}
+			return;
+		}
+
+		std::vector<u8>& commands = s_deltaData[index];
+		encodeDeltaBlock(job->src, start, start + size, commands);
+		if (commands.empty())
+		{
+			out.clear();
+		}
+		else if (!zstd_compress(out, commands.data(), (u32)commands.size(), REWIND_COMPRESSION_LEVEL))
+		{
+			job->failed = true;
+		}
+	}
+
+	void capture(u32 tick)
+	{
+		TFE_ZONE("Rewind Capture");
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+
+		s_captureStream.clear();
+		s_captureStream.open(Stream::MODE_WRITE);
+		const bool stateSaved = s_game->serializeGameState(&s_captureStream, nullptr, true);
+		s_captureStream.close();
+		const u32 size = (u32)s_captureStream.getSize();
+		if (!stateSaved || !size) { return; }
+		const u8* state = (const u8*)s_captureStream.data();
+		const f64 serializeTime = getElapsedTime(startTime);
+
+		// Start a new key frame periodically, or if the snapshots using the current one were dropped.
+		const bool keyframe = s_keyframeState.empty() || s_keyframeSnapshots >= REWIND_KEYFRAME_INTERVAL || !findSnapshot(s_keyframeId);
+		CaptureJob job;
+		job.src = state;
+		job.size = size;
+		job.delta = !keyframe;
+		job.failed = false;
+
+		const u32 blockCount = getBlockCount(size);
+		if (s_blockData.size() < blockCount)
+		{
+			s_blockData.resize(blockCount);
+			s_deltaData.resize(blockCount);
+		}
+		TFE_Jobs::parallelFor(s32(blockCount), captureBlockJob, &job);
+		if (job.failed)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Rewind", "Cannot compress the rewind snapshot at tick %u.", tick);
+			return;
+		}
+
+		Snapshot snapshot;
+		snapshot.id = s_nextId++;
+		snapshot.keyframeId = keyframe ? snapshot.id : s_keyframeId;
+		snapshot.tick = tick;
+		snapshot.size = size;
+		snapshot.blockOffsets.resize(blockCount + 1);
+		u32 dataSize = 0;
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			snapshot.blockOffsets[i] = dataSize;
+			dataSize += (u32)s_blockData[i].size();
+		}
+		snapshot.blockOffsets[blockCount] = dataSize;
+		if (!keyframe)
+		{
+			snapshot.deltaSizes.resize(blockCount);
+			for (u32 i = 0; i < blockCount; i++)
+			{
+				snapshot.deltaSizes[i] = (u32)s_deltaData[i].size();
+			}
+		}
+		snapshot.data.resize(dataSize);
+		for (u32 i = 0; i < blockCount; i++)
+		{
+			if (!s_blockData[i].empty())
+			{
+				memcpy(snapshot.data.data() + snapshot.blockOffsets[i], s_blockData[i].data(), s_blockData[i].size());
+			}
+		}
+
+		if (keyframe)
+		{
+			s_keyframeState.assign(state, state + size);
+			buildKeyframeIndex();
+			s_keyframeId = snapshot.id;
+			s_keyframeSnapshots = 0;
+		}
+		s_keyframeSnapshots++;
+		s_memoryUsed += getSnapshotMemory(snapshot);
+		s_snapshots.push_back(std::move(snapshot));
+		enforceBudget();
+
+		s_stats.lastStateSize = size;
+		s_stats.lastSnapshotSize = dataSize;
+		s_stats.lastCaptureTime = getElapsedTime(startTime);
+		s_stats.lastSerializeTime = serializeTime;
+		s_stats.captureCount++;
+		s_stateBytes += size;
+		s_snapshotTotalBytes += dataSize;
+		s_totalCaptureTime += s_stats.lastCaptureTime;
+		s_totalSerializeTime += serializeTime;
+		s_captureTimeUs = s32(s_stats.lastCaptureTime * 1000000.0);
+		s_serializeTimeUs = s32(serializeTime * 1000000.0);
+		s_snapshotBytes = s32(dataSize);
+		updateCounters();
+	}
+
+	void restoreKeyframeBlockJob(s32 index, void* userData)
+	{
+		RestoreJob* job = (RestoreJob*)userData;
+		const Snapshot* snapshot = job->snapshot;
+		const u32 offset = snapshot->blockOffsets[index];
+		const u32 compressedSize = snapshot->blockOffsets[index + 1] - offset;
+		const u32 size = getBlockSize(snapshot->size, index);
+		if (!zstd_decompress(job->dst + (u32(index) << REWIND_BLOCK_SHIFT), size, snapshot->data.data() + offset, compressedSize))
+		{
+			job->failed = true;
+		}
+	}
+
+	// The key frame must already be decoded into s_keyframeState.
+	void restoreDeltaBlockJob(s32 index, void* userData)
+	{
+		RestoreJob* job = (RestoreJob*)userData;
+		const Snapshot* snapshot = job->snapshot;
+		const u32 start = u32(index) << REWIND_BLOCK_SHIFT;
+		const u32 offset = snapshot->blockOffsets[index];
+		const u32 compressedSize = snapshot->blockOffsets[index + 1] - offset;
+		const u32 size = getBlockSize(snapshot->size, index);
+		u8* dst = job->dst + start;
+		if (!compressedSize)
+		{
+			if (u64(start) + size > s_keyframeState.size())
+			{
+				job->failed = true;
+				return;
+			}
+			memcpy(dst, s_keyframeState.data() + start, size);
+			return;
+		}
+
+		std::vector<u8>& commands = s_deltaData[index];
+		commands.resize(snapshot->deltaSizes[index]);
+		if (!zstd_decompress(commands.data(), (u32)commands.size(), snapshot->data.data() + offset, compressedSize) ||
+			!decodeDeltaBlock(commands.data(), (u32)commands.size(), dst, size))
+		{
+			job->failed = true;
+		}
+	}
+
+	////////////////////////////////////////////////////////
+	// API
+	////////////////////////////////////////////////////////
+	void init()
+	{
+		CVAR_BOOL(s_enableRewind, "g_rewindEnable", CVFLAG_NONE, "Capture the game state in memory so it can be rewound.");
+		CVAR_INT(s_captureInterval, "g_rewindInterval", CVFLAG_NONE, "Number of ticks between rewind snapshots, 145 ticks = 1 second.");
+		CVAR_INT(s_memoryBudgetMB, "g_rewindBudgetMB", CVFLAG_NONE, "Memory budget for the rewind snapshots in megabytes.");
+		CCMD("rewind", console_rewind, 1, "Rewind the game by N snapshots, example: rewind 1");
+		CCMD("rewind_stats", console_rewindStats, 0, "Display the rewind capture cost and memory use.");
+
+		TFE_COUNTER(s_captureTimeUs, "Rewind Capture Time (us)");
+		TFE_COUNTER(s_serializeTimeUs, "Rewind Serialize Time (us)");
+		TFE_COUNTER(s_snapshotBytes, "Rewind Snapshot Bytes");
+		TFE_COUNTER(s_memoryUsedKb, "Rewind Memory (Kb)");
+	}
+
+	void destroy()
+	{
+		clear();
+		s_snapshots.shrink_to_fit();
+		s_blockData.clear();
+		s_blockData.shrink_to_fit();
+		s_deltaData.clear();
+		s_deltaData.shrink_to_fit();
+		s_keyframeState.shrink_to_fit();
+		s_keyframeIndex.shrink_to_fit();
+		s_restoreKey.clear();
+		s_restoreKey.shrink_to_fit();
+		s_game = nullptr;
+	}
+
+	void clear()
+	{
+		if (s_stats.captureCount)
+		{
+			TFE_System::logWrite(LOG_MSG, "Rewind", "Captured %d snapshots, %0.3f ms per capture (%0.3f ms serializing), %0.4f ms per frame on average. Snapshots are %0.1f%% of the state size.",
+				s_stats.captureCount, s_totalCaptureTime * 1000.0 / f64(s_stats.captureCount), s_totalSerializeTime * 1000.0 / f64(s_stats.captureCount),
+				s_stats.averageFrameCost * 1000.0, f64(s_snapshotTotalBytes) * 100.0 / f64(s_stateBytes));
+		}
+		s_snapshots.clear();
+		s_keyframeState.clear();
+		s_keyframeIndex.clear();
+		s_memoryUsed = 0;
+		s_keyframeSnapshots = 0;
+		s_hasCaptureTick = false;
+		s_restoreCount = 0;
+		s_restorePrepared = false;
+		s_stats = { 0 };
+		s_frameCount = 0;
+		s_stateBytes = 0;
+		s_snapshotTotalBytes = 0;
+		s_totalCaptureTime = 0.0;
+		s_totalSerializeTime = 0.0;
+		updateCounters();
+	}
+
+	void setCurrentGame(IGame* game)
+	{
+		s_game = game;
+		if (!s_restoreCount)
+		{
+			clear();
+		}
+	}
+
+	void update()
+	{
+		if (!s_enableRewind || !s_game || s_restoreCount) { return; }
+		if (!s_game->canSave() || s_game->isPaused()) { return; }
+
+		// The capture cost is averaged over every frame the game runs, not just the frames that capture.
+		s_frameCount++;
+		const u32 tick = s_game->getTick();
+		// The tick goes backwards when a new level is started.
+		if (!s_hasCaptureTick || tick < s_lastCaptureTick || tick - s_lastCaptureTick >= u32(s_captureInterval > 1 ? s_captureInterval : 1))
+		{
+			s_lastCaptureTick = tick;
+			s_hasCaptureTick = true;
+			capture(tick);
+		}
+		s_stats.averageFrameCost = s_totalCaptureTime / f64(s_frameCount);
+	}
+
+	s32 getSnapshotCount()
+	{
+		return (s32)s_snapshots.size();
+	}
+
+	void getStats(RewindStats* stats)
+	{
+		*stats = s_stats;
+	}
+
+	bool postRestoreRequest(s32 count)
+	{
+		if (count < 1 || count > (s32)s_snapshots.size()) { return false; }
+		s_restoreCount = count;
+		s_restorePrepared = false;
+		return true;
+	}
+
+	bool hasRestoreRequest()
+	{
+		return s_restoreCount > 0;
+	}
+
+	bool prepareRestore()
+	{
+		const s32 count = s_restoreCount;
+		s_restorePrepared = false;
+		if (count < 1 || count > (s32)s_snapshots.size())
+		{
+			s_restoreCount = 0;
+			return false;
+		}
+
+		TFE_ZONE("Rewind Decode");
+		s_restoreStartTime = TFE_System::getCurrentTimeInTicks();
+		const size_t index = s_snapshots.size() - size_t(count);
+		const Snapshot* target = &s_snapshots[index];
+		const Snapshot* keyframe = findSnapshot(target->keyframeId);
+		if (!keyframe || !s_restoreStream.allocate(target->size))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Rewind", "Cannot prepare the rewind snapshot at tick %u.", target->tick);
+			s_restoreCount = 0;
+			return false;
+		}
+
+		// Decode the key frame blocks in parallel, then the delta blocks which copy from it.
+		const bool isKeyframe = keyframe == target;
+		u8* state = (u8*)s_restoreStream.data();
+		s_restoreKey.resize(keyframe->size);
+		RestoreJob job;
+		job.snapshot = keyframe;
+		job.dst = s_restoreKey.data();
+		job.failed = false;
+		TFE_Jobs::parallelFor(s32(getBlockCount(keyframe->size)), restoreKeyframeBlockJob, &job);
+		if (!job.failed)
+		{
+			s_keyframeState.swap(s_restoreKey);
+			if (isKeyframe)
+			{
+				memcpy(state, s_keyframeState.data(), target->size);
+			}
+			else
+			{
+				const u32 blockCount = getBlockCount(target->size);
+				if (s_deltaData.size() < blockCount)
+				{
+					s_blockData.resize(blockCount);
+					s_deltaData.resize(blockCount);
+				}
+				job.snapshot = target;
+				job.dst = state;
+				TFE_Jobs::parallelFor(s32(blockCount), restoreDeltaBlockJob, &job);
+			}
+		}
+		if (job.failed)
+		{
+			// The snapshots are left as they were, so encoding has to start from a new key frame.
+			TFE_System::logWrite(LOG_ERROR, "Rewind", "Cannot decompress the rewind snapshot at tick %u.", target->tick);
+			s_keyframeState.clear();
+			s_keyframeIndex.clear();
+			s_restoreCount = 0;
+			return false;
+		}
+		s_stats.lastDecodeTime = getElapsedTime(s_restoreStartTime);
+		s_restorePrepared = true;
+		return true;
+	}
+
+	bool restoreRequest()
+	{
+		if (!s_restorePrepared && !prepareRestore()) { return false; }
+		const s32 count = s_restoreCount;
+		s_restoreCount = 0;
+		s_restorePrepared = false;
+		if (!s_game) { return false; }
+
+		TFE_ZONE("Rewind Restore");
+		const size_t index = s_snapshots.size() - size_t(count);
+
+		// Newer snapshots are from a future that no longer happens.
+		while (s_snapshots.size() > index + 1)
+		{
+			s_memoryUsed -= getSnapshotMemory(s_snapshots.back());
+			s_snapshots.pop_back();
+		}
+		buildKeyframeIndex();
+		s_keyframeId = s_snapshots.back().keyframeId;
+		s_keyframeSnapshots = 0;
+		for (size_t i = 0; i < s_snapshots.size(); i++)
+		{
+			if (s_snapshots[i].keyframeId == s_keyframeId) { s_keyframeSnapshots++; }
+		}
+		s_lastCaptureTick = s_snapshots.back().tick;
+		s_hasCaptureTick = true;
+
+		s_restoreStream.open(Stream::MODE_READ);
+		const bool result = s_game->serializeGameState(&s_restoreStream, nullptr, false);
+		s_restoreStream.close();
+
+		s_stats.lastRestoreTime = getElapsedTime(s_restoreStartTime);
+		updateCounters();
+		return result;
+	}
+
+	void console_rewind(const ConsoleArgList& args)
+	{
+		if (args.size() < 2) { return; }
+		const s32 count = (s32)strtol(args[1].c_str(), nullptr, 10);
+		if (!postRestoreRequest(count))
+		{
+			char msg[256];
+			sprintf(msg, "Cannot rewind by %d snapshots, %d are available.", count, getSnapshotCount());
+			TFE_Console::addToHistory(msg);
+		}
+	}
+
+	void console_rewindStats(const ConsoleArgList& args)
+	{
+		char msg[256];
+		sprintf(msg, "Rewind: %d snapshots (%d key frames), %u Kb of %u Kb used.", s_stats.snapshotCount, s_stats.keyframeCount,
+			u32(s_stats.memoryUsed >> 10), u32(s_stats.memoryBudget >> 10));
+		TFE_Console::addToHistory(msg);
+		if (!s_stats.captureCount) { return; }
+
+		sprintf(msg, "Last capture: %u byte state, %u byte snapshot, %0.3f ms (%0.3f ms serializing).",
+			s_stats.lastStateSize, s_stats.lastSnapshotSize, s_stats.lastCaptureTime * 1000.0, s_stats.lastSerializeTime * 1000.0);
+		TFE_Console::addToHistory(msg);
+		sprintf(msg, "Average: %0.3f ms per capture, %0.4f ms per frame, snapshots are %0.1f%% of the state size.",
+			s_totalCaptureTime * 1000.0 / f64(s_stats.captureCount), s_stats.averageFrameCost * 1000.0,
+			f64(s_snapshotTotalBytes) * 100.0 / f64(s_stateBytes));
+		TFE_Console::addToHistory(msg);
+		if (s_stats.lastRestoreTime <= 0.0) { return; }
+
+		// Restores reload the level, so they are compared against the one frame goal.
+		sprintf(msg, "Last restore: %0.3f ms (%0.3f ms decoding, the rest is the level reload), %0.1f frames at 60 fps against a goal of 1 frame.",
+			s_stats.lastRestoreTime * 1000.0, s_stats.lastDecodeTime * 1000.0, s_stats.lastRestoreTime * 60.0);
+		TFE_Console::addToHistory(msg);
+	}
+}
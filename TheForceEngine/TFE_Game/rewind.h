@@ -0,0 +1,59 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// In-memory rewind buffer.
+// The game state is captured every few ticks using the save game
+// serializer and kept in a ring of compressed snapshots with a fixed
+// memory budget, the oldest snapshots are dropped first.
+//
+// Snapshots are split into blocks that are compressed in parallel.
+// Each snapshot is either a key frame or a delta against the newest
+// key frame before it, so restoring any snapshot decodes at most two
+// of them. Deltas copy ranges from anywhere in the key frame, so data
+// that moves when objects are added or removed still matches.
+//
+// A restore is a level reload: the game is recreated and the snapshot
+// is loaded like a save game, so it takes much longer than one frame.
+// rewind_stats reports the restore time against a one frame budget.
+//////////////////////////////////////////////////////////////////////
+#include "igame.h"
+
+namespace TFE_Rewind
+{
+	struct RewindStats
+	{
+		s32 snapshotCount;
+		s32 keyframeCount;
+		size_t memoryUsed;			// compressed snapshots + the key frame used for encoding.
+		size_t memoryBudget;
+		u32 lastStateSize;			// uncompressed size of the last captured state.
+		u32 lastSnapshotSize;		// compressed size of the last captured snapshot.
+		f64 lastCaptureTime;		// in seconds, including serialization.
+		f64 lastSerializeTime;
+		f64 lastDecodeTime;			// snapshot decoding only.
+		f64 lastRestoreTime;		// decoding and the level reload.
+		s32 captureCount;
+		f64 averageFrameCost;		// capture time in seconds averaged over every frame, including frames without a capture.
+	};
+
+	void init();
+	void destroy();
+	void clear();
+
+	// The buffer is cleared when a new game is started, unless a snapshot is being restored into it.
+	void setCurrentGame(IGame* game);
+	// Called once per frame before the game update, captures a snapshot if enough ticks have passed.
+	void update();
+
+	s32  getSnapshotCount();
+	void getStats(RewindStats* stats);
+
+	// Request that the game is rewound by 'count' snapshots (1 = the newest snapshot).
+	// The request is handled like loading a save game, see restoreRequest().
+	bool postRestoreRequest(s32 count);
+	bool hasRestoreRequest();
+	// Decode and validate the requested snapshot while the running game still exists.
+	// On failure the request is dropped, so the current game can keep running.
+	bool prepareRestore();
+	// Restore the prepared snapshot into the current game, snapshots newer than it are discarded.
+	bool restoreRequest();
+}
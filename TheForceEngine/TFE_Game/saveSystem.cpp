@@ -3,11 +3,17 @@
 #include <TFE_System/system.h>
 #include <TFE_Settings/gameSourceData.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/memorystream.h>
 
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_Asset/imageAsset.h>
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <string>
+#include <unordered_map>
 
 using namespace TFE_Input;
 
@@ -26,6 +32,16 @@ namespace TFE_SaveSystem
 		SVER_CUR = SVER_INIT
 	};
 
+	enum SaveIndexConst
+	{
+		SAVE_INDEX_MAGIC   = 0x58444953,	// "SIDX"
+		SAVE_INDEX_VERSION = 1,
+		// Version, four length prefixed strings and the image size.
+		SAVE_HEADER_PREFIX_SIZE = 4 + 4 * 256 + 4,
+		SAVE_THUMBNAIL_CACHE_SIZE = 32,
+	};
+	static const char* c_saveIndexName = "saveIndex.cache";
+
 	static SaveRequest s_req = SF_REQ_NONE;
 	static char s_reqFilename[TFE_MAX_PATH];
 	static char s_reqSavename[TFE_MAX_PATH];
@@ -33,36 +49,58 @@ namespace TFE_SaveSystem
 	static IGame* s_game = nullptr;
 	static s32 s_saveDelay = 0;
 
+	// Buffer 0 is used when loading headers, buffer 1 holds the screenshot of the save in progress.
 	static u32* s_imageBuffer[2] = { nullptr, nullptr };
 	static size_t s_imageBufferSize[2] = { 0 };
 
-	void saveHeader(Stream* stream, const char* saveName)
+	// Saves are split in two: the game state and screenshot are captured into memory during the frame,
+	// then the screenshot is encoded and the file is written on the save thread.
+	struct SaveJob
 	{
-		// Generate a screenshot.
-		DisplayInfo displayInfo;
-		TFE_RenderBackend::getDisplayInfo(&displayInfo);
-		size_t size = displayInfo.width * displayInfo.height * 4;
-		if (size > s_imageBufferSize[0])
-		{
-			s_imageBuffer[0] = (u32*)realloc(s_imageBuffer[0], size);
-			s_imageBufferSize[0] = size;
-		}
-		TFE_RenderBackend::captureScreenToMemory(s_imageBuffer[0]);
-		// Save to memory.
-		u8* png = (u8*)malloc(SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4);
-		u32 pngSize = 0;
-		if (png)
-		{
-			pngSize = (u32)TFE_Image::writeImageToMemory(png, displayInfo.width, displayInfo.height,
-								 SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT,
-								 s_imageBuffer[0]);
-		}
-		else
-		{
-			pngSize = 0;
-			png = (u8*)s_imageBuffer[0];
-		}
+		char filePath[TFE_MAX_PATH];
+		u32 imageWidth;
+		u32 imageHeight;
+		MemoryStream header;	// Everything in the header before the image.
+		MemoryStream state;
+	};
+	static SaveJob s_saveJob;
+	static SDL_Thread* s_saveThread = nullptr;
+	static std::atomic<s32> s_saveState(SAVE_STATE_IDLE);
+
+	// Save headers by file name, persisted in the save directory so unmodified saves are not opened.
+	typedef std::unordered_map<std::string, SaveHeader> SaveIndex;
+	static SaveIndex s_saveIndex;
+	static bool s_saveIndexLoaded = false;
 
+	// Thumbnails are decoded on the thumbnail thread and kept in a small LRU cache.
+	struct Thumbnail
+	{
+		u64 modifiedTime;
+		u32 lastUse;
+		bool ready;
+		std::vector<u32> image;
+	};
+	struct ThumbnailRequest
+	{
+		std::string fileName;
+		u64 modifiedTime;
+		u32 imageOffset;
+		u32 imageSize;
+	};
+	typedef std::unordered_map<std::string, Thumbnail> ThumbnailCache;
+	// Shared with the thumbnail thread, guarded by s_thumbnailMutex.
+	static ThumbnailCache s_thumbnails;
+	static std::vector<ThumbnailRequest> s_thumbnailRequests;
+	static char s_thumbnailPath[TFE_MAX_PATH];
+	static bool s_thumbnailQuit = false;
+	// Main thread only.
+	static SDL_Thread* s_thumbnailThread = nullptr;
+	static SDL_mutex* s_thumbnailMutex = nullptr;
+	static SDL_cond* s_thumbnailCond = nullptr;
+	static u32 s_thumbnailUse = 0;
+
+	void saveHeader(Stream* stream, const char* saveName)
+	{
 		// Master version.
 		u32 version = SVER_CUR;
 		stream->write(&version);
@@ -94,6 +132,18 @@ namespace TFE_SaveSystem
 		len = (u8)strlen(modList);
 		stream->write(&len);
 		stream->writeBuffer(modList, len);
+	}
+
+	// The image is written after the rest of the header.
+	void saveHeaderImage(Stream* stream, const u32* image, u32 width, u32 height)
+	{
+		// Save to memory.
+		u8* png = (u8*)malloc(SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * 4);
+		u32 pngSize = 0;
+		if (png)
+		{
+			pngSize = (u32)TFE_Image::writeImageToMemory(png, width, height, SAVE_IMAGE_WIDTH, SAVE_IMAGE_HEIGHT, image);
+		}
 
 		// Image.
 		stream->write(&pngSize);
@@ -101,14 +151,50 @@ namespace TFE_SaveSystem
 		free(png);
 	}
 
+	// Runs on the save thread, so nothing here can log.
+	int saveThreadFunc(void* userData)
+	{
+		SaveJob* job = (SaveJob*)userData;
+
+		bool result = false;
+		FileStream stream;
+		if (stream.open(job->filePath, Stream::MODE_WRITE))
+		{
+			stream.writeBuffer(job->header.data(), (u32)job->header.getSize());
+			saveHeaderImage(&stream, s_imageBuffer[1], job->imageWidth, job->imageHeight);
+			stream.writeBuffer(job->state.data(), (u32)job->state.getSize());
+			stream.close();
+			result = true;
+		}
+
+		s_saveState = result ? SAVE_STATE_COMPLETE : SAVE_STATE_FAILED;
+		return 0;
+	}
+
+	// Wait for the save thread to finish, this must be called before reading save files.
+	void finishSave()
+	{
+		if (!s_saveThread) { return; }
+
+		SDL_WaitThread(s_saveThread, nullptr);
+		s_saveThread = nullptr;
+		if (s_saveState == SAVE_STATE_FAILED)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Cannot write save file '%s'.", s_saveJob.filePath);
+		}
+	}
+
+	// Reads the header up to the thumbnail, which is left in the stream.
 	void loadHeader(Stream* stream, SaveHeader* header, const char* fileName)
 	{
+		memset(header, 0, sizeof(SaveHeader));
+
 		// Master version.
-		u32 version;
+		u32 version = 0;
 		stream->read(&version);
 
 		// Save Name.
-		u8 len;
+		u8 len = 0;
 		stream->read(&len);
 		stream->readBuffer(header->saveName, len);
 		header->saveName[len] = 0;
@@ -136,40 +222,321 @@ namespace TFE_SaveSystem
 		stream->readBuffer(header->modNames, len);
 		header->modNames[len] = 0;
 
-		// Image, re-use buffer 0 for the PNG.
-		u32 pngSize;
+		// Image.
+		u32 pngSize = 0;
 		stream->read(&pngSize);
-		if (pngSize > s_imageBufferSize[0])
+		header->imageOffset = (u32)stream->getLoc();
+		header->imageSize = pngSize;
+	}
+
+	/////////////////////////////////////////////
+	// Save Index
+	/////////////////////////////////////////////
+	void writeIndexString(Stream* stream, const char* str)
+	{
+		const u8 len = (u8)strlen(str);
+		stream->write(&len);
+		stream->writeBuffer(str, len);
+	}
+
+	bool readIndexString(Stream* stream, char* str, size_t bufferSize)
+	{
+		u8 len = 0;
+		stream->read(&len);
+		if (len >= bufferSize) { return false; }
+		stream->readBuffer(str, len);
+		str[len] = 0;
+		return true;
+	}
+
+	void loadSaveIndex()
+	{
+		s_saveIndex.clear();
+		s_saveIndexLoaded = true;
+
+		char indexPath[TFE_MAX_PATH];
+		sprintf(indexPath, "%s%s", s_gameSavePath, c_saveIndexName);
+		FileStream stream;
+		if (!stream.open(indexPath, Stream::MODE_READ))
+		{
+			return;
+		}
+
+		u32 magic = 0, version = 0, count = 0;
+		stream.read(&magic);
+		stream.read(&version);
+		stream.read(&count);
+		if (magic != SAVE_INDEX_MAGIC || version != SAVE_INDEX_VERSION)
+		{
+			return;
+		}
+
+		for (u32 i = 0; i < count; i++)
+		{
+			SaveHeader header = {};
+			if (!readIndexString(&stream, header.fileName, sizeof(header.fileName)) || !readIndexString(&stream, header.saveName, sizeof(header.saveName)) ||
+				!readIndexString(&stream, header.dateTime, sizeof(header.dateTime)) || !readIndexString(&stream, header.levelName, sizeof(header.levelName)) ||
+				!readIndexString(&stream, header.modNames, sizeof(header.modNames)))
+			{
+				// The index is corrupt, the headers are read from the saves instead.
+				s_saveIndex.clear();
+				return;
+			}
+			stream.read(&header.modifiedTime);
+			stream.read(&header.imageOffset);
+			stream.read(&header.imageSize);
+			s_saveIndex[header.fileName] = header;
+		}
+	}
+
+	void writeSaveIndex()
+	{
+		char indexPath[TFE_MAX_PATH];
+		sprintf(indexPath, "%s%s", s_gameSavePath, c_saveIndexName);
+		FileStream stream;
+		if (!stream.open(indexPath, Stream::MODE_WRITE))
 		{
-			s_imageBuffer[0] = (u32*)realloc(s_imageBuffer[0], pngSize);
-			s_imageBufferSize[0] = pngSize;
+			TFE_System::logWrite(LOG_WARNING, "SaveSystem", "Cannot write the save index '%s'.", indexPath);
+			return;
 		}
-		stream->readBuffer(s_imageBuffer[0], pngSize);
 
-		SDL_Surface* image;
-		TFE_Image::readImageFromMemory(&image, pngSize, s_imageBuffer[0]);
-		if (image)
+		const u32 magic = SAVE_INDEX_MAGIC, version = SAVE_INDEX_VERSION, count = (u32)s_saveIndex.size();
+		stream.write(&magic);
+		stream.write(&version);
+		stream.write(&count);
+		for (SaveIndex::const_iterator iSave = s_saveIndex.begin(); iSave != s_saveIndex.end(); ++iSave)
 		{
-			const u32 sz = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * sizeof(u32);
-			memcpy(header->imageData, image->pixels, sz);
-			TFE_Image::free(image);
+			const SaveHeader& header = iSave->second;
+			writeIndexString(&stream, header.fileName);
+			writeIndexString(&stream, header.saveName);
+			writeIndexString(&stream, header.dateTime);
+			writeIndexString(&stream, header.levelName);
+			writeIndexString(&stream, header.modNames);
+			stream.write(&header.modifiedTime);
+			stream.write(&header.imageOffset);
+			stream.write(&header.imageSize);
 		}
 	}
 
 	void populateSaveDirectory(std::vector<SaveHeader>& dir)
 	{
+		finishSave();
+		if (!s_saveIndexLoaded)
+		{
+			loadSaveIndex();
+		}
+
 		dir.clear();
 		FileList fileList;
 		FileUtil::readDirectory(s_gameSavePath, "tfe", fileList);
 		size_t saveCount = fileList.size();
 		dir.resize(saveCount);
 
+		bool indexChanged = false;
+		SaveIndex prevIndex;
+		std::swap(prevIndex, s_saveIndex);
+
 		const std::string* filenames = fileList.data();
 		SaveHeader* headers = dir.data();
 		for (size_t i = 0; i < saveCount; i++)
 		{
-			loadGameHeader(filenames[i].c_str(), &headers[i]);
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", s_gameSavePath, filenames[i].c_str());
+			const u64 modifiedTime = FileUtil::getModifiedTime(filePath);
+
+			SaveIndex::const_iterator iSave = prevIndex.find(filenames[i]);
+			if (iSave != prevIndex.end() && iSave->second.modifiedTime == modifiedTime)
+			{
+				headers[i] = iSave->second;
+			}
+			else
+			{
+				loadGameHeader(filenames[i].c_str(), &headers[i]);
+				indexChanged = true;
+			}
+			s_saveIndex[filenames[i]] = headers[i];
+		}
+
+		// Write the index if any save was added, modified or removed.
+		if (indexChanged || prevIndex.size() != s_saveIndex.size())
+		{
+			writeSaveIndex();
+		}
+	}
+
+	/////////////////////////////////////////////
+	// Thumbnails
+	/////////////////////////////////////////////
+	// Runs on the thumbnail thread, so nothing here can log.
+	bool decodeThumbnail(const char* filePath, u32 imageOffset, u32 imageSize, std::vector<u32>& image)
+	{
+		if (!imageSize) { return false; }
+
+		FileStream stream;
+		if (!stream.open(filePath, Stream::MODE_READ))
+		{
+			return false;
+		}
+		std::vector<u8> png(imageSize);
+		stream.seek(imageOffset);
+		const bool readOk = stream.readBuffer(png.data(), imageSize) == imageSize;
+		stream.close();
+		if (!readOk) { return false; }
+
+		// TFE_Image::free() is not thread safe, so the surface is freed directly.
+		SDL_Surface* surface = nullptr;
+		TFE_Image::readImageFromMemory(&surface, imageSize, (const u32*)png.data());
+		if (!surface) { return false; }
+
+		bool result = false;
+		if (surface->w == SAVE_IMAGE_WIDTH && surface->h == SAVE_IMAGE_HEIGHT && surface->format->BytesPerPixel == 4)
+		{
+			image.resize(SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT);
+			for (s32 y = 0; y < SAVE_IMAGE_HEIGHT; y++)
+			{
+				memcpy(&image[y * SAVE_IMAGE_WIDTH], (u8*)surface->pixels + y * surface->pitch, SAVE_IMAGE_WIDTH * sizeof(u32));
+			}
+			result = true;
+		}
+		SDL_FreeSurface(surface);
+		return result;
+	}
+
+	int thumbnailThreadFunc(void* userData)
+	{
+		SDL_LockMutex(s_thumbnailMutex);
+		while (1)
+		{
+			while (!s_thumbnailQuit && s_thumbnailRequests.empty())
+			{
+				SDL_CondWait(s_thumbnailCond, s_thumbnailMutex);
+			}
+			if (s_thumbnailQuit) { break; }
+
+			// The most recent request is usually the one on screen.
+			ThumbnailRequest request = s_thumbnailRequests.back();
+			s_thumbnailRequests.pop_back();
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", s_thumbnailPath, request.fileName.c_str());
+			SDL_UnlockMutex(s_thumbnailMutex);
+
+			std::vector<u32> image;
+			const bool decoded = decodeThumbnail(filePath, request.imageOffset, request.imageSize, image);
+
+			SDL_LockMutex(s_thumbnailMutex);
+			// The entry may have been evicted while decoding.
+			ThumbnailCache::iterator iThumb = s_thumbnails.find(request.fileName);
+			if (decoded && iThumb != s_thumbnails.end() && !iThumb->second.ready && iThumb->second.modifiedTime == request.modifiedTime)
+			{
+				iThumb->second.image.swap(image);
+				iThumb->second.ready = true;
+			}
+		}
+		SDL_UnlockMutex(s_thumbnailMutex);
+		return 0;
+	}
+
+	bool startThumbnailThread()
+	{
+		if (s_thumbnailThread) { return true; }
+
+		s_thumbnailMutex = SDL_CreateMutex();
+		s_thumbnailCond = SDL_CreateCond();
+		s_thumbnailQuit = false;
+		if (s_thumbnailMutex && s_thumbnailCond)
+		{
+			s_thumbnailThread = SDL_CreateThread(thumbnailThreadFunc, "TFE_ThumbnailThread", nullptr);
+		}
+		if (!s_thumbnailThread)
+		{
+			TFE_System::logWrite(LOG_ERROR, "SaveSystem", "Cannot create the save thumbnail thread.");
+			if (s_thumbnailMutex) { SDL_DestroyMutex(s_thumbnailMutex); }
+			if (s_thumbnailCond)  { SDL_DestroyCond(s_thumbnailCond); }
+			s_thumbnailMutex = nullptr;
+			s_thumbnailCond = nullptr;
+			return false;
 		}
+		return true;
+	}
+
+	void stopThumbnailThread()
+	{
+		if (!s_thumbnailThread) { return; }
+
+		SDL_LockMutex(s_thumbnailMutex);
+		s_thumbnailQuit = true;
+		SDL_CondSignal(s_thumbnailCond);
+		SDL_UnlockMutex(s_thumbnailMutex);
+		SDL_WaitThread(s_thumbnailThread, nullptr);
+
+		SDL_DestroyMutex(s_thumbnailMutex);
+		SDL_DestroyCond(s_thumbnailCond);
+		s_thumbnailThread = nullptr;
+		s_thumbnailMutex = nullptr;
+		s_thumbnailCond = nullptr;
+		s_thumbnails.clear();
+		s_thumbnailRequests.clear();
+	}
+
+	const u32* getSaveThumbnail(const SaveHeader* header)
+	{
+		if (!header || !startThumbnailThread()) { return nullptr; }
+
+		const u32* image = nullptr;
+		SDL_LockMutex(s_thumbnailMutex);
+		ThumbnailCache::iterator iThumb = s_thumbnails.find(header->fileName);
+		if (iThumb != s_thumbnails.end() && iThumb->second.modifiedTime == header->modifiedTime)
+		{
+			iThumb->second.lastUse = ++s_thumbnailUse;
+			if (iThumb->second.ready)
+			{
+				image = iThumb->second.image.data();
+			}
+			else
+			{
+				// Still pending, move the request to the front of the queue since it was asked for again.
+				for (size_t r = 0; r < s_thumbnailRequests.size(); r++)
+				{
+					if (s_thumbnailRequests[r].fileName == header->fileName)
+					{
+						ThumbnailRequest request = s_thumbnailRequests[r];
+						s_thumbnailRequests.erase(s_thumbnailRequests.begin() + r);
+						s_thumbnailRequests.push_back(request);
+						break;
+					}
+				}
+			}
+		}
+		else
+		{
+			// Evict the least recently used thumbnail.
+			if (iThumb == s_thumbnails.end() && s_thumbnails.size() >= SAVE_THUMBNAIL_CACHE_SIZE)
+			{
+				ThumbnailCache::iterator iOldest = s_thumbnails.begin();
+				for (ThumbnailCache::iterator iCur = s_thumbnails.begin(); iCur != s_thumbnails.end(); ++iCur)
+				{
+					if (iCur->second.lastUse < iOldest->second.lastUse) { iOldest = iCur; }
+				}
+				s_thumbnails.erase(iOldest);
+			}
+
+			Thumbnail& thumbnail = s_thumbnails[header->fileName];
+			thumbnail.modifiedTime = header->modifiedTime;
+			thumbnail.lastUse = ++s_thumbnailUse;
+			thumbnail.ready = false;
+			thumbnail.image.clear();
+
+			// Drop the oldest requests if the list is scrolled faster than thumbnails can be decoded.
+			if (s_thumbnailRequests.size() >= SAVE_THUMBNAIL_CACHE_SIZE)
+			{
+				s_thumbnailRequests.erase(s_thumbnailRequests.begin());
+			}
+			strcpy(s_thumbnailPath, s_gameSavePath);
+			s_thumbnailRequests.push_back({ header->fileName, header->modifiedTime, header->imageOffset, header->imageSize });
+			SDL_CondSignal(s_thumbnailCond);
+		}
+		SDL_UnlockMutex(s_thumbnailMutex);
+		return image;
 	}
 
 	void init()
@@ -178,6 +545,8 @@ namespace TFE_SaveSystem
 
 	void destroy()
 	{
+		finishSave();
+		stopThumbnailThread();
 		for (s32 i = 0; i < 2; i++)
 		{
 			free(s_imageBuffer[i]);
@@ -188,22 +557,62 @@ namespace TFE_SaveSystem
 
 	bool saveGame(const char* filename, const char* saveName)
 	{
-		char filePath[TFE_MAX_PATH];
-		sprintf(filePath, "%s%s", s_gameSavePath, filename);
+		// Only one save can be in flight, since the job buffers are reused.
+		finishSave();
+		SaveJob* job = &s_saveJob;
+		sprintf(job->filePath, "%s%s", s_gameSavePath, filename);
 
-		bool ret = false;
-		FileStream stream;
-		if (stream.open(filePath, Stream::MODE_WRITE))
+		// Generate a screenshot.
+		DisplayInfo displayInfo;
+		TFE_RenderBackend::getDisplayInfo(&displayInfo);
+		size_t size = displayInfo.width * displayInfo.height * 4;
+		if (size > s_imageBufferSize[1])
 		{
-			saveHeader(&stream, saveName);
-			ret = s_game->serializeGameState(&stream, filename, true);
-			stream.close();
+			s_imageBuffer[1] = (u32*)realloc(s_imageBuffer[1], size);
+			s_imageBufferSize[1] = size;
 		}
-		return ret;
+		TFE_RenderBackend::captureScreenToMemory(s_imageBuffer[1]);
+		job->imageWidth  = displayInfo.width;
+		job->imageHeight = displayInfo.height;
+
+		// Snapshot the header and game state.
+		job->header.clear();
+		job->state.clear();
+		job->header.open(Stream::MODE_WRITE);
+		job->state.open(Stream::MODE_WRITE);
+		saveHeader(&job->header, saveName);
+		const bool stateSaved = s_game->serializeGameState(&job->state, filename, true);
+		job->header.close();
+		job->state.close();
+		if (!stateSaved)
+		{
+			return false;
+		}
+
+		// Encode and write on the save thread, fall back to writing in place if it cannot be created.
+		s_saveState = SAVE_STATE_IN_PROGRESS;
+		s_saveThread = SDL_CreateThread(saveThreadFunc, "TFE_SaveThread", job);
+		if (!s_saveThread)
+		{
+			saveThreadFunc(job);
+			return s_saveState == SAVE_STATE_COMPLETE;
+		}
+		return true;
+	}
+
+	bool isSaveInProgress()
+	{
+		return s_saveState == SAVE_STATE_IN_PROGRESS;
+	}
+
+	SaveState getSaveState()
+	{
+		return SaveState(s_saveState.load());
 	}
 
 	bool loadGame(const char* filename)
 	{
+		finishSave();
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
 
@@ -213,6 +622,7 @@ namespace TFE_SaveSystem
 		{
 			SaveHeader header;
 			loadHeader(&stream, &header, filename);
+			stream.seek(header.imageSize, Stream::ORIGIN_CURRENT);
 			ret = s_game->serializeGameState(&stream, filename, false);
 			stream.close();
 		}
@@ -221,17 +631,28 @@ namespace TFE_SaveSystem
 
 	bool loadGameHeader(const char* filename, SaveHeader* header)
 	{
+		finishSave();
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
 
+		// Read the header from a small prefix of the file, the rest is the thumbnail and game state.
 		bool ret = false;
 		FileStream stream;
 		if (stream.open(filePath, Stream::MODE_READ))
 		{
-			loadHeader(&stream, header, filename);
-			strcpy(header->fileName, filename);
+			u8 prefix[SAVE_HEADER_PREFIX_SIZE];
+			const u32 prefixSize = stream.readBuffer(prefix, SAVE_HEADER_PREFIX_SIZE);
 			stream.close();
-			ret = true;
+
+			MemoryStream prefixStream;
+			if (prefixStream.load(prefixSize, prefix))
+			{
+				prefixStream.open(Stream::MODE_READ);
+				loadHeader(&prefixStream, header, filename);
+				strcpy(header->fileName, filename);
+				header->modifiedTime = FileUtil::getModifiedTime(filePath);
+				ret = true;
+			}
 		}
 		return ret;
 	}
@@ -296,6 +717,9 @@ namespace TFE_SaveSystem
 		sprintf(relativePath, "Saves/%s/", TFE_Settings::c_gameName[id]);
 
 		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, relativePath, s_gameSavePath);
+		// The index is per game.
+		s_saveIndex.clear();
+		s_saveIndexLoaded = false;
 		if (!FileUtil::directoryExits(s_gameSavePath))
 		{
 			FileUtil::makeDirectory(s_gameSavePath);
@@ -310,6 +734,11 @@ namespace TFE_SaveSystem
 
 	void update()
 	{
+		// Clean up the save thread once the file has been written.
+		if (s_saveThread && !isSaveInProgress())
+		{
+			finishSave();
+		}
 		if (!s_game) { return; }
 
 		static s32 lastState = 0;
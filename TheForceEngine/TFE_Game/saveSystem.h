@@ -14,6 +14,13 @@ namespace TFE_SaveSystem
 		SAVE_IMAGE_WIDTH  = 426,
 		SAVE_IMAGE_HEIGHT = 240,
 	};
+	enum SaveState
+	{
+		SAVE_STATE_IDLE = 0,
+		SAVE_STATE_IN_PROGRESS,	// The save file is being encoded and written in the background.
+		SAVE_STATE_COMPLETE,	// The last save was written.
+		SAVE_STATE_FAILED,		// The last save could not be written.
+	};
 	struct SaveHeader
 	{
 		char fileName[256];
@@ -21,7 +28,10 @@ namespace TFE_SaveSystem
 		char dateTime[256];
 		char levelName[256];
 		char modNames[256];
-		u32  imageData[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];
+		// The thumbnail is decoded on demand, see getSaveThumbnail().
+		u64  modifiedTime;
+		u32  imageOffset;	// Location of the PNG thumbnail in the save file.
+		u32  imageSize;
 	};
 
 	void init();
@@ -30,10 +40,16 @@ namespace TFE_SaveSystem
 	void setCurrentGame(IGame* game);
 	void setCurrentGame(GameID id);
 	void update();
+	// The game state is captured immediately, the file is written in the background.
 	bool saveGame(const char* filename, const char* saveName);
+	bool isSaveInProgress();
+	SaveState getSaveState();
 	bool loadGame(const char* filename);
-	// Load only the header for UI.
+	// Load only the header for UI, the thumbnail is not decoded.
 	bool loadGameHeader(const char* filename, SaveHeader* header);
+	// Returns the SAVE_IMAGE_WIDTH x SAVE_IMAGE_HEIGHT thumbnail, or null if it is not ready yet - in which
+	// case it is decoded in the background. The pointer is only valid until the next call.
+	const u32* getSaveThumbnail(const SaveHeader* header);
 
 	void postLoadRequest(const char* filename);
 	void postSaveRequest(const char* filename, const char* saveName, s32 delay = 0);
@@ -42,5 +58,6 @@ namespace TFE_SaveSystem
 
 	void getSaveFilenameFromIndex(s32 index, char* name);
 
+	// Headers are read from the save index cache when the save file has not been modified.
 	void populateSaveDirectory(std::vector<SaveHeader>& dir);
 }
\ No newline at end of file
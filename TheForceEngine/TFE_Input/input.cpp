@@ -8,8 +8,6 @@
 
 namespace TFE_Input
 {
-	#define BUFFERED_TEXT_LEN 64
-
 	////////////////////////////////////////////////////////
 	// Input State
 	////////////////////////////////////////////////////////
@@ -140,6 +138,42 @@ namespace TFE_Input
 	{
 		s_relativeMode = enable;
 	}
+
+	void getInputState(InputState* state)
+	{
+		memcpy(state->axis, s_axis, sizeof(s_axis));
+		memcpy(state->mouseWheel, s_mouseWheel, sizeof(s_mouseWheel));
+		memcpy(state->mouseMove, s_mouseMove, sizeof(s_mouseMove));
+		memcpy(state->mouseMoveAccum, s_mouseMoveAccum, sizeof(s_mouseMoveAccum));
+		memcpy(state->mousePos, s_mousePos, sizeof(s_mousePos));
+		memcpy(state->buttonDown, s_buttonDown, CONTROLLER_BUTTON_COUNT);
+		memcpy(state->buttonPressed, s_buttonPressed, CONTROLLER_BUTTON_COUNT);
+		memcpy(state->mouseDown, s_mouseDown, MBUTTON_COUNT);
+		memcpy(state->mousePressed, s_mousePressed, MBUTTON_COUNT);
+		memcpy(state->keyDown, s_keyDown, KEY_COUNT);
+		memcpy(state->keyPressed, s_keyPressed, KEY_COUNT);
+		memcpy(state->keyPressedRepeat, s_keyPressedRepeat, KEY_COUNT);
+		memcpy(state->bufferedKey, s_bufferedKey, KEY_COUNT);
+		memcpy(state->bufferedText, s_bufferedText, BUFFERED_TEXT_LEN);
+	}
+
+	void setInputState(const InputState* state)
+	{
+		memcpy(s_axis, state->axis, sizeof(s_axis));
+		memcpy(s_mouseWheel, state->mouseWheel, sizeof(s_mouseWheel));
+		memcpy(s_mouseMove, state->mouseMove, sizeof(s_mouseMove));
+		memcpy(s_mouseMoveAccum, state->mouseMoveAccum, sizeof(s_mouseMoveAccum));
+		memcpy(s_mousePos, state->mousePos, sizeof(s_mousePos));
+		memcpy(s_buttonDown, state->buttonDown, CONTROLLER_BUTTON_COUNT);
+		memcpy(s_buttonPressed, state->buttonPressed, CONTROLLER_BUTTON_COUNT);
+		memcpy(s_mouseDown, state->mouseDown, MBUTTON_COUNT);
+		memcpy(s_mousePressed, state->mousePressed, MBUTTON_COUNT);
+		memcpy(s_keyDown, state->keyDown, KEY_COUNT);
+		memcpy(s_keyPressed, state->keyPressed, KEY_COUNT);
+		memcpy(s_keyPressedRepeat, state->keyPressedRepeat, KEY_COUNT);
+		memcpy(s_bufferedKey, state->bufferedKey, KEY_COUNT);
+		memcpy(s_bufferedText, state->bufferedText, BUFFERED_TEXT_LEN);
+	}
 	
 	// Buffered Input
 	void setBufferedInput(const char* text)
@@ -13,9 +13,30 @@
 #include <TFE_Input/inputEnum.h>
 
 typedef void(*KeyBindingCallback)(f32 value);
+#define BUFFERED_TEXT_LEN 64
 
 namespace TFE_Input
 {
+	// A copy of the raw input state, used to record and replay input.
+	// Only plain data so it can be compared and written byte by byte.
+	struct InputState
+	{
+		f32 axis[AXIS_COUNT];
+		s32 mouseWheel[2];
+		s32 mouseMove[2];
+		s32 mouseMoveAccum[2];
+		s32 mousePos[2];
+		u8  buttonDown[CONTROLLER_BUTTON_COUNT];
+		u8  buttonPressed[CONTROLLER_BUTTON_COUNT];
+		u8  mouseDown[MBUTTON_COUNT];
+		u8  mousePressed[MBUTTON_COUNT];
+		u8  keyDown[KEY_COUNT];
+		u8  keyPressed[KEY_COUNT];
+		u8  keyPressedRepeat[KEY_COUNT];
+		u8  bufferedKey[KEY_COUNT];
+		char bufferedText[BUFFERED_TEXT_LEN];
+	};
+
 	// Call this once at the end of each frame
 	// to reset transient key events.
 	void endFrame();
@@ -37,6 +58,10 @@ namespace TFE_Input
 
 	void enableRelativeMode(bool enable);
 
+	// Copy the whole input state, the relative mouse mode is not included.
+	void getInputState(InputState* state);
+	void setInputState(const InputState* state);
+
 	// Buffered Input
 	void setBufferedInput(const char* text);
 	void setBufferedKey(KeyboardCode key);
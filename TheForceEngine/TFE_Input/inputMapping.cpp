@@ -187,26 +187,7 @@ namespace TFE_Input
 			return false;
 		}
 
-		file.writeBuffer(c_inputRemappingHdr, 4);
-		file.write(&c_inputRemappingVersion);
-
-		file.write(&s_inputConfig.bindCount);
-		file.write(&s_inputConfig.bindCapacity);
-		file.writeBuffer(s_inputConfig.binds, sizeof(InputBinding), s_inputConfig.bindCount);
-
-		file.write(&s_inputConfig.controllerFlags);
-		file.writeBuffer(s_inputConfig.axis, sizeof(Axis), AA_COUNT);
-		file.write(s_inputConfig.ctrlSensitivity, 2);
-
-		// version: INPUT_ADD_DEADZONE
-		{
-			file.write(s_inputConfig.ctrlDeadzone, 2);
-		}
-
-		file.write(&s_inputConfig.mouseFlags);
-		file.writeBuffer(&s_inputConfig.mouseMode, sizeof(MouseMode));
-		file.write(s_inputConfig.mouseSensitivity, 2);
-
+		inputMapping_writeConfig(&file);
 		file.close();
 		return true;
 	}
@@ -223,28 +204,57 @@ namespace TFE_Input
 			return false;
 		}
 
+		const bool result = inputMapping_readConfig(&file);
+		file.close();
+		return result;
+	}
+
+	void inputMapping_writeConfig(Stream* stream)
+	{
+		stream->writeBuffer(c_inputRemappingHdr, 4);
+		stream->write(&c_inputRemappingVersion);
+
+		stream->write(&s_inputConfig.bindCount);
+		stream->write(&s_inputConfig.bindCapacity);
+		stream->writeBuffer(s_inputConfig.binds, sizeof(InputBinding), s_inputConfig.bindCount);
+
+		stream->write(&s_inputConfig.controllerFlags);
+		stream->writeBuffer(s_inputConfig.axis, sizeof(Axis), AA_COUNT);
+		stream->write(s_inputConfig.ctrlSensitivity, 2);
+
+		// version: INPUT_ADD_DEADZONE
+		{
+			stream->write(s_inputConfig.ctrlDeadzone, 2);
+		}
+
+		stream->write(&s_inputConfig.mouseFlags);
+		stream->writeBuffer(&s_inputConfig.mouseMode, sizeof(MouseMode));
+		stream->write(s_inputConfig.mouseSensitivity, 2);
+	}
+
+	bool inputMapping_readConfig(Stream* stream)
+	{
 		char hdr[4];
 		u32 version;
-		file.readBuffer(hdr, 4);
-		file.read(&version);
+		stream->readBuffer(hdr, 4);
+		stream->read(&version);
 		if (memcmp(hdr, c_inputRemappingHdr, 4) != 0)
 		{
-			file.close();
 			return false;
 		}
 
-		file.read(&s_inputConfig.bindCount);
-		file.read(&s_inputConfig.bindCapacity);
+		stream->read(&s_inputConfig.bindCount);
+		stream->read(&s_inputConfig.bindCapacity);
 		s_inputConfig.binds = (InputBinding*)realloc(s_inputConfig.binds, sizeof(InputBinding) * s_inputConfig.bindCapacity);
-		file.readBuffer(s_inputConfig.binds, sizeof(InputBinding), s_inputConfig.bindCount);
+		stream->readBuffer(s_inputConfig.binds, sizeof(InputBinding), s_inputConfig.bindCount);
 
-		file.read(&s_inputConfig.controllerFlags);
-		file.readBuffer(s_inputConfig.axis, sizeof(Axis), AA_COUNT);
-		file.read(s_inputConfig.ctrlSensitivity, 2);
+		stream->read(&s_inputConfig.controllerFlags);
+		stream->readBuffer(s_inputConfig.axis, sizeof(Axis), AA_COUNT);
+		stream->read(s_inputConfig.ctrlSensitivity, 2);
 
 		if (version >= INPUT_ADD_DEADZONE)
 		{
-			file.read(s_inputConfig.ctrlDeadzone, 2);
+			stream->read(s_inputConfig.ctrlDeadzone, 2);
 		}
 		else
 		{
@@ -252,11 +262,9 @@ namespace TFE_Input
 			s_inputConfig.ctrlDeadzone[1] = 0.1f;
 		}
 
-		file.read(&s_inputConfig.mouseFlags);
-		file.readBuffer(&s_inputConfig.mouseMode, sizeof(MouseMode));
-		file.read(s_inputConfig.mouseSensitivity, 2);
-
-		file.close();
+		stream->read(&s_inputConfig.mouseFlags);
+		stream->readBuffer(&s_inputConfig.mouseMode, sizeof(MouseMode));
+		stream->read(s_inputConfig.mouseSensitivity, 2);
 
 		if (version < INPUT_ADD_QUICKSAVE)
 		{
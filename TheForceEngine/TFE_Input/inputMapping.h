@@ -4,6 +4,7 @@
 //////////////////////////////////////////////////////////////////////
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/paths.h>
+#include <TFE_FileSystem/stream.h>
 #include <TFE_Input/input.h>
 
 namespace TFE_Input
@@ -178,6 +179,9 @@ namespace TFE_Input
 
 	bool inputMapping_serialize();
 	bool inputMapping_restore();
+	// Write or read the bindings and settings using the same format as the input remapping file.
+	void inputMapping_writeConfig(Stream* stream);
+	bool inputMapping_readConfig(Stream* stream);
 		
 	void inputMapping_addBinding(InputBinding* binding);
 	void inputMapping_removeBinding(u32 index);
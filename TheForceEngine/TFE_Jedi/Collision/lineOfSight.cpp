@@ -0,0 +1,451 @@
+#include <cstring>
+#include <vector>
+
+#include "lineOfSight.h"
+#include "collision.h"
+#include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/rsector.h>
+#include <TFE_Jedi/Level/rwall.h>
+#include <TFE_Jedi/Level/sectorPvs.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+#include <TFE_System/jobSystem.h>
+
+namespace TFE_Jedi
+{
+	enum LosConstants
+	{
+		LOS_CACHE_SIZE         = 1024,	// must be a power of 2.
+		LOS_MAX_HIT_WALLS      = 128,	// walls (and mirrors) a single query can pass through before falling back.
+		LOS_MAX_CACHED_SECTORS = 16,	// queries that traverse more sectors are not cached.
+		LOS_BATCH_SIZE         = 16,	// queries per job.
+		LOS_MIN_PARALLEL_COUNT = 32,	// smaller batches are not worth waking the workers for.
+	};
+
+	struct LosPath
+	{
+		fixed16_16 x0;
+		fixed16_16 x1;
+		fixed16_16 z0;
+		fixed16_16 z1;
+	};
+
+	// Per query state, this replaces the shared collision globals and wall collision frames.
+	struct LosTrace
+	{
+		LosPath path;
+		fixed16_16 hitDist;
+
+		// Walls already hit along the path, which are skipped in the same way as
+		// walls marked with the current collision frame.
+		RWall* hitWalls[LOS_MAX_HIT_WALLS];
+		s32 hitWallCount;
+
+		// Sectors traversed by the path, used to validate cached results.
+		s32 sectors[LOS_MAX_CACHED_SECTORS];
+		s32 sectorCount;
+	};
+
+	struct LosCacheEntry
+	{
+		LosRequest req;
+		u32 stamp;		// 0 = empty.
+		JBool canHit;
+		JBool wallHit;
+		s32 sectorCount;
+		s32 sectors[LOS_MAX_CACHED_SECTORS];
+	};
+
+	struct LosJob
+	{
+		LosRequest req;
+		LosCacheEntry* entry;
+		JBool computed;
+		JBool canHit;
+		JBool wallHit;
+		LosTrace trace;
+	};
+
+	static LosCacheEntry s_losCache[LOS_CACHE_SIZE];
+	static std::vector<u32> s_losSectorStamps;
+	static std::vector<LosJob> s_losJobs;
+	// Incremented whenever geometry changes, cached results are valid if no traversed sector has a newer stamp.
+	static u32 s_losStamp = 1;
+
+	////////////////////////////////////////////////////////
+	// Reentrant versions of the collision path tests.
+	// These must match pathIntersectsWall(), computeIntersectPos()
+	// and collision_pathWallCollision() in collision.cpp exactly.
+	////////////////////////////////////////////////////////
+	JBool los_pathIntersectsWall(const LosPath* path, const RWall* wall, fixed16_16* intersectNum, fixed16_16* intersectDen)
+	{
+		const fixed16_16 wallX0 = wall->w0->x;
+		const fixed16_16 wallZ0 = wall->w0->z;
+		const fixed16_16 wallX1 = wall->w1->x;
+		const fixed16_16 wallZ1 = wall->w1->z;
+
+		const fixed16_16 pathDx = path->x1 - path->x0;
+		const fixed16_16 wallDx = wallX0 - wallX1;
+		const fixed16_16 adjPathX0 = (pathDx < 0) ? path->x1 : path->x0;
+		const fixed16_16 adjPathX1 = (pathDx < 0) ? path->x0 : path->x1;
+		if (wallDx > 0 && (adjPathX1 < wallX1 || wallX0 < adjPathX0))
+		{
+			return JFALSE;
+		}
+		else if (wallDx <= 0 && (adjPathX1 < wallX0 || wallX1 < adjPathX0))
+		{
+			return JFALSE;
+		}
+
+		const fixed16_16 pathDz = path->z1 - path->z0;
+		const fixed16_16 wallDz = wallZ0 - wallZ1;
+		const fixed16_16 adjPathZ0 = (pathDz < 0) ? path->z1 : path->z0;
+		const fixed16_16 adjPathZ1 = (pathDz < 0) ? path->z0 : path->z1;
+		if (wallDz > 0 && adjPathZ1 < wallZ1)
+		{
+			return JFALSE;
+		}
+		if (wallZ0 < adjPathZ0 && (adjPathZ1 < wallZ0 || wallZ1 < adjPathZ0))
+		{
+			return JFALSE;
+		}
+
+		const fixed16_16 offsetX = path->x0 - wallX0;
+		const fixed16_16 offsetZ = path->z0 - wallZ0;
+		const fixed16_16 num = mul16(wallDz, offsetX) - mul16(wallDx, offsetZ);
+		const fixed16_16 den = mul16(pathDz, wallDx) - mul16(pathDx, wallDz);
+		if (den <= 0 && (num > 0 || num < den))
+		{
+			return JFALSE;
+		}
+		else if (den > 0 && den > num)
+		{
+			return JFALSE;
+		}
+
+		const fixed16_16 num2 = mul16(pathDx, offsetZ) - mul16(pathDz, offsetX);
+		if (den > 0 && num2 > den)
+		{
+			return JFALSE;
+		}
+		if (num2 > 0 || num2 < den)
+		{
+			return JFALSE;
+		}
+		if (den == 0)
+		{
+			return JFALSE;
+		}
+
+		*intersectNum = num;
+		*intersectDen = den;
+		return JTRUE;
+	}
+
+	JBool los_wallWasHit(const LosTrace* trace, const RWall* wall)
+	{
+		for (s32 i = 0; i < trace->hitWallCount; i++)
+		{
+			if (trace->hitWalls[i] == wall) { return JTRUE; }
+		}
+		return JFALSE;
+	}
+
+	// Returns JFALSE if the trace ran out of space to track hit walls.
+	JBool los_pathWallCollision(RSector* sector, LosTrace* trace, RWall** outWall)
+	{
+		const LosPath* path = &trace->path;
+		RWall* wall = sector->walls;
+		RWall* hitWall = nullptr;
+		trace->hitDist = COL_INFINITY;
+		for (s32 i = 0; i < sector->wallCount; i++, wall++)
+		{
+			if (los_wallWasHit(trace, wall))
+			{
+				continue;
+			}
+
+			fixed16_16 num, den;
+			if (!los_pathIntersectsWall(path, wall, &num, &den))
+			{
+				continue;
+			}
+
+			const fixed16_16 param = div16(num, den);
+			const fixed16_16 dx = path->x1 - path->x0;
+			const fixed16_16 dz = path->z1 - path->z0;
+			const fixed16_16 posX = path->x0 + mul16(param, dx);
+			const fixed16_16 posZ = path->z0 + mul16(param, dz);
+			if ((posX != path->x0 || posZ != path->z0) && mul16(dx, wall->wallDir.z) - mul16(dz, wall->wallDir.x) >= 0)
+			{
+				continue;
+			}
+
+			const fixed16_16 dist = distApprox(path->x0, path->z0, posX, posZ);
+			if (dist < trace->hitDist)
+			{
+				trace->hitDist = dist;
+				hitWall = wall;
+			}
+		}
+
+		*outWall = hitWall;
+		if (hitWall)
+		{
+			if (trace->hitWallCount + 2 > LOS_MAX_HIT_WALLS)
+			{
+				return JFALSE;
+			}
+			trace->hitWalls[trace->hitWallCount++] = hitWall;
+			if (hitWall->mirrorWall)
+			{
+				trace->hitWalls[trace->hitWallCount++] = hitWall->mirrorWall;
+			}
+		}
+		return JTRUE;
+	}
+
+	void los_addTracedSector(LosTrace* trace, RSector* sector)
+	{
+		if (trace->sectorCount < LOS_MAX_CACHED_SECTORS)
+		{
+			trace->sectors[trace->sectorCount] = sector->index;
+		}
+		trace->sectorCount++;
+	}
+
+	// Matches collision_canHitObject().
+	// Returns JFALSE if the query is too long to trace here and has to use the original path.
+	JBool los_trace(const LosRequest* req, LosTrace* trace, JBool* canHit, JBool* wallHit)
+	{
+		const vec3_fixed p0 = req->p0;
+		const vec3_fixed p1 = req->p1;
+		*canHit = JFALSE;
+		*wallHit = JFALSE;
+		trace->hitWallCount = 0;
+		trace->sectorCount = 0;
+
+		const fixed16_16 approxDist = distApprox(p0.x, p0.z, p1.x, p1.z);
+		const fixed16_16 dy = p1.y - p0.y;
+		const fixed16_16 yStep = approxDist ? div16(dy, approxDist) : dy;
+
+		RSector* sector = req->sector0;
+		RWall* hitWall = nullptr;
+		los_addTracedSector(trace, sector);
+
+		// If there is no horizontal movement, there is no possible wall collision.
+		if (p1.x - p0.x != 0 || p1.z - p0.z != 0)
+		{
+			trace->path = { p0.x, p1.x, p0.z, p1.z };
+			if (!los_pathWallCollision(sector, trace, &hitWall)) { return JFALSE; }
+		}
+		while (hitWall)
+		{
+			RSector* nextSector = hitWall->nextSector;
+			if (!nextSector)
+			{
+				*wallHit = JTRUE;
+				return JTRUE;
+			}
+			los_addTracedSector(trace, nextSector);
+			if (hitWall->flags3 & req->exclWallFlags3)
+			{
+				return JTRUE;
+			}
+			const fixed16_16 yHit = p0.y + mul16(trace->hitDist, yStep);
+			const RSector* hitSector = hitWall->sector;
+			if (yHit < hitSector->ceilingHeight || yHit < nextSector->ceilingHeight || yHit > hitSector->floorHeight || yHit > nextSector->floorHeight)
+			{
+				return JTRUE;
+			}
+			sector = nextSector;
+			if (!los_pathWallCollision(nextSector, trace, &hitWall)) { return JFALSE; }
+		}
+		*canHit = (sector == req->sector1) ? JTRUE : JFALSE;
+		return JTRUE;
+	}
+
+	////////////////////////////////////////////////////////
+	// Cache
+	////////////////////////////////////////////////////////
+	u32 los_hashValue(u32 hash, u32 value)
+	{
+		return (hash ^ value) * 16777619u;
+	}
+
+	LosCacheEntry* los_getCacheEntry(const LosRequest* req)
+	{
+		u32 hash = 2166136261u;
+		hash = los_hashValue(hash, u32(req->sector0->index));
+		hash = los_hashValue(hash, u32(req->sector1->index));
+		hash = los_hashValue(hash, u32(req->p0.x));
+		hash = los_hashValue(hash, u32(req->p0.y));
+		hash = los_hashValue(hash, u32(req->p0.z));
+		hash = los_hashValue(hash, u32(req->p1.x));
+		hash = los_hashValue(hash, u32(req->p1.y));
+		hash = los_hashValue(hash, u32(req->p1.z));
+		hash = los_hashValue(hash, req->exclWallFlags3);
+		return &s_losCache[(hash ^ (hash >> 16)) & (LOS_CACHE_SIZE - 1)];
+	}
+
+	u32 los_getSectorStamp(s32 index)
+	{
+		return (index >= 0 && index < (s32)s_losSectorStamps.size()) ? s_losSectorStamps[index] : 0;
+	}
+
+	JBool los_isCacheHit(const LosCacheEntry* entry, const LosRequest* req)
+	{
+		if (!entry->stamp) { return JFALSE; }
+		const LosRequest* key = &entry->req;
+		if (key->sector0 != req->sector0 || key->sector1 != req->sector1 || key->exclWallFlags3 != req->exclWallFlags3 ||
+			key->p0.x != req->p0.x || key->p0.y != req->p0.y || key->p0.z != req->p0.z ||
+			key->p1.x != req->p1.x || key->p1.y != req->p1.y || key->p1.z != req->p1.z)
+		{
+			return JFALSE;
+		}
+		for (s32 i = 0; i < entry->sectorCount; i++)
+		{
+			if (los_getSectorStamp(entry->sectors[i]) > entry->stamp)
+			{
+				return JFALSE;
+			}
+		}
+		return JTRUE;
+	}
+
+	void los_storeResult(LosCacheEntry* entry, const LosRequest* req, const LosTrace* trace, JBool canHit, JBool wallHit)
+	{
+		if (trace->sectorCount > LOS_MAX_CACHED_SECTORS)
+		{
+			return;
+		}
+		entry->req = *req;
+		entry->stamp = s_losStamp;
+		entry->canHit = canHit;
+		entry->wallHit = wallHit;
+		entry->sectorCount = trace->sectorCount;
+		memcpy(entry->sectors, trace->sectors, sizeof(s32) * trace->sectorCount);
+	}
+
+	////////////////////////////////////////////////////////
+	// API Implementation
+	////////////////////////////////////////////////////////
+	void los_clear()
+	{
+		memset(s_losCache, 0, sizeof(s_losCache));
+		s_losSectorStamps.clear();
+		s_losStamp = 1;
+	}
+
+	void los_sectorChanged(RSector* sector)
+	{
+		if (!sector || sector->index < 0) { return; }
+		if (sector->index >= (s32)s_losSectorStamps.size())
+		{
+			s_losSectorStamps.resize(sector->index + 1, 0);
+		}
+		s_losStamp++;
+		s_losSectorStamps[sector->index] = s_losStamp;
+	}
+
+	JBool los_canHitObject(RSector* startSector, RSector* endSector, vec3_fixed p0, vec3_fixed p1, u32 exclWallFlags3, JBool* wallHit)
+	{
+		if (!startSector || !endSector)
+		{
+			const JBool canHit = collision_canHitObject(startSector, endSector, p0, p1, exclWallFlags3);
+			if (wallHit) { *wallHit = s_collision_wallHit; }
+			return canHit;
+		}
+
+		// The line of sight cannot leave the sectors visible from the start sector, so it can never reach the end sector.
+		// Such a trace always ends at a solid wall or earlier, so it is reported as a wall hit.
+		if (!pvs_isVisible(startSector, endSector))
+		{
+			s_collision_wallHit = JTRUE;
+			if (wallHit) { *wallHit = JTRUE; }
+			return JFALSE;
+		}
+
+		const LosRequest req = { startSector, endSector, p0, p1, exclWallFlags3 };
+		LosCacheEntry* entry = los_getCacheEntry(&req);
+
+		JBool canHit, hitWall;
+		if (los_isCacheHit(entry, &req))
+		{
+			canHit = entry->canHit;
+			hitWall = entry->wallHit;
+		}
+		else
+		{
+			LosTrace trace;
+			if (los_trace(&req, &trace, &canHit, &hitWall))
+			{
+				los_storeResult(entry, &req, &trace, canHit, hitWall);
+			}
+			else
+			{
+				canHit = collision_canHitObject(startSector, endSector, p0, p1, exclWallFlags3);
+				hitWall = s_collision_wallHit;
+			}
+		}
+
+		s_collision_wallHit = hitWall;
+		if (wallHit) { *wallHit = hitWall; }
+		return canHit;
+	}
+
+	void los_traceJob(s32 index, void* userData)
+	{
+		const s32 start = index * LOS_BATCH_SIZE;
+		const s32 end = min(start + LOS_BATCH_SIZE, (s32)s_losJobs.size());
+		for (s32 i = start; i < end; i++)
+		{
+			LosJob* job = &s_losJobs[i];
+			job->computed = los_trace(&job->req, &job->trace, &job->canHit, &job->wallHit);
+		}
+	}
+
+	void los_queryBatch(const LosRequest* requests, s32 count)
+	{
+		// Gather the requests that are not already cached.
+		s_losJobs.clear();
+		for (s32 i = 0; i < count; i++)
+		{
+			const LosRequest* req = &requests[i];
+			if (!req->sector0 || !req->sector1) { continue; }
+
+			LosCacheEntry* entry = los_getCacheEntry(req);
+			if (los_isCacheHit(entry, req)) { continue; }
+
+			s_losJobs.push_back({});
+			LosJob* job = &s_losJobs.back();
+			job->req = *req;
+			job->entry = entry;
+		}
+		if (s_losJobs.empty()) { return; }
+
+		// Geometry is read-only while the batch is traced, so the queries can run in parallel.
+		const s32 jobCount = (s32)s_losJobs.size();
+		const s32 batchCount = (jobCount + LOS_BATCH_SIZE - 1) / LOS_BATCH_SIZE;
+		if (jobCount >= LOS_MIN_PARALLEL_COUNT && TFE_Jobs::getWorkerCount() > 0)
+		{
+			TFE_Jobs::parallelFor(batchCount, los_traceJob, nullptr);
+		}
+		else
+		{
+			for (s32 i = 0; i < batchCount; i++)
+			{
+				los_traceJob(i, nullptr);
+			}
+		}
+
+		// Queries that could not be traced here are left to los_canHitObject().
+		for (s32 i = 0; i < jobCount; i++)
+		{
+			const LosJob* job = &s_losJobs[i];
+			if (job->computed)
+			{
+				los_storeResult(job->entry, &job->req, &job->trace, job->canHit, job->wallHit);
+			}
+		}
+	}
+}
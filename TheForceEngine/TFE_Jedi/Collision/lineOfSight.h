@@ -0,0 +1,42 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Line of Sight Service
+// Answers the "can p0 hit p1" queries that actor AI issues every think
+// tick (see collision_canHitObject()) with the same results, but:
+//   * queries are reentrant, so batches can be split across the job
+//     system worker threads.
+//   * results are cached between ticks and stay valid until the
+//     geometry of a traversed sector changes.
+//
+// Any code that changes sector heights, wall vertices, wall flags or
+// adjoins at runtime must call los_sectorChanged() so that cached
+// results are invalidated.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/core_math.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	struct LosRequest
+	{
+		RSector* sector0;
+		RSector* sector1;
+		vec3_fixed p0;
+		vec3_fixed p1;
+		u32 exclWallFlags3;
+	};
+
+	// Clears all cached results, called when level data is cleared or loaded.
+	void los_clear();
+	// Invalidates cached results that traversed 'sector'.
+	void los_sectorChanged(RSector* sector);
+
+	// Matches collision_canHitObject(), including setting s_collision_wallHit.
+	// The optional 'wallHit' receives the same value.
+	JBool los_canHitObject(RSector* startSector, RSector* endSector, vec3_fixed p0, vec3_fixed p1, u32 exclWallFlags3, JBool* wallHit = nullptr);
+	// Computes the results for a batch of requests ahead of time, so that the matching
+	// los_canHitObject() calls later in the tick are cache hits.
+	void los_queryBatch(const LosRequest* requests, s32 count);
+}
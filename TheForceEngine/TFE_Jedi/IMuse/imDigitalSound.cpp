@@ -8,6 +8,8 @@
 #include <TFE_System/system.h>
 #include <TFE_Audio/midi.h>
 #include <TFE_Audio/audioSystem.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/spscQueue.h>
 #include <cassert>
 #include <cstring>
 
@@ -16,9 +18,13 @@ namespace TFE_Jedi
 	#define MAX_SOUND_CHANNELS 16
 	#define DEFAULT_SOUND_CHANNELS 8
 	#define AUDIO_BUFFER_SIZE 512
-	
-	#define AUDIO_LOCK()   TFE_Audio::lock()
-	#define AUDIO_UNLOCK() TFE_Audio::unlock()
+
+	enum ImWaveQueueConst
+	{
+		IM_WAVE_COMMAND_CAPACITY = 256,
+		IM_WAVE_EVENT_CAPACITY   = 256,
+		IM_WAVE_MARKER_SIZE      = 44,	// Marker data after the chunk header, up to the end of the 48 byte chunk buffer.
+	};
 
 	////////////////////////////////////////////////////
 	// Structures
@@ -44,6 +50,9 @@ namespace TFE_Jedi
 
 		s32 detuneTrans;
 		s32 mailbox;
+
+		// TFE: matches the voice playing this sound on the audio thread.
+		u32 generation;
 	};
 
 	struct ImWaveData
@@ -55,6 +64,52 @@ namespace TFE_Jedi
 		s32 chunkIndex;
 	};
 
+	// TFE: The game thread owns the wave sound list, and the audio thread mixes its own copy of each sound.
+	// s_imWaveVoice[i] plays s_imWaveSound[i], they only talk to each other through the queues and stop generations below.
+	struct ImWaveVoice
+	{
+		s32 index;
+		u32 generation;
+		ImSoundId soundId;
+		u8* sndData;
+		ImWaveData data;
+		s32 volume;
+		s32 pan;
+		JBool active;
+		JBool finished;		// Finished playing, but the game thread has not been told yet.
+	};
+
+	// Commands sent from the game thread, applied at the start of ImUpdateWave().
+	// Sounds are stopped through s_imWaveStopGeneration instead, so stopping never fails.
+	enum ImWaveCommandType
+	{
+		IM_WAVE_START = 0,	// Start playing the voice.
+		IM_WAVE_PARAM,		// Change the volume and pan.
+	};
+
+	struct ImWaveCommand
+	{
+		ImWaveCommandType type;
+		ImWaveVoice voice;
+	};
+
+	// Events sent from the audio thread, applied on the game thread by ImUpdateWaveEvents().
+	enum ImWaveEventType
+	{
+		IM_WAVE_FINISHED = 0,
+		IM_WAVE_MAILBOX,
+		IM_WAVE_MARKER,
+	};
+
+	struct ImWaveEvent
+	{
+		ImWaveEventType type;
+		s32 index;
+		u32 generation;
+		s32 mailbox;
+		u8 marker[IM_WAVE_MARKER_SIZE];
+	};
+
 	/////////////////////////////////////////////////////
 	// Internal State
 	/////////////////////////////////////////////////////
@@ -63,7 +118,21 @@ namespace TFE_Jedi
 	static ImWaveSound* s_imWaveSoundList = nullptr;
 	static ImWaveSound  s_imWaveSound[MAX_SOUND_CHANNELS];
 	static ImWaveData   s_imWaveData[MAX_SOUND_CHANNELS];
-	static u8  s_imWaveChunkData[48];
+	static u32 s_imWaveGeneration = 0;
+
+	// Audio thread state.
+	static ImWaveVoice s_imWaveVoice[MAX_SOUND_CHANNELS];
+	static u8  s_imWaveChunkData[48];	// Also used by the game thread while the sound is setup, before the voice exists.
+	static u8  s_imWaveVoiceChunkData[48];
+
+	// Voices with a generation up to this value are stopped.
+	static atomic_u32 s_imWaveStopGeneration[MAX_SOUND_CHANNELS];
+	static SpscQueue<ImWaveCommand, IM_WAVE_COMMAND_CAPACITY> s_imWaveCommands;
+	static SpscQueue<ImWaveEvent, IM_WAVE_EVENT_CAPACITY> s_imWaveEvents;
+
+	// Counters
+	static atomic_s32 s_imWaveEventDrops(0);	// Written by both threads, copied to s_imWaveDropCount on the game thread.
+	static s32 s_imWaveDropCount = 0;			// Wave commands and events dropped because a queue was full.
 	static s32 s_imWaveMixCount = DEFAULT_SOUND_CHANNELS;
 	static s32 s_imWaveNanosecsPerSample;
 	static iMuseInitData* s_imDigitalData;
@@ -93,8 +162,9 @@ namespace TFE_Jedi
 	s32 ImGetWaveParamIntern(ImSoundId soundId, s32 param);
 	s32 ImFreeWaveSoundByIdIntern(ImSoundId soundId);
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex);
-	s32 audioPlaySoundFrame(ImWaveSound* sound);
+	s32 audioPlaySoundFrame(ImWaveVoice* voice);
 	s32 audioWriteToDriver(f32 systemVolume);
+	void ImWaveSendCommand(ImWaveCommandType type, ImWaveSound* sound);
 		
 	/////////////////////////////////////////////////////////// 
 	// API
@@ -110,6 +180,13 @@ namespace TFE_Jedi
 		s_imWaveMixCount = initData->waveMixCount;
 		s_digitalPause = 0;
 		s_imWaveSoundList = nullptr;
+		TFE_COUNTER(s_imWaveDropCount, "ImWaveDropped");
+
+		// The audio thread callback is not set yet, so both sides can be reset.
+		memset(s_imWaveVoice, 0, sizeof(ImWaveVoice) * MAX_SOUND_CHANNELS);
+		s_imWaveCommands.clear();
+		s_imWaveEvents.clear();
+		s_imWaveEventDrops = 0;
 
 		if (initData->waveSpeed == IM_WAVE_11kHz) // <- this is the path taken by Dark Forces DOS
 		{
@@ -153,23 +230,20 @@ namespace TFE_Jedi
 		{
 			return imArgErr;
 		}
+		// The voices were stopped by ImFreeAllWaveSounds() and the audio thread does not touch the sounds themselves.
 		ImFreeAllWaveSounds();
 
-		AUDIO_LOCK();
+		s_imWaveMixCount = count;
+		ImWaveSound* sound = s_imWaveSound;
+		for (s32 i = 0; i < s_imWaveMixCount; i++, sound++)
 		{
-			s_imWaveMixCount = count;
-			ImWaveSound* sound = s_imWaveSound;
-			for (s32 i = 0; i < s_imWaveMixCount; i++, sound++)
-			{
-				sound->prev = nullptr;
-				sound->next = nullptr;
-				ImWaveData* data = ImGetWaveData(i);
-				sound->data = data;
-				data->sound = sound;
-				sound->soundId = IM_NULL_SOUNDID;
-			}
+			sound->prev = nullptr;
+			sound->next = nullptr;
+			ImWaveData* data = ImGetWaveData(i);
+			sound->data = data;
+			data->sound = sound;
+			sound->soundId = IM_NULL_SOUNDID;
 		}
-		AUDIO_UNLOCK();
 
 		return ImComputeAudioNormalization(count);
 	}
@@ -190,8 +264,25 @@ namespace TFE_Jedi
 		return ImStartDigitalSoundIntern(soundId, priority, 0);
 	}
 		
+	// Runs on the audio thread.
 	void ImUpdateWave(f32* buffer, u32 bufferSize, f32 systemVolume)
 	{
+		// Apply the game thread changes since the last buffer.
+		ImWaveCommand cmd;
+		while (s_imWaveCommands.pop(&cmd))
+		{
+			ImWaveVoice* voice = &s_imWaveVoice[cmd.voice.index];
+			if (cmd.type == IM_WAVE_START)
+			{
+				*voice = cmd.voice;
+			}
+			else if (voice->generation == cmd.voice.generation)
+			{
+				voice->volume = cmd.voice.volume;
+				voice->pan = cmd.voice.pan;
+			}
+		}
+
 		// Prepare buffers.
 		s_audioDriverOut = buffer;
 		s_audioOutSize = bufferSize;
@@ -199,18 +290,65 @@ namespace TFE_Jedi
 		memset(s_audioOut, 0, 2*(bufferSize + IM_AUDIO_OVERSAMPLE) * sizeof(s16));
 
 		// Write sounds to s_audioOut.
-		ImWaveSound* sound = s_imWaveSoundList;
-		while (sound)
+		ImWaveVoice* voice = s_imWaveVoice;
+		for (s32 i = 0; i < MAX_SOUND_CHANNELS; i++, voice++)
 		{
-			ImWaveSound* next = sound->next;
-			audioPlaySoundFrame(sound);
-			sound = next;
+			if (voice->generation <= s_imWaveStopGeneration[i].load())
+			{
+				voice->active = JFALSE;
+				voice->finished = JFALSE;
+			}
+			if (voice->active)
+			{
+				audioPlaySoundFrame(voice);
+			}
+			if (voice->finished)
+			{
+				// If the queue is full, try again on the next buffer.
+				ImWaveEvent evt = {};
+				evt.type = IM_WAVE_FINISHED;
+				evt.index = i;
+				evt.generation = voice->generation;
+				voice->finished = s_imWaveEvents.push(evt) ? JFALSE : JTRUE;
+			}
 		}
 
 		// Convert s_audioOut to "driver" buffer.
 		audioWriteToDriver(systemVolume);
 	}
 
+	// Runs on the game thread, applies what the audio thread found while playing the wave sounds.
+	void ImUpdateWaveEvents()
+	{
+		ImWaveEvent evt;
+		while (s_imWaveEvents.pop(&evt))
+		{
+			ImWaveSound* sound = &s_imWaveSound[evt.index];
+			// Ignore events from sounds that have already been freed.
+			if (!sound->soundId || sound->generation != evt.generation)
+			{
+				continue;
+			}
+
+			if (evt.type == IM_WAVE_FINISHED)
+			{
+				ImFreeWaveSound(sound);
+			}
+			else if (evt.type == IM_WAVE_MAILBOX)
+			{
+				if (sound->mailbox == 0)
+				{
+					sound->mailbox = evt.mailbox;
+				}
+			}
+			else if (evt.type == IM_WAVE_MARKER)
+			{
+				ImSetSoundTrigger((ImSoundId)sound, evt.marker);
+			}
+		}
+		s_imWaveDropCount = s_imWaveEventDrops.load(std::memory_order_relaxed);
+	}
+
 	s32 ImPauseDigitalSound()
 	{
 		s_digitalPause = 1;
@@ -270,6 +408,7 @@ namespace TFE_Jedi
 					}
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(value)) >> 7;
 					sound->group = value;
+					ImWaveSendCommand(IM_WAVE_PARAM, sound);
 					return imSuccess;
 				}
 				else if (param == soundPriority)
@@ -289,6 +428,7 @@ namespace TFE_Jedi
 					}
 					sound->baseVolume = value;
 					sound->volume = ((sound->baseVolume + 1) * ImGetGroupVolume(sound->group)) >> 7;
+					ImWaveSendCommand(IM_WAVE_PARAM, sound);
 					return imSuccess;
 				}
 				else if (param == soundPan)
@@ -298,6 +438,7 @@ namespace TFE_Jedi
 						return imArgErr;
 					}
 					sound->pan = value;
+					ImWaveSendCommand(IM_WAVE_PARAM, sound);
 					return imSuccess;
 				}
 				else if (param == soundDetune)
@@ -408,7 +549,6 @@ namespace TFE_Jedi
 			}
 		}
 
-		AUDIO_LOCK();
 		IM_DBG_MSG("ERR: no spare tracks...");
 		s32 minPriority = 127;
 		ImWaveSound* minPrioritySound = nullptr;
@@ -432,8 +572,6 @@ namespace TFE_Jedi
 				newSound = minPrioritySound;
 			}
 		}
-
-		AUDIO_UNLOCK();
 		return newSound;
 	}
 
@@ -444,11 +582,56 @@ namespace TFE_Jedi
 		return nullptr;
 	}
 
-	s32 ImSeekToNextChunk(ImWaveData* data)
+	// TFE: The mixer sends mailbox values and markers to the game thread, which applies them in ImUpdateWaveEvents().
+	void ImWaveSetMailbox(ImWaveData* data, ImWaveVoice* voice, s32 value)
+	{
+		if (!voice)
+		{
+			if (data->sound->mailbox == 0)
+			{
+				data->sound->mailbox = value;
+			}
+			return;
+		}
+
+		ImWaveEvent evt = {};
+		evt.type = IM_WAVE_MAILBOX;
+		evt.index = voice->index;
+		evt.generation = voice->generation;
+		evt.mailbox = value;
+		if (!s_imWaveEvents.push(evt))
+		{
+			s_imWaveEventDrops++;
+		}
+	}
+
+	void ImWaveSetTrigger(ImWaveData* data, ImWaveVoice* voice, u8* marker)
+	{
+		if (!voice)
+		{
+			ImSetSoundTrigger((ImSoundId)data->sound, marker);
+			return;
+		}
+
+		ImWaveEvent evt;
+		evt.type = IM_WAVE_MARKER;
+		evt.index = voice->index;
+		evt.generation = voice->generation;
+		evt.mailbox = 0;
+		memcpy(evt.marker, marker, IM_WAVE_MARKER_SIZE);
+		if (!s_imWaveEvents.push(evt))
+		{
+			s_imWaveEventDrops++;
+		}
+	}
+
+	// voice is null when called from the game thread.
+	s32 ImSeekToNextChunk(ImWaveData* data, ImWaveVoice* voice)
 	{
+		const ImSoundId soundId = voice ? voice->soundId : data->sound->soundId;
 		while (1)
 		{
-			u8* chunkData = s_imWaveChunkData;
+			u8* chunkData = voice ? s_imWaveVoiceChunkData : s_imWaveChunkData;
 			u8* sndData = nullptr;
 
 			if (data->chunkIndex)
@@ -465,14 +648,10 @@ namespace TFE_Jedi
 			}
 			else  // chunkIndex == 0
 			{
-				ImWaveSound* sound = data->sound;
-				sndData = ImInternalGetSoundData(sound->soundId);
+				sndData = voice ? voice->sndData : ImInternalGetSoundData(soundId);
 				if (!sndData)
 				{
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 8;
-					}
+					ImWaveSetMailbox(data, voice, 8);
 					IM_LOG_ERR("%s", "null sound addr in SeekToNextChunk()...");
 					return imFail;
 				}
@@ -497,11 +676,7 @@ namespace TFE_Jedi
 				data->chunkSize = chunkSize;
 				if (chunkSize > 220000)
 				{
-					ImWaveSound* sound = data->sound;
-					if (sound->mailbox == 0)
-					{
-						sound->mailbox = 9;
-					}
+					ImWaveSetMailbox(data, voice, 9);
 				}
 
 				data->offset += (id == 1) ? 6 : 4;
@@ -515,7 +690,7 @@ namespace TFE_Jedi
 			else if (id == 4)
 			{
 				chunkData += 3;
-				ImSetSoundTrigger((ImSoundId)data->sound, chunkData);
+				ImWaveSetTrigger(data, voice, chunkData);
 				data->offset += 6;
 			}
 			else if (id == 6)
@@ -541,7 +716,7 @@ namespace TFE_Jedi
 			{
 				if (chunkData[0] != 'r' || chunkData[1] != 'e' || chunkData[2] != 'a')
 				{
-					IM_LOG_ERR("ERR: Not a valid VOC sound %lu...", data->sound->soundId);
+					IM_LOG_ERR("ERR: Not a valid VOC sound %lu...", soundId);
 					return imFail;
 				}
 				data->offset += 26;
@@ -556,7 +731,7 @@ namespace TFE_Jedi
 				// dont warn on silence (3) and ascii text (5)
 				if ((id != 3) && (id != 5))
 				{
-					IM_LOG_ERR("ERR: Illegal chunk %d in sound %lu...", id, data->sound->soundId);
+					IM_LOG_ERR("ERR: Illegal chunk %d in sound %lu...", id, soundId);
 				}
 				return imFail;
 			}
@@ -578,7 +753,35 @@ namespace TFE_Jedi
 		}
 
 		data->chunkIndex = 0;
-		return ImSeekToNextChunk(data);
+		return ImSeekToNextChunk(data, nullptr);
+	}
+
+	// Game thread: send the sound state the audio thread needs to play it.
+	void ImWaveSendCommand(ImWaveCommandType type, ImWaveSound* sound)
+	{
+		ImWaveCommand cmd = {};
+		cmd.type = type;
+		ImWaveVoice* voice = &cmd.voice;
+		voice->index = s32(sound - s_imWaveSound);
+		voice->generation = sound->generation;
+		voice->volume = sound->volume;
+		voice->pan = sound->pan;
+		if (type == IM_WAVE_START)
+		{
+			voice->soundId = sound->soundId;
+			voice->sndData = ImInternalGetSoundData(sound->soundId);
+			voice->data = *sound->data;
+			voice->active = JTRUE;
+		}
+		if (!s_imWaveCommands.push(cmd))
+		{
+			s_imWaveEventDrops++;
+			// Without the start command the sound never plays, so free it here instead of waiting for the voice.
+			if (type == IM_WAVE_START)
+			{
+				ImFreeWaveSound(sound);
+			}
+		}
 	}
 
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex)
@@ -591,6 +794,7 @@ namespace TFE_Jedi
 		}
 
 		sound->soundId = soundId;
+		sound->generation = ++s_imWaveGeneration;
 		sound->marker = 0;
 		sound->group = 0;
 		sound->priority = priority;
@@ -608,17 +812,15 @@ namespace TFE_Jedi
 			return imFail;
 		}
 
-		AUDIO_LOCK();
-		{
-			IM_LIST_ADD(s_imWaveSoundList, sound);
-		}
-		AUDIO_UNLOCK();
-
-		return imSuccess;
+		IM_LIST_ADD(s_imWaveSoundList, sound);
+		ImWaveSendCommand(IM_WAVE_START, sound);
+		return sound->soundId ? imSuccess : imFail;
 	}
 
 	void ImFreeWaveSound(ImWaveSound* sound)
 	{
+		// Stop the voice, the audio thread checks this before mixing each buffer.
+		s_imWaveStopGeneration[sound - s_imWaveSound].store(sound->generation);
 		IM_LIST_REM(s_imWaveSoundList, sound);
 		ImClearSoundFaders(sound->soundId, -1);
 		ImClearTrigger(sound->soundId, -1, -1);
@@ -632,17 +834,15 @@ namespace TFE_Jedi
 
 	s32 ImFreeAllWaveSounds()
 	{
-		AUDIO_LOCK();
+		ImWaveSound* sound = s_imWaveSoundList;
+		while (sound)
 		{
-			ImWaveSound* sound = s_imWaveSoundList;
-			while (sound)
-			{
-				ImWaveSound* next = sound->next;
-				ImFreeWaveSound(sound);
-				sound = next;
-			}
+			ImWaveSound* next = sound->next;
+			ImFreeWaveSound(sound);
+			sound = next;
 		}
-		AUDIO_UNLOCK();
+		// The sound data is usually unloaded next, so make sure the mixer is no longer reading it.
+		TFE_Audio::waitForAudioThreadCallback();
 		return imSuccess;
 	}
 
@@ -705,9 +905,9 @@ namespace TFE_Jedi
 		digitalAudioOutput_Stereo(&s_audioOut[outOffset * 2], audioFrame, leftMapping, rightMapping, size);
 	}
 
-	s32 audioPlaySoundFrame(ImWaveSound* sound)
+	s32 audioPlaySoundFrame(ImWaveVoice* voice)
 	{
-		ImWaveData* data = sound->data;
+		ImWaveData* data = &voice->data;
 		s32 bufferSize = s_audioOutSize;
 		s32 offset = 0;
 		s32 res = imSuccess;
@@ -716,12 +916,13 @@ namespace TFE_Jedi
 			res = imSuccess;
 			if (!data->chunkSize)
 			{
-				res = ImSeekToNextChunk(data);
+				res = ImSeekToNextChunk(data, voice);
 				if (res != imSuccess)
 				{
-					if (res == imFail)  // Sound has finished playing.
+					if (res == imFail)  // Sound has finished playing, the game thread frees it.
 					{
-						ImFreeWaveSound(sound);
+						voice->active = JFALSE;
+						voice->finished = JTRUE;
 					}
 					break;
 				}
@@ -731,8 +932,8 @@ namespace TFE_Jedi
 			// This is required since the results might be interpolated on upsample.
 			const s32 baseReadSize = min(bufferSize, data->chunkSize);
 			const s32 readSize = min(bufferSize+IM_AUDIO_OVERSAMPLE, data->chunkSize);
-			s_audioData = ImInternalGetSoundData(sound->soundId) + data->offset;
-			audioProcessFrame(s_audioData, readSize, offset, sound->volume, sound->pan);
+			s_audioData = voice->sndData + data->offset;
+			audioProcessFrame(s_audioData, readSize, offset, voice->volume, voice->pan);
 
 			offset += baseReadSize;
 			bufferSize -= baseReadSize;
@@ -762,23 +963,17 @@ namespace TFE_Jedi
 	s32 ImFreeWaveSoundByIdIntern(ImSoundId soundId)
 	{
 		s32 result = imInvalidSound;
-
-		AUDIO_LOCK();
+		ImWaveSound* sound = s_imWaveSoundList;
+		while (sound)
 		{
-			ImWaveSound* sound = s_imWaveSoundList;
-			while (sound)
+			ImWaveSound* next = sound->next;
+			if (sound->soundId == soundId)
 			{
-				ImWaveSound* next = sound->next;
-				if (sound->soundId == soundId)
-				{
-					ImFreeWaveSound(sound);
-					result = imSuccess;
-				}
-				sound = next;
+				ImFreeWaveSound(sound);
+				result = imSuccess;
 			}
+			sound = next;
 		}
-		AUDIO_UNLOCK();
-
 		return result;
 	}
 
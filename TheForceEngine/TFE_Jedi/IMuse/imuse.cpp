@@ -63,6 +63,7 @@ namespace TFE_Jedi
 	/////////////////////////////////////////////////////
 	void ImUpdate();
 	void ImUpdateMidi();
+	void ImUpdateGroupVolumes();
 	void ImUpdateSustainedNotes();
 		
 	void ImAdvanceMidiPlayer(ImPlayerData* playerData);
@@ -145,6 +146,9 @@ namespace TFE_Jedi
 	atomic_s32 s_imPause;
 	atomic_s32 s_midiPaused;
 	atomic_s32 s_midiLock;
+	// 1/60th second and group volume updates counted by ImUpdate(), and run on the game thread by ImUpdateQueued().
+	atomic_s32 s_imQueuedFrames;
+	atomic_s32 s_imQueuedGroupUpdates;
 
 	static iMuseInitData s_imInitData = { 0, IM_WAVE_11kHz, 8, 6944 };
 
@@ -367,6 +371,8 @@ namespace TFE_Jedi
 
 		s_iMuseTimeInMicrosec = 0;
 		s_iMuseTimeLong = 0;
+		s_imQueuedFrames = 0;
+		s_imQueuedGroupUpdates = 0;
 		IM_LOG_MSG("Initializing...COMMANDS module...");
 
 		if (ImSetupFilesModule(&s_imInitData) == imSuccess)
@@ -395,6 +401,8 @@ namespace TFE_Jedi
 		s_iMuseTimeInMicrosec = 0;
 		s_iMuseTimeLong = 0;
 		s_iMuseSystemTime = 0;
+		s_imQueuedFrames = 0;
+		s_imQueuedGroupUpdates = 0;
 		s_midiFrame = 0;
 		s_trackTicksRemaining = 0;
 		s_midiTickDelta = 0;
@@ -643,7 +651,9 @@ namespace TFE_Jedi
 	// Internal "main loop"
 	///////////////////////////////////////////////////////////
 	// Main update entry point which is called at a fixed rate (see ImGetDeltaTime).
-	// This is responsible for updating the midi players and updating digital audio playback.
+	// This is responsible for updating the midi players and runs on the midi scheduler, usually inside the audio callback.
+	// Faders, deferred commands and group volumes can stop sounds, which changes game thread state, so their
+	// updates are counted here and run on the game thread by ImUpdateQueued().
 	void ImUpdate()
 	{
 		const s32 dtInMicrosec = ImGetDeltaTime();
@@ -660,11 +670,7 @@ namespace TFE_Jedi
 		while (s_iMuseTimeInMicrosec >= 16667)
 		{
 			s_iMuseTimeInMicrosec -= 16667;
-			s32 prevTime = s_iMuseSystemTime;
-			s_iMuseSystemTime++;	// increment the system time every 1/60th of a second.
-
-			ImUpdateSoundFaders();
-			ImHandleDeferredCommands();
+			s_imQueuedFrames++;
 		}
 
 		// Update Group Volumes every 6 "frames".
@@ -672,41 +678,67 @@ namespace TFE_Jedi
 		while (s_iMuseTimeLong >= 100000)	// ~6 frames @ 60Hz
 		{
 			s_iMuseTimeLong -= 100000;
+			s_imQueuedGroupUpdates++;
+		}
+	}
 
-			s32 musicVolume = ImSetGroupVol(groupMusic, imGetValue);
-			ImSoundId soundId = IM_NULL_SOUNDID;
-			do
+	void ImUpdateQueued()
+	{
+		s32 frames = s_imQueuedFrames.exchange(0);
+		s32 groupUpdates = s_imQueuedGroupUpdates.exchange(0);
+
+		// Keep the midi players from advancing while these change them, like the other API calls.
+		ImMidiLock();
+		// Free finished wave sounds and apply their markers.
+		ImUpdateWaveEvents();
+		for (; frames > 0; frames--)
+		{
+			s_iMuseSystemTime++;	// increment the system time every 1/60th of a second.
+			ImUpdateSoundFaders();
+			ImHandleDeferredCommands();
+		}
+		for (; groupUpdates > 0; groupUpdates--)
+		{
+			ImUpdateGroupVolumes();
+		}
+		ImMidiUnlock();
+	}
+
+	void ImUpdateGroupVolumes()
+	{
+		s32 musicVolume = ImSetGroupVol(groupMusic, imGetValue);
+		ImSoundId soundId = IM_NULL_SOUNDID;
+		do
+		{
+			soundId = ImGetNextSound(soundId);
+			if (soundId)
 			{
-				soundId = ImGetNextSound(soundId);
-				if (soundId)
+				if (ImGetParam(soundId, soundGroup) == groupVoice)
 				{
-					if (ImGetParam(soundId, soundGroup) == groupVoice)
-					{
-						musicVolume = (musicVolume * 82) >> imVolumeShift;
-						break;
-					}
+					musicVolume = (musicVolume * 82) >> imVolumeShift;
+					break;
 				}
-			} while (soundId);
+			}
+		} while (soundId);
 
-			s32 dippedMusicVolume = ImSetGroupVol(groupDippedMusic, imGetValue);
-			if (dippedMusicVolume > musicVolume)
+		s32 dippedMusicVolume = ImSetGroupVol(groupDippedMusic, imGetValue);
+		if (dippedMusicVolume > musicVolume)
+		{
+			dippedMusicVolume -= 6;
+			if (dippedMusicVolume <= musicVolume)
 			{
-				dippedMusicVolume -= 6;
-				if (dippedMusicVolume <= musicVolume)
-				{
-					dippedMusicVolume = musicVolume;
-				}
-				ImSetGroupVol(groupDippedMusic, dippedMusicVolume);
+				dippedMusicVolume = musicVolume;
 			}
-			else if (dippedMusicVolume != musicVolume)
+			ImSetGroupVol(groupDippedMusic, dippedMusicVolume);
+		}
+		else if (dippedMusicVolume != musicVolume)
+		{
+			dippedMusicVolume += 3;
+			if (dippedMusicVolume >= musicVolume)
 			{
-				dippedMusicVolume += 3;
-				if (dippedMusicVolume >= musicVolume)
-				{
-					dippedMusicVolume = musicVolume;
-				}
-				ImSetGroupVol(groupDippedMusic, dippedMusicVolume);
+				dippedMusicVolume = musicVolume;
 			}
+			ImSetGroupVol(groupDippedMusic, dippedMusicVolume);
 		}
 	}
 
@@ -134,6 +134,9 @@ namespace TFE_Jedi
 	////////////////////////////////////////////////////
 	s32 ImSetDigitalChannelCount(s32 count);
 	s32 ImReintializeMidi();
+	// Run the fader, deferred command and group volume updates queued by the midi scheduler.
+	// Called once per frame from the game thread.
+	void ImUpdateQueued();
 
 	////////////////////////////////////////////////////
 	// Low level functions
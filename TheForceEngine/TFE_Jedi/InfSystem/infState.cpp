@@ -6,6 +6,7 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/stateHash.h>
 #include <cstring>
 
 using namespace TFE_DarkForces;
@@ -31,6 +32,7 @@ namespace TFE_Jedi
 	void inf_serializeFixupLinks();
 
 	void inf_computeElevValuePointer(InfElevator* elev);
+	s32  inf_getTriggerFrameIndex(const InfTrigger* trigger);
 	extern void inf_deleteElevator(InfElevator* elev);
 	extern void inf_deleteTrigger(InfTrigger* trigger);
 
@@ -448,20 +450,8 @@ namespace TFE_Jedi
 		s32 frameIndex = -1;
 		if (serialization_getMode() == SMODE_WRITE)
 		{
-			AnimatedTexture* animTex = trigger->animTex;
-			if (trigger->tex && animTex)
-			{
-				// Which frame is it currently on?
-				for (s32 f = 0; f < animTex->count; f++)
-				{
-					if (trigger->tex == animTex->frameList[f])
-					{
-						frameIndex = f;
-						break;
-					}
-				}
-				assert(frameIndex >= 0);
-			}
+			frameIndex = inf_getTriggerFrameIndex(trigger);
+			assert(frameIndex >= 0 || !trigger->tex || !trigger->animTex);
 		}
 		SERIALIZE(InfState_InitVersion, frameIndex, -1);
 		if (serialization_getMode() == SMODE_READ)
@@ -884,4 +874,81 @@ namespace TFE_Jedi
 				assert(0);
 		};
 	}
+
+	// Which frame of its animated sign texture is the trigger currently on? Returns -1 if there is none.
+	s32 inf_getTriggerFrameIndex(const InfTrigger* trigger)
+	{
+		const AnimatedTexture* animTex = trigger->animTex;
+		if (!trigger->tex || !animTex) { return -1; }
+
+		for (s32 f = 0; f < animTex->count; f++)
+		{
+			if (trigger->tex == animTex->frameList[f])
+			{
+				return f;
+			}
+		}
+		return -1;
+	}
+
+	u32 inf_hashState()
+	{
+		u32 sum = 0;
+		if (s_infSerState.infElevators)
+		{
+			// The elevator task may be part way through the elevator list.
+			allocator_saveIter(s_infSerState.infElevators);
+			InfElevator* elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
+			while (elev)
+			{
+				if (!elev->deleted)
+				{
+					u32 hash = stateHash_begin();
+					hash = stateHash_add(hash, elev->type);
+					hash = stateHash_add(hash, elev->sector ? elev->sector->index : -1);
+					hash = stateHash_add(hash, elev->key);
+					hash = stateHash_add(hash, elev->nextTick);
+					hash = stateHash_add(hash, elev->timer);
+					hash = stateHash_add(hash, elev->nextStop ? elev->nextStop->index : -1);
+					hash = stateHash_add(hash, elev->speed);
+					hash = stateHash_add(hash, elev->value ? *elev->value : 0);
+					hash = stateHash_add(hash, elev->iValue);
+					hash = stateHash_add(hash, elev->dirOrCenter.x);
+					hash = stateHash_add(hash, elev->dirOrCenter.z);
+					hash = stateHash_add(hash, elev->flags);
+					hash = stateHash_add(hash, elev->updateFlags);
+					hash = stateHash_add(hash, elev->prevValue);
+					sum += stateHash_end(hash);
+				}
+				elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+			}
+			allocator_restoreIter(s_infSerState.infElevators);
+		}
+
+		if (s_infSerState.infTriggers)
+		{
+			allocator_saveIter(s_infSerState.infTriggers);
+			InfTrigger* trigger = (InfTrigger*)allocator_getHead(s_infSerState.infTriggers);
+			while (trigger)
+			{
+				if (!trigger->deleted)
+				{
+					u32 hash = stateHash_begin();
+					hash = stateHash_add(hash, trigger->type);
+					hash = stateHash_add(hash, trigger->cmd);
+					hash = stateHash_add(hash, trigger->event);
+					hash = stateHash_add(hash, trigger->timer);
+					hash = stateHash_add(hash, trigger->time);
+					hash = stateHash_add(hash, trigger->master);
+					hash = stateHash_add(hash, trigger->state);
+					// The switch sign shown on the trigger wall.
+					hash = stateHash_add(hash, inf_getTriggerFrameIndex(trigger));
+					sum += stateHash_end(hash);
+				}
+				trigger = (InfTrigger*)allocator_getNext(s_infSerState.infTriggers);
+			}
+			allocator_restoreIter(s_infSerState.infTriggers);
+		}
+		return stateHash_add(sum, s_infSerState.activeTriggerCount);
+	}
 }
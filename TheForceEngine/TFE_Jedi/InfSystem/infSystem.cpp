@@ -15,12 +15,16 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Level/level.h>
 #include <TFE_Jedi/Level/levelData.h>
+#include <TFE_Jedi/Level/stateHash.h>
 #include <TFE_Jedi/Collision/collision.h>
+#include <TFE_Jedi/Collision/lineOfSight.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_System/parser.h>
 #include <TFE_System/system.h>
 #include <TFE_System/memoryPool.h>
 #include <TFE_System/math.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_FrontEndUI/console.h>
 #include <TFE_Jedi/Level/rtexture.h>
 #include <TFE_Jedi/Task/task.h>
 // TODO: This will make adding Outlaws harder, fix the abstraction.
@@ -41,6 +45,13 @@ namespace TFE_Jedi
 		DELAY_SLEEP = 0xffffffff,
 	};
 
+	enum ElevBatchConstants
+	{
+		ELEV_BATCH_SIZE = 16,					// elevators per job.
+		ELEV_BATCH_MIN_PARALLEL_COUNT = 64,		// smaller batches are not worth waking the workers for.
+		ELEV_VERIFY_LOG_INTERVAL = 1000,		// verified batches between summary log messages.
+	};
+
 	const fixed16_16 c_verticalElevCrushThres  = 0x3000;	// 0x4000 in the original code, reduced to account for higher framerate.
 	const fixed16_16 c_verticalElevCrushThres2 = 0x1000;
 
@@ -66,6 +77,25 @@ namespace TFE_Jedi
 	static char s_infArg4[256];
 	static char s_infArgExtra[256];
 
+	// Elevators updated ahead of the main elevator loop, see inf_updateElevatorBatch().
+	struct ElevBatchEntry
+	{
+		InfElevator* elev;
+		JBool reachedStop;
+	};
+	static std::vector<ElevBatchEntry> s_elevBatch;
+	static std::vector<u8> s_elevBatchSectorUsed;
+	static s32 s_elevBatchPos = 0;
+	static bool s_parallelElevators = false;
+	// Parallel update verification, see inf_verifyElevatorBatch().
+	static bool s_verifyParallelElevators = false;
+	static std::vector<u8> s_elevVerifyState;
+	static s32 s_elevVerifyBatches = 0;
+	static s32 s_elevVerifyElevators = 0;
+	static s32 s_elevVerifyMismatches = 0;
+	static f64 s_elevVerifySerialTime = 0.0;
+	static f64 s_elevVerifyParallelTime = 0.0;
+
 	// DOS hack... this is required since elevators with an invalid delay use the previous valid delay.
 	static Tick s_prevStopDelay = 0;
 
@@ -81,6 +111,7 @@ namespace TFE_Jedi
 	void inf_deleteElevator(InfElevator* elev);
 	void inf_deleteTrigger(InfTrigger* trigger);
 	JBool updateElevator(InfElevator* elev);
+	fixed16_16 inf_getElevatorFrameDelta(InfElevator* elev, fixed16_16 pos, fixed16_16 targetPos);
 	void elevHandleStopDelay(InfElevator* elev);
 	Stop* inf_advanceStops(Allocator* stops, s32 absoluteStop, s32 relativeStop);
 	bool inf_parseElevatorCommand(s32 argCount, KEYWORD action, Allocator* linkAlloc, bool seqEnd, InfElevator*& elev, s32& initStopIndex, InfLink*& link);
@@ -119,6 +150,8 @@ namespace TFE_Jedi
 
 	void inf_createElevatorTask()
 	{
+		CVAR_BOOL(s_parallelElevators, "d_parallelElevators", CVFLAG_DO_NOT_SERIALIZE, "Update independent scrolling and lighting elevators on worker threads.");
+		CVAR_BOOL(s_verifyParallelElevators, "d_verifyParallelElevators", CVFLAG_DO_NOT_SERIALIZE, "Update each elevator batch both in order and in parallel, compare the results and log the timings.");
 		s_infSerState.infElevators = allocator_create(sizeof(InfElevator));
 		s_infState.infElevTask = createSubTask("elevator", inf_elevatorTaskFunc, inf_elevatorTaskLocal);
 	}
@@ -1500,6 +1533,256 @@ namespace TFE_Jedi
 		}
 	}
 
+	// Scrolling and lighting elevators only change their own sectors and slaves, and the new value is
+	// known before the update. So they can be updated in parallel as long as they do not share sectors.
+	// Other elevator types move objects, check for crushing, etc. and are always updated in order.
+	bool inf_canUpdateInParallel(InfElevator* elev)
+	{
+		switch (elev->type)
+		{
+			case IELEV_SCROLL_WALL:
+			case IELEV_SCROLL_FLOOR:
+			case IELEV_SCROLL_CEILING:
+			case IELEV_CHANGE_LIGHT:
+			case IELEV_CHANGE_WALL_LIGHT:
+				return true;
+			default:
+				break;
+		}
+		return false;
+	}
+
+	// Returns JTRUE if updateElevator() will report that the elevator reached its next stop.
+	// This is only valid if no earlier elevator in the batch changes the same value, see inf_claimBatchSectors().
+	JBool inf_elevatorWillReachStop(InfElevator* elev)
+	{
+		Stop* nextStop = elev->nextStop;
+		if (!nextStop) { return JFALSE; }
+
+		const fixed16_16 pos = *elev->value;
+		const fixed16_16 targetPos = nextStop->value;
+		if (pos == targetPos) { return JTRUE; }
+		return (pos + inf_getElevatorFrameDelta(elev, pos, targetPos) == targetPos) ? JTRUE : JFALSE;
+	}
+
+	bool inf_isBatchSectorUsed(RSector* sector)
+	{
+		if (!sector || sector->index < 0 || sector->index >= (s32)s_elevBatchSectorUsed.size()) { return false; }
+		return s_elevBatchSectorUsed[sector->index] != 0;
+	}
+
+	void inf_setBatchSectorUsed(RSector* sector, u8 used)
+	{
+		if (!sector || sector->index < 0 || sector->index >= (s32)s_elevBatchSectorUsed.size()) { return; }
+		s_elevBatchSectorUsed[sector->index] = used;
+	}
+
+	void inf_setBatchSectorsUsed(InfElevator* elev, u8 used)
+	{
+		inf_setBatchSectorUsed(elev->sector, used);
+		Slave* child = (Slave*)allocator_getHead(elev->slaves);
+		while (child)
+		{
+			inf_setBatchSectorUsed(child->sector, used);
+			child = (Slave*)allocator_getNext(elev->slaves);
+		}
+	}
+
+	// Returns false if the elevator changes a sector that an earlier elevator in the batch already changes.
+	// The elevator value is either in its own sector or the elevator itself, so elevators with separate sectors
+	// are fully independent: they can run in any order and the stop prediction is exact.
+	bool inf_claimBatchSectors(InfElevator* elev)
+	{
+		if (inf_isBatchSectorUsed(elev->sector)) { return false; }
+		Slave* child = (Slave*)allocator_getHead(elev->slaves);
+		while (child)
+		{
+			if (inf_isBatchSectorUsed(child->sector)) { return false; }
+			child = (Slave*)allocator_getNext(elev->slaves);
+		}
+		inf_setBatchSectorsUsed(elev, 1);
+		return true;
+	}
+
+	void inf_updateElevatorBatchJob(s32 index, void* userData)
+	{
+		const s32 start = index * ELEV_BATCH_SIZE;
+		const s32 end = min(start + ELEV_BATCH_SIZE, (s32)s_elevBatch.size());
+		for (s32 i = start; i < end; i++)
+		{
+			ElevBatchEntry* entry = &s_elevBatch[i];
+			const JBool reachedStop = updateElevator(entry->elev);
+			assert(reachedStop == entry->reachedStop);
+			entry->reachedStop = reachedStop;
+		}
+	}
+
+	void inf_copyBatchState(void* data, size_t size, bool restore, size_t& offset)
+	{
+		if (restore)
+		{
+			memcpy(data, s_elevVerifyState.data() + offset, size);
+		}
+		else
+		{
+			s_elevVerifyState.resize(offset + size);
+			memcpy(s_elevVerifyState.data() + offset, data, size);
+		}
+		offset += size;
+	}
+
+	void inf_copyBatchSector(RSector* sector, bool restore, size_t& offset)
+	{
+		if (!sector) { return; }
+		inf_copyBatchState(sector, sizeof(RSector), restore, offset);
+		inf_copyBatchState(sector->walls, sizeof(RWall) * sector->wallCount, restore, offset);
+	}
+
+	// Save or restore everything the batch can change: the elevators, their sectors and the walls of those sectors.
+	void inf_copyElevatorBatchState(bool restore)
+	{
+		size_t offset = 0;
+		for (size_t i = 0; i < s_elevBatch.size(); i++)
+		{
+			InfElevator* elev = s_elevBatch[i].elev;
+			inf_copyBatchState(elev, sizeof(InfElevator), restore, offset);
+			inf_copyBatchSector(elev->sector, restore, offset);
+			Slave* child = (Slave*)allocator_getHead(elev->slaves);
+			while (child)
+			{
+				inf_copyBatchSector(child->sector, restore, offset);
+				child = (Slave*)allocator_getNext(elev->slaves);
+			}
+		}
+	}
+
+	u32 inf_hashElevatorBatch()
+	{
+		u32 hash = stateHash_begin();
+		for (size_t i = 0; i < s_elevBatch.size(); i++)
+		{
+			InfElevator* elev = s_elevBatch[i].elev;
+			hash = stateHash_add(hash, *elev->value);
+			hash = stateHash_add(hash, elev->iValue);
+			hash = stateHash_add(hash, s_elevBatch[i].reachedStop);
+			if (elev->sector) { hash = stateHash_add(hash, stateHash_hashSector(elev->sector)); }
+			Slave* child = (Slave*)allocator_getHead(elev->slaves);
+			while (child)
+			{
+				if (child->sector) { hash = stateHash_add(hash, stateHash_hashSector(child->sector)); }
+				child = (Slave*)allocator_getNext(elev->slaves);
+			}
+		}
+		return stateHash_end(hash);
+	}
+
+	// Update the batch in list order, then restore the starting state and update it again as parallel jobs.
+	// The two results are compared with the state hash and the timings are logged periodically.
+	void inf_verifyElevatorBatch(s32 jobCount)
+	{
+		inf_copyElevatorBatchState(false);
+		u64 startTime = TFE_System::getCurrentTimeInTicks();
+		for (s32 i = 0; i < jobCount; i++)
+		{
+			inf_updateElevatorBatchJob(i, nullptr);
+		}
+		s_elevVerifySerialTime += TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		const u32 serialHash = inf_hashElevatorBatch();
+
+		inf_copyElevatorBatchState(true);
+		startTime = TFE_System::getCurrentTimeInTicks();
+		if (TFE_Jobs::getWorkerCount() > 0)
+		{
+			TFE_Jobs::parallelFor(jobCount, inf_updateElevatorBatchJob, nullptr);
+		}
+		else
+		{
+			// Without workers, run the jobs in reverse order so the result still cannot depend on the order.
+			for (s32 i = jobCount - 1; i >= 0; i--)
+			{
+				inf_updateElevatorBatchJob(i, nullptr);
+			}
+		}
+		s_elevVerifyParallelTime += TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		const u32 parallelHash = inf_hashElevatorBatch();
+
+		s_elevVerifyBatches++;
+		s_elevVerifyElevators += (s32)s_elevBatch.size();
+		if (serialHash != parallelHash)
+		{
+			s_elevVerifyMismatches++;
+			TFE_System::logWrite(LOG_ERROR, "INF", "Parallel elevator update does not match the serial update at tick %u, batch of %d elevators.",
+				s_curTick, (s32)s_elevBatch.size());
+		}
+		if (s_elevVerifyBatches % ELEV_VERIFY_LOG_INTERVAL == 0)
+		{
+			TFE_System::logWrite(LOG_MSG, "INF", "Verified %d elevator batches with %d elevators on %d threads: serial %0.3f ms, parallel %0.3f ms, %d mismatches.",
+				s_elevVerifyBatches, s_elevVerifyElevators, TFE_Jobs::getWorkerCount() + 1, s_elevVerifySerialTime * 1000.0,
+				s_elevVerifyParallelTime * 1000.0, s_elevVerifyMismatches);
+		}
+	}
+
+	// Starting with 'first', gather the following elevators that can be updated in parallel and update them.
+	// The batch ends before the next elevator that must be updated in order, before the next elevator that
+	// shares a sector with an earlier one, or at the first elevator that reaches its stop, since the stop
+	// messages may change the elevators that follow it.
+	// Sounds are started in list order so the result matches updating the elevators one at a time.
+	void inf_updateElevatorBatch(InfElevator* first)
+	{
+		s_elevBatch.clear();
+		s_elevBatchPos = 0;
+		if (s_elevBatchSectorUsed.size() != s_levelState.sectorCount)
+		{
+			s_elevBatchSectorUsed.assign(s_levelState.sectorCount, 0);
+		}
+
+		allocator_saveIter(s_infSerState.infElevators);
+		InfElevator* elev = first;
+		while (elev)
+		{
+			if (!elev->deleted && (elev->updateFlags & ELEV_MASTER_ON) && elev->nextTick < s_curTick)
+			{
+				if (!inf_canUpdateInParallel(elev) || !inf_claimBatchSectors(elev)) { break; }
+
+				if (!(elev->updateFlags & ELEV_MOVING))
+				{
+					inf_startElevator(elev);
+				}
+				inf_elevatorVolume(elev);
+
+				const JBool reachedStop = inf_elevatorWillReachStop(elev);
+				s_elevBatch.push_back({ elev, reachedStop });
+				if (reachedStop) { break; }
+			}
+			elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+		}
+		allocator_restoreIter(s_infSerState.infElevators);
+
+		// Reset the sectors for the next batch.
+		const s32 count = (s32)s_elevBatch.size();
+		for (s32 i = 0; i < count; i++)
+		{
+			inf_setBatchSectorsUsed(s_elevBatch[i].elev, 0);
+		}
+
+		const s32 jobCount = (count + ELEV_BATCH_SIZE - 1) / ELEV_BATCH_SIZE;
+		if (s_verifyParallelElevators)
+		{
+			inf_verifyElevatorBatch(jobCount);
+		}
+		else if (s_parallelElevators && count >= ELEV_BATCH_MIN_PARALLEL_COUNT && TFE_Jobs::getWorkerCount() > 0)
+		{
+			TFE_Jobs::parallelFor(jobCount, inf_updateElevatorBatchJob, nullptr);
+		}
+		else
+		{
+			for (s32 i = 0; i < jobCount; i++)
+			{
+				inf_updateElevatorBatchJob(i, nullptr);
+			}
+		}
+	}
+
 	// Per frame update.
 	void inf_elevatorTaskFunc(MessageType msg)
 	{
@@ -1508,6 +1791,7 @@ namespace TFE_Jedi
 			InfElevator* elev;
 			Stop* nextStop;
 			s32 elevDeleted;
+			JBool reachedStop;
 
 		};
 		task_begin_ctx;
@@ -1520,6 +1804,8 @@ namespace TFE_Jedi
 			}
 			else  // id == MSG_RUN_TASK
 			{
+				s_elevBatch.clear();
+				s_elevBatchPos = 0;
 				taskCtx->elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
 				while (taskCtx->elev)
 				{
@@ -1530,90 +1816,107 @@ namespace TFE_Jedi
 					}
 
 					taskCtx->elevDeleted = 0;
-					if ((taskCtx->elev->updateFlags & ELEV_MASTER_ON) && taskCtx->elev->nextTick < s_curTick)
+					taskCtx->reachedStop = JFALSE;
+					if (s_elevBatchPos < (s32)s_elevBatch.size() && s_elevBatch[s_elevBatchPos].elev == taskCtx->elev)
+					{
+						// Already updated as part of a batch.
+						taskCtx->reachedStop = s_elevBatch[s_elevBatchPos].reachedStop;
+						s_elevBatchPos++;
+					}
+					else if ((taskCtx->elev->updateFlags & ELEV_MASTER_ON) && taskCtx->elev->nextTick < s_curTick)
 					{
-						// If not already moving, get started.
-						if (!(taskCtx->elev->updateFlags & ELEV_MOVING) && !taskCtx->elevDeleted)
+						if (inf_canUpdateInParallel(taskCtx->elev))
 						{
-							inf_startElevator(taskCtx->elev);
+							inf_updateElevatorBatch(taskCtx->elev);
+							taskCtx->reachedStop = s_elevBatch[0].reachedStop;
+							s_elevBatchPos = 1;
 						}
-						inf_elevatorVolume(taskCtx->elev);
-
-						if (updateElevator(taskCtx->elev))
+						else
 						{
-							// The elevator has reached the next stop.
-							elevHandleStopDelay(taskCtx->elev);
+							// If not already moving, get started.
+							if (!(taskCtx->elev->updateFlags & ELEV_MOVING) && !taskCtx->elevDeleted)
+							{
+								inf_startElevator(taskCtx->elev);
+							}
+							inf_elevatorVolume(taskCtx->elev);
+							taskCtx->reachedStop = updateElevator(taskCtx->elev);
+						}
+					}
+
+					if (taskCtx->reachedStop)
+					{
+						// The elevator has reached the next stop.
+						elevHandleStopDelay(taskCtx->elev);
 
-							taskCtx->nextStop = taskCtx->elev->nextStop;
-							if (taskCtx->elev->updateFlags & ELEV_CRUSH)
+						taskCtx->nextStop = taskCtx->elev->nextStop;
+						if (taskCtx->elev->updateFlags & ELEV_CRUSH)
+						{
+							taskCtx->elev->nextTick = s_curTick + TICKS_PER_SECOND;	// this will pause the elevator for one second.
+							taskCtx->elev->updateFlags &= ~ELEV_CRUSH;				// remove the crush flag.
+						}
+						else
+						{
+							u32 delay = taskCtx->nextStop->delay;
+							if (delay == IDELAY_HOLD)
 							{
-								taskCtx->elev->nextTick = s_curTick + TICKS_PER_SECOND;	// this will pause the elevator for one second.
-								taskCtx->elev->updateFlags &= ~ELEV_CRUSH;				// remove the crush flag.
+								taskCtx->elev->nextTick = DELAY_SLEEP;
 							}
-							else
+							else if (delay == IDELAY_COMPLETE || delay == IDELAY_TERMINATE)
 							{
-								u32 delay = taskCtx->nextStop->delay;
-								if (delay == IDELAY_HOLD)
-								{
-									taskCtx->elev->nextTick = DELAY_SLEEP;
-								}
-								else if (delay == IDELAY_COMPLETE || delay == IDELAY_TERMINATE)
+								// delete the elevator, we're done here.
+								inf_deleteElevator(taskCtx->elev);
+								taskCtx->elevDeleted = 1;
+								if (delay == IDELAY_COMPLETE)
 								{
-									// delete the elevator, we're done here.
-									inf_deleteElevator(taskCtx->elev);
-									taskCtx->elevDeleted = 1;
-									if (delay == IDELAY_COMPLETE)
-									{
-										agent_levelComplete();
-										agent_createLevelEndTask();
-									}
-								}
-								else  // Timed
-								{
-									taskCtx->elev->nextTick = s_curTick + taskCtx->nextStop->delay;
+									agent_levelComplete();
+									agent_createLevelEndTask();
 								}
 							}
-
-							// Process stop messages if the elevator has not been deleted.
-							if (!taskCtx->elevDeleted)
+							else  // Timed
 							{
-								// Messages
-								s_infState.nextStop = taskCtx->nextStop;
-								task_callTaskFunc(inf_stopHandleMessages);
+								taskCtx->elev->nextTick = s_curTick + taskCtx->nextStop->delay;
+							}
+						}
 
-								task_localBlockBegin;
-								// Adjoin Commands.
-								inf_stopAdjoinCommands(taskCtx->nextStop);
+						// Process stop messages if the elevator has not been deleted.
+						if (!taskCtx->elevDeleted)
+						{
+							// Messages
+							s_infState.nextStop = taskCtx->nextStop;
+							task_callTaskFunc(inf_stopHandleMessages);
 
-								// Floor texture change.
-								TextureData** floorTex = taskCtx->nextStop->floorTex;
-								if (floorTex)
-								{
-									RSector* sector = taskCtx->elev->sector;
-									sector->floorTex = floorTex;
-								}
+							task_localBlockBegin;
+							// Adjoin Commands.
+							inf_stopAdjoinCommands(taskCtx->nextStop);
 
-								// Ceiling texture change.
-								TextureData** ceilTex = taskCtx->nextStop->ceilTex;
-								if (ceilTex)
-								{
-									RSector* sector = taskCtx->elev->sector;
-									sector->ceilTex = ceilTex;
-								}
+							// Floor texture change.
+							TextureData** floorTex = taskCtx->nextStop->floorTex;
+							if (floorTex)
+							{
+								RSector* sector = taskCtx->elev->sector;
+								sector->floorTex = floorTex;
+							}
 
-								// Page (special 2D sound effect that plays, such as voice overs).
-								SoundSourceId pageId = taskCtx->nextStop->pageId;
-								if (pageId)
-								{
-									sound_play(pageId);
-								}
+							// Ceiling texture change.
+							TextureData** ceilTex = taskCtx->nextStop->ceilTex;
+							if (ceilTex)
+							{
+								RSector* sector = taskCtx->elev->sector;
+								sector->ceilTex = ceilTex;
+							}
 
-								// Advance to the next stop.
-								taskCtx->elev->nextStop = inf_advanceStops(taskCtx->elev->stops, 0, 1);
-								task_localBlockEnd;
-							} // (!elevDeleted)
-						}
-					} // ((elev->updateFlags & ELEV_MASTER_ON) && elev->nextTick < s_curTick)
+							// Page (special 2D sound effect that plays, such as voice overs).
+							SoundSourceId pageId = taskCtx->nextStop->pageId;
+							if (pageId)
+							{
+								sound_play(pageId);
+							}
+
+							// Advance to the next stop.
+							taskCtx->elev->nextStop = inf_advanceStops(taskCtx->elev->stops, 0, 1);
+							task_localBlockEnd;
+						} // (!elevDeleted)
+					} // (reachedStop)
 
 					// Next elevator.
 					taskCtx->elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
@@ -2267,6 +2570,8 @@ namespace TFE_Jedi
 	{
 		u32 flagsIndex = s_msgArg1;
 		u32 bits = s_msgArg2;
+		stateHash_sectorChanged(wall->sector);
+		if (wall->mirrorWall) { stateHash_sectorChanged(wall->mirrorWall->sector); }
 		if (flagsIndex == 1)
 		{
 			wall->flags1 |= bits;
@@ -2287,6 +2592,7 @@ namespace TFE_Jedi
 		else if (flagsIndex == 3)
 		{
 			wall->flags3 |= bits;
+			los_sectorChanged(wall->sector);
 
 			// If there is a mirror, also set some of the bits there.
 			RWall* mirror = wall->mirrorWall;
@@ -2294,6 +2600,7 @@ namespace TFE_Jedi
 			{
 				const u32 allowedMirrorFlags = (WF3_ALWAYS_WALK | WF3_CANNOT_FIRE_THROUGH | WF3_PLAYER_WALK_ONLY | WF3_SOLID_WALL);
 				mirror->flags3 |= (bits & allowedMirrorFlags);
+				los_sectorChanged(mirror->sector);
 			}
 		}
 	}
@@ -2302,6 +2609,8 @@ namespace TFE_Jedi
 	{
 		u32 flagsIndex = s_msgArg1;
 		u32 bits = s_msgArg2;
+		stateHash_sectorChanged(wall->sector);
+		if (wall->mirrorWall) { stateHash_sectorChanged(wall->mirrorWall->sector); }
 		if (flagsIndex == 1)
 		{
 			wall->flags1 &= ~bits;
@@ -2321,6 +2630,7 @@ namespace TFE_Jedi
 		else if (flagsIndex == 3)
 		{
 			wall->flags3 &= ~bits;
+			los_sectorChanged(wall->sector);
 
 			// If there is a mirror, also set some of the bits there.
 			RWall* mirror = wall->mirrorWall;
@@ -2328,6 +2638,7 @@ namespace TFE_Jedi
 			{
 				const u32 allowedMirrorFlags = (WF3_ALWAYS_WALK | WF3_CANNOT_FIRE_THROUGH | WF3_PLAYER_WALK_ONLY | WF3_SOLID_WALL);
 				mirror->flags3 &= ~(bits & allowedMirrorFlags);
+				los_sectorChanged(mirror->sector);
 			}
 		}
 	}
@@ -2361,6 +2672,38 @@ namespace TFE_Jedi
 		}
 	}
 	
+	// Returns how far the elevator value moves this frame.
+	fixed16_16 inf_getElevatorFrameDelta(InfElevator* elev, fixed16_16 pos, fixed16_16 targetPos)
+	{
+		fixed16_16 dt = s_deltaTime;
+		fixed16_16 frameDelta = 0;
+		if (!elev->nextStop)
+		{
+			// If there are no stops, then the elevator keeps going forever...
+			// Useful for scrolling textures, constantly spinning gears, etc.
+			frameDelta = mul16(elev->speed, dt);
+		}
+		else
+		{
+			fixed16_16 delta = targetPos - pos;
+			frameDelta = delta;
+			if (elev->speed)
+			{
+				if (!elev->fixedStep)
+				{
+					fixed16_16 move = mul16(elev->speed, dt);
+					frameDelta = delta > move ? move : delta < -move ? -move : delta;
+				}
+				else
+				{
+					// This is a little strange, this could lead to framerate based speeds...
+					frameDelta = elev->speed;
+				}
+			}
+		}
+		return frameDelta;
+	}
+
 	// Update an elevator.
 	// Returns JTRUE if the elevator has reached the next stop, else JFALSE.
 	JBool updateElevator(InfElevator* elev)
@@ -2412,33 +2755,7 @@ namespace TFE_Jedi
 				break;
 		}
 
-		fixed16_16 dt = s_deltaTime;
-		fixed16_16 frameDelta = 0;
-		if (!nextStop)
-		{
-			// If there are no stops, then the elevator keeps going forever...
-			// Useful for scrolling textures, constantly spinning gears, etc.
-			frameDelta = mul16(elev->speed, dt);
-		}
-		else
-		{
-			fixed16_16 delta = targetPos - pos;
-			frameDelta = delta;
-			if (elev->speed)
-			{
-				if (!elev->fixedStep)
-				{
-					fixed16_16 move = mul16(elev->speed, dt);
-					frameDelta = delta > move ? move : delta < -move ? -move : delta;
-				}
-				else
-				{
-					// This is a little strange, this could lead to framerate based speeds...
-					frameDelta = elev->speed;
-				}
-			}
-		}
-
+		fixed16_16 frameDelta = inf_getElevatorFrameDelta(elev, pos, targetPos);
 		if (updateFunc)
 		{
 			pos = updateFunc(elev, frameDelta);
@@ -2514,6 +2831,7 @@ namespace TFE_Jedi
 			{
 				wall->flags1 &= ~(WF1_HIDE_ON_MAP | WF1_SHOW_NORMAL_ON_MAP);
 			}
+			stateHash_sectorChanged(sector);
 		}
 	}
 
@@ -2983,6 +3301,41 @@ namespace TFE_Jedi
 		}
 	}
 
+	void inf_forEachAdjoinCmd(InfAdjoinCmdFunc func, void* userData)
+	{
+		if (!s_infSerState.infElevators) { return; }
+
+		// The elevator task may be part way through the elevator list.
+		allocator_saveIter(s_infSerState.infElevators);
+		InfElevator* elev = (InfElevator*)allocator_getHead(s_infSerState.infElevators);
+		while (elev)
+		{
+			if (!elev->deleted && elev->stops)
+			{
+				allocator_saveIter(elev->stops);
+				Stop* stop = (Stop*)allocator_getHead(elev->stops);
+				while (stop)
+				{
+					if (stop->adjoinCmds)
+					{
+						allocator_saveIter(stop->adjoinCmds);
+						AdjoinCmd* cmd = (AdjoinCmd*)allocator_getHead(stop->adjoinCmds);
+						while (cmd)
+						{
+							func(cmd->sector0, cmd->sector1, cmd->wall0, cmd->wall1, userData);
+							cmd = (AdjoinCmd*)allocator_getNext(stop->adjoinCmds);
+						}
+						allocator_restoreIter(stop->adjoinCmds);
+					}
+					stop = (Stop*)allocator_getNext(elev->stops);
+				}
+				allocator_restoreIter(elev->stops);
+			}
+			elev = (InfElevator*)allocator_getNext(s_infSerState.infElevators);
+		}
+		allocator_restoreIter(s_infSerState.infElevators);
+	}
+
 	void inf_stopAdjoinCommands(Stop* stop)
 	{
 		Allocator* adjoinCmds = stop->adjoinCmds;
@@ -3012,6 +3365,10 @@ namespace TFE_Jedi
 
 				sector_setupWallDrawFlags(sector0);
 				sector_setupWallDrawFlags(sector1);
+				los_sectorChanged(sector0);
+				los_sectorChanged(sector1);
+				stateHash_sectorChanged(sector0);
+				stateHash_sectorChanged(sector1);
 
 				cmd = (AdjoinCmd*)allocator_getNext(adjoinCmds);
 			}
@@ -3102,6 +3459,7 @@ namespace TFE_Jedi
 			{
 				u32 flagsIndex = s_msgArg1;
 				u32 bits = s_msgArg2;
+				stateHash_sectorChanged(sector);
 
 				if (flagsIndex == 1)
 				{
@@ -3120,6 +3478,7 @@ namespace TFE_Jedi
 			{
 				u32 flagsIndex = s_msgArg1;
 				u32 bits = s_msgArg2;
+				stateHash_sectorChanged(sector);
 
 				if (flagsIndex == 1)
 				{
@@ -3227,6 +3586,7 @@ namespace TFE_Jedi
 			// Store the old value in flags3 so the lights can be toggled.
 			sector->flags3 = floor16(sector->ambient);
 			sector->ambient = newAmbient;
+			stateHash_sectorChanged(sector);
 		}
 	}
 
@@ -3348,6 +3708,7 @@ namespace TFE_Jedi
 					trigger->animTex = animTex;
 					trigger->tex = animTex->frameList[0];
 					wall->signTex = &trigger->tex;
+					stateHash_sectorChanged(wall->sector);
 					// Removes "cross line" events
 					link->eventMask &= ~(INF_EVENT_CROSS_LINE_FRONT | INF_EVENT_CROSS_LINE_BACK);
 				}
@@ -3525,6 +3886,7 @@ namespace TFE_Jedi
 	{
 		RSector* sector = elev->sector;
 		sector->dirtyFlags |= SDF_VERTICES;
+		stateHash_sectorChanged(sector);
 
 		JBool halfStep = JFALSE;
 		if (abs(delta) < ONE_16)
@@ -3606,6 +3968,7 @@ namespace TFE_Jedi
 
 		RSector* sector = elev->sector;
 		sector->dirtyFlags |= SDF_FLAT_OFFSETS;
+		stateHash_sectorChanged(sector);
 		if (elev->type == IELEV_SCROLL_FLOOR)
 		{
 			sector->floorOffset.x += deltaX;
@@ -3622,6 +3985,7 @@ namespace TFE_Jedi
 		{
 			sector = child->sector;
 			sector->dirtyFlags |= SDF_FLAT_OFFSETS;
+			stateHash_sectorChanged(sector);
 			if (elev->type == IELEV_SCROLL_FLOOR)
 			{
 				sector->floorOffset.x += deltaX;
@@ -3643,12 +4007,14 @@ namespace TFE_Jedi
 		RSector* sector = elev->sector;
 		sector->ambient += delta;
 		sector->dirtyFlags |= SDF_AMBIENT;
+		stateHash_sectorChanged(sector);
 
 		Slave* child = (Slave*)allocator_getHead(elev->slaves);
 		while (child)
 		{
 			child->sector->ambient += delta;
 			child->sector->dirtyFlags |= SDF_AMBIENT;
+			stateHash_sectorChanged(child->sector);
 			child = (Slave*)allocator_getNext(elev->slaves);
 		}
 		return sector->ambient;
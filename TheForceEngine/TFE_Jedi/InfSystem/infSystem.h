@@ -36,6 +36,8 @@ namespace TFE_Jedi
 	// Serialization & State
 	void inf_clearState();
 	void inf_serialize(Stream* stream);
+	// Hash of the elevator and trigger state, see TFE_Jedi/Level/stateHash.h
+	u32  inf_hashState();
 	
 	// ** Runtime API **
 	// Messages are the way entities and the player interact with the INF system during gameplay.
@@ -84,4 +86,8 @@ namespace TFE_Jedi
 	void inf_sendLinkMessages(Allocator* infLink, SecObject* entity, u32 evt, MessageType msgType);
 
 	JBool sector_isDoor(RSector* sector);
+
+	// Calls func() for every adjoin change that elevator stops can make at runtime.
+	typedef void(*InfAdjoinCmdFunc)(RSector* sector0, RSector* sector1, RWall* wall0, RWall* wall1, void* userData);
+	void inf_forEachAdjoinCmd(InfAdjoinCmdFunc func, void* userData);
 }
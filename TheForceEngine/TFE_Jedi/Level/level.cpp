@@ -4,8 +4,11 @@
 #include "level.h"
 #include "levelBin.h"
 #include "levelData.h"
+#include "levelAssets.h"
 #include "rwall.h"
 #include "rtexture.h"
+#include "sectorGrid.h"
+#include "sectorPvs.h"
 #include <TFE_Game/igame.h>
 #include <TFE_Asset/assetSystem.h>
 #include <TFE_Asset/dfKeywords.h>
@@ -68,10 +71,21 @@ namespace TFE_Jedi
 		// Settings helper
 		TFE_Settings::setLevelName(levelName);
 
-		if (!level_loadGeometry(levelName)) { return JFALSE; }
+		// Decode the level textures and sprites in parallel, they are committed as the level loads.
+		const u64 loadStart = TFE_System::getCurrentTimeInTicks();
+		levelAssets_prefetch(levelName);
+		if (!level_loadGeometry(levelName))
+		{
+			levelAssets_clear();
+			return JFALSE;
+		}
 		level_loadObjects(levelName, difficulty);
+		levelAssets_clear();
+		const f64 loadTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - loadStart);
+		TFE_System::logWrite(LOG_MSG, "Level", "Loaded level geometry, objects and assets in %.2f ms.", loadTime * 1000.0);
 		inf_load(levelName);
 		level_loadGoals(levelName);
+		pvs_build(levelName);
 
 		return JTRUE;
 	}
@@ -96,6 +110,7 @@ namespace TFE_Jedi
 	void level_postProcessGeometry()
 	{
 		// Process sectors after load.
+		sectorGrid_clear();
 		RSector* sector = s_levelState.sectors;
 		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
 		{
@@ -137,6 +152,9 @@ namespace TFE_Jedi
 			}
 		}
 
+		// TFE: Build the spatial index used by sector_which3D().
+		sectorGrid_build();
+
 		// Setup the control sector.
 		s_levelState.controlSector->id = s_levelState.sectorCount;
 		s_levelState.controlSector->index = s_levelState.controlSector->id;
@@ -266,7 +284,7 @@ namespace TFE_Jedi
 			}
 			else
 			{
-				TextureData* tex = bitmap_load(textureName, 1);
+				TextureData* tex = levelAssets_getTexture(textureName);
 				if (!tex)
 				{
 					TFE_System::logWrite(LOG_WARNING, "level_loadGeometry", "Could not open '%s', using 'default.bm' instead.", textureName);
@@ -800,7 +818,7 @@ namespace TFE_Jedi
 						char name[32];
 						if (sscanf(line, " SPR: %s ", name) == 1)
 						{
-							s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax(name);
+							s_levelIntState.sprites[s] = levelAssets_getWax(name);
 							if (!s_levelIntState.sprites[s])
 							{
 								s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax("default.wax");
@@ -826,7 +844,7 @@ namespace TFE_Jedi
 						char name[32];
 						if (sscanf(line, " FME: %s ", name) == 1)
 						{
-							s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame(name);
+							s_levelIntState.frames[f] = levelAssets_getFrame(name);
 							if (!s_levelIntState.frames[f])
 							{
 								s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame("default.fme");
@@ -38,6 +38,8 @@ struct Safe
 namespace TFE_Jedi
 {
 	JBool level_load(const char* levelName, u8 difficulty);
+	// Loads only the sectors, walls and textures, without objects, INF or goals.
+	JBool level_loadGeometry(const char* levelName);
 	void  level_clearData();
 	void  level_freeAllAssets();
 
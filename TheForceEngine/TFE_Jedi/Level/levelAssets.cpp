@@ -0,0 +1,301 @@
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "levelAssets.h"
+#include "rtexture.h"
+#include <TFE_Archive/archive.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/parser.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/system.h>
+
+using namespace TFE_Sprite_Jedi;
+
+namespace TFE_Jedi
+{
+	enum LevelAssetType
+	{
+		LASSET_TEXTURE = 0,
+		LASSET_WAX,
+		LASSET_FRAME,
+		LASSET_COUNT
+	};
+
+	struct LevelAssetFile
+	{
+		FilePath path;
+		std::vector<u8> buffer;	// Only used if the file cannot be accessed in place.
+		const u8* data = nullptr;
+		size_t size = 0;
+		bool valid = false;
+	};
+
+	struct LevelAsset
+	{
+		LevelAssetType type;
+		std::string name;
+		LevelAssetFile file;
+		LevelAssetFile hdFile;
+
+		// Decoded result, owned by the level asset until it is committed.
+		void* decoded = nullptr;
+		HdWax* hdWax = nullptr;
+	};
+
+	typedef std::unordered_map<std::string, s32> LevelAssetMap;
+
+	static std::vector<LevelAsset> s_levelAssets;
+	static LevelAssetMap s_levelAssetMap[LASSET_COUNT];
+	static std::vector<u8> s_listBuffer;
+
+	void levelAssets_add(const char* name, LevelAssetType type)
+	{
+		if (s_levelAssetMap[type].find(name) != s_levelAssetMap[type].end())
+		{
+			return;
+		}
+
+		// Missing files are left to the regular loader, which handles the fallbacks.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(name, &filePath))
+		{
+			return;
+		}
+
+		s_levelAssetMap[type][name] = (s32)s_levelAssets.size();
+		s_levelAssets.push_back({});
+
+		LevelAsset* asset = &s_levelAssets.back();
+		asset->type = type;
+		asset->name = name;
+		asset->file.path = filePath;
+		asset->file.valid = true;
+
+		switch (type)
+		{
+			case LASSET_TEXTURE:
+				asset->hdFile.valid = bitmap_getHDFilePath(name, &filePath, POOL_LEVEL, &asset->hdFile.path);
+				break;
+			case LASSET_WAX:
+				asset->hdFile.valid = getHdFilePath(name, true, POOL_LEVEL, &asset->hdFile.path);
+				break;
+			case LASSET_FRAME:
+				asset->hdFile.valid = getHdFilePath(name, false, POOL_LEVEL, &asset->hdFile.path);
+				break;
+			default:
+				break;
+		}
+	}
+
+	void levelAssets_scanList(TFE_Parser& parser, size_t& bufferPos, s32 count, const char* format, LevelAssetType type)
+	{
+		for (s32 i = 0; i < count; i++)
+		{
+			const char* line = parser.readLine(bufferPos);
+			if (!line) { break; }
+
+			char name[256];
+			if (sscanf(line, format, name) == 1 && strcasecmp(name, "<NoTexture>") != 0)
+			{
+				levelAssets_add(name, type);
+			}
+		}
+	}
+
+	// Reads the asset lists using the same parser settings as the level loader, so the names match exactly.
+	void levelAssets_scanFile(const char* levelName, const char* ext)
+	{
+		char levelPath[TFE_MAX_PATH];
+		strcpy(levelPath, levelName);
+		strcat(levelPath, ext);
+
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(levelPath, &filePath))
+		{
+			return;
+		}
+		size_t size = 0;
+		const u8* data = Archive::readFileView(&filePath, s_listBuffer, &size);
+		if (!data)
+		{
+			return;
+		}
+
+		const bool objects = strcasecmp(ext, ".O") == 0;
+		TFE_Parser parser;
+		size_t bufferPos = 0;
+		parser.init((const char*)data, size);
+		if (objects)
+		{
+			parser.enableBlockComments();
+			parser.addCommentString("//");
+		}
+		parser.addCommentString("#");
+		parser.convertToUpperCase(true);
+
+		const char* line;
+		s32 count;
+		while (nullptr != (line = parser.readLine(bufferPos)))
+		{
+			if (!objects && sscanf(line, " TEXTURES %d", &count) == 1)
+			{
+				levelAssets_scanList(parser, bufferPos, count, " TEXTURE: %s ", LASSET_TEXTURE);
+				break;
+			}
+			else if (objects && sscanf(line, "SPRS %d", &count) == 1)
+			{
+				levelAssets_scanList(parser, bufferPos, count, " SPR: %s ", LASSET_WAX);
+			}
+			else if (objects && sscanf(line, "FMES %d", &count) == 1)
+			{
+				levelAssets_scanList(parser, bufferPos, count, " FME: %s ", LASSET_FRAME);
+			}
+			else if (objects && sscanf(line, "OBJECTS %d", &count) == 1)
+			{
+				break;
+			}
+		}
+	}
+
+	// Archives that are not memory mapped must be read on the main thread, since archive reads are stateful.
+	bool levelAssets_canReadOnWorker(const FilePath* path)
+	{
+		return !path->archive || path->archive->getFileData(path->index);
+	}
+
+	void levelAssets_readFile(LevelAssetFile* file)
+	{
+		if (file->valid && !file->data)
+		{
+			file->data = Archive::readFileView(&file->path, file->buffer, &file->size);
+		}
+	}
+
+	void levelAssets_decodeJob(s32 index, void* userData)
+	{
+		LevelAsset* asset = &((LevelAsset*)userData)[index];
+		levelAssets_readFile(&asset->file);
+		levelAssets_readFile(&asset->hdFile);
+		if (!asset->file.data) { return; }
+
+		const u8* hdData = asset->hdFile.data;
+		const size_t hdSize = asset->hdFile.size;
+		switch (asset->type)
+		{
+			case LASSET_TEXTURE:
+				asset->decoded = bitmap_decode(asset->file.data, asset->file.size, 1, hdData, hdSize);
+				break;
+			case LASSET_WAX:
+				asset->decoded = decodeWax(asset->file.data, asset->file.size, hdData, hdSize, POOL_LEVEL, &asset->hdWax);
+				break;
+			case LASSET_FRAME:
+				asset->decoded = decodeFrame(asset->file.data, asset->file.size, hdData, hdSize, POOL_LEVEL, &asset->hdWax);
+				break;
+			default:
+				break;
+		}
+
+		// The source data is no longer needed.
+		asset->file.buffer = std::vector<u8>();
+		asset->hdFile.buffer = std::vector<u8>();
+		asset->file.data = nullptr;
+		asset->hdFile.data = nullptr;
+	}
+
+	void levelAssets_prefetch(const char* levelName)
+	{
+		TFE_ZONE("Level Asset Prefetch");
+		levelAssets_clear();
+		// Without workers there is nothing to gain over the regular loaders.
+		if (!levelName || TFE_Jobs::getWorkerCount() < 1) { return; }
+
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		levelAssets_scanFile(levelName, ".LEV");
+		levelAssets_scanFile(levelName, ".O");
+
+		const s32 count = (s32)s_levelAssets.size();
+		LevelAsset* asset = s_levelAssets.data();
+		for (s32 i = 0; i < count; i++, asset++)
+		{
+			if (!levelAssets_canReadOnWorker(&asset->file.path))   { levelAssets_readFile(&asset->file); }
+			if (!levelAssets_canReadOnWorker(&asset->hdFile.path)) { levelAssets_readFile(&asset->hdFile); }
+		}
+		TFE_Jobs::parallelFor(count, levelAssets_decodeJob, s_levelAssets.data());
+
+		const f64 decodeTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+		TFE_System::logWrite(LOG_MSG, "Level", "Decoded %d level assets on %d threads in %.2f ms.", count, TFE_Jobs::getWorkerCount() + 1, decodeTime * 1000.0);
+	}
+
+	void levelAssets_clear()
+	{
+		const s32 count = (s32)s_levelAssets.size();
+		LevelAsset* asset = s_levelAssets.data();
+		for (s32 i = 0; i < count; i++, asset++)
+		{
+			if (asset->type == LASSET_TEXTURE)
+			{
+				bitmap_freeDecoded((TextureData*)asset->decoded);
+			}
+			else if (asset->decoded || asset->hdWax)
+			{
+				freeDecoded(asset->decoded, asset->hdWax);
+			}
+		}
+		s_levelAssets.clear();
+		for (s32 i = 0; i < LASSET_COUNT; i++)
+		{
+			s_levelAssetMap[i].clear();
+		}
+	}
+
+	// Returns the staged asset if it was decoded and not committed yet, otherwise null.
+	LevelAsset* levelAssets_findDecoded(const char* name, LevelAssetType type)
+	{
+		LevelAssetMap::iterator iAsset = s_levelAssetMap[type].find(name);
+		if (iAsset == s_levelAssetMap[type].end()) { return nullptr; }
+
+		LevelAsset* asset = &s_levelAssets[iAsset->second];
+		return asset->decoded ? asset : nullptr;
+	}
+
+	TextureData* levelAssets_getTexture(const char* name)
+	{
+		LevelAsset* asset = levelAssets_findDecoded(name, LASSET_TEXTURE);
+		if (!asset)
+		{
+			return bitmap_load(name, 1);
+		}
+		TextureData* texture = bitmap_commit(name, (TextureData*)asset->decoded);
+		asset->decoded = nullptr;
+		return texture;
+	}
+
+	JediWax* levelAssets_getWax(const char* name)
+	{
+		LevelAsset* asset = levelAssets_findDecoded(name, LASSET_WAX);
+		if (!asset)
+		{
+			return getWax(name);
+		}
+		JediWax* wax = commitWax(name, (JediWax*)asset->decoded, asset->hdWax);
+		asset->decoded = nullptr;
+		asset->hdWax = nullptr;
+		return wax;
+	}
+
+	JediFrame* levelAssets_getFrame(const char* name)
+	{
+		LevelAsset* asset = levelAssets_findDecoded(name, LASSET_FRAME);
+		if (!asset)
+		{
+			return getFrame(name);
+		}
+		JediFrame* frame = commitFrame(name, (JediFrame*)asset->decoded, asset->hdWax);
+		asset->decoded = nullptr;
+		asset->hdWax = nullptr;
+		return frame;
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Level Assets
+// Parallel loading of the textures, sprites and frames used by a level.
+//
+// levelAssets_prefetch() reads the asset lists from the .LEV and .O
+// files and decodes the assets on the job system workers into
+// temporary memory. The level loader then requests the assets in the
+// original load order using levelAssets_get*(), which commit the
+// decoded asset on the main thread (or fall back to the regular
+// loader), so the asset caches are identical to a serial load.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Asset/spriteAsset_Jedi.h>
+
+struct TextureData;
+
+namespace TFE_Jedi
+{
+	void levelAssets_prefetch(const char* levelName);
+	// Frees any decoded assets that were not requested.
+	void levelAssets_clear();
+
+	TextureData* levelAssets_getTexture(const char* name);
+	JediWax*     levelAssets_getWax(const char* name);
+	JediFrame*   levelAssets_getFrame(const char* name);
+}
@@ -3,6 +3,7 @@
 #include "levelBin.h"
 #include "level.h"
 #include "levelData.h"
+#include "levelAssets.h"
 #include "rwall.h"
 #include "rtexture.h"
 #include <TFE_Game/igame.h>
@@ -215,7 +216,7 @@ namespace TFE_Jedi
 			}
 			else
 			{
-				TextureData* tex = bitmap_load(textureName, 1);
+				TextureData* tex = levelAssets_getTexture(textureName);
 				if (!tex)
 				{
 					TFE_System::logWrite(LOG_WARNING, "level_loadTextureListBin", "Could not open '%s', using 'default.bm' instead.", textureName);
@@ -5,10 +5,14 @@
 #include "rsector.h"
 #include "rwall.h"
 #include "robjData.h"
+#include "sectorGrid.h"
+#include "sectorPvs.h"
+#include "stateHash.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_Asset/spriteAsset_Jedi.h>
 #include <TFE_Jedi/Serialization/serialization.h>
+#include <TFE_Jedi/Collision/lineOfSight.h>
 
 // TODO: coupling between Dark Forces and Jedi.
 using namespace TFE_DarkForces;
@@ -49,6 +53,10 @@ namespace TFE_Jedi
 	{
 		s_levelState = { 0 };
 		s_levelIntState = { 0 };
+		sectorGrid_clear();
+		pvs_clear();
+		los_clear();
+		stateHash_clear();
 
 		s_levelState.controlSector = (RSector*)level_alloc(sizeof(RSector));
 		sector_clear(s_levelState.controlSector);
@@ -219,6 +227,7 @@ namespace TFE_Jedi
 			}
 
 			level_serializeFixupMirrors();
+			sectorGrid_build();
 		}
 
 		// Serialize objects.
@@ -48,6 +48,21 @@ namespace TFE_Jedi
 		}
 	}
 
+	void objData_forEach(ObjDataFunc func, void* userData)
+	{
+		ChunkedArray* list = s_objData.objectList;
+		if (!list) { return; }
+
+		const u32 size = TFE_Memory::chunkedArraySize(list);
+		for (u32 i = 0; i < size; i++)
+		{
+			SecObject* obj = (SecObject*)TFE_Memory::chunkedArrayGet(list, i);
+			// Skip deleted objects.
+			if (!obj->self) { continue; }
+			func(obj, userData);
+		}
+	}
+
 	void objData_serializeObject(SecObject* obj, Stream* stream)
 	{
 		if (serialization_getMode() == SMODE_READ)
@@ -120,6 +120,10 @@ namespace TFE_Jedi
 
 	void objData_serialize(Stream* stream);
 
+	// Calls 'func' for every allocated object.
+	typedef void(*ObjDataFunc)(SecObject* obj, void* userData);
+	void objData_forEach(ObjDataFunc func, void* userData);
+
 	// Used for downstream serialization, to get the object from the serialized object ID.
 	SecObject* objData_getObjectBySerializationId(u32 id);
 	SecObject* objData_getObjectBySerializationId_NoValidation(u32 id);
@@ -6,11 +6,14 @@
 #include "robject.h"
 #include "level.h"
 #include "levelData.h"
+#include "sectorGrid.h"
+#include "stateHash.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_DarkForces/player.h>
 #include <TFE_DarkForces/projectile.h>
 #include <TFE_Jedi/Collision/collision.h>
+#include <TFE_Jedi/Collision/lineOfSight.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_Jedi/InfSystem/message.h>
 #include <TFE_Settings/settings.h>
@@ -103,6 +106,8 @@ namespace TFE_Jedi
 	void sector_adjustHeights(RSector* sector, fixed16_16 floorOffset, fixed16_16 ceilOffset, fixed16_16 secondHeightOffset)
 	{
 		sector->dirtyFlags |= SDF_HEIGHTS;
+		los_sectorChanged(sector);
+		stateHash_sectorChanged(sector);
 
 		// Adjust objects.
 		if (sector->objectCount)
@@ -212,6 +217,7 @@ namespace TFE_Jedi
 		sector->boundsMax.x = maxX;
 		sector->boundsMin.z = minZ;
 		sector->boundsMax.z = maxZ;
+		sectorGrid_updateSector(sector);
 	}
 
 	fixed16_16 sector_getMaxObjectHeight(RSector* sector)
@@ -255,6 +261,8 @@ namespace TFE_Jedi
 		if (!playerCollides)
 		{
 			sector->dirtyFlags |= SDF_VERTICES;
+			los_sectorChanged(sector);
+			stateHash_sectorChanged(sector);
 
 			wall = sector->walls;
 			for (s32 i = 0; i < wallCount; i++, wall++)
@@ -266,6 +274,8 @@ namespace TFE_Jedi
 					if (mirror && (mirror->flags1 & WF1_WALL_MORPHS))
 					{
 						mirror->sector->dirtyFlags |= SDF_VERTICES;
+						los_sectorChanged(mirror->sector);
+						stateHash_sectorChanged(mirror->sector);
 						sector_moveWallVertex(mirror, offsetX, offsetZ);
 					}
 				}
@@ -283,6 +293,7 @@ namespace TFE_Jedi
 		s32 wallCount = sector->wallCount;
 
 		sector->dirtyFlags |= SDF_AMBIENT;
+		stateHash_sectorChanged(sector);
 		for (s32 i = 0; i < wallCount; i++, wall++)
 		{
 			if (wall->flags1 & WF1_CHANGE_WALL_LIGHT)
@@ -297,6 +308,7 @@ namespace TFE_Jedi
 		RWall* wall = sector->walls;
 		s32 wallCount = sector->wallCount;
 		sector->dirtyFlags |= SDF_WALL_OFFSETS;
+		stateHash_sectorChanged(sector);
 
 		const u32 scrollFlags = WF1_SCROLL_SIGN_TEX | WF1_SCROLL_BOT_TEX | WF1_SCROLL_MID_TEX | WF1_SCROLL_TOP_TEX;
 		for (s32 i = 0; i < wallCount; i++, wall++)
@@ -330,6 +342,7 @@ namespace TFE_Jedi
 	void sector_adjustTextureWallOffsets_Floor(RSector* sector, fixed16_16 floorDelta)
 	{
 		sector->dirtyFlags |= SDF_WALL_OFFSETS;
+		stateHash_sectorChanged(sector);
 
 		RWall* wall = sector->walls;
 		s32 wallCount = sector->wallCount;
@@ -364,6 +377,7 @@ namespace TFE_Jedi
 			if (mirror)
 			{
 				mirror->sector->dirtyFlags |= SDF_WALL_OFFSETS;
+				stateHash_sectorChanged(mirror->sector);
 
 				fixed16_16 textureOffset = -floorDelta * 8;
 				if (mirror->flags1 & WF1_TEX_ANCHORED)
@@ -504,85 +518,102 @@ namespace TFE_Jedi
 			fixed16_16 newLightLevel = intToFixed16(sector->flags3);
 			sector->flags3 = floor16(sector->ambient);
 			sector->ambient = newLightLevel;
+			stateHash_sectorChanged(sector);
 		}
 	}
 	
+	// Shared by the linear and grid versions, the candidates must be visited in sector order so that ties in area
+	// resolve to the same sector.
+	static void sector_which3D_Test(RSector* sector, fixed16_16 ix, fixed16_16 iz, s32* prevSectorUnitArea, RSector** foundSector)
+	{
+		const fixed16_16 sectorMaxX = sector->boundsMax.x;
+		const fixed16_16 sectorMinX = sector->boundsMin.x;
+		const fixed16_16 sectorMaxZ = sector->boundsMax.z;
+		const fixed16_16 sectorMinZ = sector->boundsMin.z;
+
+		const s32 dxInt = floor16(sectorMaxX - sectorMinX) + 1;
+		const s32 dzInt = floor16(sectorMaxZ - sectorMinZ) + 1;
+		const s32 sectorUnitArea = dzInt * dxInt;
+
+		if (ix >= sectorMinX && ix <= sectorMaxX && iz >= sectorMinZ && iz <= sectorMaxZ)
+		{
+			// pick the containing sector with the smallest area.
+			if (sectorUnitArea < *prevSectorUnitArea && sector_pointInsideDF(sector, ix, iz))
+			{
+				*prevSectorUnitArea = sectorUnitArea;
+				*foundSector = sector;
+			}
+		}
+	}
+
 	RSector* sector_which3D(fixed16_16 dx, fixed16_16 dy, fixed16_16 dz)
 	{
-		fixed16_16 ix = dx;
-		fixed16_16 iz = dz;
-		fixed16_16 y = dy;
-		
-		RSector* sector = s_levelState.sectors;
+		// TFE: Use the sector grid to only test sectors whose bounds overlap the point.
+		if (!sectorGrid_isValid())
+		{
+			return sector_which3D_Linear(dx, dy, dz);
+		}
+
 		RSector* foundSector = nullptr;
-		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		s32 count;
+		const s32* candidates = sectorGrid_getCandidates(dx, dz, &count);
+		for (s32 i = 0; i < count; i++)
 		{
-			if (y >= sector->ceilingHeight && y <= sector->floorHeight)
+			RSector* sector = &s_levelState.sectors[candidates[i]];
+			if (dy >= sector->ceilingHeight && dy <= sector->floorHeight)
 			{
-				const fixed16_16 sectorMaxX = sector->boundsMax.x;
-				const fixed16_16 sectorMinX = sector->boundsMin.x;
-				const fixed16_16 sectorMaxZ = sector->boundsMax.z;
-				const fixed16_16 sectorMinZ = sector->boundsMin.z;
-
-				const s32 dxInt = floor16(sectorMaxX - sectorMinX) + 1;
-				const s32 dzInt = floor16(sectorMaxZ - sectorMinZ) + 1;
-				sectorUnitArea = dzInt * dxInt;
-				
-				s32 insideBounds = 0;
-				if (ix >= sectorMinX && ix <= sectorMaxX && iz >= sectorMinZ && iz <= sectorMaxZ)
-				{
-					// pick the containing sector with the smallest area.
-					if (sectorUnitArea < prevSectorUnitArea && sector_pointInsideDF(sector, ix, iz))
-					{
-						prevSectorUnitArea = sectorUnitArea;
-						foundSector = sector;
-					}
-				}
+				sector_which3D_Test(sector, dx, dz, &prevSectorUnitArea, &foundSector);
 			}
 		}
-
 		return foundSector;
 	}
 
-	RSector* sector_which3D_Map(fixed16_16 dx, fixed16_16 dz, s32 layer)
+	RSector* sector_which3D_Linear(fixed16_16 dx, fixed16_16 dy, fixed16_16 dz)
 	{
-		fixed16_16 ix = dx;
-		fixed16_16 iz = dz;
-
 		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
-		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
 		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
 		{
-			if (sector->layer == layer)
+			if (dy >= sector->ceilingHeight && dy <= sector->floorHeight)
 			{
-				const fixed16_16 sectorMaxX = sector->boundsMax.x;
-				const fixed16_16 sectorMinX = sector->boundsMin.x;
-				const fixed16_16 sectorMaxZ = sector->boundsMax.z;
-				const fixed16_16 sectorMinZ = sector->boundsMin.z;
+				sector_which3D_Test(sector, dx, dz, &prevSectorUnitArea, &foundSector);
+			}
+		}
+		return foundSector;
+	}
 
-				const s32 dxInt = floor16(sectorMaxX - sectorMinX) + 1;
-				const s32 dzInt = floor16(sectorMaxZ - sectorMinZ) + 1;
-				sectorUnitArea = dzInt * dxInt;
+	RSector* sector_which3D_Map(fixed16_16 dx, fixed16_16 dz, s32 layer)
+	{
+		RSector* foundSector = nullptr;
+		s32 prevSectorUnitArea = INT_MAX;
 
-				s32 insideBounds = 0;
-				if (ix >= sectorMinX && ix <= sectorMaxX && iz >= sectorMinZ && iz <= sectorMaxZ)
+		if (sectorGrid_isValid())
+		{
+			s32 count;
+			const s32* candidates = sectorGrid_getCandidates(dx, dz, &count);
+			for (s32 i = 0; i < count; i++)
+			{
+				RSector* sector = &s_levelState.sectors[candidates[i]];
+				if (sector->layer == layer)
 				{
-					// pick the containing sector with the smallest area.
-					if (sectorUnitArea < prevSectorUnitArea && sector_pointInsideDF(sector, ix, iz))
-					{
-						prevSectorUnitArea = sectorUnitArea;
-						foundSector = sector;
-					}
+					sector_which3D_Test(sector, dx, dz, &prevSectorUnitArea, &foundSector);
 				}
 			}
+			return foundSector;
 		}
 
+		RSector* sector = s_levelState.sectors;
+		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		{
+			if (sector->layer == layer)
+			{
+				sector_which3D_Test(sector, dx, dz, &prevSectorUnitArea, &foundSector);
+			}
+		}
 		return foundSector;
 	}
 
@@ -958,6 +989,8 @@ namespace TFE_Jedi
 		sinCosFixed(angle, &sinAngle, &cosAngle);
 
 		sector->dirtyFlags |= SDF_WALL_SHAPE;
+		los_sectorChanged(sector);
+		stateHash_sectorChanged(sector);
 		// TODO: (TFE) Handle rotateFlags for floor and ceiling texture rotation.
 
 		s32 wallCount = sector->wallCount;
@@ -972,6 +1005,8 @@ namespace TFE_Jedi
 				if (mirror && (mirror->flags1 & WF1_WALL_MORPHS))
 				{
 					mirror->sector->dirtyFlags |= SDF_WALL_SHAPE;
+					los_sectorChanged(mirror->sector);
+					stateHash_sectorChanged(mirror->sector);
 					sector_rotateWall(mirror, cosAngle, sinAngle, centerX, centerZ);
 				}
 			}
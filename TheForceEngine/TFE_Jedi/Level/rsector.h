@@ -155,6 +155,8 @@ namespace TFE_Jedi
 	
 	RSector* sector_which3D(fixed16_16 dx, fixed16_16 dy, fixed16_16 dz);
 	RSector* sector_which3D_Map(fixed16_16 dx, fixed16_16 dz, s32 layer);
+	// Reference version of sector_which3D() that tests every sector, used when the sector grid is not available.
+	RSector* sector_which3D_Linear(fixed16_16 dx, fixed16_16 dy, fixed16_16 dz);
 	bool sector_pointInside(RSector* sector, fixed16_16 x, fixed16_16 z);
 	JBool sector_pointInsideDF(RSector* sector, fixed16_16 x, fixed16_16 z);
 
@@ -5,6 +5,7 @@
 #include <TFE_System/system.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_Asset/assetSystem.h>
+#include <TFE_Asset/hdTextureAsset.h>
 #include <TFE_FileSystem/fileutil.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_FileSystem/filestream.h>
@@ -49,6 +50,9 @@ namespace TFE_Jedi
 
 	static std::vector<std::string> s_coreAchiveNames;
 
+	typedef void* (*BitmapAllocFunc)(size_t size);
+	typedef void  (*BitmapFreeFunc)(void* ptr);
+
 	void decompressColumn_Type1(const u8* src, u8* dst, s32 pixelCount);
 	void decompressColumn_Type2(const u8* src, u8* dst, s32 pixelCount);
 	void textureAnimationTaskFunc(MessageType msg);
@@ -206,69 +210,77 @@ namespace TFE_Jedi
 		return list;
 	}
 
-	void bitmap_loadHD(const char* name, TextureData* texData, s32 scaleFactor, AssetPool pool)
+	// Size of the HD replacement data for 'texData', including all animation frames.
+	size_t bitmap_getHDSize(const TextureData* texData, s32 scaleFactor, s32* frameWidth, s32* frameHeight, s32* frameCount)
 	{
-		texData->scaleFactor = 1;
-		texData->hdAssetData = nullptr;
-		// Verify that the HD texture *can* be loaded first.
-		if (pool == POOL_LEVEL && !TFE_Settings::isHdAssetValid(name, HD_ASSET_TYPE_BM))
+		s32 width  = texData->width  * scaleFactor;
+		s32 height = texData->height * scaleFactor;
+		s32 count = 1;
+		if (texData->uvWidth == BM_ANIMATED_TEXTURE)
 		{
-			return;
-		}
+			const u8* base = texData->image + 2;
+			const u32* textureOffsets = (u32*)base;
+			const TextureData* frame0 = (TextureData*)(base + textureOffsets[0]);
 
-		char hdPath[TFE_MAX_PATH];
-		FileUtil::replaceExtension(name, "raw", hdPath);
+			width  = frame0->width  * scaleFactor;
+			height = frame0->height * scaleFactor;
+			count = texData->uvHeight;
+		}
+		if (frameWidth)  { *frameWidth  = width;  }
+		if (frameHeight) { *frameHeight = height; }
+		if (frameCount)  { *frameCount  = count;  }
+		return size_t(width) * size_t(height) * 4 * size_t(count);
+	}
 
-		// If the file doesn't exist, just return - there is no HD asset.
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(hdPath, &filepath))
+	// Decompress mip 0 of a packed HD texture directly into place, the container is already stored top-down.
+	static void bitmap_processPackedHD(TextureData* texData, const u8* srcData, size_t size, BitmapAllocFunc alloc, BitmapFreeFunc freeFunc)
+	{
+		const TFE_HdTexture::HdTextureHeader* header = TFE_HdTexture::getHeader(srcData);
+		s32 width, height, frameCount;
+		const size_t hdSize = bitmap_getHDSize(texData, header->scaleFactor, &width, &height, &frameCount);
+		// Verify that the container matches the base texture.
+		if (width != header->width || height != header->height || frameCount != header->frameCount)
 		{
 			return;
 		}
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
+
+		u8* hdData = (u8*)alloc(hdSize);
+		if (!TFE_HdTexture::readMip(srcData, size, 0, hdData))
 		{
+			freeFunc(hdData);
 			return;
 		}
+		texData->scaleFactor = header->scaleFactor;
+		texData->hdAssetData = hdData;
+	}
 
-		// Load the raw data from disk.
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
-		// Process the data based on the base texture.
-		s32 width  = texData->width  * scaleFactor;
-		s32 height = texData->height * scaleFactor;
-		s32 frameCount = 1;
-		if (texData->uvWidth == BM_ANIMATED_TEXTURE)
+	// Process the HD data based on the base texture, the result is allocated with 'alloc'.
+	// The data is either a packed HD texture or a raw file with bottom-up frames.
+	static void bitmap_processHD(TextureData* texData, const u8* srcData, size_t size, s32 scaleFactor, BitmapAllocFunc alloc, BitmapFreeFunc freeFunc)
+	{
+		if (TFE_HdTexture::isHdTexture(srcData, size))
 		{
-			const u8* base = texData->image + 2;
-			const u32* textureOffsets = (u32*)base;
-			const TextureData* frame0 = (TextureData*)(base + textureOffsets[0]);
-
-			width  = frame0->width  * scaleFactor;
-			height = frame0->height * scaleFactor;
-			frameCount = texData->uvHeight;
+			bitmap_processPackedHD(texData, srcData, size, alloc, freeFunc);
+			return;
 		}
 
-		const s32 hdFrameSize = width * height * 4;
+		s32 width, height, frameCount;
+		const size_t hdSize = bitmap_getHDSize(texData, scaleFactor, &width, &height, &frameCount);
 		// Verify this is a valid texture.
-		if (size != hdFrameSize * frameCount)
+		if (size != hdSize)
 		{
 			return;
 		}
+		const s32 hdFrameSize = width * height * 4;
 
 		// Process the HD data.
 		texData->scaleFactor = scaleFactor;
-		texData->hdAssetData = (u8*)region_alloc(s_texState.memoryRegion, hdFrameSize * frameCount);
-		memset(texData->hdAssetData, 0, hdFrameSize * frameCount);
+		texData->hdAssetData = (u8*)alloc(hdSize);
 		
 		u8* dstData = texData->hdAssetData;
-		const u8* srcData = s_buffer.data();
 		for (s32 i = 0; i < frameCount; i++)
 		{
-			for (u32 y = 0; y < height; y++)
+			for (s32 y = 0; y < height; y++)
 			{
 				memcpy(&dstData[y*width*4], &srcData[(height - y - 1)*width*4], width * 4);
 			}
@@ -307,52 +319,35 @@ namespace TFE_Jedi
 		return true;
 	}
 
-	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	static void* bitmap_regionAlloc(size_t size)
 	{
-		// TFE: Keep track of per-level texture state for serialization.
-		// This is also useful for handling per-level GPU texture mirrors.
-		TextureTable::iterator iTex = s_textureTable[pool].find(name);
-		if (iTex != s_textureTable[pool].end())
-		{
-			return s_textureList[pool][iTex->second].texture;
-		}
-
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(name, &filepath))
-		{
-			return nullptr;
-		}
-
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
+		return region_alloc(s_texState.memoryRegion, size);
+	}
 
-		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
-		memset(texture, 0, sizeof(TextureData));
+	static void bitmap_regionFree(void* ptr)
+	{
+		region_free(s_texState.memoryRegion, ptr);
+	}
 
-		const u8* data = s_buffer.data();
+	// Parses a BM file into 'texture', the image data is allocated with 'alloc'.
+	// Errors are only logged if 'name' is set since logging is not thread safe.
+	static bool bitmap_parse(const u8* data, size_t size, u32 decompress, const char* name, TextureData* texture, BitmapAllocFunc alloc)
+	{
 		const u8* end = data + size;
 		const u8* fheader = data;
 		data += 3;
 
 		if (strncmp((char*)fheader, "BM ", 3))
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", filepath);
-			return nullptr;
+			if (name) { TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", name); }
+			return false;
 		}
 
 		u8 version = readByte(data);
 		if (version != DF_BM_VERSION)
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", filepath, version);
-			return nullptr;
+			if (name) { TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", name, version); }
+			return false;
 		}
 
 		texture->width = readUShort(data);
@@ -380,7 +375,7 @@ namespace TFE_Jedi
 			if (decompress & 1)
 			{
 				texture->dataSize = texture->width * texture->height;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)alloc(texture->dataSize);
 
 				const u8* inBuffer = data;
 				data += inSize;
@@ -413,12 +408,12 @@ namespace TFE_Jedi
 			else
 			{
 				texture->dataSize = inSize;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				texture->image = (u8*)alloc(texture->dataSize);
 				memcpy(texture->image, data, texture->dataSize);
 				data += texture->dataSize;
 				assert(data <= end);
 
-				texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
+				texture->columns = (u32*)alloc(texture->width * sizeof(u32));
 				memcpy(texture->columns, data, texture->width * sizeof(u32));
 				data += texture->width * sizeof(u32);
 				assert(data <= end);
@@ -437,49 +432,169 @@ namespace TFE_Jedi
 			assert(data <= end);
 
 			// Allocate and read the BM image.
-			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+			texture->image = (u8*)alloc(texture->dataSize);
 			memcpy(texture->image, data, texture->dataSize);
 			data += texture->dataSize;
 			assert(data <= end);
 		}
+		return true;
+	}
 
-		// Add the texture to the level texture cache if appropriate.
-		if (addToCache)
-		{
-			s32 index = (s32)s_textureList[pool].size();
-			s_textureList[pool].push_back({ name, texture });
-			s_textureTable[pool][name] = index;
-		}
+	static void bitmap_addToCache(const char* name, TextureData* texture, AssetPool pool)
+	{
+		s32 index = (s32)s_textureList[pool].size();
+		s_textureList[pool].push_back({ name, texture });
+		s_textureTable[pool][name] = index;
+	}
 
+	bool bitmap_getHDFilePath(const char* name, const FilePath* filePath, AssetPool pool, FilePath* hdPath)
+	{
 		// Determine if a texture is "custom" or not, custom textures do not use HD Assets.
-		bool isCustomAsset = false;
-		if (filepath.archive)
+		if (filePath->archive)
 		{
-			const char* path = filepath.archive->getPath();
+			const char* path = filePath->archive->getPath();
 			// Memory archive, from a zip file.
 			if (!path || path[0] == 0)
 			{
-				isCustomAsset = true;
+				return false;
 			}
 			// Regular archive path.
-			else
+			if (isAssetCustom(filePath->archive->getName()))
+			{
+				return false;
+			}
+		}
+		// Verify that the HD texture *can* be loaded.
+		if (pool == POOL_LEVEL && !TFE_Settings::isHdAssetValid(name, HD_ASSET_TYPE_BM))
+		{
+			return false;
+		}
+
+		// If the file doesn't exist, there is no HD asset.
+		// Packed HD textures are preferred over raw files.
+		char hdName[TFE_MAX_PATH];
+		FileUtil::replaceExtension(name, "hdt", hdName);
+		if (TFE_Paths::getFilePath(hdName, hdPath))
+		{
+			return true;
+		}
+		FileUtil::replaceExtension(name, "raw", hdName);
+		return TFE_Paths::getFilePath(hdName, hdPath);
+	}
+
+	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	{
+		// TFE: Keep track of per-level texture state for serialization.
+		// This is also useful for handling per-level GPU texture mirrors.
+		TextureTable::iterator iTex = s_textureTable[pool].find(name);
+		if (iTex != s_textureTable[pool].end())
+		{
+			return s_textureList[pool][iTex->second].texture;
+		}
+
+		FilePath filepath;
+		if (!TFE_Paths::getFilePath(name, &filepath))
+		{
+			return nullptr;
+		}
+
+		// The file is only parsed, so use the archive data in place when possible.
+		size_t size = 0;
+		const u8* data = Archive::readFileView(&filepath, s_buffer, &size);
+		if (!data)
+		{
+			return nullptr;
+		}
+
+		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		memset(texture, 0, sizeof(TextureData));
+		if (!bitmap_parse(data, size, decompress, name, texture, bitmap_regionAlloc))
+		{
+			return nullptr;
+		}
+
+		// Add the texture to the level texture cache if appropriate.
+		if (addToCache)
+		{
+			bitmap_addToCache(name, texture, pool);
+		}
+
+		texture->scaleFactor = 1;
+		texture->hdAssetData = nullptr;
+		FilePath hdPath;
+		if (bitmap_getHDFilePath(name, &filepath, pool, &hdPath))
+		{
+			// Load the HD data, directly from the archive if it is memory mapped.
+			size_t hdSize = 0;
+			const u8* hdData = Archive::readFileView(&hdPath, s_buffer, &hdSize);
+			if (hdData)
 			{
-				isCustomAsset = isAssetCustom(filepath.archive->getName());
+				bitmap_processHD(texture, hdData, hdSize, 2, bitmap_regionAlloc, bitmap_regionFree);
 			}
 		}
-		if (!isCustomAsset)
+		return texture;
+	}
+
+	TextureData* bitmap_decode(const u8* data, size_t size, u32 decompress, const u8* hdData, size_t hdSize)
+	{
+		TextureData* texture = (TextureData*)malloc(sizeof(TextureData));
+		memset(texture, 0, sizeof(TextureData));
+		if (!bitmap_parse(data, size, decompress, nullptr, texture, malloc))
 		{
-			bitmap_loadHD(name, texture, 2, pool);
+			bitmap_freeDecoded(texture);
+			return nullptr;
 		}
-		else
+
+		texture->scaleFactor = 1;
+		texture->hdAssetData = nullptr;
+		if (hdData)
 		{
-			texture->scaleFactor = 1;
-			texture->hdAssetData = nullptr;
+			bitmap_processHD(texture, hdData, hdSize, 2, malloc, free);
 		}
+		return texture;
+	}
 
+	TextureData* bitmap_commit(const char* name, TextureData* decoded, AssetPool pool)
+	{
+		// The same texture may have been committed since it was decoded.
+		TextureTable::iterator iTex = s_textureTable[pool].find(name);
+		if (iTex != s_textureTable[pool].end())
+		{
+			bitmap_freeDecoded(decoded);
+			return s_textureList[pool][iTex->second].texture;
+		}
+
+		// Move the texture into the texture region.
+		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		*texture = *decoded;
+		texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+		memcpy(texture->image, decoded->image, texture->dataSize);
+		if (decoded->columns)
+		{
+			texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
+			memcpy(texture->columns, decoded->columns, texture->width * sizeof(u32));
+		}
+		if (decoded->hdAssetData)
+		{
+			const size_t hdSize = bitmap_getHDSize(texture, texture->scaleFactor, nullptr, nullptr, nullptr);
+			texture->hdAssetData = (u8*)region_alloc(s_texState.memoryRegion, hdSize);
+			memcpy(texture->hdAssetData, decoded->hdAssetData, hdSize);
+		}
+		bitmap_freeDecoded(decoded);
+
+		bitmap_addToCache(name, texture, pool);
 		return texture;
 	}
 
+	void bitmap_freeDecoded(TextureData* decoded)
+	{
+		if (!decoded) { return; }
+		free(decoded->image);
+		free(decoded->columns);
+		free(decoded->hdAssetData);
+		free(decoded);
+	}
+
 	TextureData* bitmap_loadFromMemory(const u8* data, size_t size, u32 decompress)
 	{
 		TextureData* texture = (TextureData*)malloc(sizeof(TextureData));
@@ -112,6 +112,17 @@ namespace TFE_Jedi
 	TextureData* bitmap_getTextureByIndex(s32 index, AssetPool pool);
 	const char* bitmap_getTextureName(s32 index, AssetPool pool);
 
+	// Staged loading, used to decode level textures on worker threads.
+	// bitmap_decode() is thread safe and returns a texture in temporary memory (or null without logging), bitmap_getHDFilePath()
+	// and bitmap_commit() must be called on the main thread. bitmap_commit() moves the texture into
+	// the texture region and cache, so commit in load order to keep the texture indices deterministic.
+	bool bitmap_getHDFilePath(const char* name, const FilePath* filePath, AssetPool pool, FilePath* hdPath);
+	TextureData* bitmap_decode(const u8* data, size_t size, u32 decompress, const u8* hdData = nullptr, size_t hdSize = 0);
+	TextureData* bitmap_commit(const char* name, TextureData* decoded, AssetPool pool = POOL_LEVEL);
+	void bitmap_freeDecoded(TextureData* decoded);
+	// Size of the HD replacement data in bytes, including all animation frames.
+	size_t bitmap_getHDSize(const TextureData* texData, s32 scaleFactor, s32* frameWidth, s32* frameHeight, s32* frameCount);
+
 	// Used for tools.
 	TextureData* bitmap_loadFromMemory(const u8* data, size_t size, u32 decompress);
 	Allocator* bitmap_getAnimTextureAlloc();
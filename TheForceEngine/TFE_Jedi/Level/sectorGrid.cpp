@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sectorGrid.h"
+#include "rsector.h"
+#include "levelData.h"
+#include <TFE_System/system.h>
+
+namespace TFE_Jedi
+{
+	enum SectorGridConstants
+	{
+		GRID_MAX_DIM = 256,
+		GRID_SECTORS_PER_CELL = 2,	// Target average number of sectors per cell.
+	};
+
+	struct CellRect
+	{
+		s32 x0, z0;
+		s32 x1, z1;
+	};
+
+	static std::vector<std::vector<s32>> s_cells;
+	static std::vector<CellRect> s_sectorRect;
+	static fixed16_16 s_gridMinX = 0;
+	static fixed16_16 s_gridMinZ = 0;
+	static fixed16_16 s_cellSize = ONE_16;
+	static s32 s_gridWidth = 0;
+	static s32 s_gridHeight = 0;
+	static u32 s_gridSectorCount = 0;
+	static bool s_gridValid = false;
+
+	s32 sectorGrid_cellX(fixed16_16 x)
+	{
+		const s64 cx = (s64(x) - s64(s_gridMinX)) / s_cellSize;
+		return s32(std::max(s64(0), std::min(cx, s64(s_gridWidth - 1))));
+	}
+
+	s32 sectorGrid_cellZ(fixed16_16 z)
+	{
+		const s64 cz = (s64(z) - s64(s_gridMinZ)) / s_cellSize;
+		return s32(std::max(s64(0), std::min(cz, s64(s_gridHeight - 1))));
+	}
+
+	CellRect sectorGrid_getRect(RSector* sector)
+	{
+		CellRect rect;
+		rect.x0 = sectorGrid_cellX(sector->boundsMin.x);
+		rect.x1 = sectorGrid_cellX(sector->boundsMax.x);
+		rect.z0 = sectorGrid_cellZ(sector->boundsMin.z);
+		rect.z1 = sectorGrid_cellZ(sector->boundsMax.z);
+		return rect;
+	}
+
+	void sectorGrid_insert(s32 index, const CellRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<s32>* cell = &s_cells[z * s_gridWidth + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				// Keep the cell sorted so candidates are visited in sector order.
+				cell->insert(std::lower_bound(cell->begin(), cell->end(), index), index);
+			}
+		}
+	}
+
+	void sectorGrid_remove(s32 index, const CellRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<s32>* cell = &s_cells[z * s_gridWidth + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				std::vector<s32>::iterator iter = std::lower_bound(cell->begin(), cell->end(), index);
+				if (iter != cell->end() && *iter == index)
+				{
+					cell->erase(iter);
+				}
+			}
+		}
+	}
+
+	void sectorGrid_build()
+	{
+		sectorGrid_clear();
+		const u32 sectorCount = s_levelState.sectorCount;
+		if (!sectorCount || !s_levelState.sectors) { return; }
+
+		// Compute the level bounds.
+		RSector* sector = s_levelState.sectors;
+		fixed16_16 minX = sector->boundsMin.x, maxX = sector->boundsMax.x;
+		fixed16_16 minZ = sector->boundsMin.z, maxZ = sector->boundsMax.z;
+		sector++;
+		for (u32 i = 1; i < sectorCount; i++, sector++)
+		{
+			minX = min(minX, sector->boundsMin.x);
+			minZ = min(minZ, sector->boundsMin.z);
+			maxX = max(maxX, sector->boundsMax.x);
+			maxZ = max(maxZ, sector->boundsMax.z);
+		}
+
+		// Pick a square cell size so that there are roughly GRID_SECTORS_PER_CELL sectors per cell.
+		const f64 width  = fixed16ToFloat(maxX - minX) + 1.0;
+		const f64 height = fixed16ToFloat(maxZ - minZ) + 1.0;
+		const f64 cellCount = std::max(1.0, f64(sectorCount) / f64(GRID_SECTORS_PER_CELL));
+		f64 cellSize = sqrt(width * height / cellCount);
+		cellSize = std::max(cellSize, std::max(width, height) / f64(GRID_MAX_DIM));
+		cellSize = std::max(cellSize, 1.0);
+
+		s_cellSize = floatToFixed16(f32(cellSize));
+		s_gridMinX = minX;
+		s_gridMinZ = minZ;
+		s_gridWidth  = std::min(s32(width / cellSize) + 1, s32(GRID_MAX_DIM));
+		s_gridHeight = std::min(s32(height / cellSize) + 1, s32(GRID_MAX_DIM));
+		s_gridSectorCount = sectorCount;
+
+		s_cells.resize(s_gridWidth * s_gridHeight);
+		s_sectorRect.resize(sectorCount);
+		sector = s_levelState.sectors;
+		for (u32 i = 0; i < sectorCount; i++, sector++)
+		{
+			s_sectorRect[i] = sectorGrid_getRect(sector);
+			// Sectors are added in order, so appending keeps the cells sorted.
+			const CellRect& rect = s_sectorRect[i];
+			for (s32 z = rect.z0; z <= rect.z1; z++)
+			{
+				for (s32 x = rect.x0; x <= rect.x1; x++)
+				{
+					s_cells[z * s_gridWidth + x].push_back(s32(i));
+				}
+			}
+		}
+		s_gridValid = true;
+	}
+
+	void sectorGrid_clear()
+	{
+		s_cells.clear();
+		s_sectorRect.clear();
+		s_gridWidth = 0;
+		s_gridHeight = 0;
+		s_gridSectorCount = 0;
+		s_gridValid = false;
+	}
+
+	bool sectorGrid_isValid()
+	{
+		return s_gridValid && s_gridSectorCount == s_levelState.sectorCount;
+	}
+
+	void sectorGrid_updateSector(RSector* sector)
+	{
+		if (!s_gridValid || !sector) { return; }
+		// Use the position in the sector array rather than the id, the control sector is not part of the grid.
+		const s32 index = s32(sector - s_levelState.sectors);
+		if (index < 0 || u32(index) >= s_gridSectorCount) { return; }
+
+		const CellRect rect = sectorGrid_getRect(sector);
+		CellRect& prevRect = s_sectorRect[index];
+		if (rect.x0 == prevRect.x0 && rect.x1 == prevRect.x1 && rect.z0 == prevRect.z0 && rect.z1 == prevRect.z1)
+		{
+			return;
+		}
+		sectorGrid_remove(index, prevRect);
+		sectorGrid_insert(index, rect);
+		prevRect = rect;
+	}
+
+	const s32* sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, s32* count)
+	{
+		const std::vector<s32>& cell = s_cells[sectorGrid_cellZ(z) * s_gridWidth + sectorGrid_cellX(x)];
+		*count = s32(cell.size());
+		return cell.data();
+	}
+
+	s32 sectorGrid_benchmark(s32 queryCount, f64* linearTimeMs, f64* gridTimeMs)
+	{
+		*linearTimeMs = 0.0;
+		*gridTimeMs = 0.0;
+		if (!sectorGrid_isValid() || queryCount <= 0) { return 0; }
+
+		// Generate query points inside random sector bounds and height ranges so most queries hit something.
+		std::vector<vec3_fixed> points(queryCount);
+		u32 seed = 0x1234567u;
+		for (s32 i = 0; i < queryCount; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			RSector* sector = &s_levelState.sectors[(seed >> 8) % s_levelState.sectorCount];
+			seed = seed * 1664525u + 1013904223u;
+			const fixed16_16 fx = fixed16_16((seed >> 16) & 0xffff);
+			seed = seed * 1664525u + 1013904223u;
+			const fixed16_16 fz = fixed16_16((seed >> 16) & 0xffff);
+
+			points[i].x = sector->boundsMin.x + fixed16_16((s64(sector->boundsMax.x - sector->boundsMin.x) * fx) >> 16);
+			points[i].z = sector->boundsMin.z + fixed16_16((s64(sector->boundsMax.z - sector->boundsMin.z) * fz) >> 16);
+			points[i].y = sector->ceilingHeight + ((sector->floorHeight - sector->ceilingHeight) >> 1);
+		}
+
+		std::vector<RSector*> linearResult(queryCount);
+		u64 start = TFE_System::getCurrentTimeInTicks();
+		for (s32 i = 0; i < queryCount; i++)
+		{
+			linearResult[i] = sector_which3D_Linear(points[i].x, points[i].y, points[i].z);
+		}
+		*linearTimeMs = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start) * 1000.0;
+
+		s32 mismatchCount = 0;
+		start = TFE_System::getCurrentTimeInTicks();
+		for (s32 i = 0; i < queryCount; i++)
+		{
+			if (sector_which3D(points[i].x, points[i].y, points[i].z) != linearResult[i])
+			{
+				mismatchCount++;
+			}
+		}
+		*gridTimeMs = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - start) * 1000.0;
+		return mismatchCount;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Grid
+// Uniform grid over the sector XZ bounds, used to accelerate point
+// in sector queries such as sector_which3D().
+//
+// Each cell stores the indices of the sectors whose bounds overlap it,
+// in ascending order, so walking a cell visits the candidates in the
+// same order as a linear scan over s_levelState.sectors.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <TFE_Jedi/Math/fixedPoint.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	// Build the grid from the current level sectors, this must be called after the sector bounds are computed.
+	void sectorGrid_build();
+	void sectorGrid_clear();
+	bool sectorGrid_isValid();
+
+	// Call whenever the bounds of a sector change.
+	void sectorGrid_updateSector(RSector* sector);
+
+	// Returns the sorted list of sector indices whose bounds may contain (x, z).
+	const s32* sectorGrid_getCandidates(fixed16_16 x, fixed16_16 z, s32* count);
+
+	// Compares the linear scan to the grid for queryCount random points inside the level bounds.
+	// Returns the number of queries where the results differ.
+	s32 sectorGrid_benchmark(s32 queryCount, f64* linearTimeMs, f64* gridTimeMs);
+}
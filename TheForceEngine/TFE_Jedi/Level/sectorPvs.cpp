@@ -0,0 +1,568 @@
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "sectorPvs.h"
+#include "rsector.h"
+#include "rwall.h"
+#include "levelData.h"
+#include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/jobSystem.h>
+#include <TFE_System/system.h>
+
+namespace TFE_Jedi
+{
+	enum PvsConstants
+	{
+		PVS_CACHE_MAGIC   = 0x31535650,	// "PVS1"
+		PVS_CACHE_VERSION = 1,
+		PVS_MAX_STEPS     = 65536,		// portal steps per source sector before falling back to a flood fill.
+		PVS_MAX_DEPTH     = 256,
+	};
+	// Portals are clipped with a small tolerance so that round off never hides a visible sector.
+	static const f32 c_pvsClipEpsilon = 0.01f;
+
+	struct PvsVec2
+	{
+		f32 x, z;
+	};
+
+	struct PvsSegment
+	{
+		PvsVec2 v0, v1;
+	};
+
+	// Per source sector state, so sectors can be built in parallel.
+	struct PvsFlowState
+	{
+		s32 source;
+		u32* row;
+		std::vector<u8> onPath;
+		std::vector<u8> flooded;
+		std::vector<s32> floodStack;
+		s32 steps;
+		bool overflow;
+	};
+
+	static std::vector<u32> s_pvsSets;
+	static std::vector<u8>  s_pvsDynamicWall;		// indexed by s_pvsWallBase[sector] + wall.
+	static std::vector<s32> s_pvsWallBase;
+	// Sectors that can become adjoined at runtime, as pairs.
+	static std::vector<s32> s_pvsExtraLinks;
+	// Sectors whose sets are merged into each set once all of them are built.
+	static std::vector<std::vector<s32>> s_pvsMergeSets;
+	static s32 s_pvsWordCount = 0;
+	static u32 s_pvsSectorCount = 0;
+	static bool s_pvsValid = false;
+	// Build statistics, written by the sector jobs.
+	static std::atomic<s32> s_pvsTotalSteps;
+	static std::atomic<s32> s_pvsOverflowCount;
+
+	////////////////////////////////////////////////////////
+	// Dynamic portals
+	////////////////////////////////////////////////////////
+	void pvs_addAdjoinCmd(RSector* sector0, RSector* sector1, RWall* wall0, RWall* wall1, void* userData)
+	{
+		if (!sector0 || !sector1) { return; }
+		s_pvsExtraLinks.push_back(sector0->index);
+		s_pvsExtraLinks.push_back(sector1->index);
+		if (wall0) { s_pvsDynamicWall[s_pvsWallBase[wall0->sector->index] + wall0->id] = 1; }
+		if (wall1) { s_pvsDynamicWall[s_pvsWallBase[wall1->sector->index] + wall1->id] = 1; }
+	}
+
+	// Flag the walls that can move or change their adjoin at runtime.
+	void pvs_findDynamicWalls()
+	{
+		const u32 sectorCount = s_levelState.sectorCount;
+		s_pvsWallBase.resize(sectorCount + 1);
+		s32 wallCount = 0;
+		for (u32 i = 0; i < sectorCount; i++)
+		{
+			s_pvsWallBase[i] = wallCount;
+			wallCount += s_levelState.sectors[i].wallCount;
+		}
+		s_pvsWallBase[sectorCount] = wallCount;
+		s_pvsDynamicWall.assign(wallCount, 0);
+		s_pvsExtraLinks.clear();
+
+		// Morphing walls move their first vertex, which also moves the previous wall.
+		std::vector<u8> movingVertex;
+		RSector* sector = s_levelState.sectors;
+		for (u32 i = 0; i < sectorCount; i++, sector++)
+		{
+			movingVertex.assign(sector->vertexCount, 0);
+			RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				if (wall->flags1 & WF1_WALL_MORPHS)
+				{
+					movingVertex[wall->w0 - sector->verticesWS] = 1;
+				}
+			}
+
+			u8* dynamicWall = &s_pvsDynamicWall[s_pvsWallBase[i]];
+			wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				if (movingVertex[wall->w0 - sector->verticesWS] || movingVertex[wall->w1 - sector->verticesWS])
+				{
+					dynamicWall[w] = 1;
+				}
+			}
+		}
+
+		// A portal is dynamic if either side can move.
+		sector = s_levelState.sectors;
+		for (u32 i = 0; i < sectorCount; i++, sector++)
+		{
+			RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				RWall* mirror = wall->mirrorWall;
+				if (mirror && s_pvsDynamicWall[s_pvsWallBase[mirror->sector->index] + mirror->id])
+				{
+					s_pvsDynamicWall[s_pvsWallBase[i] + w] = 1;
+				}
+			}
+		}
+
+		inf_forEachAdjoinCmd(pvs_addAdjoinCmd, nullptr);
+	}
+
+	bool pvs_isDynamicWall(const RSector* sector, s32 wallIndex)
+	{
+		return s_pvsDynamicWall[s_pvsWallBase[sector->index] + wallIndex] != 0;
+	}
+
+	////////////////////////////////////////////////////////
+	// Portal flow
+	////////////////////////////////////////////////////////
+	void pvs_setBit(u32* row, s32 index)
+	{
+		row[index >> 5] |= (1u << (index & 31));
+	}
+
+	PvsSegment pvs_getWallSegment(const RWall* wall)
+	{
+		PvsSegment seg;
+		seg.v0 = { fixed16ToFloat(wall->w0->x), fixed16ToFloat(wall->w0->z) };
+		seg.v1 = { fixed16ToFloat(wall->w1->x), fixed16ToFloat(wall->w1->z) };
+		return seg;
+	}
+
+	// Clip the segment to the half plane dot(p - origin, normal) >= -epsilon, where normal is unit length.
+	bool pvs_clipSegment(PvsSegment* seg, PvsVec2 origin, PvsVec2 normal)
+	{
+		const f32 d0 = (seg->v0.x - origin.x) * normal.x + (seg->v0.z - origin.z) * normal.z + c_pvsClipEpsilon;
+		const f32 d1 = (seg->v1.x - origin.x) * normal.x + (seg->v1.z - origin.z) * normal.z + c_pvsClipEpsilon;
+		if (d0 < 0.0f && d1 < 0.0f) { return false; }
+		if (d0 >= 0.0f && d1 >= 0.0f) { return true; }
+
+		const f32 s = d0 / (d0 - d1);
+		const PvsVec2 p = { seg->v0.x + (seg->v1.x - seg->v0.x) * s, seg->v0.z + (seg->v1.z - seg->v0.z) * s };
+		if (d0 < 0.0f) { seg->v0 = p; }
+		else { seg->v1 = p; }
+		return true;
+	}
+
+	// Keep the part of the segment on the far side of a portal, walls are clockwise so the outside is to the left.
+	bool pvs_clipToPortal(PvsSegment* seg, const PvsSegment& portal)
+	{
+		const f32 dx = portal.v1.x - portal.v0.x;
+		const f32 dz = portal.v1.z - portal.v0.z;
+		const f32 len = sqrtf(dx*dx + dz*dz);
+		if (len < FLT_EPSILON) { return true; }
+		return pvs_clipSegment(seg, portal.v0, { -dz / len, dx / len });
+	}
+
+	// Keep the part of the segment that can be reached by a line through both the source and pass portals.
+	// These are bounded by the separating lines through one end point of each portal, that have
+	// the rest of the source and the pass portals on opposite sides.
+	bool pvs_clipToSeparators(PvsSegment* seg, const PvsSegment& source, const PvsSegment& pass)
+	{
+		const PvsVec2 src[] = { source.v0, source.v1 };
+		const PvsVec2 dst[] = { pass.v0, pass.v1 };
+		for (s32 i = 0; i < 2; i++)
+		{
+			for (s32 j = 0; j < 2; j++)
+			{
+				const f32 dx = dst[j].x - src[i].x;
+				const f32 dz = dst[j].z - src[i].z;
+				const f32 len = sqrtf(dx*dx + dz*dz);
+				if (len < FLT_EPSILON) { continue; }
+
+				PvsVec2 normal = { -dz / len, dx / len };
+				const PvsVec2 srcOther = src[1 - i];
+				const PvsVec2 dstOther = dst[1 - j];
+				const f32 srcSide = (srcOther.x - src[i].x) * normal.x + (srcOther.z - src[i].z) * normal.z;
+				const f32 dstSide = (dstOther.x - src[i].x) * normal.x + (dstOther.z - src[i].z) * normal.z;
+				if (srcSide * dstSide >= 0.0f) { continue; }
+
+				// Keep the side that has the rest of the pass portal.
+				if (dstSide < 0.0f)
+				{
+					normal.x = -normal.x;
+					normal.z = -normal.z;
+				}
+				if (!pvs_clipSegment(seg, src[i], normal)) { return false; }
+			}
+		}
+		return true;
+	}
+
+	// Mark everything reachable from 'sector' through the adjoin graph, including adjoins that INF can create.
+	void pvs_flood(PvsFlowState* state, s32 sectorIndex)
+	{
+		if (state->flooded[sectorIndex]) { return; }
+		state->flooded[sectorIndex] = 1;
+		state->floodStack.push_back(sectorIndex);
+		while (!state->floodStack.empty())
+		{
+			const s32 index = state->floodStack.back();
+			state->floodStack.pop_back();
+			pvs_setBit(state->row, index);
+
+			const RSector* sector = &s_levelState.sectors[index];
+			const RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				const RSector* next = wall->nextSector;
+				if (next && !state->flooded[next->index])
+				{
+					state->flooded[next->index] = 1;
+					state->floodStack.push_back(next->index);
+				}
+			}
+
+			const size_t linkCount = s_pvsExtraLinks.size();
+			for (size_t i = 0; i < linkCount; i += 2)
+			{
+				s32 other = -1;
+				if (s_pvsExtraLinks[i] == index) { other = s_pvsExtraLinks[i + 1]; }
+				else if (s_pvsExtraLinks[i + 1] == index) { other = s_pvsExtraLinks[i]; }
+				if (other >= 0 && !state->flooded[other])
+				{
+					state->flooded[other] = 1;
+					state->floodStack.push_back(other);
+				}
+			}
+		}
+	}
+
+	// Any line that passes through a dynamic portal continues from inside of the sector behind it,
+	// so the set of that sector is merged in instead of clipping against the portal.
+	void pvs_mergeThroughWall(PvsFlowState* state, const RSector* sector, const RWall* wall)
+	{
+		std::vector<s32>& mergeSets = s_pvsMergeSets[state->source];
+		if (wall->nextSector) { mergeSets.push_back(wall->nextSector->index); }
+
+		// The adjoin may change, so also merge the sectors that INF can connect to this one.
+		const size_t linkCount = s_pvsExtraLinks.size();
+		for (size_t i = 0; i < linkCount; i += 2)
+		{
+			if (s_pvsExtraLinks[i] == sector->index) { mergeSets.push_back(s_pvsExtraLinks[i + 1]); }
+			else if (s_pvsExtraLinks[i + 1] == sector->index) { mergeSets.push_back(s_pvsExtraLinks[i]); }
+		}
+	}
+
+	void pvs_flow(PvsFlowState* state, const PvsSegment& source, const PvsSegment& pass, const RWall* passWall, const RSector* sector, s32 depth)
+	{
+		pvs_setBit(state->row, sector->index);
+		state->steps++;
+		if (state->steps > PVS_MAX_STEPS || depth > PVS_MAX_DEPTH)
+		{
+			state->overflow = true;
+			return;
+		}
+
+		const RWall* wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount && !state->overflow; w++, wall++)
+		{
+			const RSector* next = wall->nextSector;
+			if (wall == passWall->mirrorWall) { continue; }
+			if (pvs_isDynamicWall(sector, w))
+			{
+				pvs_mergeThroughWall(state, sector, wall);
+				continue;
+			}
+			if (!next || state->onPath[next->index]) { continue; }
+
+			PvsSegment seg = pvs_getWallSegment(wall);
+			if (!pvs_clipToPortal(&seg, pass) || !pvs_clipToSeparators(&seg, source, pass))
+			{
+				continue;
+			}
+
+			state->onPath[next->index] = 1;
+			pvs_flow(state, source, seg, wall, next, depth + 1);
+			state->onPath[next->index] = 0;
+		}
+	}
+
+	void pvs_buildSectorJob(s32 index, void* userData)
+	{
+		const RSector* sector = &s_levelState.sectors[index];
+		PvsFlowState state;
+		state.source = index;
+		state.row = &s_pvsSets[index * s_pvsWordCount];
+		state.onPath.assign(s_pvsSectorCount, 0);
+		state.flooded.assign(s_pvsSectorCount, 0);
+		state.steps = 0;
+		state.overflow = false;
+
+		pvs_setBit(state.row, index);
+		state.onPath[index] = 1;
+
+		const RWall* wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount && !state.overflow; w++, wall++)
+		{
+			if (pvs_isDynamicWall(sector, w))
+			{
+				pvs_mergeThroughWall(&state, sector, wall);
+				continue;
+			}
+
+			const RSector* next = wall->nextSector;
+			if (!next || next == sector) { continue; }
+
+			// The viewer can be anywhere in the sector, so the whole portal is the source.
+			const PvsSegment portal = pvs_getWallSegment(wall);
+			state.onPath[next->index] = 1;
+			pvs_flow(&state, portal, portal, wall, next, 1);
+			state.onPath[next->index] = 0;
+		}
+
+		if (state.overflow)
+		{
+			pvs_flood(&state, index);
+			s_pvsOverflowCount++;
+		}
+		s_pvsTotalSteps += state.steps;
+	}
+
+	////////////////////////////////////////////////////////
+	// Disk cache
+	////////////////////////////////////////////////////////
+	u64 pvs_hashValue(u64 hash, u32 value)
+	{
+		for (s32 i = 0; i < 4; i++, value >>= 8)
+		{
+			hash = (hash ^ (value & 0xff)) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	// Hash everything the sets are built from.
+	u64 pvs_hashGeometry()
+	{
+		u64 hash = 0xcbf29ce484222325ull;
+		hash = pvs_hashValue(hash, PVS_CACHE_VERSION);
+		hash = pvs_hashValue(hash, s_pvsSectorCount);
+		const RSector* sector = s_levelState.sectors;
+		for (u32 i = 0; i < s_pvsSectorCount; i++, sector++)
+		{
+			hash = pvs_hashValue(hash, sector->wallCount);
+			const RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				// Dynamic walls are flooded through, so their current position and adjoin do not matter.
+				// This keeps the hash stable when loading a save with moved walls.
+				const u32 dynamicWall = s_pvsDynamicWall[s_pvsWallBase[i] + w];
+				hash = pvs_hashValue(hash, dynamicWall);
+				if (dynamicWall) { continue; }
+
+				hash = pvs_hashValue(hash, wall->w0->x);
+				hash = pvs_hashValue(hash, wall->w0->z);
+				hash = pvs_hashValue(hash, wall->w1->x);
+				hash = pvs_hashValue(hash, wall->w1->z);
+				hash = pvs_hashValue(hash, wall->nextSector ? wall->nextSector->index : -1);
+			}
+		}
+		for (size_t i = 0; i < s_pvsExtraLinks.size(); i++)
+		{
+			hash = pvs_hashValue(hash, s_pvsExtraLinks[i]);
+		}
+		return hash;
+	}
+
+	void pvs_getCachePath(const char* levelName, char* path)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_PROGRAM_DATA, "Cache/", cacheDir);
+		if (!FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+		strcat(cacheDir, "Pvs/");
+		if (!FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+		sprintf(path, "%s%s.pvs", cacheDir, levelName);
+	}
+
+	bool pvs_readCache(const char* path, u64 hash)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			return false;
+		}
+
+		u32 magic = 0, sectorCount = 0;
+		u64 fileHash = 0;
+		file.read(&magic);
+		file.read(&fileHash);
+		file.read(&sectorCount);
+		if (magic != PVS_CACHE_MAGIC || fileHash != hash || sectorCount != s_pvsSectorCount ||
+			file.getSize() != sizeof(u32) * 2 + sizeof(u64) + s_pvsSets.size() * sizeof(u32))
+		{
+			return false;
+		}
+		file.readBuffer(s_pvsSets.data(), u32(s_pvsSets.size() * sizeof(u32)));
+		return true;
+	}
+
+	void pvs_writeCache(const char* path, u64 hash)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "PVS", "Cannot write the visibility cache '%s'.", path);
+			return;
+		}
+		const u32 magic = PVS_CACHE_MAGIC;
+		file.write(&magic);
+		file.write(&hash);
+		file.write(&s_pvsSectorCount);
+		file.writeBuffer(s_pvsSets.data(), u32(s_pvsSets.size() * sizeof(u32)));
+	}
+
+	////////////////////////////////////////////////////////
+	// API Implementation
+	////////////////////////////////////////////////////////
+	void pvs_build(const char* levelName)
+	{
+		pvs_clear();
+		s_pvsSectorCount = s_levelState.sectorCount;
+		if (!s_pvsSectorCount || !s_levelState.sectors) { return; }
+
+		s_pvsWordCount = s32((s_pvsSectorCount + 31) >> 5);
+		s_pvsSets.assign(size_t(s_pvsSectorCount) * s_pvsWordCount, 0);
+		pvs_findDynamicWalls();
+
+		const u64 startTime = TFE_System::getCurrentTimeInTicks();
+		const u64 hash = pvs_hashGeometry();
+		char cachePath[TFE_MAX_PATH] = "";
+		if (levelName)
+		{
+			pvs_getCachePath(levelName, cachePath);
+			if (pvs_readCache(cachePath, hash))
+			{
+				TFE_System::logWrite(LOG_MSG, "PVS", "Read the visibility sets for %u sectors from the cache in %0.2f ms.",
+					s_pvsSectorCount, TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime) * 1000.0);
+				s_pvsValid = true;
+				return;
+			}
+		}
+
+		s_pvsTotalSteps = 0;
+		s_pvsOverflowCount = 0;
+		s_pvsMergeSets.resize(s_pvsSectorCount);
+		TFE_Jobs::parallelFor(s32(s_pvsSectorCount), pvs_buildSectorJob, nullptr);
+
+		// Merge the sets seen through dynamic portals, these can chain so repeat until nothing changes.
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+			for (u32 i = 0; i < s_pvsSectorCount; i++)
+			{
+				u32* row = &s_pvsSets[i * s_pvsWordCount];
+				for (size_t m = 0; m < s_pvsMergeSets[i].size(); m++)
+				{
+					const u32* mergeRow = &s_pvsSets[s_pvsMergeSets[i][m] * s_pvsWordCount];
+					for (s32 w = 0; w < s_pvsWordCount; w++)
+					{
+						const u32 bits = row[w] | mergeRow[w];
+						changed |= (bits != row[w]);
+						row[w] = bits;
+					}
+				}
+			}
+		}
+		s_pvsMergeSets.clear();
+
+		// Visibility is symmetric, so merge both directions. This also covers any difference in
+		// the clipping in either direction.
+		s32 visibleCount = 0;
+		for (u32 i = 0; i < s_pvsSectorCount; i++)
+		{
+			const u32* row = &s_pvsSets[i * s_pvsWordCount];
+			for (u32 j = 0; j < s_pvsSectorCount; j++)
+			{
+				if (row[j >> 5] & (1u << (j & 31)))
+				{
+					pvs_setBit(&s_pvsSets[j * s_pvsWordCount], i);
+				}
+			}
+		}
+		for (size_t i = 0; i < s_pvsSets.size(); i++)
+		{
+			u32 bits = s_pvsSets[i];
+			for (; bits; bits &= bits - 1) { visibleCount++; }
+		}
+		TFE_System::logWrite(LOG_MSG, "PVS", "Built the visibility sets for %u sectors in %0.2f ms on %d threads, %0.1f visible sectors on average.",
+			s_pvsSectorCount, TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime) * 1000.0,
+			TFE_Jobs::getWorkerCount() + 1, f64(visibleCount) / f64(s_pvsSectorCount));
+		TFE_System::logWrite(LOG_MSG, "PVS", "%d portal steps, %d sectors went over the %d step budget and were flood filled.",
+			s32(s_pvsTotalSteps), s32(s_pvsOverflowCount), PVS_MAX_STEPS);
+
+		if (cachePath[0])
+		{
+			pvs_writeCache(cachePath, hash);
+		}
+		s_pvsValid = true;
+	}
+
+	void pvs_clear()
+	{
+		s_pvsSets.clear();
+		s_pvsDynamicWall.clear();
+		s_pvsWallBase.clear();
+		s_pvsExtraLinks.clear();
+		s_pvsMergeSets.clear();
+		s_pvsWordCount = 0;
+		s_pvsSectorCount = 0;
+		s_pvsValid = false;
+	}
+
+	bool pvs_isValid()
+	{
+		return s_pvsValid && s_pvsSectorCount == s_levelState.sectorCount;
+	}
+
+	bool pvs_isVisible(const RSector* source, const RSector* target)
+	{
+		if (!pvs_isValid() || !source || !target) { return true; }
+		const s32 s = source->index, t = target->index;
+		if (s < 0 || t < 0 || u32(s) >= s_pvsSectorCount || u32(t) >= s_pvsSectorCount) { return true; }
+		return (s_pvsSets[s * s_pvsWordCount + (t >> 5)] & (1u << (t & 31))) != 0;
+	}
+
+	const u32* pvs_getSet(const RSector* sector, s32* wordCount)
+	{
+		if (!pvs_isValid() || !sector || sector->index < 0 || u32(sector->index) >= s_pvsSectorCount)
+		{
+			return nullptr;
+		}
+		*wordCount = s_pvsWordCount;
+		return &s_pvsSets[sector->index * s_pvsWordCount];
+	}
+}
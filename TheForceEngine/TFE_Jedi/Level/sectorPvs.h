@@ -0,0 +1,35 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Potential Visibility Sets
+// For each sector, a bitset of the sectors that can possibly be seen
+// from anywhere inside of it. The sets are built at load time by
+// flowing through the adjoin graph in XZ, clipping each portal against
+// the lines that pass through the source portal and the previous
+// portal. Heights are ignored, so the sets are conservative: a sector
+// that is not in the set can never be seen, but being in the set does
+// not mean it is visible.
+//
+// Portals that can move (morphing walls) or be created (INF adjoin
+// commands) cannot be clipped, so the set of the sector behind them is
+// merged in instead.
+//
+// The sets are cached on disk, keyed by a hash of the level geometry.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	// Build the sets for the current level, this must be called after the INF is loaded.
+	// If levelName is not null, the sets are read from or written to the disk cache.
+	void pvs_build(const char* levelName);
+	void pvs_clear();
+	bool pvs_isValid();
+
+	// Returns true if 'target' may be visible from anywhere in 'source'.
+	// Always returns true if the sets have not been built.
+	bool pvs_isVisible(const RSector* source, const RSector* target);
+	// Returns the visibility bitset of 'sector' (bit i = sector index i) or null if the sets have not been built.
+	const u32* pvs_getSet(const RSector* sector, s32* wordCount);
+}
@@ -0,0 +1,270 @@
+#include <vector>
+
+#include "stateHash.h"
+#include "rsector.h"
+#include "rwall.h"
+#include "robject.h"
+#include "levelData.h"
+#include <TFE_DarkForces/logic.h>
+#include <TFE_Jedi/InfSystem/infSystem.h>
+#include <TFE_Jedi/Memory/allocator.h>
+#include <TFE_Jedi/Task/task.h>
+#include <TFE_System/profiler.h>
+
+namespace TFE_Jedi
+{
+	// Set by the renderer or by objects moving between sectors, these are not part of the hashed state.
+	static const u32 c_sectorHashFlags1Mask = ~u32(SEC_FLAGS1_RENDERED | SEC_FLAGS1_PLAYER);
+
+	struct ObjectHashSums
+	{
+		u32 objects;
+		u32 logics;
+	};
+
+	static JBool s_hashEnabled = JFALSE;
+	static bool s_sectorsValid = false;
+	static RSector* s_hashSectors = nullptr;
+	static std::vector<u32> s_sectorHashes;
+	static std::vector<u8>  s_sectorDirty;
+	static u32 s_sectorSum = 0;
+	static s32 s_hashedSectorCount = 0;
+
+	static const char* c_systemNames[SHASH_COUNT] =
+	{
+		"Sectors",	// SHASH_SECTORS
+		"Objects",	// SHASH_OBJECTS
+		"Logics",	// SHASH_LOGICS
+		"INF",		// SHASH_INF
+		"Random",	// SHASH_RANDOM
+	};
+
+	u32 stateHash_hashSector(RSector* sector);
+	void stateHash_hashObject(SecObject* obj, void* userData);
+	void stateHash_updateSectors();
+
+	void stateHash_enable(JBool enable)
+	{
+		if (enable == s_hashEnabled) { return; }
+		s_hashEnabled = enable;
+		// Changes are not tracked while disabled.
+		stateHash_clear();
+	}
+
+	JBool stateHash_isEnabled()
+	{
+		return s_hashEnabled;
+	}
+
+	void stateHash_clear()
+	{
+		s_sectorsValid = false;
+		s_hashSectors = nullptr;
+		s_sectorHashes.clear();
+		s_sectorDirty.clear();
+		s_sectorSum = 0;
+	}
+
+	// This only writes the flag of the sector, so it is safe to call from elevators updated on
+	// worker threads, which never share sectors (see inf_updateElevatorBatch()).
+	void stateHash_sectorChanged(RSector* sector)
+	{
+		if (!s_hashEnabled || !s_sectorsValid || !sector) { return; }
+
+		const s32 index = sector->index;
+		if (index < 0 || index >= (s32)s_sectorDirty.size()) { return; }
+		s_sectorDirty[index] = 1;
+	}
+
+	void stateHash_compute(StateHash* hash, u32 randomSeed)
+	{
+		TFE_ZONE("State Hash");
+		TFE_COUNTER(s_hashedSectorCount, "State Hash Sectors");
+		stateHash_updateSectors();
+		hash->value[SHASH_SECTORS] = s_sectorSum;
+
+		ObjectHashSums sums = { 0, 0 };
+		objData_forEach(stateHash_hashObject, &sums);
+		hash->value[SHASH_OBJECTS] = sums.objects;
+		hash->value[SHASH_LOGICS] = sums.logics;
+
+		hash->value[SHASH_INF] = inf_hashState();
+		hash->value[SHASH_RANDOM] = stateHash_end(stateHash_add(stateHash_begin(), randomSeed));
+	}
+
+	s32 stateHash_compare(const StateHash* a, const StateHash* b)
+	{
+		for (s32 i = 0; i < SHASH_COUNT; i++)
+		{
+			if (a->value[i] != b->value[i]) { return i; }
+		}
+		return -1;
+	}
+
+	const char* stateHash_getSystemName(s32 system)
+	{
+		if (system < 0 || system >= SHASH_COUNT) { return "Unknown"; }
+		return c_systemNames[system];
+	}
+
+	// FNV-1a over 32-bit words, finished with the murmur3 mixer so that summing element hashes is not linear.
+	u32 stateHash_begin()
+	{
+		return 0x811c9dc5u;
+	}
+
+	u32 stateHash_add(u32 hash, u32 value)
+	{
+		return (hash ^ value) * 0x01000193u;
+	}
+
+	u32 stateHash_end(u32 hash)
+	{
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35u;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	////////////////////////////////////////////////////////
+	// Internal
+	////////////////////////////////////////////////////////
+	// Level textures are hashed by index, switch signs point to their trigger and are hashed with the INF state.
+	s32 stateHash_getSignIndex(const RWall* wall)
+	{
+		TextureData** signTex = wall->signTex;
+		if (!signTex) { return -1; }
+
+		TextureData** textures = s_levelState.textures;
+		if (!textures || signTex < textures || signTex >= textures + s_levelState.textureCount) { return -2; }
+		return s32(signTex - textures);
+	}
+
+	u32 stateHash_hashSector(RSector* sector)
+	{
+		u32 hash = stateHash_begin();
+		hash = stateHash_add(hash, sector->index);
+		hash = stateHash_add(hash, sector->floorHeight);
+		hash = stateHash_add(hash, sector->ceilingHeight);
+		hash = stateHash_add(hash, sector->secHeight);
+		hash = stateHash_add(hash, sector->ambient);
+		hash = stateHash_add(hash, sector->colFloorHeight);
+		hash = stateHash_add(hash, sector->colCeilHeight);
+		hash = stateHash_add(hash, sector->colSecHeight);
+		hash = stateHash_add(hash, sector->colSecCeilHeight);
+		hash = stateHash_add(hash, sector->floorOffset.x);
+		hash = stateHash_add(hash, sector->floorOffset.z);
+		hash = stateHash_add(hash, sector->ceilOffset.x);
+		hash = stateHash_add(hash, sector->ceilOffset.z);
+		hash = stateHash_add(hash, sector->flags1 & c_sectorHashFlags1Mask);
+		hash = stateHash_add(hash, sector->flags2);
+		hash = stateHash_add(hash, sector->flags3);
+
+		const vec2_fixed* vtx = sector->verticesWS;
+		for (s32 v = 0; v < sector->vertexCount; v++, vtx++)
+		{
+			hash = stateHash_add(hash, vtx->x);
+			hash = stateHash_add(hash, vtx->z);
+		}
+
+		const RWall* wall = sector->walls;
+		for (s32 w = 0; w < sector->wallCount; w++, wall++)
+		{
+			hash = stateHash_add(hash, wall->nextSector ? wall->nextSector->index : -1);
+			hash = stateHash_add(hash, wall->flags1);
+			hash = stateHash_add(hash, wall->flags2);
+			hash = stateHash_add(hash, wall->flags3);
+			hash = stateHash_add(hash, wall->wallLight);
+			hash = stateHash_add(hash, wall->topOffset.x);
+			hash = stateHash_add(hash, wall->topOffset.z);
+			hash = stateHash_add(hash, wall->midOffset.x);
+			hash = stateHash_add(hash, wall->midOffset.z);
+			hash = stateHash_add(hash, wall->botOffset.x);
+			hash = stateHash_add(hash, wall->botOffset.z);
+			hash = stateHash_add(hash, wall->signOffset.x);
+			hash = stateHash_add(hash, wall->signOffset.z);
+			hash = stateHash_add(hash, stateHash_getSignIndex(wall));
+		}
+		return stateHash_end(hash);
+	}
+
+	void stateHash_updateSectors()
+	{
+		const u32 sectorCount = s_levelState.sectorCount;
+		if (!s_sectorsValid || s_hashSectors != s_levelState.sectors || s_sectorHashes.size() != sectorCount)
+		{
+			// Hash every sector, from here on only the changed sectors are hashed.
+			s_hashSectors = s_levelState.sectors;
+			s_sectorHashes.resize(sectorCount);
+			s_sectorDirty.assign(sectorCount, 0);
+			s_sectorSum = 0;
+
+			RSector* sector = s_levelState.sectors;
+			for (u32 s = 0; s < sectorCount; s++, sector++)
+			{
+				s_sectorHashes[s] = stateHash_hashSector(sector);
+				s_sectorSum += s_sectorHashes[s];
+			}
+			s_sectorsValid = true;
+			s_hashedSectorCount = s32(sectorCount);
+			return;
+		}
+
+		// Scanning the flags is much cheaper than hashing, even with thousands of sectors.
+		s32 dirtyCount = 0;
+		u8* dirty = s_sectorDirty.data();
+		for (u32 s = 0; s < sectorCount; s++)
+		{
+			if (!dirty[s]) { continue; }
+			s_sectorSum -= s_sectorHashes[s];
+			s_sectorHashes[s] = stateHash_hashSector(&s_levelState.sectors[s]);
+			s_sectorSum += s_sectorHashes[s];
+			dirty[s] = 0;
+			dirtyCount++;
+		}
+		s_hashedSectorCount = dirtyCount;
+	}
+
+	void stateHash_hashObject(SecObject* obj, void* userData)
+	{
+		ObjectHashSums* sums = (ObjectHashSums*)userData;
+
+		u32 hash = stateHash_begin();
+		hash = stateHash_add(hash, obj->type);
+		hash = stateHash_add(hash, obj->entityFlags);
+		hash = stateHash_add(hash, obj->posWS.x);
+		hash = stateHash_add(hash, obj->posWS.y);
+		hash = stateHash_add(hash, obj->posWS.z);
+		hash = stateHash_add(hash, obj->worldWidth);
+		hash = stateHash_add(hash, obj->worldHeight);
+		hash = stateHash_add(hash, obj->frame);
+		hash = stateHash_add(hash, obj->anim);
+		hash = stateHash_add(hash, obj->sector ? obj->sector->index : -1);
+		hash = stateHash_add(hash, obj->flags);
+		hash = stateHash_add(hash, obj->pitch);
+		hash = stateHash_add(hash, obj->yaw);
+		hash = stateHash_add(hash, obj->roll);
+		const u32 objHash = stateHash_end(hash);
+		sums->objects += objHash;
+
+		// Logics are identified by their object, the logic specific state shows up in the object and task timing.
+		Allocator* logicList = (Allocator*)obj->logic;
+		if (!logicList) { return; }
+
+		allocator_saveIter(logicList);
+		Logic** logicPtr = (Logic**)allocator_getHead(logicList);
+		while (logicPtr)
+		{
+			Logic* logic = *logicPtr;
+			u32 logicHash = stateHash_add(stateHash_begin(), objHash);
+			logicHash = stateHash_add(logicHash, logic->type);
+			logicHash = stateHash_add(logicHash, logic->task ? task_getNextTick(logic->task) : 0);
+			sums->logics += stateHash_end(logicHash);
+
+			logicPtr = (Logic**)allocator_getNext(logicList);
+		}
+		allocator_restoreIter(logicList);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Simulation State Hash
+// A hash of the simulation state per subsystem, used to detect where
+// two runs of the same game diverge, such as a demo and its playback.
+//
+// Sectors and their walls are hashed once and cached, afterwards only
+// sectors reported through stateHash_sectorChanged() are hashed again.
+// Objects, logics and INF state are hashed every time. Element hashes
+// are summed so the result does not depend on allocation order.
+//
+// Hashing is disabled by default, in which case the only cost is a
+// branch in stateHash_sectorChanged().
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+struct RSector;
+
+namespace TFE_Jedi
+{
+	enum StateHashSystem
+	{
+		SHASH_SECTORS = 0,
+		SHASH_OBJECTS,
+		SHASH_LOGICS,
+		SHASH_INF,
+		SHASH_RANDOM,
+		SHASH_COUNT
+	};
+
+	struct StateHash
+	{
+		u32 value[SHASH_COUNT];
+	};
+
+	void  stateHash_enable(JBool enable);
+	JBool stateHash_isEnabled();
+	// Discard the cached sector hashes, called when the level is cleared.
+	void  stateHash_clear();
+	// Called when the simulation changes a sector or its walls: heights, offsets, lighting, vertices or flags.
+	void  stateHash_sectorChanged(RSector* sector);
+
+	// Hash the current state, 'randomSeed' is the game random number generator state.
+	void stateHash_compute(StateHash* hash, u32 randomSeed);
+	// Hash a single sector and its walls, ignoring the cached hashes.
+	u32  stateHash_hashSector(RSector* sector);
+	// Returns the first subsystem that differs or -1 if the hashes match.
+	s32  stateHash_compare(const StateHash* a, const StateHash* b);
+	const char* stateHash_getSystemName(s32 system);
+
+	// Element hash helpers.
+	u32 stateHash_begin();
+	u32 stateHash_add(u32 hash, u32 value);
+	u32 stateHash_end(u32 hash);
+}
@@ -6,10 +6,21 @@
 struct AllocHeader
 {
 	AllocHeader* prev;
-	AllocHeader* next;
+	AllocHeader* next;	// next free header while the item is on the free list.
 	char data[];		// actual data storage area.
 };
 
+// TFE: Items are carved out of contiguous slabs instead of being allocated individually.
+// Deleted items go onto a free list and are reused by the next allocation, slabs are only
+// returned to the region when the allocator is freed.
+struct AllocSlab
+{
+	AllocSlab* next;
+	s32 capacity;
+	s32 pad;
+	// items follow.
+};
+
 struct Allocator
 {
 	Allocator*   self;
@@ -24,6 +35,10 @@ struct Allocator
 	// TFE
 	AllocHeader* iterSave;
 	AllocHeader* iterPrevSave;
+	AllocSlab*   slabs;
+	AllocHeader* freeList;
+	s32 slabCapacity;	// item count of the next slab.
+	s32 count;
 };
 
 // given an "item" (=allocheader->data), get the "AllocHeader" it belongs to.
@@ -41,6 +56,35 @@ template<class P, class C>C* _AllocHeader_of(P ptr)
 namespace TFE_Jedi
 {
 	#define MAX_ALLOC_SIZE (8*1024*1024)  // 8MB
+	#define MIN_SLAB_ITEMS 8
+	#define MAX_SLAB_ITEMS 256
+	#define MAX_SLAB_SIZE  (64*1024)       // Slabs grow until they reach this size or MAX_SLAB_ITEMS.
+
+	// Add a new slab and put its items on the free list, the first item ends up at the head of the list.
+	static bool allocator_addSlab(Allocator* alloc)
+	{
+		const s32 capacity = alloc->slabCapacity;
+		AllocSlab* slab = (AllocSlab*)TFE_Memory::region_alloc(alloc->region, sizeof(AllocSlab) + u64(alloc->size) * capacity);
+		if (!slab) { return false; }
+
+		slab->next = alloc->slabs;
+		slab->capacity = capacity;
+		alloc->slabs = slab;
+
+		u8* items = (u8*)(slab + 1);
+		for (s32 i = capacity - 1; i >= 0; i--)
+		{
+			AllocHeader* header = (AllocHeader*)(items + i * alloc->size);
+			header->next = alloc->freeList;
+			alloc->freeList = header;
+		}
+
+		if (alloc->slabCapacity < MAX_SLAB_ITEMS && alloc->size * alloc->slabCapacity * 2 <= MAX_SLAB_SIZE)
+		{
+			alloc->slabCapacity *= 2;
+		}
+		return true;
+	}
 
 	// Create and free an allocator.
 	Allocator* allocator_create(s32 allocSize, MemoryRegion* region)
@@ -60,8 +104,14 @@ namespace TFE_Jedi
 		memset(res, 0, sizeof(Allocator));
 		res->self = res;
 		res->region = region;
-		res->size = allocSize + sizeof(AllocHeader);
+		// Keep items in a slab pointer aligned.
+		res->size = (allocSize + sizeof(AllocHeader) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
 		res->refCount = 0;
+		res->slabCapacity = MIN_SLAB_ITEMS;
+		while (res->slabCapacity > 1 && res->size * res->slabCapacity > MAX_SLAB_SIZE)
+		{
+			res->slabCapacity >>= 1;
+		}
 
 		return res;
 	}
@@ -70,11 +120,12 @@ namespace TFE_Jedi
 	{
 		if (!alloc) { return; }
 
-		void* item = allocator_getHead(alloc);
-		while (item)
+		AllocSlab* slab = alloc->slabs;
+		while (slab)
 		{
-			allocator_deleteItem(alloc, item);
-			item = allocator_getNext(alloc);
+			AllocSlab* next = slab->next;
+			TFE_Memory::region_free(alloc->region, slab);
+			slab = next;
 		}
 
 		alloc->self = nullptr;
@@ -91,13 +142,15 @@ namespace TFE_Jedi
 	{
 		if (!alloc) { return nullptr; }
 
-		AllocHeader* header = (AllocHeader*)TFE_Memory::region_alloc(alloc->region, alloc->size);
-		if (!header)
+		if (!alloc->freeList && !allocator_addSlab(alloc))
 		{
-			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot allocate header of size %d", alloc->size);
+			TFE_System::logWrite(LOG_ERROR, "Allocator", "allocator_newItem - cannot allocate slab of %d items of size %d", alloc->slabCapacity, alloc->size);
 			return nullptr;
 		}
+		AllocHeader* header = alloc->freeList;
+		alloc->freeList = header->next;
 		memset(header, 0, alloc->size);
+		alloc->count++;
 
 		header->next = nullptr;
 		header->prev = alloc->tail;
@@ -121,7 +174,8 @@ namespace TFE_Jedi
 		if (!alloc || !item) { return; }
 
 		AllocHeader* header = AllocHeader_of(item);
-		if (header == nullptr) { return; }
+		// Items on the free list point to themselves, ignore double deletes.
+		if (header == nullptr || header->prev == header) { return; }
 
 		AllocHeader* prev = header->prev;
 		AllocHeader* next = header->next;
@@ -141,22 +195,16 @@ namespace TFE_Jedi
 			alloc->iterPrev = header->next;
 		}
 
-		TFE_Memory::region_free(alloc->region, header);
+		header->prev = header;
+		header->next = alloc->freeList;
+		alloc->freeList = header;
+		alloc->count--;
 	}
 
 	// Random access.
 	s32 allocator_getCount(Allocator* alloc)
 	{
-		if (!alloc) { return 0; }
-
-		s32 count = 0;
-		AllocHeader* header = alloc->head;
-		while (header)
-		{
-			count++;
-			header = header->next;
-		}
-		return count;
+		return alloc ? alloc->count : 0;
 	}
 		
 	s32 allocator_getCurPos(Allocator* alloc)
@@ -9,6 +9,7 @@
 #include "../rsectorRender.h"
 #include "../redgePair.h"
 #include "../rcommon.h"
+#include "../rdrawKernels.h"
 #include <assert.h>
 
 namespace TFE_Jedi
@@ -79,104 +80,34 @@ namespace RClassic_Fixed
 	// to account for C vs ASM differences.
 	void drawScanline()
 	{
-		fixed16_16 U = s_scanlineU0;
-		fixed16_16 V = s_scanlineV0;
-		const fixed16_16 dUdX = s_scanline_dUdX;
-		const fixed16_16 dVdX = s_scanline_dVdX;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		u32 texel = ((floor16(U) & 63)<<6) + (floor16(V) & 63);
-		texel &= s_ftexDataEnd;
-		U += dUdX;
-		V += dVdX;
-
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--)
-		{
-			u8 c = s_scanlineLight[s_ftexImage[texel]];
-			texel = ((floor16(U) & 63)<<6) + (floor16(V) & 63);
-			texel &= s_ftexDataEnd;
-			U += dUdX;
-			V += dVdX;
-			s_scanlineOut[i] = c;
-		}
+		s_drawSpanKernel[DK_LIT](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_16, u32(s_ftexDataEnd), s_ftexImage, s_scanlineLight);
 	}
 
 	void drawScanline_Fullbright()
 	{
-		fixed16_16 V = s_scanlineV0;
-		fixed16_16 U = s_scanlineU0;
-		fixed16_16 dVdX = s_scanline_dVdX;
-		fixed16_16 dUdX = s_scanline_dUdX;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		u32 texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-		texel &= s_ftexDataEnd;
-		U += dUdX;
-		V += dVdX;
-
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--)
-		{
-			u8 c = s_ftexImage[texel];
-			texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-			texel &= s_ftexDataEnd;
-			U += dUdX;
-			V += dVdX;
-			s_scanlineOut[i] = c;
-		}
+		s_drawSpanKernel[DK_FULLBRIGHT](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_16, u32(s_ftexDataEnd), s_ftexImage, nullptr);
 	}
 
 	void drawScanline_Trans()
 	{
-		fixed16_16 V = s_scanlineV0;
-		fixed16_16 U = s_scanlineU0;
-		fixed16_16 dVdX = s_scanline_dVdX;
-		fixed16_16 dUdX = s_scanline_dUdX;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		u32 texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-		texel &= s_ftexDataEnd;
-		U += dUdX;
-		V += dVdX;
-
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--)
-		{
-			u8 baseColor = s_ftexImage[texel];
-			u8 c = s_scanlineLight[baseColor];
-			texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-			texel &= s_ftexDataEnd;
-			U += dUdX;
-			V += dVdX;
-
-			if (baseColor) { s_scanlineOut[i] = c; }
-		}
+		s_drawSpanKernel[DK_LIT_TRANS](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_16, u32(s_ftexDataEnd), s_ftexImage, s_scanlineLight);
 	}
 
 	void drawScanline_Fullbright_Trans()
 	{
-		fixed16_16 V = s_scanlineV0;
-		fixed16_16 U = s_scanlineU0;
-		fixed16_16 dVdX = s_scanline_dVdX;
-		fixed16_16 dUdX = s_scanline_dUdX;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		u32 texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-		texel &= s_ftexDataEnd;
-		U += dUdX;
-		V += dVdX;
-
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--)
-		{
-			u8 c = s_ftexImage[texel];
-			texel = (floor16(U) & 63) * 64 + (floor16(V) & 63);
-			texel &= s_ftexDataEnd;
-			U += dUdX;
-			V += dVdX;
-			if (c) { s_scanlineOut[i] = c; }
-		}
+		s_drawSpanKernel[DK_FULLBRIGHT_TRANS](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_16, u32(s_ftexDataEnd), s_ftexImage, nullptr);
 	}
 			   
 	bool flat_setTexture(TextureData* tex)
@@ -12,6 +12,7 @@
 #include "redgePairFixed.h"
 #include "rclassicFixedSharedState.h"
 #include "../rcommon.h"
+#include "../rdrawKernels.h"
 #include "../jediRenderer.h"
 
 namespace TFE_Jedi
@@ -2078,6 +2079,13 @@ namespace RClassic_Fixed
 
 	void drawColumn_Fullbright()
 	{
+		// Use the SIMD kernels unless the texture is too tall for 32 bit texture coordinates, see rdrawKernels.h
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_16))
+		{
+			s_drawColumnKernel[DK_FULLBRIGHT](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_16, nullptr);
+			return;
+		}
+
 		fixed16_16 vCoordFixed = s_vCoordFixed;
 		u8* tex = s_texImage;
 
@@ -2096,6 +2104,12 @@ namespace RClassic_Fixed
 
 	void drawColumn_Lit()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_16))
+		{
+			s_drawColumnKernel[DK_LIT](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_16, s_columnLight);
+			return;
+		}
+
 		fixed16_16 vCoordFixed = s_vCoordFixed;
 		u8* tex = s_texImage;
 
@@ -2114,6 +2128,12 @@ namespace RClassic_Fixed
 
 	void drawColumn_Fullbright_Trans()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_16))
+		{
+			s_drawColumnKernel[DK_FULLBRIGHT_TRANS](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_16, nullptr);
+			return;
+		}
+
 		fixed16_16 vCoordFixed = s_vCoordFixed;
 		u8* tex = s_texImage;
 
@@ -2132,6 +2152,12 @@ namespace RClassic_Fixed
 
 	void drawColumn_Lit_Trans()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_16))
+		{
+			s_drawColumnKernel[DK_LIT_TRANS](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_16, s_columnLight);
+			return;
+		}
+
 		fixed16_16 vCoordFixed = s_vCoordFixed;
 		u8* tex = s_texImage;
 
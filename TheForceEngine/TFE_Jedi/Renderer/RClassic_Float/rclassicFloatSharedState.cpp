@@ -2,5 +2,5 @@
 
 namespace TFE_Jedi
 {
-	RClassicFloatState s_rcfltState = { 0 };
+	thread_local RClassicFloatState s_rcfltState = { 0 };
 }  // TFE_Jedi
\ No newline at end of file
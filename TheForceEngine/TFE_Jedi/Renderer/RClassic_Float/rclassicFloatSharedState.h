@@ -53,14 +53,16 @@ namespace TFE_Jedi
 		f32 windowMaxY;
 
 		// Flats
+		// The lists are allocated separately so that each render thread can own its own copy.
 		EdgePairFloat* flatEdge;
-		EdgePairFloat  flatEdgeList[MAX_SEG_EXT];
+		EdgePairFloat* flatEdgeList;		// [MAX_SEG_EXT]
 		EdgePairFloat* adjoinEdge;
 		EdgePairFloat* adjoinEdgeList;
 
-		RWallSegmentFloat   wallSegListDst[MAX_SEG_EXT];
-		RWallSegmentFloat   wallSegListSrc[MAX_SEG_EXT];
+		RWallSegmentFloat*  wallSegListDst;	// [MAX_SEG_EXT]
+		RWallSegmentFloat*  wallSegListSrc;	// [MAX_SEG_EXT]
 		RWallSegmentFloat** adjoinSegment;
 	};
-	extern RClassicFloatState s_rcfltState;
+	// Each thread has its own state, render bands copy the main thread state before drawing.
+	extern thread_local RClassicFloatState s_rcfltState;
 }  // TFE_Jedi
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "../rsectorRender.h"
 #include "../redgePair.h"
 #include "../rcommon.h"
+#include "../rdrawKernels.h"
 #include <assert.h>
 
 namespace TFE_Jedi
@@ -18,23 +19,23 @@ namespace TFE_Jedi
 
 namespace RClassic_Float
 {
-	static s32 s_scanlineX0;
-
-	static fixed44_20 s_scanlineU0;
-	static fixed44_20 s_scanlineV0;
-	static fixed44_20 s_scanline_dUdX;
-	static fixed44_20 s_scanline_dVdX;
-
-	static s32 s_scanlineWidth;
-	static const u8* s_scanlineLight;
-	static u8* s_scanlineOut;
-
-	static u8* s_ftexImage;
-	static s32 s_ftexDataEnd;
-	static s32 s_ftexHeight;
-	static s32 s_ftexWidthMask;
-	static s32 s_ftexHeightMask;
-	static s32 s_ftexHeightLog2;
+	static thread_local s32 s_scanlineX0;
+
+	static thread_local fixed44_20 s_scanlineU0;
+	static thread_local fixed44_20 s_scanlineV0;
+	static thread_local fixed44_20 s_scanline_dUdX;
+	static thread_local fixed44_20 s_scanline_dVdX;
+
+	static thread_local s32 s_scanlineWidth;
+	static thread_local const u8* s_scanlineLight;
+	static thread_local u8* s_scanlineOut;
+
+	static thread_local u8* s_ftexImage;
+	static thread_local s32 s_ftexDataEnd;
+	static thread_local s32 s_ftexHeight;
+	static thread_local s32 s_ftexWidthMask;
+	static thread_local s32 s_ftexHeightMask;
+	static thread_local s32 s_ftexHeightLog2;
 		
 	void flat_addEdges(s32 length, s32 x0, f32 dyFloor_dx, f32 yFloor, f32 dyCeil_dx, f32 yCeil)
 	{
@@ -81,70 +82,34 @@ namespace RClassic_Float
 	// to account for C vs ASM differences.
 	void drawScanline()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			s_scanlineOut[i] = s_scanlineLight[s_ftexImage[texel]];
-		}
+		s_drawSpanKernel[DK_LIT](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_20, u32(s_ftexDataEnd), s_ftexImage, s_scanlineLight);
 	}
 
 	void drawScanline_Fullbright()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			s_scanlineOut[i] = s_ftexImage[texel];
-		}
+		s_drawSpanKernel[DK_FULLBRIGHT](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_20, u32(s_ftexDataEnd), s_ftexImage, nullptr);
 	}
 
 	void drawScanline_Trans()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			const u8 baseColor = s_ftexImage[texel];
-
-			if (baseColor) { s_scanlineOut[i] = s_scanlineLight[baseColor]; }
-		}
+		s_drawSpanKernel[DK_LIT_TRANS](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_20, u32(s_ftexDataEnd), s_ftexImage, s_scanlineLight);
 	}
 
 	void drawScanline_Fullbright_Trans()
 	{
-		const fixed44_20 dVdX = s_scanline_dVdX;
-		const fixed44_20 dUdX = s_scanline_dUdX;
-		fixed44_20 V = s_scanlineV0;
-		fixed44_20 U = s_scanlineU0;
-
 		// Note this produces a distorted mapping if the texture is not 64x64.
 		// This behavior matches the original.
-		for (s32 i = s_scanlineWidth - 1; i >= 0; i--, U += dUdX, V += dVdX)
-		{
-			const u32 texel = ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & s_ftexDataEnd;
-			const u8 baseColor = s_ftexImage[texel];
-
-			if (baseColor) { s_scanlineOut[i] = baseColor; }
-		}
+		s_drawSpanKernel[DK_FULLBRIGHT_TRANS](s_scanlineOut, s_scanlineWidth, u32(s_scanlineU0), u32(s_scanlineV0), u32(s_scanline_dUdX), u32(s_scanline_dVdX),
+			FRAC_BITS_20, u32(s_ftexDataEnd), s_ftexImage, nullptr);
 	}
 			   
 	bool flat_setTexture(TextureData* tex)
@@ -304,15 +269,15 @@ namespace RClassic_Float
 		drawScanline_Fullbright_Trans
 	};
 
-	static f32 s_poly_offsetX;
-	static f32 s_poly_offsetZ;
+	static thread_local f32 s_poly_offsetX;
+	static thread_local f32 s_poly_offsetZ;
 
-	static f32 s_poly_scaledHOffset;
-	static f32 s_poly_sinYawHOffset;
-	static f32 s_poly_cosYawHOffset;
+	static thread_local f32 s_poly_scaledHOffset;
+	static thread_local f32 s_poly_sinYawHOffset;
+	static thread_local f32 s_poly_cosYawHOffset;
 
-	static f32 s_poly_cosYawScaledHOffset;
-	static f32 s_poly_sinYawScaledHOffset;
+	static thread_local f32 s_poly_cosYawScaledHOffset;
+	static thread_local f32 s_poly_sinYawScaledHOffset;
 		
 	void flat_preparePolygon(f32 heightOffset, f32 offsetX, f32 offsetZ, TextureData* texture)
 	{
@@ -16,8 +16,8 @@
 
 namespace TFE_Jedi
 {
-extern s32 s_drawnObjCount;
-extern SecObject* s_drawnObj[];
+extern thread_local s32 s_drawnObjCount;
+extern thread_local SecObject* s_drawnObj[];
 
 namespace RClassic_Float
 {
@@ -97,7 +97,7 @@ namespace RClassic_Float
 			const s32 pixel_y = roundFloat((vertex->y*s_rcfltState.focalLenAspect) / z + s_rcfltState.projOffsetY);
 
 			// If the X position is out of view, skip the vertex.
-			if (pixel_x < s_minScreenX_Pixels || pixel_x > s_maxScreenX_Pixels)
+			if (pixel_x < s_bandMinX_Pixels || pixel_x > s_bandMaxX_Pixels)
 			{
 				continue;
 			}
@@ -109,7 +109,7 @@ namespace RClassic_Float
 
 			for (s32 i = 0; i < area; i++)
 			{
-				const s32 x = clamp(pixel_x - halfSize + (i % size), s_minScreenX_Pixels, s_maxScreenX_Pixels);
+				const s32 x = clamp(pixel_x - halfSize + (i % size), s_bandMinX_Pixels, s_bandMaxX_Pixels);
 				const s32 y = clamp(pixel_y - halfSize + (i / size), s_windowMinY_Pixels, s_windowMaxY_Pixels);
 				s_display[y*s_width + x] = color;
 			}
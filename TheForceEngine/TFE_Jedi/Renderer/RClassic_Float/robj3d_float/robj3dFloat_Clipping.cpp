@@ -17,35 +17,35 @@ namespace RClassic_Float
 	/////////////////////////////////////////////
 	// Clipping
 	/////////////////////////////////////////////
-	static f32        s_clipIntensityBuffer[POLY_MAX_VTX_COUNT];	// a buffer to hold clipped/final intensities
-	static vec3_float s_clipPosBuffer[POLY_MAX_VTX_COUNT];			// a buffer to hold clipped/final positions
-	static vec2_float s_clipUvBuffer[POLY_MAX_VTX_COUNT];			// a buffer to hold clipped/final texture coordinates
+	static thread_local f32        s_clipIntensityBuffer[POLY_MAX_VTX_COUNT];	// a buffer to hold clipped/final intensities
+	static thread_local vec3_float s_clipPosBuffer[POLY_MAX_VTX_COUNT];			// a buffer to hold clipped/final positions
+	static thread_local vec2_float s_clipUvBuffer[POLY_MAX_VTX_COUNT];			// a buffer to hold clipped/final texture coordinates
 
-	static f32  s_clipY0;
-	static f32  s_clipY1;
-	static f32  s_clipParam0;
-	static f32  s_clipParam1;
-	static f32  s_clipIntersectY;
-	static f32  s_clipIntersectZ;
-	static vec3_float* s_clipTempPos;
-	static f32  s_clipPlanePos0;
-	static f32  s_clipPlanePos1;
-	static f32* s_clipTempIntensity;
-	static f32* s_clipIntensitySrc;
-	static f32* s_clipIntensity0;
-	static f32* s_clipIntensity1;
-	static vec2_float* s_clipTempUv;
-	static vec2_float* s_clipUvSrc;
-	static vec2_float* s_clipUv0;
-	static vec2_float* s_clipUv1;
-	static f32  s_clipParam;
-	static f32  s_clipIntersectX;
-	static vec3_float* s_clipPos0;
-	static vec3_float* s_clipPos1;
-	static vec3_float* s_clipPosSrc;
-	static vec3_float* s_clipPosOut;
-	static f32* s_clipIntensityOut;
-	static vec2_float* s_clipUvOut;
+	static thread_local f32  s_clipY0;
+	static thread_local f32  s_clipY1;
+	static thread_local f32  s_clipParam0;
+	static thread_local f32  s_clipParam1;
+	static thread_local f32  s_clipIntersectY;
+	static thread_local f32  s_clipIntersectZ;
+	static thread_local vec3_float* s_clipTempPos;
+	static thread_local f32  s_clipPlanePos0;
+	static thread_local f32  s_clipPlanePos1;
+	static thread_local f32* s_clipTempIntensity;
+	static thread_local f32* s_clipIntensitySrc;
+	static thread_local f32* s_clipIntensity0;
+	static thread_local f32* s_clipIntensity1;
+	static thread_local vec2_float* s_clipTempUv;
+	static thread_local vec2_float* s_clipUvSrc;
+	static thread_local vec2_float* s_clipUv0;
+	static thread_local vec2_float* s_clipUv1;
+	static thread_local f32  s_clipParam;
+	static thread_local f32  s_clipIntersectX;
+	static thread_local vec3_float* s_clipPos0;
+	static thread_local vec3_float* s_clipPos1;
+	static thread_local vec3_float* s_clipPosSrc;
+	static thread_local vec3_float* s_clipPosOut;
+	static thread_local f32* s_clipIntensityOut;
+	static thread_local vec2_float* s_clipUvOut;
 	
 	////////////////////////////////////////////////
 	// Instantiate Clip Routines.
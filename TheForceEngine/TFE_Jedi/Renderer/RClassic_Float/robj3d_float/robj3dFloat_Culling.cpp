@@ -19,7 +19,7 @@ namespace RClassic_Float
 	};
 
 	// List of potentially visible polygons (after backface culling).
-	std::vector<JmPolygon*> s_visPolygons;
+	thread_local std::vector<JmPolygon*> s_visPolygons;
 
 	s32 getPolygonFacing(const vec3_float* normal, const vec3_float* pos)
 	{
@@ -10,7 +10,7 @@ namespace TFE_Jedi
 {
 	namespace RClassic_Float
 	{
-		extern std::vector<JmPolygon*> s_visPolygons;
+		extern thread_local std::vector<JmPolygon*> s_visPolygons;
 		s32 robj3d_backfaceCull(JediModel* model);
 	}
 }
@@ -347,10 +347,11 @@ void robj3d_drawFlatColorPolygon(vec3_float* projVertices, s32 vertexCount, u8 c
 
 	if (FIND_NEXT_EDGE(minXIndex, xMin) != 0 || FIND_PREV_EDGE(minXIndex) != 0) { return; }
 
-	for (s32 foundEdge = 0; !foundEdge && s_columnX >= s_minScreenX_Pixels && s_columnX <= s_maxScreenX_Pixels; s_columnX++)
+	for (s32 foundEdge = 0; !foundEdge && s_columnX >= s_minScreenX_Pixels && s_columnX <= s_bandMaxX_Pixels; s_columnX++)
 	{
 		const f32 edgeMinZ = min(s_edgeBot_Z0, s_edgeTop_Z0);
-		const f32 z = s_rcfltState.depth1d[s_columnX];
+		// Columns to the left of the current band belong to another thread, only the edges are stepped.
+		const f32 z = (s_columnX >= s_bandMinX_Pixels) ? s_rcfltState.depth1d[s_columnX] : 0.0f;
 
 		// Is ave edge Z occluded by walls? Is column outside of the vertical area?
 		if (edgeMinZ < z && s_edgeTopY0_Pixel <= s_windowMaxY_Pixels && s_edgeBotY0_Pixel >= s_windowMinY_Pixels)
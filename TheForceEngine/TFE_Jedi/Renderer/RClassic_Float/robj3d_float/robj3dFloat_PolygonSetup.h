@@ -14,10 +14,10 @@ namespace TFE_Jedi
 {
 	namespace RClassic_Float
 	{
-		extern vec3_float s_polygonVerticesVS[POLY_MAX_VTX_COUNT];
-		extern vec3_float s_polygonVerticesProj[POLY_MAX_VTX_COUNT];
-		extern vec2_float s_polygonUv[POLY_MAX_VTX_COUNT];
-		extern f32 s_polygonIntensity[POLY_MAX_VTX_COUNT];
+		extern thread_local vec3_float s_polygonVerticesVS[POLY_MAX_VTX_COUNT];
+		extern thread_local vec3_float s_polygonVerticesProj[POLY_MAX_VTX_COUNT];
+		extern thread_local vec2_float s_polygonUv[POLY_MAX_VTX_COUNT];
+		extern thread_local f32 s_polygonIntensity[POLY_MAX_VTX_COUNT];
 
 		void robj3d_setupPolygon(JmPolygon* polygon);
 	}
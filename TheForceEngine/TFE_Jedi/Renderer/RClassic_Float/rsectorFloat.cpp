@@ -1,6 +1,7 @@
 #include <cstring>
 
 #include <TFE_System/profiler.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Jedi/Level/level.h>
@@ -19,15 +20,57 @@
 #include "rclassicFloatSharedState.h"
 #include "robj3d_float/robj3dFloat.h"
 #include "../rcommon.h"
+#include "../jediRenderer.h"
 
 using namespace TFE_Jedi::RClassic_Float;
 #define PTR_OFFSET(ptr, base) size_t((u8*)ptr - (u8*)base)
 
 namespace TFE_Jedi
 {
+	enum RenderBandConstants
+	{
+		MAX_RENDER_BANDS = 16,
+		MIN_RENDER_BAND_WIDTH = 64,	// Narrower bands spend more time traversing sectors than drawing.
+		SECTOR_TRANSFORM_BATCH = 64,
+	};
+
+	// A vertical band of screen columns drawn by a single thread.
+	// Bands never touch each others columns, so the shared column and depth buffers can be written without locks.
+	struct RenderBand
+	{
+		TFE_Sectors_Float* sectors;
+		s32 x0;
+		s32 x1;
+
+		// Thread local lists that would otherwise live in the shared state.
+		EdgePairFloat* flatEdgeList;
+		EdgePairFloat* adjoinEdgeList;
+		RWallSegmentFloat* wallSegListDst;
+		RWallSegmentFloat* wallSegListSrc;
+
+		// Results, merged back into the main thread once all bands are done.
+		WallFlagWrites wallFlags;
+		s32 drawnObjCount;
+		SecObject* drawnObj[MAX_DRAWN_OBJ_STORE];
+		s32 sectorCount;
+		s32 flatCount;
+		s32 wallSegCount;
+		s32 adjoinSegCount;
+		s32 maxAdjoinDepth;
+		s32 maxAdjoinIndex;
+	};
+
+	struct RenderBandJob
+	{
+		RenderBand* bands;
+		RSector* sector;
+		TFE_Sectors_Float* sectors;
+		RClassicFloatState state;	// copy of the main thread state, the camera and projection are shared by all bands.
+	};
+
 	namespace
 	{
-		static TFE_Sectors_Float* s_ctx = nullptr;
+		static thread_local TFE_Sectors_Float* s_ctx = nullptr;
 
 		s32 wallSortX(const void* r0, const void* r1)
 		{
@@ -169,6 +212,18 @@ namespace TFE_Jedi
 
 	void TFE_Sectors_Float::destroy()
 	{
+		if (!m_bands) { return; }
+		for (s32 i = 0; i < MAX_RENDER_BANDS; i++)
+		{
+			RenderBand* band = &m_bands[i];
+			delete band->sectors;
+			free(band->flatEdgeList);
+			free(band->adjoinEdgeList);
+			free(band->wallSegListDst);
+			free(band->wallSegListSrc);
+		}
+		delete[] m_bands;
+		m_bands = nullptr;
 	}
 
 	void TFE_Sectors_Float::reset()
@@ -180,6 +235,7 @@ namespace TFE_Jedi
 	void TFE_Sectors_Float::prepare()
 	{
 		allocateCachedData();
+		m_frameState.resize(m_cachedSectorCount);
 
 		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
 		s_rcfltState.flatEdge = flatEdge;
@@ -199,6 +255,207 @@ namespace TFE_Jedi
 		viewPoint->z = z*s_rcfltState.cosYaw + x*s_rcfltState.negSinYaw + s_rcfltState.cameraTrans.z;
 	}
 	
+	void TFE_Sectors_Float::transformSector(SectorCached* cached)
+	{
+		RSector* sector = cached->sector;
+		TFE_ZONE_BEGIN(secXform, "Sector Vertex Transform");
+			vec2_fixed* vtxWS = sector->verticesWS;
+			vec2_float* vtxVS = cached->verticesVS;
+			for (s32 v = 0; v < sector->vertexCount; v++)
+			{
+				const f32 x = fixed16ToFloat(vtxWS->x);
+				const f32 z = fixed16ToFloat(vtxWS->z);
+
+				vtxVS->x = x*s_rcfltState.cosYaw     + z*s_rcfltState.sinYaw + s_rcfltState.cameraTrans.x;
+				vtxVS->z = x*s_rcfltState.negSinYaw  + z*s_rcfltState.cosYaw + s_rcfltState.cameraTrans.z;
+				vtxVS++;
+				vtxWS++;
+			}
+		TFE_ZONE_END(secXform);
+
+		TFE_ZONE_BEGIN(objXform, "Sector Object Transform");
+			SecObject** obj = sector->objectList;
+			vec3_float* objPosVS = cached->objPosVS;
+			for (s32 i = sector->objectCount - 1; i >= 0; i--, obj++)
+			{
+				SecObject* curObj = *obj;
+				while (!curObj)
+				{
+					obj++;
+					curObj = *obj;
+				}
+
+				if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
+				{
+					transformPointByCameraFixedToFloat(&curObj->posWS, &objPosVS[curObj->index]);
+				}
+			}
+		TFE_ZONE_END(objXform);
+	}
+
+	void TFE_Sectors_Float::transformSectorsJob(s32 index, void* userData)
+	{
+		RenderBandJob* job = (RenderBandJob*)userData;
+		TFE_Sectors_Float* sectors = job->sectors;
+		s_rcfltState = job->state;
+
+		const s32 start = index * SECTOR_TRANSFORM_BATCH;
+		const s32 end = min(start + SECTOR_TRANSFORM_BATCH, (s32)sectors->m_cachedSectorCount);
+		for (s32 i = start; i < end; i++)
+		{
+			sectors->transformSector(&sectors->m_cachedSectors[i]);
+		}
+	}
+
+	void TFE_Sectors_Float::drawBandJob(s32 index, void* userData)
+	{
+		RenderBandJob* job = (RenderBandJob*)userData;
+		RenderBand* band = &job->bands[index];
+
+		s_rcfltState = job->state;
+		s_rcfltState.flatEdgeList   = band->flatEdgeList;
+		s_rcfltState.adjoinEdgeList = band->adjoinEdgeList;
+		s_rcfltState.wallSegListDst = band->wallSegListDst;
+		s_rcfltState.wallSegListSrc = band->wallSegListSrc;
+
+		wall_setFlagWrites(&band->wallFlags);
+		band->sectors->drawBand(job->sector, band->x0, band->x1);
+		wall_setFlagWrites(nullptr);
+
+		band->drawnObjCount = s_drawnObjCount;
+		memcpy(band->drawnObj, s_drawnObj, sizeof(SecObject*) * s_drawnObjCount);
+		band->sectorCount = s_sectorIndex;
+		band->flatCount = s_flatCount;
+		band->wallSegCount = s_curWallSeg;
+		band->adjoinSegCount = s_adjoinSegCount;
+		band->maxAdjoinDepth = s_maxAdjoinDepth;
+		band->maxAdjoinIndex = s_maxAdjoinIndex;
+	}
+
+	void TFE_Sectors_Float::drawBand(RSector* sector, s32 x0, s32 x1)
+	{
+		resetWindowState(x0, x1);
+
+		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
+		s_rcfltState.flatEdge = flatEdge;
+		flat_addEdges(x1 - x0 + 1, x0, 0, s_rcfltState.windowMaxY, 0, s_rcfltState.windowMinY);
+
+		draw(sector);
+	}
+
+	void TFE_Sectors_Float::drawBands(RSector* sector)
+	{
+		const s32 bandCount = min(min(TFE_Jobs::getWorkerCount() + 1, s_screenWidth / MIN_RENDER_BAND_WIDTH), (s32)MAX_RENDER_BANDS);
+		if (bandCount < 2)
+		{
+			draw(sector);
+			return;
+		}
+
+		if (!m_bands)
+		{
+			m_bands = new RenderBand[MAX_RENDER_BANDS]();
+		}
+
+		// Sector cache updates allocate from the level and cannot run in parallel, so they are done up front.
+		TFE_ZONE_BEGIN(secUpdateCache, "Update Sector Cache");
+		for (u32 i = 0; i < m_cachedSectorCount; i++)
+		{
+			SectorCached* cached = &m_cachedSectors[i];
+			RSector* srcSector = cached->sector;
+			if (srcSector->dirtyFlags || cached->objectCapacity < srcSector->objectCapacity)
+			{
+				updateCachedSector(cached, srcSector->dirtyFlags);
+			}
+		}
+		TFE_ZONE_END(secUpdateCache);
+
+		RenderBandJob job;
+		job.bands = m_bands;
+		job.sector = sector;
+		job.sectors = this;
+		job.state = s_rcfltState;
+
+		// Every band needs the transformed vertices of the sectors it can see, so transform them all.
+		TFE_ZONE_BEGIN(secXform, "Sector Transform");
+			TFE_Jobs::parallelFor((m_cachedSectorCount + SECTOR_TRANSFORM_BATCH - 1) / SECTOR_TRANSFORM_BATCH, transformSectorsJob, &job);
+		TFE_ZONE_END(secXform);
+
+		const s32 bandWidth = s_screenWidth / bandCount;
+		for (s32 i = 0; i < bandCount; i++)
+		{
+			RenderBand* band = &m_bands[i];
+			if (!band->sectors)
+			{
+				band->sectors = new TFE_Sectors_Float();
+				band->sectors->m_isBand = true;
+				band->flatEdgeList   = (EdgePairFloat*)malloc(sizeof(EdgePairFloat) * MAX_SEG_EXT);
+				band->adjoinEdgeList = (EdgePairFloat*)malloc(sizeof(EdgePairFloat) * MAX_ADJOIN_SEG_EXT);
+				band->wallSegListDst = (RWallSegmentFloat*)malloc(sizeof(RWallSegmentFloat) * MAX_SEG_EXT);
+				band->wallSegListSrc = (RWallSegmentFloat*)malloc(sizeof(RWallSegmentFloat) * MAX_SEG_EXT);
+			}
+			band->sectors->m_cachedSectors = m_cachedSectors;
+			band->sectors->m_cachedSectorCount = m_cachedSectorCount;
+			band->sectors->m_frameState.resize(m_cachedSectorCount);
+
+			band->x0 = s_minScreenX_Pixels + i * bandWidth;
+			band->x1 = (i == bandCount - 1) ? s_maxScreenX_Pixels : band->x0 + bandWidth - 1;
+		}
+
+		TFE_ZONE_BEGIN(secDrawBands, "Draw Bands");
+			TFE_Jobs::parallelFor(bandCount, drawBandJob, &job);
+		TFE_ZONE_END(secDrawBands);
+
+		// The calling thread draws one of the bands, so restore its state.
+		s_rcfltState = job.state;
+		resetWindowState(s_minScreenX_Pixels, s_maxScreenX_Pixels);
+
+		// Merge the band results.
+		for (s32 i = 0; i < bandCount; i++)
+		{
+			const RenderBand* band = &m_bands[i];
+			for (s32 o = 0; o < band->drawnObjCount && s_drawnObjCount < MAX_DRAWN_OBJ_STORE; o++)
+			{
+				SecObject* obj = band->drawnObj[o];
+				s32 d = 0;
+				for (; d < s_drawnObjCount; d++)
+				{
+					if (s_drawnObj[d] == obj) { break; }
+				}
+				if (d == s_drawnObjCount)
+				{
+					s_drawnObj[s_drawnObjCount++] = obj;
+				}
+			}
+
+			s_sectorIndex += band->sectorCount;
+			s_flatCount += band->flatCount;
+			s_curWallSeg += band->wallSegCount;
+			s_adjoinSegCount += band->adjoinSegCount;
+			s_maxAdjoinDepth = max(s_maxAdjoinDepth, band->maxAdjoinDepth);
+			s_maxAdjoinIndex = max(s_maxAdjoinIndex, band->maxAdjoinIndex);
+		}
+
+		WallFlagWrites* wallFlags[MAX_RENDER_BANDS];
+		for (s32 i = 0; i < bandCount; i++)
+		{
+			wallFlags[i] = &m_bands[i].wallFlags;
+		}
+		wall_applyFlagWrites(wallFlags, bandCount);
+
+		for (u32 s = 0; s < m_cachedSectorCount; s++)
+		{
+			for (s32 i = 0; i < bandCount; i++)
+			{
+				if (m_bands[i].sectors->m_frameState[s].prevDrawFrame2 == s_drawFrame)
+				{
+					m_cachedSectors[s].sector->flags1 |= SEC_FLAGS1_RENDERED;
+					break;
+				}
+			}
+		}
+	}
+
 	void TFE_Sectors_Float::draw(RSector* sector)
 	{
 		s_ctx = this;
@@ -217,8 +474,9 @@ namespace TFE_Jedi
 
 		s_rcfltState.depth1d = &s_rcfltState.depth1d_all[(s_adjoinDepth - 1) * s_width];
 
-		s32 startWall = s_curSector->startWall;
-		s32 drawWallCount = s_curSector->drawWallCnt;
+		SectorFrameState* frameState = &m_frameState[s_curSector->index];
+		s32 startWall = frameState->startWall;
+		s32 drawWallCount = frameState->drawWallCnt;
 
 		if (s_flatLighting)
 		{
@@ -237,52 +495,24 @@ namespace TFE_Jedi
 		if (s_adjoinDepth > 1)
 		{
 			depthPrev = &s_rcfltState.depth1d_all[(s_adjoinDepth - 2) * s_width];
-			memcpy(&s_rcfltState.depth1d[s_minScreenX_Pixels], &depthPrev[s_minScreenX_Pixels], s_width * 4);
+			memcpy(&s_rcfltState.depth1d[s_bandMinX_Pixels], &depthPrev[s_bandMinX_Pixels], (s_bandMaxX_Pixels - s_bandMinX_Pixels + 1) * sizeof(f32));
 		}
 
 		s_wallMaxCeilY  = s_windowMinY_Pixels;
 		s_wallMinFloorY = s_windowMaxY_Pixels;
 		SectorCached* cachedSector = &m_cachedSectors[s_curSector->index];
 
-		if (s_drawFrame != s_curSector->prevDrawFrame)
+		if (s_drawFrame != frameState->prevDrawFrame)
 		{
-			TFE_ZONE_BEGIN(secUpdateCache, "Update Sector Cache");
-				updateCachedSector(cachedSector, s_curSector->dirtyFlags);
-			TFE_ZONE_END(secUpdateCache);
-
-			TFE_ZONE_BEGIN(secXform, "Sector Vertex Transform");
-				vec2_fixed* vtxWS = s_curSector->verticesWS;
-				vec2_float* vtxVS = cachedSector->verticesVS;
-				for (s32 v = 0; v < s_curSector->vertexCount; v++)
-				{
-					const f32 x = fixed16ToFloat(vtxWS->x);
-					const f32 z = fixed16ToFloat(vtxWS->z);
-
-					vtxVS->x = x*s_rcfltState.cosYaw     + z*s_rcfltState.sinYaw + s_rcfltState.cameraTrans.x;
-					vtxVS->z = x*s_rcfltState.negSinYaw  + z*s_rcfltState.cosYaw + s_rcfltState.cameraTrans.z;
-					vtxVS++;
-					vtxWS++;
-				}
-			TFE_ZONE_END(secXform);
-
-			TFE_ZONE_BEGIN(objXform, "Sector Object Transform");
-				SecObject** obj = s_curSector->objectList;
-				vec3_float* objPosVS = cachedSector->objPosVS;
-				for (s32 i = s_curSector->objectCount - 1; i >= 0; i--, obj++)
-				{
-					SecObject* curObj = *obj;
-					while (!curObj)
-					{
-						obj++;
-						curObj = *obj;
-					}
+			// Bands share the cached sectors, which have already been updated and transformed for this frame.
+			if (!m_isBand)
+			{
+				TFE_ZONE_BEGIN(secUpdateCache, "Update Sector Cache");
+					updateCachedSector(cachedSector, s_curSector->dirtyFlags);
+				TFE_ZONE_END(secUpdateCache);
 
-					if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
-					{
-						transformPointByCameraFixedToFloat(&curObj->posWS, &objPosVS[curObj->index]);
-					}
-				}
-			TFE_ZONE_END(objXform);
+				transformSector(cachedSector);
+			}
 
 			TFE_ZONE_BEGIN(wallProcess, "Sector Wall Process");
 				startWall = s_nextWall;
@@ -293,9 +523,9 @@ namespace TFE_Jedi
 				}
 				drawWallCount = s_nextWall - startWall;
 
-				s_curSector->startWall = startWall;
-				s_curSector->drawWallCnt = drawWallCount;
-				s_curSector->prevDrawFrame = s_drawFrame;
+				frameState->startWall = startWall;
+				frameState->drawWallCnt = drawWallCount;
+				frameState->prevDrawFrame = s_drawFrame;
 			TFE_ZONE_END(wallProcess);
 		}
 
@@ -457,7 +687,7 @@ namespace TFE_Jedi
 						s_maxAdjoinDepth = s_adjoinDepth;
 					}
 
-					srcWall->drawFrame = s_drawFrame;
+					wall_pushAdjoinPath(srcWall);
 					s_windowTop = winTopNext;
 					s_windowBot = winBotNext;
 					if (prevAdjoinSeg != 0)
@@ -484,7 +714,7 @@ namespace TFE_Jedi
 						s_adjoinDepth--;
 						restoreValues(index);
 					}
-					srcWall->drawFrame = 0;
+					wall_popAdjoinPath();
 					if (srcWall->flags1 & WF1_ADJ_MID_TEX)
 					{
 						TFE_ZONE("Draw Transparent Walls");
@@ -494,7 +724,7 @@ namespace TFE_Jedi
 			}
 		}
 
-		if (!(s_curSector->flags1 & SEC_FLAGS1_SUBSECTOR) && depthPrev && s_drawFrame != s_prevSector->prevDrawFrame2)
+		if (!(s_curSector->flags1 & SEC_FLAGS1_SUBSECTOR) && depthPrev && s_drawFrame != m_frameState[s_prevSector->index].prevDrawFrame2)
 		{
 			memcpy(&depthPrev[s_windowMinX_Pixels], &s_rcfltState.depth1d[s_windowMinX_Pixels], (s_windowMaxX_Pixels - s_windowMinX_Pixels + 1) * sizeof(f32));
 		}
@@ -557,8 +787,12 @@ namespace TFE_Jedi
 		}
 		TFE_ZONE_END(secDrawObjects);
 
-		s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
-		s_curSector->prevDrawFrame2 = s_drawFrame;
+		// Bands report the sectors they have drawn once they are all done.
+		if (!m_isBand)
+		{
+			s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+		}
+		frameState->prevDrawFrame2 = s_drawFrame;
 	}
 		
 	void TFE_Sectors_Float::adjoin_setupAdjoinWindow(s32* winBot, s32* winBotNext, s32* winTop, s32* winTopNext, EdgePairFloat* adjoinEdges, s32 adjoinCount)
@@ -567,8 +801,9 @@ namespace TFE_Jedi
 
 		// Note: This is pretty inefficient, especially at higher resolutions.
 		// The column loops below can be adjusted to do the copy only in the required ranges.
-		memcpy(&winTopNext[s_minScreenX_Pixels], &winTop[s_minScreenX_Pixels], s_width * 4);
-		memcpy(&winBotNext[s_minScreenX_Pixels], &winBot[s_minScreenX_Pixels], s_width * 4);
+		const size_t bandSize = (s_bandMaxX_Pixels - s_bandMinX_Pixels + 1) * sizeof(s32);
+		memcpy(&winTopNext[s_bandMinX_Pixels], &winTop[s_bandMinX_Pixels], bandSize);
+		memcpy(&winBotNext[s_bandMinX_Pixels], &winBot[s_bandMinX_Pixels], bandSize);
 
 		// Loop through each adjoin and setup the column range based on the edge pair and the parent
 		// column range.
@@ -9,6 +9,7 @@
 #include "rwallFloat.h"
 #include "rflatFloat.h"
 #include "../rsectorRender.h"
+#include <vector>
 
 struct RWall;
 struct SecObject;
@@ -32,6 +33,17 @@ namespace TFE_Jedi
 		vec2_float ceilOffset;
 	};
 
+	// Per-frame traversal state of a sector, each render band keeps its own copy.
+	struct SectorFrameState
+	{
+		s32 startWall;			// first processed wall segment.
+		s32 drawWallCnt;		// processed wall segment count.
+		s32 prevDrawFrame;		// frame that the walls were processed.
+		s32 prevDrawFrame2;		// frame that the sector was drawn.
+	};
+
+	struct RenderBand;
+
 	class TFE_Sectors_Float : public TFE_Sectors
 	{
 	public:
@@ -44,7 +56,16 @@ namespace TFE_Jedi
 		void draw(RSector* sector) override;
 		void subrendererChanged() override;
 
+		// Split the view into vertical bands of columns and draw them in parallel.
+		// Falls back to draw() if there are not enough threads or columns to split the work.
+		void drawBands(RSector* sector);
+
 	private:
+		void drawBand(RSector* sector, s32 x0, s32 x1);
+		void transformSector(SectorCached* cached);
+		static void transformSectorsJob(s32 index, void* userData);
+		static void drawBandJob(s32 index, void* userData);
+
 		void saveValues(s32 index);
 		void restoreValues(s32 index);
 		void adjoin_computeWindowBounds(EdgePairFloat* adjoinEdges);
@@ -58,5 +79,11 @@ namespace TFE_Jedi
 	public:
 		SectorCached* m_cachedSectors = nullptr;
 		u32 m_cachedSectorCount = 0;
+
+	private:
+		std::vector<SectorFrameState> m_frameState;
+		// Band renderers share the cached sectors of the main renderer, which are updated before the bands start.
+		bool m_isBand = false;
+		RenderBand* m_bands = nullptr;
 	};
 }  // TFE_Jedi
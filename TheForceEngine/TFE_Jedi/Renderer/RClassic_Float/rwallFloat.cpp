@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstring>
 
 #include <TFE_System/profiler.h>
@@ -13,6 +14,7 @@
 #include "redgePairFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "../rcommon.h"
+#include "../rdrawKernels.h"
 #include "../jediRenderer.h"
 
 namespace TFE_Jedi
@@ -28,15 +30,18 @@ namespace RClassic_Float
 		BACK = 0,
 	};
 
-	static f32 s_segmentCross;
-	static s32 s_texHeightMask;
-	static s32 s_yPixelCount;
-	static fixed44_20 s_vCoordStep;
-	static fixed44_20 s_vCoordFixed;
-	static const u8* s_columnLight;
-	static u8* s_texImage;
-	static u8* s_columnOut;
-	static u8  s_workBuffer[WAX_DECOMPRESS_SIZE];
+	static thread_local f32 s_segmentCross;
+	static thread_local s32 s_texHeightMask;
+	static thread_local s32 s_yPixelCount;
+	static thread_local fixed44_20 s_vCoordStep;
+	static thread_local fixed44_20 s_vCoordFixed;
+	static thread_local const u8* s_columnLight;
+	static thread_local u8* s_texImage;
+	static thread_local u8* s_columnOut;
+	static thread_local u8  s_workBuffer[WAX_DECOMPRESS_SIZE];
+	static thread_local RWall* s_adjoinPath[MAX_ADJOIN_DEPTH_EXT];
+	static thread_local s32 s_adjoinPathCount = 0;
+	static thread_local WallFlagWrites* s_wallFlagWrites = nullptr;
 
 	s32 segmentCrossesLine(f32 ax0, f32 ay0, f32 ax1, f32 ay1, f32 bx0, f32 by0, f32 bx1, f32 by1);
 	f32 solveForZ_Numerator(RWallSegmentFloat* wallSegment);
@@ -299,13 +304,13 @@ namespace RClassic_Float
 		// Cull the wall if it is completely beyind the camera.
 		if (z0 < 0.0f && z1 < 0.0f)
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 		// Cull the wall if it is completely outside the view
 		if ((x0 < left0 && x1 < left1) || (x0 > right0 && x1 > right1))
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 
@@ -316,7 +321,7 @@ namespace RClassic_Float
 		const f32 side = (z0 * dx) - (x0 * dz);
 		if (side < 0.0f)
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 
@@ -335,7 +340,7 @@ namespace RClassic_Float
 		//////////////////////////////////////////////
 		if (!wall_clipToFrustum(x0, z0, x1, z1, dx, dz, curU, texelLen, texelLenRem, clipX0_Near, clipX1_Near, left0, right0, left1, right1))
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 		
@@ -363,19 +368,19 @@ namespace RClassic_Float
 		// The wall is backfacing if x0 > x1
 		if (x0pixel > x1pixel)
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 		// The wall is completely outside of the screen.
 		if (x0pixel > s_maxScreenX_Pixels || x1pixel < s_minScreenX_Pixels)
 		{
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 		if (s_nextWall == s_maxSegCount)
 		{
 			TFE_System::logWrite(LOG_ERROR, "ClassicRenderer", "Wall_Process : Maximum processed walls exceeded!");
-			wall->visible = 0;
+			wall_setVisible(wall, 0);
 			return;
 		}
 	
@@ -419,7 +424,92 @@ namespace RClassic_Float
 		wallSeg->slope = slope;
 		wallSeg->uScale = texelLenRem / den;
 		wallSeg->orient = orient;
-		wall->visible = 1;
+		wall_setVisible(wall, 1);
+	}
+
+	void wall_setVisible(RWall* wall, s32 visible)
+	{
+		if (s_wallFlagWrites)
+		{
+			s_wallFlagWrites->visible.push_back({ wall, visible });
+		}
+		else
+		{
+			wall->visible = visible;
+		}
+	}
+
+	void wall_setSeen(RWall* wall)
+	{
+		if (s_wallFlagWrites)
+		{
+			s_wallFlagWrites->seen.push_back(wall);
+		}
+		else
+		{
+			wall->seen = JTRUE;
+		}
+	}
+
+	void wall_setFlagWrites(WallFlagWrites* writes)
+	{
+		s_wallFlagWrites = writes;
+	}
+
+	// Within a band the last write to a wall wins, as it does when drawing the whole view.
+	// Across bands a wall is visible if it is visible in any of them.
+	void wall_applyFlagWrites(WallFlagWrites** writes, s32 count)
+	{
+		for (s32 b = 0; b < count; b++)
+		{
+			const std::vector<WallVisibleWrite>& visible = writes[b]->visible;
+			for (size_t i = 0; i < visible.size(); i++)
+			{
+				visible[i].wall->visible = 0;
+			}
+		}
+		for (s32 b = 0; b < count; b++)
+		{
+			std::vector<WallVisibleWrite>& visible = writes[b]->visible;
+			std::stable_sort(visible.begin(), visible.end(), [](const WallVisibleWrite& a, const WallVisibleWrite& b) { return a.wall < b.wall; });
+			for (size_t i = 0; i < visible.size(); i++)
+			{
+				if (i + 1 == visible.size() || visible[i + 1].wall != visible[i].wall)
+				{
+					visible[i].wall->visible |= visible[i].visible;
+				}
+			}
+			visible.clear();
+
+			std::vector<RWall*>& seen = writes[b]->seen;
+			for (size_t i = 0; i < seen.size(); i++)
+			{
+				seen[i]->seen = JTRUE;
+			}
+			seen.clear();
+		}
+	}
+
+	void wall_pushAdjoinPath(RWall* wall)
+	{
+		assert(s_adjoinPathCount < MAX_ADJOIN_DEPTH_EXT);
+		s_adjoinPath[s_adjoinPathCount++] = wall;
+	}
+
+	void wall_popAdjoinPath()
+	{
+		assert(s_adjoinPathCount > 0);
+		s_adjoinPathCount--;
+	}
+
+	JBool wall_isOnAdjoinPath(const RWall* wall)
+	{
+		if (!wall->nextSector) { return JFALSE; }
+		for (s32 i = s_adjoinPathCount - 1; i >= 0; i--)
+		{
+			if (s_adjoinPath[i] == wall) { return JTRUE; }
+		}
+		return JFALSE;
 	}
 
 	s32 wall_mergeSort(RWallSegmentFloat* segOutList, s32 availSpace, s32 start, s32 count)
@@ -444,7 +534,7 @@ namespace RClassic_Float
 		while (1)
 		{
 			WallCached* srcWall = srcSeg->srcWall;
-			JBool processed = (s_drawFrame == srcWall->wall->drawFrame) ? JTRUE : JFALSE;
+			JBool processed = wall_isOnAdjoinPath(srcWall->wall);
 			JBool insideWindow = ((srcSeg->z0 >= s_rcfltState.windowMinZ || srcSeg->z1 >= s_rcfltState.windowMinZ) && srcSeg->wallX0 <= s_windowMaxX_Pixels && srcSeg->wallX1 >= s_windowMinX_Pixels) ? JTRUE : JFALSE;
 			if (!processed && insideWindow)
 			{
@@ -784,7 +874,7 @@ namespace RClassic_Float
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			return;
 		}
 
@@ -905,7 +995,7 @@ namespace RClassic_Float
 			y0F += dYdXbot;
 		}
 
-		srcWall->seen = JTRUE;
+		wall_setSeen(srcWall);
 	}
 
 	void wall_drawTransparent(RWallSegmentFloat* wallSegment, EdgePairFloat* edge)
@@ -1017,8 +1107,8 @@ namespace RClassic_Float
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 
-			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_setVisible(srcWall, 0);
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1048,8 +1138,8 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, numerator);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->visible = 0;
-			srcWall->seen = JTRUE;
+			wall_setVisible(srcWall, 0);
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1097,7 +1187,7 @@ namespace RClassic_Float
 			}
 		}
 
-		srcWall->seen = JTRUE;
+		wall_setSeen(srcWall);
 	}
 
 	void wall_drawBottom(RWallSegmentFloat* wallSegment)
@@ -1131,7 +1221,7 @@ namespace RClassic_Float
 		s32 cy1 = roundFloat(cProj1);
 		if (cy0 > s_windowMaxY_Pixels && cy1 >= s_windowMaxY_Pixels)
 		{
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			s32 x = wallSegment->wallX0;
 			s32 length = wallSegment->wallX1 - x + 1;
 
@@ -1143,7 +1233,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1156,7 +1246,7 @@ namespace RClassic_Float
 		if (fy0 < s_windowMinY_Pixels && fy1 < s_windowMinY_Pixels)
 		{
 			// Wall is above the top of the screen.
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			s32 x = wallSegment->wallX0;
 			s32 length = wallSegment->wallX1 - x + 1;
 
@@ -1168,7 +1258,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1222,7 +1312,7 @@ namespace RClassic_Float
 				s_columnBot[x] = bot;
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1333,7 +1423,7 @@ namespace RClassic_Float
 				yC += ceil_dYdX;
 			}
 		}
-		srcWall->seen = JTRUE;
+		wall_setSeen(srcWall);
 	}
 
 	void wall_drawTop(RWallSegmentFloat* wallSegment)
@@ -1365,7 +1455,7 @@ namespace RClassic_Float
 
 		if (yC0_pixel > s_windowMaxY_Pixels && yC1_pixel > s_windowMaxY_Pixels)
 		{
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			for (s32 i = 0; i < lengthInPixels; i++) { s_columnTop[x0 + i] = s_windowMaxY_Pixels; }
 			flat_addEdges(lengthInPixels, x0, 0, f32(s_windowMaxY_Pixels + 1), 0, f32(s_windowMaxY_Pixels + 1));
 			for (s32 i = 0, x = x0; i < lengthInPixels; i++, x++)
@@ -1373,7 +1463,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1393,7 +1483,7 @@ namespace RClassic_Float
 		s32 yF1_pixel = roundFloat(yF1);
 		if (yF0_pixel < s_windowMinY_Pixels && yF1_pixel < s_windowMinY_Pixels)
 		{
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			for (s32 i = 0; i < lengthInPixels; i++) { s_columnBot[x0 + i] = s_windowMinY_Pixels; }
 			flat_addEdges(lengthInPixels, x0, 0, f32(s_windowMinY_Pixels - 1), 0, f32(s_windowMinY_Pixels - 1));
 			for (s32 i = 0, x = x0; i < lengthInPixels; i++, x++)
@@ -1401,7 +1491,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1450,7 +1540,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				yF0 += floor_dYdX;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1552,7 +1642,7 @@ namespace RClassic_Float
 			yF0 += floor_dYdX;
 		}
 		
-		srcWall->seen = JTRUE;
+		wall_setSeen(srcWall);
 	}
 
 	void wall_drawTopAndBottom(RWallSegmentFloat* wallSegment)
@@ -1580,7 +1670,7 @@ namespace RClassic_Float
 
 		if (c0_pixel > s_windowMaxY_Pixels && c1_pixel > s_windowMaxY_Pixels)
 		{
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			for (s32 i = 0; i < length; i++) { s_columnTop[x0 + i] = s_windowMaxY_Pixels; }
 
 			flat_addEdges(length, x0, 0, f32(s_windowMaxY_Pixels + 1), 0, f32(s_windowMaxY_Pixels + 1));
@@ -1590,7 +1680,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1602,7 +1692,7 @@ namespace RClassic_Float
 		s32 f1_pixel = roundFloat(fProj1);
 		if (f0_pixel < s_windowMinY_Pixels && f1_pixel < s_windowMinY_Pixels)
 		{
-			srcWall->visible = 0;
+			wall_setVisible(srcWall, 0);
 			for (s32 i = 0; i < length; i++) { s_columnBot[x0 + i] = s_windowMinY_Pixels; }
 
 			flat_addEdges(length, x0, 0, f32(s_windowMinY_Pixels - 1), 0, f32(s_windowMinY_Pixels - 1));
@@ -1613,7 +1703,7 @@ namespace RClassic_Float
 				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
@@ -1853,12 +1943,12 @@ namespace RClassic_Float
 		s32 next_c1_pixel = roundFloat(next_cProj1);
 		if ((next_f0_pixel <= s_windowMinY_Pixels && next_f1_pixel <= s_windowMinY_Pixels) || (next_c0_pixel >= s_windowMaxY_Pixels && next_c1_pixel >= s_windowMaxY_Pixels) || (nextSector->floorHeight <= nextSector->ceilingHeight))
 		{
-			srcWall->seen = JTRUE;
+			wall_setSeen(srcWall);
 			return;
 		}
 
 		wall_addAdjoinSegment(length, x0, next_floor_dYdX, next_fProj0 - 1.0f, next_ceil_dYdX, next_cProj0 + 1.0f, wallSegment);
-		srcWall->seen = JTRUE;
+		wall_setSeen(srcWall);
 	}
 
 	// Parts of the code inside 's_height == SKY_BASE_HEIGHT' are based on the original DOS exe.
@@ -2142,6 +2232,13 @@ namespace RClassic_Float
 
 	void drawColumn_Fullbright()
 	{
+		// Use the SIMD kernels unless the texture is too tall for 32 bit texture coordinates, see rdrawKernels.h
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_20))
+		{
+			s_drawColumnKernel[DK_FULLBRIGHT](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_20, nullptr);
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2156,6 +2253,12 @@ namespace RClassic_Float
 
 	void drawColumn_Lit()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_20))
+		{
+			s_drawColumnKernel[DK_LIT](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_20, s_columnLight);
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2170,6 +2273,12 @@ namespace RClassic_Float
 
 	void drawColumn_Fullbright_Trans()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_20))
+		{
+			s_drawColumnKernel[DK_FULLBRIGHT_TRANS](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_20, nullptr);
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2185,6 +2294,12 @@ namespace RClassic_Float
 
 	void drawColumn_Lit_Trans()
 	{
+		if (drawKernel_columnFits(s_texHeightMask, FRAC_BITS_20))
+		{
+			s_drawColumnKernel[DK_LIT_TRANS](s_columnOut, s_width, s_yPixelCount, s_texImage, s_texHeightMask, u32(s_vCoordFixed), u32(s_vCoordStep), FRAC_BITS_20, s_columnLight);
+			return;
+		}
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -11,6 +11,7 @@
 #include "../rlimits.h"
 #include "../rwallRender.h"
 #include "../rwallSegment.h"
+#include <vector>
 
 struct RSector;
 
@@ -45,6 +46,20 @@ namespace TFE_Jedi
 		f32 length;
 	};
 
+	struct WallVisibleWrite
+	{
+		RWall* wall;
+		s32 visible;
+	};
+
+	// Writes to RWall::visible and RWall::seen made while drawing a render band.
+	// The bands share the walls, so the writes are applied on the main thread once all of them are done.
+	struct WallFlagWrites
+	{
+		std::vector<WallVisibleWrite> visible;
+		std::vector<RWall*> seen;
+	};
+
 	namespace RClassic_Float
 	{
 		void wall_process(WallCached* wallCached);
@@ -64,6 +79,18 @@ namespace TFE_Jedi
 
 		void wall_addAdjoinSegment(s32 length, s32 x0, f32 top_dydx, f32 y1, f32 bot_dydx, f32 y0, RWallSegmentFloat* wallSegment);
 
+		// Adjoins on the current traversal path, these are skipped when merging the walls of the sectors behind them.
+		// This is tracked per-thread instead of marking the walls so that several threads can traverse the same sectors.
+		void wall_pushAdjoinPath(RWall* wall);
+		void wall_popAdjoinPath();
+
+		// Set the wall flags, or record the writes if the current thread is drawing a render band.
+		void wall_setVisible(RWall* wall, s32 visible);
+		void wall_setSeen(RWall* wall);
+		// Record the wall flag writes of the current thread in 'writes', null writes them directly.
+		void wall_setFlagWrites(WallFlagWrites* writes);
+		void wall_applyFlagWrites(WallFlagWrites** writes, s32 count);
+
 		// Sprite code for now because so much is shared.
 		void sprite_drawFrame(u8* basePtr, WaxFrame* frame, SecObject* obj, vec3_float* cachedPosVS);
 	}
@@ -35,8 +35,8 @@ using namespace TFE_RenderBackend;
 
 namespace TFE_Jedi
 {
-	extern s32 s_drawnObjCount;
-	extern SecObject* s_drawnObj[];
+	extern thread_local s32 s_drawnObjCount;
+	extern thread_local SecObject* s_drawnObj[];
 	extern u32 s_textureSettings;
 
 	enum ModelShader
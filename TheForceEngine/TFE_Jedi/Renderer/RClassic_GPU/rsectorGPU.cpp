@@ -1,4 +1,5 @@
 #include <cstring>
+#include <algorithm>
 
 #include <TFE_System/profiler.h>
 #include <TFE_System/math.h>
@@ -58,6 +59,12 @@ namespace TFE_Jedi
 		UPLOAD_WALLS    = FLAG_BIT(2),
 		UPLOAD_ALL      = UPLOAD_SECTORS | UPLOAD_VERTICES | UPLOAD_WALLS
 	};
+
+	enum
+	{
+		// Dirty ranges closer than this (in Vec4f elements) are uploaded together.
+		UPLOAD_RANGE_MERGE_GAP = 16,
+	};
 	enum Constants
 	{
 		SPRITE_PASS = SECTOR_PASS_COUNT
@@ -123,6 +130,17 @@ namespace TFE_Jedi
 	static s32 s_portalListCount = 0;
 	static s32 s_rangeCount;
 
+	// Modified ranges of the GPU source data, in Vec4f elements, uploaded at the end of the frame.
+	struct DirtyRange
+	{
+		u32 start;
+		u32 end;
+	};
+	static std::vector<DirtyRange> s_dirtySectorRanges;
+	static std::vector<DirtyRange> s_dirtyWallRanges;
+	static s32 s_gpuUploadBytes = 0;
+	static s32 s_gpuUploadCount = 0;
+
 	static Portal* s_portalList = nullptr;
 	static Vec2f  s_range[2];
 	static Vec2f  s_rangeSrc[2];
@@ -239,6 +257,8 @@ namespace TFE_Jedi
 		s_indexBuffer.destroy();
 		s_sectorGpuBuffer.destroy();
 		s_wallGpuBuffer.destroy();
+		s_dirtySectorRanges.clear();
+		s_dirtyWallRanges.clear();
 		TFE_RenderBackend::freeTexture(s_colormapTex);
 		TFE_RenderBackend::freeTexture(s_trueColorMapping);
 
@@ -811,6 +831,8 @@ namespace TFE_Jedi
 		if (!m_gpuInit)
 		{
 			TFE_COUNTER(s_wallSegGenerated, "Wall Segments");
+			TFE_COUNTER(s_gpuUploadBytes, "GPU Buffer Upload Bytes");
+			TFE_COUNTER(s_gpuUploadCount, "GPU Buffer Uploads");
 			
 			m_gpuInit = true;
 			s_gpuFrame = 1;
@@ -968,6 +990,9 @@ namespace TFE_Jedi
 				s_sectorGpuBuffer.update(s_gpuSourceData.sectors, s_gpuSourceData.sectorSize);
 				s_wallGpuBuffer.update(s_gpuSourceData.walls, s_gpuSourceData.wallSize);
 			}
+			// Everything was just uploaded.
+			s_dirtySectorRanges.clear();
+			s_dirtyWallRanges.clear();
 			m_prevSectorCount = s_levelState.sectorCount;
 			m_prevWallCount = wallCount;
 
@@ -1022,16 +1047,58 @@ namespace TFE_Jedi
 		renderDebug_enable(s_enableDebug);
 	}
 	
-	void updateCachedWalls(RSector* srcSector, u32 flags, u32& uploadFlags)
+	void addDirtyRange(std::vector<DirtyRange>& ranges, u32 start, u32 end)
 	{
-		GPUCachedSector* cached = &s_cachedSectors[srcSector->index];
-		if (flags & (SDF_HEIGHTS | SDF_AMBIENT))
+		// Sectors are usually updated in order, so try extending the last range first.
+		if (!ranges.empty() && start <= ranges.back().end && end >= ranges.back().start)
 		{
-			uploadFlags |= UPLOAD_WALLS;
+			ranges.back().start = min(ranges.back().start, start);
+			ranges.back().end = max(ranges.back().end, end);
+			return;
 		}
+		ranges.push_back({ start, end });
+	}
+
+	// Coalesce the dirty ranges and upload them with as few updates as possible.
+	void uploadDirtyRanges(ShaderBuffer& buffer, const Vec4f* srcData, std::vector<DirtyRange>& ranges)
+	{
+		if (ranges.empty()) { return; }
+
+		std::sort(ranges.begin(), ranges.end(), [](const DirtyRange& a, const DirtyRange& b) { return a.start < b.start; });
+		const size_t count = ranges.size();
+		size_t outCount = 0;
+		for (size_t i = 1; i < count; i++)
+		{
+			if (ranges[i].start <= ranges[outCount].end + UPLOAD_RANGE_MERGE_GAP)
+			{
+				ranges[outCount].end = max(ranges[outCount].end, ranges[i].end);
+			}
+			else
+			{
+				ranges[++outCount] = ranges[i];
+			}
+		}
+		outCount++;
+
+		for (size_t i = 0; i < outCount; i++)
+		{
+			const size_t offset = ranges[i].start * sizeof(Vec4f);
+			const size_t size = (ranges[i].end - ranges[i].start) * sizeof(Vec4f);
+			buffer.updateRange(&srcData[ranges[i].start], offset, size);
+			s_gpuUploadBytes += (s32)size;
+			s_gpuUploadCount++;
+		}
+		ranges.clear();
+	}
+
+	void updateCachedWalls(RSector* srcSector, u32 flags, u32& uploadFlags)
+	{
+		GPUCachedSector* cached = &s_cachedSectors[srcSector->index];
+		// Note: height and ambient changes only affect the sector data, the wall data is unchanged.
 		if (flags & (SDF_VERTICES | SDF_WALL_CHANGE | SDF_WALL_OFFSETS | SDF_WALL_SHAPE))
 		{
 			uploadFlags |= UPLOAD_WALLS;
+			addDirtyRange(s_dirtyWallRanges, cached->wallStart * 3, (cached->wallStart + srcSector->wallCount) * 3);
 			Vec4f* wallData = &s_gpuSourceData.walls[cached->wallStart*3];
 			const RWall* srcWall = srcSector->walls;
 			for (s32 w = 0; w < srcSector->wallCount; w++, wallData+=3, srcWall++)
@@ -1094,6 +1161,7 @@ namespace TFE_Jedi
 			s_gpuSourceData.sectors[srcSector->index*2+1].w = fixed16ToFloat(srcSector->ceilOffset.z);
 
 			uploadFlags |= UPLOAD_SECTORS;
+			addDirtyRange(s_dirtySectorRanges, srcSector->index * 2, srcSector->index * 2 + 2);
 		}
 		updateCachedWalls(srcSector, flags, uploadFlags);
 		srcSector->dirtyFlags = SDF_NONE;
@@ -1745,6 +1813,8 @@ namespace TFE_Jedi
 		s_portalsTraversed = 0;
 		s_portalListCount = 0;
 		s_wallSegGenerated = 0;
+		s_gpuUploadBytes = 0;
+		s_gpuUploadCount = 0;
 		Vec2f startView[] = { {0,0}, {0,0} };
 
 		// Compute an XZ direction for sprite culling.
@@ -1796,11 +1866,11 @@ namespace TFE_Jedi
 
 		if (uploadFlags & UPLOAD_SECTORS)
 		{
-			s_sectorGpuBuffer.update(s_gpuSourceData.sectors, s_gpuSourceData.sectorSize);
+			uploadDirtyRanges(s_sectorGpuBuffer, s_gpuSourceData.sectors, s_dirtySectorRanges);
 		}
 		if (uploadFlags & UPLOAD_WALLS)
 		{
-			s_wallGpuBuffer.update(s_gpuSourceData.walls, s_gpuSourceData.wallSize);
+			uploadDirtyRanges(s_wallGpuBuffer, s_gpuSourceData.walls, s_dirtyWallRanges);
 		}
 
 		return sdisplayList_getSize() > 0;
@@ -3,6 +3,7 @@
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/level.h>
 #include "rcommon.h"
+#include "rdrawKernels.h"
 #include "rsectorRender.h"
 #include "screenDraw.h"
 #include "RClassic_Fixed/rclassicFixedSharedState.h"
@@ -35,6 +36,7 @@ namespace TFE_Jedi
 	static Vec3f s_lumMask = { 0 };
 	static Vec3f s_palFx = { 0 };
 	static u32 s_sourcePalette[256];
+	static JBool s_worldDrawEnabled = JTRUE;
 	bool s_showWireframe = false;
 	TFE_Sectors* s_sectorRenderer = nullptr;
 	RendererType s_rendererType = RENDERER_SOFTWARE;
@@ -45,6 +47,8 @@ namespace TFE_Jedi
 	void clear1dDepth();
 	void console_setSubRenderer(const std::vector<std::string>& args);
 	void console_getSubRenderer(const std::vector<std::string>& args);
+	void console_setDrawKernels(const std::vector<std::string>& args);
+	void console_getDrawKernels(const std::vector<std::string>& args);
 
 	/////////////////////////////////////////////
 	// Implementation
@@ -120,6 +124,11 @@ namespace TFE_Jedi
 		// Remove temporarily until they do something useful again.
 		CCMD("rsetSubRenderer", console_setSubRenderer, 1, "Set the sub-renderer - valid values are: Classic_Fixed, Classic_Float, Classic_GPU.");
 		CCMD("rgetSubRenderer", console_getSubRenderer, 0, "Get the current sub-renderer.");
+		CCMD("rsetDrawKernels", console_setDrawKernels, 1, "Set the software column/span kernels - valid values are: Scalar, SSE2, AVX2, NEON.");
+		CCMD("rgetDrawKernels", console_getDrawKernels, 0, "Get the current software column/span kernels.");
+
+		// Pick the software column/span kernels for this CPU.
+		drawKernels_init();
 
 		// Setup performance counters.
 		TFE_COUNTER(s_maxAdjoinDepth, "Maximum Adjoin Depth");
@@ -234,6 +243,29 @@ namespace TFE_Jedi
 		TFE_Console::addToHistory(c_subRenderers[s_subRenderer]);
 	}
 
+	void console_setDrawKernels(const std::vector<std::string>& args)
+	{
+		if (args.size() < 2) { return; }
+		const char* value = args[1].c_str();
+
+		for (s32 i = 0; i < DKISA_COUNT; i++)
+		{
+			if (strcasecmp(value, drawKernels_getIsaName(DrawKernelIsa(i))) == 0)
+			{
+				if (!drawKernels_setIsa(DrawKernelIsa(i)))
+				{
+					TFE_Console::addToHistory("Draw kernels not supported on this CPU.");
+				}
+				return;
+			}
+		}
+	}
+
+	void console_getDrawKernels(const std::vector<std::string>& args)
+	{
+		TFE_Console::addToHistory(drawKernels_getIsaName(drawKernels_getIsa()));
+	}
+
 	static s32 s_fov = -1;
 	static bool s_clearCachedTextures = false;
 
@@ -492,8 +524,15 @@ namespace TFE_Jedi
 		}
 	}
 
+	void renderer_setWorldDrawEnabled(JBool enable)
+	{
+		s_worldDrawEnabled = enable;
+	}
+
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp)
 	{
+		if (!s_worldDrawEnabled) { return; }
+
 		// Clear the top pixel row.
 		if (s_subRenderer != TSR_CLASSIC_GPU)
 		{
@@ -523,25 +562,7 @@ namespace TFE_Jedi
 			clear1dDepth();
 		}
 
-		s_windowMinX_Pixels = s_minScreenX_Pixels;
-		s_windowMaxX_Pixels = s_maxScreenX_Pixels;
-		s_windowMinY_Pixels = 1;
-		s_windowMaxY_Pixels = s_height - 1;
-		s_windowMaxCeil  = s_minScreenY;
-		s_windowMinFloor = s_maxScreenY;
-		s_flatCount  = 0;
-		s_nextWall   = 0;
-		s_curWallSeg = 0;
-		s_drawnObjCount = 0;
-
-		s_prevSector = nullptr;
-		s_sectorIndex = 0;
-		s_maxAdjoinIndex = 0;
-		s_adjoinSegCount = 1;
-		s_adjoinIndex = 0;
-
-		s_adjoinDepth = 1;
-		s_maxAdjoinDepth = 1;
+		resetWindowState(s_minScreenX_Pixels, s_maxScreenX_Pixels);
 
 		if (s_subRenderer != TSR_CLASSIC_GPU)
 		{
@@ -558,7 +579,14 @@ namespace TFE_Jedi
 		{
 			TFE_ZONE("Sector Draw");
 			s_sectorRenderer->prepare();
-			s_sectorRenderer->draw(sector);
+			if (s_subRenderer == TSR_CLASSIC_FLOAT && TFE_Settings::getGraphicsSettings()->multithreadedRendering)
+			{
+				((TFE_Sectors_Float*)s_sectorRenderer)->drawBands(sector);
+			}
+			else
+			{
+				s_sectorRenderer->draw(sector);
+			}
 		}
 	}
 
@@ -67,6 +67,8 @@ namespace TFE_Jedi
 	//void setCamera(f32 yaw, f32 pitch, f32 x, f32 y, f32 z, s32 sectorId, s32 worldAmbient = 0, bool cameraLightSource = false);
 	// Draw the scene to the passed in display using the colormap for shading.
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp);
+	// Added for TFE: when disabled drawWorld() does nothing, used to skip drawing simulation steps that are not displayed.
+	void renderer_setWorldDrawEnabled(JBool enable);
 
 	// Added for TFE so the GPU renderer knows the beginning and end of the drawing frame.
 	void beginRender();
@@ -91,7 +93,7 @@ namespace TFE_Jedi
 	// Add a hud texture callback, these will be called when setting up the GPU renderer
 	void renderer_addHudTextureCallback(TextureListCallback hudTextureCallback);
 
-	extern s32 s_drawnObjCount;
+	extern thread_local s32 s_drawnObjCount;
 	extern bool s_showWireframe;
-	extern SecObject* s_drawnObj[];
+	extern thread_local SecObject* s_drawnObj[];
 }
\ No newline at end of file
@@ -0,0 +1,472 @@
+#include "rdrawKernels.h"
+#include <TFE_System/system.h>
+#include <SDL.h>
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define DK_X86 1
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#define DK_TARGET_SSE2
+		#define DK_TARGET_AVX2
+	#else
+		#define DK_TARGET_SSE2 __attribute__((target("sse2")))
+		#define DK_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+	#define DK_NEON 1
+	#include <arm_neon.h>
+#endif
+
+namespace TFE_Jedi
+{
+	static DrawKernelIsa s_drawKernelIsa = DKISA_SCALAR;
+
+	static const char* c_drawKernelIsaName[DKISA_COUNT] =
+	{
+		"Scalar",	// DKISA_SCALAR
+		"SSE2",		// DKISA_SSE2
+		"AVX2",		// DKISA_AVX2
+		"NEON",		// DKISA_NEON
+	};
+
+	//////////////////////////////////////////////////////////////////////
+	// Scalar
+	//////////////////////////////////////////////////////////////////////
+	template<bool LIT, bool TRANS>
+	static inline void drawPixel(u8* dst, u8 c, const u8* light)
+	{
+		if (TRANS && !c) { return; }
+		*dst = LIT ? light[c] : c;
+	}
+
+	template<bool LIT, bool TRANS>
+	static void drawColumn_Scalar(u8* out, s32 stride, s32 count, const u8* tex, s32 texMask, u32 v, u32 dv, s32 fracBits, const u8* light)
+	{
+		if (count <= 0) { return; }
+		u8* dst = out + (count - 1) * stride;
+		for (s32 k = 0; k < count; k++, dst -= stride, v += dv)
+		{
+			drawPixel<LIT, TRANS>(dst, tex[(v >> fracBits) & texMask], light);
+		}
+	}
+
+	template<bool LIT, bool TRANS>
+	static void drawSpan_Scalar(u8* out, s32 width, u32 u, u32 v, u32 du, u32 dv, s32 fracBits, u32 dataEnd, const u8* tex, const u8* light)
+	{
+		for (s32 i = width - 1; i >= 0; i--, u += du, v += dv)
+		{
+			const u32 texel = ((((u >> fracBits) & 63) << 6) | ((v >> fracBits) & 63)) & dataEnd;
+			drawPixel<LIT, TRANS>(&out[i], tex[texel], light);
+		}
+	}
+
+	// Fetches a batch of texels for a span and stores them in screen order (reversed).
+	template<bool LIT, s32 N>
+	static inline void fetchSpanBatch(const s32* idx, const u8* tex, const u8* light, u8* texel, u8* color)
+	{
+		for (s32 j = 0; j < N; j++)
+		{
+			const u8 c = tex[idx[j]];
+			texel[N - 1 - j] = c;
+			color[N - 1 - j] = LIT ? light[c] : c;
+		}
+	}
+
+#if DK_X86
+	//////////////////////////////////////////////////////////////////////
+	// SSE2
+	// The index math is done 4 lanes at a time, texel and colormap fetches
+	// remain scalar since there are no byte gathers. Spans are written 16
+	// pixels at a time, transparent pixels use a masked blend with the
+	// existing framebuffer contents.
+	//////////////////////////////////////////////////////////////////////
+	template<bool LIT, bool TRANS>
+	DK_TARGET_SSE2 static void drawColumn_SSE2(u8* out, s32 stride, s32 count, const u8* tex, s32 texMask, u32 v, u32 dv, s32 fracBits, const u8* light)
+	{
+		if (count <= 0) { return; }
+		const __m128i shift = _mm_cvtsi32_si128(fracBits);
+		const __m128i mask  = _mm_set1_epi32(texMask);
+		const __m128i step  = _mm_set1_epi32(s32(dv * 4));
+		__m128i vv = _mm_setr_epi32(s32(v), s32(v + dv), s32(v + dv * 2), s32(v + dv * 3));
+
+		alignas(16) s32 idx[4];
+		u8* dst = out + (count - 1) * stride;
+		s32 k = 0;
+		for (; k + 4 <= count; k += 4)
+		{
+			_mm_store_si128((__m128i*)idx, _mm_and_si128(_mm_srl_epi32(vv, shift), mask));
+			vv = _mm_add_epi32(vv, step);
+
+			drawPixel<LIT, TRANS>(dst, tex[idx[0]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[1]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[2]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[3]], light); dst -= stride;
+		}
+		v += dv * u32(k);
+		for (; k < count; k++, dst -= stride, v += dv)
+		{
+			drawPixel<LIT, TRANS>(dst, tex[(v >> fracBits) & texMask], light);
+		}
+	}
+
+	template<bool LIT, bool TRANS>
+	DK_TARGET_SSE2 static void drawSpan_SSE2(u8* out, s32 width, u32 u, u32 v, u32 du, u32 dv, s32 fracBits, u32 dataEnd, const u8* tex, const u8* light)
+	{
+		const __m128i shift = _mm_cvtsi32_si128(fracBits);
+		const __m128i mask63 = _mm_set1_epi32(63);
+		const __m128i end = _mm_set1_epi32(s32(dataEnd));
+		const __m128i stepU = _mm_set1_epi32(s32(du * 4));
+		const __m128i stepV = _mm_set1_epi32(s32(dv * 4));
+		__m128i uu = _mm_setr_epi32(s32(u), s32(u + du), s32(u + du * 2), s32(u + du * 3));
+		__m128i vv = _mm_setr_epi32(s32(v), s32(v + dv), s32(v + dv * 2), s32(v + dv * 3));
+
+		alignas(16) s32 idx[16];
+		alignas(16) u8 texel[16];
+		alignas(16) u8 color[16];
+		s32 k = 0;
+		for (; k + 16 <= width; k += 16)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const __m128i tu = _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(uu, shift), mask63), 6);
+				const __m128i tv = _mm_and_si128(_mm_srl_epi32(vv, shift), mask63);
+				_mm_store_si128((__m128i*)&idx[q * 4], _mm_and_si128(_mm_or_si128(tu, tv), end));
+				uu = _mm_add_epi32(uu, stepU);
+				vv = _mm_add_epi32(vv, stepV);
+			}
+			fetchSpanBatch<LIT, 16>(idx, tex, light, texel, color);
+
+			u8* dst = &out[width - k - 16];
+			__m128i result = _mm_load_si128((const __m128i*)color);
+			if (TRANS)
+			{
+				const __m128i isClear = _mm_cmpeq_epi8(_mm_load_si128((const __m128i*)texel), _mm_setzero_si128());
+				const __m128i prev = _mm_loadu_si128((const __m128i*)dst);
+				result = _mm_or_si128(_mm_and_si128(isClear, prev), _mm_andnot_si128(isClear, result));
+			}
+			_mm_storeu_si128((__m128i*)dst, result);
+		}
+		drawSpan_Scalar<LIT, TRANS>(out, width - k, u + du * u32(k), v + dv * u32(k), du, dv, fracBits, dataEnd, tex, light);
+	}
+
+	//////////////////////////////////////////////////////////////////////
+	// AVX2
+	// Same approach as SSE2 with 8 lanes and 32 pixel span batches.
+	//////////////////////////////////////////////////////////////////////
+	template<bool LIT, bool TRANS>
+	DK_TARGET_AVX2 static void drawColumn_AVX2(u8* out, s32 stride, s32 count, const u8* tex, s32 texMask, u32 v, u32 dv, s32 fracBits, const u8* light)
+	{
+		if (count <= 0) { return; }
+		const __m128i shift = _mm_cvtsi32_si128(fracBits);
+		const __m256i mask  = _mm256_set1_epi32(texMask);
+		const __m256i step  = _mm256_set1_epi32(s32(dv * 8));
+		const __m256i lane  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		__m256i vv = _mm256_add_epi32(_mm256_set1_epi32(s32(v)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s32(dv))));
+
+		alignas(32) s32 idx[8];
+		u8* dst = out + (count - 1) * stride;
+		s32 k = 0;
+		for (; k + 8 <= count; k += 8)
+		{
+			_mm256_store_si256((__m256i*)idx, _mm256_and_si256(_mm256_srl_epi32(vv, shift), mask));
+			vv = _mm256_add_epi32(vv, step);
+
+			for (s32 j = 0; j < 8; j++, dst -= stride)
+			{
+				drawPixel<LIT, TRANS>(dst, tex[idx[j]], light);
+			}
+		}
+		v += dv * u32(k);
+		for (; k < count; k++, dst -= stride, v += dv)
+		{
+			drawPixel<LIT, TRANS>(dst, tex[(v >> fracBits) & texMask], light);
+		}
+	}
+
+	template<bool LIT, bool TRANS>
+	DK_TARGET_AVX2 static void drawSpan_AVX2(u8* out, s32 width, u32 u, u32 v, u32 du, u32 dv, s32 fracBits, u32 dataEnd, const u8* tex, const u8* light)
+	{
+		const __m128i shift = _mm_cvtsi32_si128(fracBits);
+		const __m256i mask63 = _mm256_set1_epi32(63);
+		const __m256i end = _mm256_set1_epi32(s32(dataEnd));
+		const __m256i stepU = _mm256_set1_epi32(s32(du * 8));
+		const __m256i stepV = _mm256_set1_epi32(s32(dv * 8));
+		const __m256i lane  = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		__m256i uu = _mm256_add_epi32(_mm256_set1_epi32(s32(u)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s32(du))));
+		__m256i vv = _mm256_add_epi32(_mm256_set1_epi32(s32(v)), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s32(dv))));
+
+		alignas(32) s32 idx[32];
+		alignas(32) u8 texel[32];
+		alignas(32) u8 color[32];
+		s32 k = 0;
+		for (; k + 32 <= width; k += 32)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const __m256i tu = _mm256_slli_epi32(_mm256_and_si256(_mm256_srl_epi32(uu, shift), mask63), 6);
+				const __m256i tv = _mm256_and_si256(_mm256_srl_epi32(vv, shift), mask63);
+				_mm256_store_si256((__m256i*)&idx[q * 8], _mm256_and_si256(_mm256_or_si256(tu, tv), end));
+				uu = _mm256_add_epi32(uu, stepU);
+				vv = _mm256_add_epi32(vv, stepV);
+			}
+			fetchSpanBatch<LIT, 32>(idx, tex, light, texel, color);
+
+			u8* dst = &out[width - k - 32];
+			__m256i result = _mm256_load_si256((const __m256i*)color);
+			if (TRANS)
+			{
+				const __m256i isClear = _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i*)texel), _mm256_setzero_si256());
+				result = _mm256_blendv_epi8(result, _mm256_loadu_si256((const __m256i*)dst), isClear);
+			}
+			_mm256_storeu_si256((__m256i*)dst, result);
+		}
+		drawSpan_Scalar<LIT, TRANS>(out, width - k, u + du * u32(k), v + dv * u32(k), du, dv, fracBits, dataEnd, tex, light);
+	}
+#endif
+
+#if DK_NEON
+	//////////////////////////////////////////////////////////////////////
+	// NEON
+	// Same approach as SSE2: 4 lane index math and 16 pixel span batches.
+	//////////////////////////////////////////////////////////////////////
+	template<bool LIT, bool TRANS>
+	static void drawColumn_NEON(u8* out, s32 stride, s32 count, const u8* tex, s32 texMask, u32 v, u32 dv, s32 fracBits, const u8* light)
+	{
+		if (count <= 0) { return; }
+		const int32x4_t shift = vdupq_n_s32(-fracBits);
+		const uint32x4_t mask = vdupq_n_u32(u32(texMask));
+		const uint32x4_t step = vdupq_n_u32(dv * 4);
+		const u32 init[4] = { v, v + dv, v + dv * 2, v + dv * 3 };
+		uint32x4_t vv = vld1q_u32(init);
+
+		u32 idx[4];
+		u8* dst = out + (count - 1) * stride;
+		s32 k = 0;
+		for (; k + 4 <= count; k += 4)
+		{
+			vst1q_u32(idx, vandq_u32(vshlq_u32(vv, shift), mask));
+			vv = vaddq_u32(vv, step);
+
+			drawPixel<LIT, TRANS>(dst, tex[idx[0]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[1]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[2]], light); dst -= stride;
+			drawPixel<LIT, TRANS>(dst, tex[idx[3]], light); dst -= stride;
+		}
+		v += dv * u32(k);
+		for (; k < count; k++, dst -= stride, v += dv)
+		{
+			drawPixel<LIT, TRANS>(dst, tex[(v >> fracBits) & texMask], light);
+		}
+	}
+
+	template<bool LIT, bool TRANS>
+	static void drawSpan_NEON(u8* out, s32 width, u32 u, u32 v, u32 du, u32 dv, s32 fracBits, u32 dataEnd, const u8* tex, const u8* light)
+	{
+		const int32x4_t shift = vdupq_n_s32(-fracBits);
+		const uint32x4_t mask63 = vdupq_n_u32(63);
+		const uint32x4_t end = vdupq_n_u32(dataEnd);
+		const uint32x4_t stepU = vdupq_n_u32(du * 4);
+		const uint32x4_t stepV = vdupq_n_u32(dv * 4);
+		const u32 initU[4] = { u, u + du, u + du * 2, u + du * 3 };
+		const u32 initV[4] = { v, v + dv, v + dv * 2, v + dv * 3 };
+		uint32x4_t uu = vld1q_u32(initU);
+		uint32x4_t vv = vld1q_u32(initV);
+
+		s32 idx[16];
+		u8 texel[16];
+		u8 color[16];
+		s32 k = 0;
+		for (; k + 16 <= width; k += 16)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const uint32x4_t tu = vshlq_n_u32(vandq_u32(vshlq_u32(uu, shift), mask63), 6);
+				const uint32x4_t tv = vandq_u32(vshlq_u32(vv, shift), mask63);
+				vst1q_u32((u32*)&idx[q * 4], vandq_u32(vorrq_u32(tu, tv), end));
+				uu = vaddq_u32(uu, stepU);
+				vv = vaddq_u32(vv, stepV);
+			}
+			fetchSpanBatch<LIT, 16>(idx, tex, light, texel, color);
+
+			u8* dst = &out[width - k - 16];
+			uint8x16_t result = vld1q_u8(color);
+			if (TRANS)
+			{
+				const uint8x16_t isClear = vceqq_u8(vld1q_u8(texel), vdupq_n_u8(0));
+				result = vbslq_u8(isClear, vld1q_u8(dst), result);
+			}
+			vst1q_u8(dst, result);
+		}
+		drawSpan_Scalar<LIT, TRANS>(out, width - k, u + du * u32(k), v + dv * u32(k), du, dv, fracBits, dataEnd, tex, light);
+	}
+#endif
+
+	//////////////////////////////////////////////////////////////////////
+	// Kernel tables
+	//////////////////////////////////////////////////////////////////////
+	#define DK_COLUMN_TABLE(suffix) { drawColumn_##suffix<false, false>, drawColumn_##suffix<true, false>, drawColumn_##suffix<false, true>, drawColumn_##suffix<true, true> }
+	#define DK_SPAN_TABLE(suffix)   { drawSpan_##suffix<false, false>,   drawSpan_##suffix<true, false>,   drawSpan_##suffix<false, true>,   drawSpan_##suffix<true, true> }
+
+	static const DrawColumnKernel c_columnKernels[DKISA_COUNT][DK_COUNT] =
+	{
+		DK_COLUMN_TABLE(Scalar),
+	#if DK_X86
+		DK_COLUMN_TABLE(SSE2),
+		DK_COLUMN_TABLE(AVX2),
+	#else
+		{ nullptr }, { nullptr },
+	#endif
+	#if DK_NEON
+		DK_COLUMN_TABLE(NEON),
+	#else
+		{ nullptr },
+	#endif
+	};
+
+	static const DrawSpanKernel c_spanKernels[DKISA_COUNT][DK_COUNT] =
+	{
+		DK_SPAN_TABLE(Scalar),
+	#if DK_X86
+		DK_SPAN_TABLE(SSE2),
+		DK_SPAN_TABLE(AVX2),
+	#else
+		{ nullptr }, { nullptr },
+	#endif
+	#if DK_NEON
+		DK_SPAN_TABLE(NEON),
+	#else
+		{ nullptr },
+	#endif
+	};
+
+	DrawColumnKernel s_drawColumnKernel[DK_COUNT] = DK_COLUMN_TABLE(Scalar);
+	DrawSpanKernel   s_drawSpanKernel[DK_COUNT]   = DK_SPAN_TABLE(Scalar);
+
+	static bool drawKernels_isSupported(DrawKernelIsa isa)
+	{
+		if (isa < 0 || isa >= DKISA_COUNT || !c_columnKernels[isa][0]) { return false; }
+		switch (isa)
+		{
+			case DKISA_SCALAR: return true;
+			case DKISA_SSE2:   return SDL_HasSSE2() == SDL_TRUE;
+			case DKISA_AVX2:   return SDL_HasAVX2() == SDL_TRUE;
+			case DKISA_NEON:   return SDL_HasNEON() == SDL_TRUE;
+			default: break;
+		}
+		return false;
+	}
+
+	void drawKernels_init()
+	{
+		static const DrawKernelIsa c_preferredIsa[] = { DKISA_AVX2, DKISA_SSE2, DKISA_NEON };
+		DrawKernelIsa isa = DKISA_SCALAR;
+		for (size_t i = 0; i < TFE_ARRAYSIZE(c_preferredIsa); i++)
+		{
+			if (!drawKernels_isSupported(c_preferredIsa[i])) { continue; }
+			if (!drawKernels_validate(c_preferredIsa[i]))
+			{
+				TFE_System::logWrite(LOG_ERROR, "Draw Kernels", "%s kernels do not match the scalar kernels, skipping.", c_drawKernelIsaName[c_preferredIsa[i]]);
+				continue;
+			}
+			isa = c_preferredIsa[i];
+			break;
+		}
+		drawKernels_setIsa(isa);
+		TFE_System::logWrite(LOG_MSG, "Draw Kernels", "Using %s column and span kernels.", c_drawKernelIsaName[isa]);
+	}
+
+	bool drawKernels_setIsa(DrawKernelIsa isa)
+	{
+		if (!drawKernels_isSupported(isa)) { return false; }
+		for (s32 i = 0; i < DK_COUNT; i++)
+		{
+			s_drawColumnKernel[i] = c_columnKernels[isa][i];
+			s_drawSpanKernel[i] = c_spanKernels[isa][i];
+		}
+		s_drawKernelIsa = isa;
+		return true;
+	}
+
+	DrawKernelIsa drawKernels_getIsa()
+	{
+		return s_drawKernelIsa;
+	}
+
+	const char* drawKernels_getIsaName(DrawKernelIsa isa)
+	{
+		if (isa < 0 || isa >= DKISA_COUNT) { return "Invalid"; }
+		return c_drawKernelIsaName[isa];
+	}
+
+	bool drawKernels_validate(DrawKernelIsa isa)
+	{
+		if (!drawKernels_isSupported(isa)) { return false; }
+		if (isa == DKISA_SCALAR) { return true; }
+
+		enum
+		{
+			TEST_TEX_SIZE = 256 * 256,
+			TEST_STRIDE = 5,
+			TEST_MAX_COUNT = 133,	// Not a multiple of any batch size to exercise the tails.
+			TEST_OUT_SIZE = TEST_MAX_COUNT * TEST_STRIDE,
+		};
+		std::vector<u8> tex(TEST_TEX_SIZE);
+		u8 light[256];
+		u32 seed = 0x9e3779b9u;
+		for (s32 i = 0; i < TEST_TEX_SIZE; i++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			// Roughly 1/4 of the texels are transparent.
+			tex[i] = ((seed >> 24) & 3) ? u8(seed >> 16) : 0;
+		}
+		for (s32 i = 0; i < 256; i++)
+		{
+			light[i] = u8(255 - i);
+		}
+
+		std::vector<u8> refOut(TEST_OUT_SIZE), testOut(TEST_OUT_SIZE);
+		const s32 c_fracBits[] = { 16, 20 };
+		const s32 c_texMask[] = { 63, 255, 4095 };
+		const u32 c_dataEnd[] = { 4095, 1023 };
+		for (s32 count = 0; count <= TEST_MAX_COUNT; count++)
+		{
+			for (s32 f = 0; f < 2; f++)
+			{
+				const s32 fracBits = c_fracBits[f];
+				seed = seed * 1664525u + 1013904223u;
+				const u32 u  = seed;
+				seed = seed * 1664525u + 1013904223u;
+				const u32 v  = seed;
+				seed = seed * 1664525u + 1013904223u;
+				// Include negative steps.
+				const u32 du = u32(s32(seed) >> 10);
+				seed = seed * 1664525u + 1013904223u;
+				const u32 dv = u32(s32(seed) >> 10);
+
+				for (s32 k = 0; k < DK_COUNT; k++)
+				{
+					for (size_t m = 0; m < TFE_ARRAYSIZE(c_texMask); m++)
+					{
+						if (!drawKernel_columnFits(c_texMask[m], fracBits)) { continue; }
+						memset(refOut.data(), 0xcd, TEST_OUT_SIZE);
+						memset(testOut.data(), 0xcd, TEST_OUT_SIZE);
+						c_columnKernels[DKISA_SCALAR][k](refOut.data(), TEST_STRIDE, count, tex.data(), c_texMask[m], v, dv, fracBits, light);
+						c_columnKernels[isa][k](testOut.data(), TEST_STRIDE, count, tex.data(), c_texMask[m], v, dv, fracBits, light);
+						if (memcmp(refOut.data(), testOut.data(), TEST_OUT_SIZE)) { return false; }
+					}
+					for (size_t e = 0; e < TFE_ARRAYSIZE(c_dataEnd); e++)
+					{
+						memset(refOut.data(), 0xcd, TEST_OUT_SIZE);
+						memset(testOut.data(), 0xcd, TEST_OUT_SIZE);
+						c_spanKernels[DKISA_SCALAR][k](refOut.data(), count, u, v, du, dv, fracBits, c_dataEnd[e], tex.data(), light);
+						c_spanKernels[isa][k](testOut.data(), count, u, v, du, dv, fracBits, c_dataEnd[e], tex.data(), light);
+						if (memcmp(refOut.data(), testOut.data(), TEST_OUT_SIZE)) { return false; }
+					}
+				}
+			}
+		}
+		return true;
+	}
+}
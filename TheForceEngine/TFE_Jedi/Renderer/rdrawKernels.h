@@ -0,0 +1,59 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Draw Kernels
+// Wall column and flat span inner loops shared by the software
+// sub-renderers, with SSE2 / AVX2 / NEON versions chosen at runtime.
+//
+// Texture coordinates are passed as the low 32 bits of the fixed point
+// value along with the number of fractional bits. Only the bits at and
+// above 'fracBits' that survive the texture mask are used, so this
+// gives the same texels as the full 44.20 or 16.16 math as long as
+// (texMask << fracBits) fits in 32 bits - see drawKernel_columnFits().
+//
+// All versions produce bit-identical output to the scalar loops.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Jedi
+{
+	enum DrawKernelIsa
+	{
+		DKISA_SCALAR = 0,
+		DKISA_SSE2,
+		DKISA_AVX2,
+		DKISA_NEON,
+		DKISA_COUNT
+	};
+
+	enum DrawKernelId
+	{
+		DK_FULLBRIGHT = 0,
+		DK_LIT,
+		DK_FULLBRIGHT_TRANS,
+		DK_LIT_TRANS,
+		DK_COUNT
+	};
+
+	// Draws 'count' pixels of a column starting at the bottom, out[(count - 1) * stride], and moving up.
+	// Pixel k (from the bottom) samples tex[((v + k*dv) >> fracBits) & texMask].
+	typedef void(*DrawColumnKernel)(u8* out, s32 stride, s32 count, const u8* tex, s32 texMask, u32 v, u32 dv, s32 fracBits, const u8* light);
+	// Draws 'width' pixels of a 64x64 mapped span starting at the right, out[width - 1], and moving left.
+	typedef void(*DrawSpanKernel)(u8* out, s32 width, u32 u, u32 v, u32 du, u32 dv, s32 fracBits, u32 dataEnd, const u8* tex, const u8* light);
+
+	extern DrawColumnKernel s_drawColumnKernel[DK_COUNT];
+	extern DrawSpanKernel   s_drawSpanKernel[DK_COUNT];
+
+	// Picks the widest kernels supported by the CPU that pass validation against the scalar kernels.
+	void drawKernels_init();
+	// Returns false if the ISA is not supported on this CPU or build.
+	bool drawKernels_setIsa(DrawKernelIsa isa);
+	DrawKernelIsa drawKernels_getIsa();
+	const char* drawKernels_getIsaName(DrawKernelIsa isa);
+	// Runs the kernels for 'isa' against the scalar kernels on generated data, returns true if the output matches.
+	bool drawKernels_validate(DrawKernelIsa isa);
+
+	inline bool drawKernel_columnFits(s32 texMask, s32 fracBits)
+	{
+		return texMask >= 0 && (u64(texMask) << fracBits) <= 0xffffffffull;
+	}
+}
@@ -53,6 +53,8 @@ namespace TFE_Jedi
 	class TFE_Sectors
 	{
 	public:
+		virtual ~TFE_Sectors() {}
+
 		void computeAdjoinWindowBounds(EdgePairFixed* adjoinEdges);
 
 		// Sub-Renderer specific
@@ -27,6 +27,7 @@ namespace TFE_Jedi
 
 	static FramebufferMode s_mode = VFB_TEXTURE;
 	static FramebufferMode s_nextMode = VFB_TEXTURE;
+	static JBool s_headless = JFALSE;
 
 	void vfb_createVirtualDisplay(u32 width, u32 height);
 		
@@ -130,7 +131,10 @@ namespace TFE_Jedi
 	void vfb_setPalette(const u32* palette)
 	{
 		memcpy(s_palette, palette, sizeof(u32) * 256);
-		TFE_RenderBackend::setPalette(palette);
+		if (!s_headless)
+		{
+			TFE_RenderBackend::setPalette(palette);
+		}
 	}
 
 	void vfb_setMode(FramebufferMode mode)
@@ -138,6 +142,16 @@ namespace TFE_Jedi
 		s_nextMode = mode;
 	}
 
+	void vfb_setHeadless(JBool headless)
+	{
+		s_headless = headless;
+	}
+
+	JBool vfb_isHeadless()
+	{
+		return s_headless;
+	}
+
 	////////////////////////////
 	// Get Scale Factors
 	////////////////////////////
@@ -192,6 +206,7 @@ namespace TFE_Jedi
 	// Frame rendering is done, copy the results to GPU memory.
 	void vfb_swap()
 	{
+		if (s_headless) { return; }
 		TFE_RenderBackend::updateVirtualDisplay(s_curFrameBuffer, s_width * s_height);
 	}
 
@@ -240,6 +255,8 @@ namespace TFE_Jedi
 	////////////////////////////
 	void vfb_createVirtualDisplay(u32 width, u32 height)
 	{
+		if (s_headless) { return; }
+
 		// Setup or update the virtual display.
 		TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
 		u32 vdispFlags = 0;
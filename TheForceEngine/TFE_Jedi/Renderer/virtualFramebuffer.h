@@ -43,6 +43,10 @@ namespace TFE_Jedi
 	void vfb_setPalette(const u32* palette);
 	void vfb_setMode(FramebufferMode mode = VFB_TEXTURE);
 	u32* vfb_getPalette();
+	// Headless: render into the CPU buffer only, without creating or updating the GPU virtual display.
+	// Used for benchmarking when there is no window or GPU context.
+	void vfb_setHeadless(JBool headless);
+	JBool vfb_isHeadless();
 
 	////////////////////////////
 	// Get Scale Factors
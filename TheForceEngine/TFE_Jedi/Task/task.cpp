@@ -92,6 +92,8 @@ namespace TFE_Jedi
 	static s32 s_frameActiveTaskCount = 0;
 	static JBool s_taskSystemPaused = JFALSE;
 	static bool s_enableTimeLimiter = true;
+	static JBool s_overrideTimeLimiter = JFALSE;
+	static JBool s_overrideCanRun = JTRUE;
 	static Task* s_taskPauseTask = nullptr;
 
 	void selectNextTask();
@@ -316,6 +318,11 @@ namespace TFE_Jedi
 		task->nextTick = tick;
 	}
 
+	Tick task_getNextTick(Task* task)
+	{
+		return task->nextTick;
+	}
+
 	void task_setUserData(Task* task, void* data)
 	{
 		if (!task) { return; }
@@ -521,9 +528,24 @@ namespace TFE_Jedi
 		s_minIntervalInSec = minIntervalInSec;
 	}
 
+	f64 task_getMinStepInterval()
+	{
+		return s_minIntervalInSec;
+	}
+
+	void task_overrideTimeLimiter(JBool enable, JBool canRun)
+	{
+		s_overrideTimeLimiter = enable;
+		s_overrideCanRun = canRun;
+	}
+
 	JBool task_canRun()
 	{
-		if (s_taskCount && s_enableTimeLimiter)
+		if (s_taskCount && s_overrideTimeLimiter)
+		{
+			return s_overrideCanRun;
+		}
+		else if (s_taskCount && s_enableTimeLimiter)
 		{
 			const f64 time = TFE_System::getTime();
 			if (time - s_prevTime < s_minIntervalInSec)
@@ -552,7 +574,7 @@ namespace TFE_Jedi
 		// Limit the update rate by the minimum interval.
 		// Dark Forces uses discrete 'ticks' to track time and the game behavior is very odd with 0 tick frames.
 		const f64 time = TFE_System::getTime();
-		if (time - s_prevTime < s_minIntervalInSec)
+		if (s_overrideTimeLimiter ? !s_overrideCanRun : time - s_prevTime < s_minIntervalInSec)
 		{
 			return JFALSE;
 		}
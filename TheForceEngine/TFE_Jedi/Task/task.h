@@ -53,6 +53,7 @@ namespace TFE_Jedi
 
 	void  task_makeActive(Task* task);
 	void  task_setNextTick(Task* task, Tick tick);
+	Tick  task_getNextTick(Task* task);
 	void  task_setUserData(Task* task, void* data);
 	void  task_setMessage(MessageType msg);
 	void* task_getUserData();
@@ -73,6 +74,9 @@ namespace TFE_Jedi
 	JBool task_canRun();
 	void task_setDefaults();
 	void task_setMinStepInterval(f64 minIntervalInSec);
+	f64  task_getMinStepInterval();
+	// Replace the time limiter with a fixed decision, used to replay recorded frames.
+	void task_overrideTimeLimiter(JBool enable, JBool canRun = JTRUE);
 
 	void task_updateTime();
 	s32 task_getCount();
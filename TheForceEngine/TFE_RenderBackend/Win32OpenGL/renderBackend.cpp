@@ -684,6 +684,11 @@ void updateVirtualDisplay(const void *buffer, size_t size)
 	{
 		s_virtualDisplay->update(buffer, size);
 	}
+	// 8-bit frames can be recorded as is, along with the palette.
+	if (s_virtualDisplay && s_gpuColorConvert && size == s_virtualWidth * s_virtualHeight)
+	{
+		s_screenCapture->setFrame8((const u8*)buffer, s_virtualWidth, s_virtualHeight, s_paletteCpu);
+	}
 }
 
 void bindVirtualDisplay()
@@ -149,10 +149,20 @@ void ScreenCapture::update(bool flush)
 		f64 recordingFrame = floor(recordingTime * TFE_Settings::getSystemSettings()->gifRecordingFramerate);
 		if (m_recordingFrameLast != recordingFrame)
 		{
-			captureFrame("");
-			m_recordingFrameLast = recordingFrame;
+			if (!m_recordFrame8)
+			{
+				captureFrame("");
+				m_recordingFrameLast = recordingFrame;
+			}
+			else if (m_frame8 && m_frame8Width == m_recordingWidth && m_frame8Height == m_recordingHeight)
+			{
+				// The 8-bit frame is passed directly to the GIF writer, skipping the GPU read back.
+				TFE_GIF::addFramePal8(m_frame8, m_frame8Palette);
+				m_recordingFrameLast = recordingFrame;
+			}
 		}
 	}
+	m_frame8 = nullptr;
 
 	// Handle capture
 	m_frame++;
@@ -255,8 +265,22 @@ void ScreenCapture::startCapture()
 	m_recordingTimeStart = 0.0;
 	m_recordingFrameLast = -1.0;
 
-	u32 framerate = (u32)TFE_Settings::getSystemSettings()->gifRecordingFramerate;
-	TFE_GIF::startGif(m_capturePath.c_str(), m_width, m_height, framerate);
+	// Record the software renderer output at its own resolution if it is available.
+	const TFE_Settings_System* system = TFE_Settings::getSystemSettings();
+	m_recordFrame8 = system->gifRecordNative && m_frame8;
+	m_recordingWidth  = m_recordFrame8 ? m_frame8Width  : m_width;
+	m_recordingHeight = m_recordFrame8 ? m_frame8Height : m_height;
+
+	u32 framerate = (u32)system->gifRecordingFramerate;
+	TFE_GIF::startGif(m_capturePath.c_str(), m_recordingWidth, m_recordingHeight, framerate, m_recordFrame8 ? TFE_GIF::GIF_FRAME_PAL8 : TFE_GIF::GIF_FRAME_RGBA);
+}
+
+void ScreenCapture::setFrame8(const u8* pixels, u32 width, u32 height, const u32* palette)
+{
+	m_frame8 = pixels;
+	m_frame8Palette = palette;
+	m_frame8Width = width;
+	m_frame8Height = height;
 }
 
 void ScreenCapture::endRecording()
@@ -27,7 +27,8 @@ public:
 	};
 
 	ScreenCapture() : m_bufferCount(0), m_captureHead(0), m_captureCount(0), m_readIndex(nullptr), m_readCount(0), m_writeBuffer(0),
-		m_frame(0), m_width(0), m_height(0), m_recordingFrame(0), m_captures(0), m_stagingBuffers(nullptr), m_state(IDLE) {}
+		m_frame(0), m_width(0), m_height(0), m_recordingFrame(0), m_captures(0), m_stagingBuffers(nullptr), m_state(IDLE),
+		m_frame8(nullptr), m_frame8Palette(nullptr), m_frame8Width(0), m_frame8Height(0), m_recordFrame8(false) {}
 	~ScreenCapture();
 
 	bool create(u32 width, u32 height, u32 bufferCount);
@@ -38,6 +39,8 @@ public:
 	void captureFrame(const char* outputPath);
 
 	void captureFrontBufferToMemory(u32* mem);
+	// The 8-bit frame uploaded to the virtual display this frame, used to record GIFs without reading back the window.
+	void setFrame8(const u8* pixels, u32 width, u32 height, const u32* palette);
 
 	void beginRecording(const char* path, bool skipCountdown);
 	void endRecording();
@@ -89,6 +92,15 @@ private:
 	Capture* m_captures;
 	u32* m_stagingBuffers;
 
+	// Only valid for the current frame.
+	const u8* m_frame8;
+	const u32* m_frame8Palette;
+	u32 m_frame8Width;
+	u32 m_frame8Height;
+	bool m_recordFrame8;
+	u32 m_recordingWidth = 0;
+	u32 m_recordingHeight = 0;
+
 private:
 	// If `fullCountdown` is false, we'll just flash a brief message before capture starts.
 	void startCountdown(bool fullCountdown);
@@ -1,6 +1,7 @@
 #include <TFE_RenderBackend/shaderBuffer.h>
 #include "gl.h"
 #include <memory.h>
+#include <assert.h>
 #include "openGL_Caps.h"
 
 GLenum getFormat(const ShaderBufferDef& bufferDef);
@@ -55,11 +56,21 @@ void ShaderBuffer::destroy()
 
 void ShaderBuffer::update(const void* buffer, size_t size)
 {
+	// glBufferData() reallocates the buffer storage to the new size.
+	m_size = (u32)size;
 	glBindBuffer(GL_TEXTURE_BUFFER, m_gpuHandle[0]);
 	glBufferData(GL_TEXTURE_BUFFER, size, buffer, m_dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
 	glBindBuffer(GL_TEXTURE_BUFFER, 0);
 }
 
+void ShaderBuffer::updateRange(const void* buffer, size_t offset, size_t size)
+{
+	assert(offset + size <= m_size);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_gpuHandle[0]);
+	glBufferSubData(GL_TEXTURE_BUFFER, offset, size, buffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
 void ShaderBuffer::bind(s32 bindPoint) const
 {
 	if (bindPoint < 0) { return; }
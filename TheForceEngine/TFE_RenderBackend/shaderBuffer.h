@@ -34,6 +34,8 @@ public:
 	void destroy();
 
 	void update(const void* buffer, size_t size);
+	// Update part of the buffer in place, the buffer must already be large enough.
+	void updateRange(const void* buffer, size_t offset, size_t size);
 	void bind(s32 bindPoint) const;
 	void unbind(s32 bindPoint) const;
 
@@ -409,6 +409,7 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "colorCorrection", s_graphicsSettings.colorCorrection);
 		writeKeyValue_Bool(settings, "perspectiveCorrect3DO", s_graphicsSettings.perspectiveCorrectTexturing);
 		writeKeyValue_Bool(settings, "extendAjoinLimits", s_graphicsSettings.extendAjoinLimits);
+		writeKeyValue_Bool(settings, "multithreadedRendering", s_graphicsSettings.multithreadedRendering);
 		writeKeyValue_Bool(settings, "vsync", s_graphicsSettings.vsync);
 		writeKeyValue_Bool(settings, "show_fps", s_graphicsSettings.showFps);
 		writeKeyValue_Bool(settings, "3doNormalFix", s_graphicsSettings.fix3doNormalOverflow);
@@ -484,6 +485,8 @@ namespace TFE_Settings
 		writeKeyValue_Bool(settings, "returnToModLoader", s_systemSettings.returnToModLoader);
 		writeKeyValue_Float(settings, "gifRecordingFramerate", s_systemSettings.gifRecordingFramerate);
 		writeKeyValue_Bool(settings, "showGifPathConfirmation", s_systemSettings.showGifPathConfirmation);
+		writeKeyValue_Bool(settings, "gifRecordNative", s_systemSettings.gifRecordNative);
+		writeKeyValue_Bool(settings, "memoryMapArchives", s_systemSettings.memoryMapArchives);
 	}
 
 	void writeA11ySettings(FileStream& settings)
@@ -741,6 +744,10 @@ namespace TFE_Settings
 		{
 			s_graphicsSettings.extendAjoinLimits = parseBool(value);
 		}
+		else if (strcasecmp("multithreadedRendering", key) == 0)
+		{
+			s_graphicsSettings.multithreadedRendering = parseBool(value);
+		}
 		else if (strcasecmp("vsync", key) == 0)
 		{
 			s_graphicsSettings.vsync = parseBool(value);
@@ -971,6 +978,14 @@ namespace TFE_Settings
 		{
 			s_systemSettings.showGifPathConfirmation = parseBool(value);
 		}
+		else if (strcasecmp("gifRecordNative", key) == 0)
+		{
+			s_systemSettings.gifRecordNative = parseBool(value);
+		}
+		else if (strcasecmp("memoryMapArchives", key) == 0)
+		{
+			s_systemSettings.memoryMapArchives = parseBool(value);
+		}
 	}
 	
 	void parseA11ySettings(const char* key, const char* value)
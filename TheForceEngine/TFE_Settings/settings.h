@@ -63,6 +63,7 @@ struct TFE_Settings_Graphics
 	bool  colorCorrection = false;
 	bool  perspectiveCorrectTexturing = false;
 	bool  extendAjoinLimits = true;
+	bool  multithreadedRendering = false;
 	bool  vsync = true;
 	bool  showFps = false;
 	bool  fix3doNormalOverflow = true;
@@ -226,6 +227,8 @@ struct TFE_Settings_System
 	bool returnToModLoader = true;			// Return to the Mod Loader if running a mod.
 	f32 gifRecordingFramerate = 18;			// Used with GIF recording (Alt-F2)
 	bool showGifPathConfirmation = true;	// Used with GIF recording (Alt-F2)
+	bool gifRecordNative = true;			// Record the software renderer output with its palette, at the game resolution (Alt-F2)
+	bool memoryMapArchives = true;			// Memory map GOB, LFD and LAB archives and read assets in place.
 };
 
 struct TFE_Settings_A11y
@@ -0,0 +1,206 @@
+#include "jobSystem.h"
+#include "system.h"
+#include "profiler.h"
+#include <SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+namespace TFE_Jobs
+{
+	enum JobConstants
+	{
+		MAX_WORKER_COUNT = 15,
+	};
+
+	static SDL_Thread* s_workers[MAX_WORKER_COUNT];
+	static s32 s_workerCount = 0;
+
+	static SDL_mutex* s_lock = nullptr;
+	static SDL_cond*  s_workReady = nullptr;
+	static SDL_cond*  s_workDone = nullptr;
+	static SDL_mutex* s_callerLock = nullptr;
+
+	// Current batch - only modified while holding s_lock with no active workers.
+	static JobFunc s_func = nullptr;
+	static void*   s_userData = nullptr;
+	static s32     s_count = 0;
+	static std::atomic<s32> s_next(0);
+
+	static u32  s_generation = 0;
+	static s32  s_activeWorkers = 0;
+	static bool s_quit = false;
+
+	static thread_local bool s_isWorker = false;
+	static thread_local bool s_inJob = false;
+
+	// Names used in profiler traces, these must remain valid for the lifetime of the threads.
+	static const char* c_workerNames[MAX_WORKER_COUNT] =
+	{
+		"Job Worker 0",  "Job Worker 1",  "Job Worker 2",  "Job Worker 3",  "Job Worker 4",
+		"Job Worker 5",  "Job Worker 6",  "Job Worker 7",  "Job Worker 8",  "Job Worker 9",
+		"Job Worker 10", "Job Worker 11", "Job Worker 12", "Job Worker 13", "Job Worker 14",
+	};
+
+	void runBatch()
+	{
+		const JobFunc func = s_func;
+		void* userData = s_userData;
+		const s32 count = s_count;
+		for (s32 i = s_next.fetch_add(1); i < count; i = s_next.fetch_add(1))
+		{
+			func(i, userData);
+		}
+	}
+
+	int workerFunc(void* userData)
+	{
+		s_isWorker = true;
+		TFE_THREAD_NAME((const char*)userData);
+
+		u32 generation = 0;
+		SDL_LockMutex(s_lock);
+		while (1)
+		{
+			while (!s_quit && generation == s_generation)
+			{
+				SDL_CondWait(s_workReady, s_lock);
+			}
+			if (s_quit) { break; }
+
+			generation = s_generation;
+			s_activeWorkers++;
+			SDL_UnlockMutex(s_lock);
+
+			runBatch();
+
+			SDL_LockMutex(s_lock);
+			s_activeWorkers--;
+			if (s_activeWorkers == 0)
+			{
+				SDL_CondBroadcast(s_workDone);
+			}
+		}
+		SDL_UnlockMutex(s_lock);
+		return 0;
+	}
+
+	bool init(s32 workerCount)
+	{
+		if (workerCount <= 0)
+		{
+			workerCount = SDL_GetCPUCount() - 1;
+		}
+		workerCount = std::max(0, std::min(workerCount, (s32)MAX_WORKER_COUNT));
+
+		s_lock = SDL_CreateMutex();
+		s_callerLock = SDL_CreateMutex();
+		s_workReady = SDL_CreateCond();
+		s_workDone = SDL_CreateCond();
+		if (!s_lock || !s_callerLock || !s_workReady || !s_workDone)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Jobs", "Cannot create job system synchronization primitives.");
+			destroy();
+			return false;
+		}
+
+		s_quit = false;
+		s_generation = 0;
+		s_activeWorkers = 0;
+		s_workerCount = 0;
+		for (s32 i = 0; i < workerCount; i++)
+		{
+			char name[32];
+			sprintf(name, "TFE_Worker%d", i);
+			s_workers[i] = SDL_CreateThread(workerFunc, name, (void*)c_workerNames[i]);
+			if (!s_workers[i])
+			{
+				TFE_System::logWrite(LOG_WARNING, "Jobs", "Cannot create worker thread %d, continuing with %d workers.", i, s_workerCount);
+				break;
+			}
+			s_workerCount++;
+		}
+		TFE_System::logWrite(LOG_MSG, "Jobs", "Job system started with %d worker thread(s).", s_workerCount);
+		return true;
+	}
+
+	void destroy()
+	{
+		if (s_lock)
+		{
+			SDL_LockMutex(s_lock);
+			s_quit = true;
+			SDL_CondBroadcast(s_workReady);
+			SDL_UnlockMutex(s_lock);
+		}
+		for (s32 i = 0; i < s_workerCount; i++)
+		{
+			SDL_WaitThread(s_workers[i], nullptr);
+			s_workers[i] = nullptr;
+		}
+		s_workerCount = 0;
+
+		if (s_workReady)  { SDL_DestroyCond(s_workReady); }
+		if (s_workDone)   { SDL_DestroyCond(s_workDone); }
+		if (s_callerLock) { SDL_DestroyMutex(s_callerLock); }
+		if (s_lock)       { SDL_DestroyMutex(s_lock); }
+		s_workReady = nullptr;
+		s_workDone = nullptr;
+		s_callerLock = nullptr;
+		s_lock = nullptr;
+	}
+
+	s32 getWorkerCount()
+	{
+		return s_workerCount;
+	}
+
+	bool isWorkerThread()
+	{
+		return s_isWorker;
+	}
+
+	void parallelFor(s32 count, JobFunc func, void* userData)
+	{
+		if (count <= 0) { return; }
+		// Run serially if there are no workers, there is nothing to split or this is a nested call.
+		if (s_workerCount == 0 || count == 1 || s_isWorker || s_inJob)
+		{
+			for (s32 i = 0; i < count; i++)
+			{
+				func(i, userData);
+			}
+			return;
+		}
+
+		// Only one batch may be in flight at a time.
+		SDL_LockMutex(s_callerLock);
+		SDL_LockMutex(s_lock);
+		// A worker that woke up late for the previous batch may still be looking at it.
+		while (s_activeWorkers > 0)
+		{
+			SDL_CondWait(s_workDone, s_lock);
+		}
+		s_func = func;
+		s_userData = userData;
+		s_count = count;
+		s_next.store(0);
+		s_generation++;
+		SDL_CondBroadcast(s_workReady);
+		SDL_UnlockMutex(s_lock);
+
+		// The calling thread helps out.
+		s_inJob = true;
+		runBatch();
+		s_inJob = false;
+
+		// Every index has been claimed at this point, wait for the workers to finish theirs.
+		SDL_LockMutex(s_lock);
+		while (s_activeWorkers > 0)
+		{
+			SDL_CondWait(s_workDone, s_lock);
+		}
+		SDL_UnlockMutex(s_lock);
+		SDL_UnlockMutex(s_callerLock);
+	}
+}
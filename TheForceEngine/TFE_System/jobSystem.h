@@ -0,0 +1,28 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Job System
+// A small pool of worker threads used to split work that would
+// otherwise run on a single core across the available CPU cores.
+//
+// parallelFor() is a blocking fork/join: the calling thread takes
+// part in the work and only returns once every index has been
+// processed. Jobs must not call parallelFor() themselves - nested
+// calls from a worker simply run serially.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+typedef void(*JobFunc)(s32 index, void* userData);
+
+namespace TFE_Jobs
+{
+	// workerCount = 0 picks one worker per logical core, minus the calling thread.
+	bool init(s32 workerCount = 0);
+	void destroy();
+
+	// Number of worker threads, not counting the calling thread.
+	s32  getWorkerCount();
+	bool isWorkerThread();
+
+	// Calls func(i, userData) for i = [0, count) and waits until all calls have completed.
+	void parallelFor(s32 count, JobFunc func, void* userData);
+}
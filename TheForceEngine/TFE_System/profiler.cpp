@@ -1,18 +1,24 @@
 #include <cstring>
 
 #include "profiler.h"
+#include "spscQueue.h"
+#include <TFE_FileSystem/filestream.h>
 #include <assert.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
-
-// TODO: Support call "paths" - with seperate time per path.
+#include <mutex>
+#include <thread>
 
 namespace TFE_Profiler
 {
 	#define ZONE_BUFFER_COUNT 2
 	#define MAX_ZONE_STACK 256
+	#define TRACE_EVENTS_PER_THREAD 8192
 	
 	struct Zone
 	{
@@ -42,7 +48,41 @@ namespace TFE_Profiler
 		char name[64];
 	};
 
-	typedef std::map<std::string, u32> ZoneMap;
+	// Zones recorded by a single thread, drained by the frame thread while capturing.
+	struct TraceZone
+	{
+		const char* name;
+		u64 start;
+		u64 duration;
+	};
+
+	struct ThreadTrace
+	{
+		SpscQueue<TraceZone, TRACE_EVENTS_PER_THREAD> zones;
+		const char* name;
+		u32 tid;
+		atomic_u32 dropped;
+	};
+
+	enum TraceEventType
+	{
+		TRACE_ZONE = 0,
+		TRACE_COUNTER,
+	};
+
+	struct TraceEvent
+	{
+		TraceEventType type;
+		const char* name;	// Zone name, or null for counters.
+		u32 id;				// Thread id for zones, counter index for counters.
+		s32 value;
+		u64 start;
+		u64 duration;
+	};
+
+	// Zones are keyed by their parent and name, so each call path gets its own entry.
+	typedef std::map<std::pair<u32, std::string>, u32> ZoneMap;
+	typedef std::map<std::string, u32> CounterMap;
 	typedef std::vector<Zone> ZoneList;
 	typedef std::vector<u32> SortedZoneList;
 	typedef std::vector<Counter> CounterList;
@@ -52,7 +92,7 @@ namespace TFE_Profiler
 	static SortedZoneList s_sortedZoneList;
 	static SortedZoneList s_roots;
 
-	static ZoneMap  s_counterMap;
+	static CounterMap  s_counterMap;
 	static CounterList s_counterList;
 
 	static u64 s_frameBegin;
@@ -64,6 +104,37 @@ namespace TFE_Profiler
 	static u32 s_zoneStack[MAX_ZONE_STACK];
 	static u64 s_currentFrame = 1;
 	static u64 s_currentPath;
+	// Zones are only tracked on the thread driving the frame, work done on job threads is
+	// accounted for by the zone that waits on it.
+	static std::thread::id s_frameThread;
+
+	// Trace capture.
+	static std::mutex s_threadTraceMutex;
+	static std::vector<ThreadTrace*> s_threadTraces;
+	static thread_local ThreadTrace* s_threadTrace = nullptr;
+	static thread_local const char* s_threadName = nullptr;
+
+	static atomic_bool s_capturing(false);
+	static bool s_captureRequested = false;
+	static u32  s_captureFramesLeft = 0;
+	static u64  s_captureStart = 0;
+	static std::string s_capturePath;
+	static std::vector<TraceEvent> s_traceEvents;
+
+	void writeCapture();
+	void freeThreadTrace(ThreadTrace* trace);
+
+	void destroy()
+	{
+		std::lock_guard<std::mutex> lock(s_threadTraceMutex);
+		const size_t count = s_threadTraces.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			freeThreadTrace(s_threadTraces[i]);
+		}
+		s_threadTraces.clear();
+		s_threadTrace = nullptr;
+	}
 
 	void addZoneChild(u32 parentId, u32 zoneId)
 	{
@@ -104,7 +175,13 @@ namespace TFE_Profiler
 
 	u32 beginZone(const char* name, const char* func, u32 lineNumber)
 	{
-		ZoneMap::iterator iZone = s_zoneMap.find(name);
+		if (std::this_thread::get_id() != s_frameThread)
+		{
+			return NULL_ZONE;
+		}
+		const u32 parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
+		const std::pair<u32, std::string> key(parent, name);
+		ZoneMap::iterator iZone = s_zoneMap.find(key);
 		u32 id = 0;
 
 		if (iZone == s_zoneMap.end())
@@ -121,7 +198,7 @@ namespace TFE_Profiler
 			zone.frame = 0;
 			
 			s_zoneList.push_back(zone);
-			s_zoneMap[name] = id;
+			s_zoneMap[key] = id;
 		}
 		else
 		{
@@ -134,7 +211,7 @@ namespace TFE_Profiler
 		zone.lineNumber = lineNumber;
 		zone.level = s_level;
 
-		zone.parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
+		zone.parent = parent;
 		if (zone.parent == NULL_ZONE)
 		{
 			s_roots.push_back(id);
@@ -152,13 +229,14 @@ namespace TFE_Profiler
 
 	void endZone(u32 id, u64 dt)
 	{
+		if (id == NULL_ZONE) { return; }
 		s_zoneList[id].timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(dt);
 		s_level--;
 	}
 
 	void addCounter(const char* name, s32* counter)
 	{
-		ZoneMap::iterator iCounter = s_counterMap.find(name);
+		CounterMap::iterator iCounter = s_counterMap.find(name);
 		if (iCounter == s_counterMap.end())
 		{
 			const u32 id = (u32)s_counterList.size();
@@ -174,6 +252,215 @@ namespace TFE_Profiler
 		}
 	}
 
+	// ThreadTrace has cache line aligned members, which plain new does not respect before C++17.
+	ThreadTrace* allocThreadTrace()
+	{
+		const size_t align = alignof(ThreadTrace);
+		u8* mem = (u8*)malloc(sizeof(ThreadTrace) + align - 1 + sizeof(void*));
+		if (!mem) { return nullptr; }
+
+		// The original allocation is stored just before the aligned object.
+		u8* aligned = (u8*)((uintptr_t(mem) + sizeof(void*) + align - 1) & ~uintptr_t(align - 1));
+		((void**)aligned)[-1] = mem;
+		return new (aligned) ThreadTrace();
+	}
+
+	void freeThreadTrace(ThreadTrace* trace)
+	{
+		if (!trace) { return; }
+		void* mem = ((void**)trace)[-1];
+		trace->~ThreadTrace();
+		free(mem);
+	}
+
+	ThreadTrace* getThreadTrace()
+	{
+		if (!s_threadTrace)
+		{
+			ThreadTrace* trace = allocThreadTrace();
+			assert(trace);
+			trace->name = s_threadName;
+			trace->dropped = 0;
+
+			std::lock_guard<std::mutex> lock(s_threadTraceMutex);
+			trace->tid = (u32)s_threadTraces.size() + 1;
+			s_threadTraces.push_back(trace);
+			s_threadTrace = trace;
+		}
+		return s_threadTrace;
+	}
+
+	void setThreadName(const char* name)
+	{
+		s_threadName = name;
+		if (s_threadTrace)
+		{
+			s_threadTrace->name = name;
+		}
+	}
+
+	bool isCapturing()
+	{
+		return s_capturing.load(std::memory_order_relaxed);
+	}
+
+	void recordZone(const char* name, u64 startTicks, u64 durationTicks)
+	{
+		ThreadTrace* trace = getThreadTrace();
+		if (!trace->zones.push({ name, startTicks, durationTicks }))
+		{
+			trace->dropped++;
+		}
+	}
+
+	bool beginCapture(u32 frameCount, const char* path)
+	{
+		if (s_captureRequested || isCapturing() || !frameCount || !path)
+		{
+			return false;
+		}
+		s_capturePath = path;
+		s_captureFramesLeft = frameCount;
+		s_captureRequested = true;
+		return true;
+	}
+
+	// Move the events recorded by all threads into the capture.
+	void drainThreadTraces(bool discard)
+	{
+		std::lock_guard<std::mutex> lock(s_threadTraceMutex);
+		const size_t count = s_threadTraces.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			ThreadTrace* trace = s_threadTraces[i];
+			TraceZone zone;
+			while (trace->zones.pop(&zone))
+			{
+				// Skip zones that started before the capture.
+				if (discard || zone.start < s_captureStart) { continue; }
+				s_traceEvents.push_back({ TRACE_ZONE, zone.name, trace->tid, 0, zone.start, zone.duration });
+			}
+		}
+	}
+
+	// Called at the start of a frame on the frame thread.
+	void startCapture()
+	{
+		s_captureRequested = false;
+		if (!s_threadName)
+		{
+			setThreadName("Main");
+		}
+		drainThreadTraces(true);
+		s_traceEvents.clear();
+		{
+			std::lock_guard<std::mutex> lock(s_threadTraceMutex);
+			for (size_t i = 0; i < s_threadTraces.size(); i++)
+			{
+				s_threadTraces[i]->dropped = 0;
+			}
+		}
+		s_captureStart = s_frameBegin;
+		s_capturing.store(true, std::memory_order_relaxed);
+	}
+
+	// Called at the end of a frame on the frame thread.
+	void captureFrame()
+	{
+		const u64 curTime = TFE_System::getCurrentTimeInTicks();
+		s_traceEvents.push_back({ TRACE_ZONE, "Frame", getThreadTrace()->tid, 0, s_frameBegin, curTime - s_frameBegin });
+		drainThreadTraces(false);
+
+		const size_t counterCount = s_counterList.size();
+		for (size_t i = 0; i < counterCount; i++)
+		{
+			s_traceEvents.push_back({ TRACE_COUNTER, nullptr, (u32)i, *s_counterList[i].ptr, curTime, 0 });
+		}
+
+		s_captureFramesLeft--;
+		if (!s_captureFramesLeft)
+		{
+			s_capturing.store(false, std::memory_order_relaxed);
+			// Pick up any zones that finished after the drain above.
+			drainThreadTraces(false);
+			writeCapture();
+		}
+	}
+
+	void writeJsonString(FileStream* file, const char* str)
+	{
+		char escaped[256];
+		size_t len = 0;
+		for (const char* c = str; *c && len < sizeof(escaped) - 2; c++)
+		{
+			if (*c == '"' || *c == '\\') { escaped[len++] = '\\'; }
+			escaped[len++] = *c;
+		}
+		escaped[len] = 0;
+		file->writeString("\"%s\"", escaped);
+	}
+
+	f64 ticksToMicroseconds(u64 ticks)
+	{
+		return TFE_System::convertFromTicksToSeconds(ticks) * 1000000.0;
+	}
+
+	// Writes the capture as Chrome trace event JSON.
+	void writeCapture()
+	{
+		FileStream file;
+		if (!file.open(s_capturePath.c_str(), Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Profiler", "Cannot write trace capture to '%s'.", s_capturePath.c_str());
+			s_traceEvents.clear();
+			return;
+		}
+
+		file.writeString("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+		u32 dropped = 0;
+		{
+			std::lock_guard<std::mutex> lock(s_threadTraceMutex);
+			const size_t threadCount = s_threadTraces.size();
+			for (size_t i = 0; i < threadCount; i++)
+			{
+				const ThreadTrace* trace = s_threadTraces[i];
+				file.writeString("{\"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"name\": \"thread_name\", \"args\": {\"name\": ", trace->tid);
+				if (trace->name) { writeJsonString(&file, trace->name); }
+				else { file.writeString("\"Thread %u\"", trace->tid); }
+				file.writeString("}},\n");
+				dropped += trace->dropped;
+			}
+		}
+
+		const size_t eventCount = s_traceEvents.size();
+		for (size_t i = 0; i < eventCount; i++)
+		{
+			const TraceEvent& ev = s_traceEvents[i];
+			const f64 ts = ticksToMicroseconds(ev.start - s_captureStart);
+			if (ev.type == TRACE_ZONE)
+			{
+				file.writeString("{\"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %0.3f, \"dur\": %0.3f, \"name\": ", ev.id, ts, ticksToMicroseconds(ev.duration));
+				writeJsonString(&file, ev.name);
+			}
+			else
+			{
+				file.writeString("{\"ph\": \"C\", \"pid\": 1, \"ts\": %0.3f, \"args\": {\"value\": %d}, \"name\": ", ts, ev.value);
+				writeJsonString(&file, s_counterList[ev.id].name);
+			}
+			file.writeString(i + 1 < eventCount ? "},\n" : "}\n");
+		}
+		file.writeString("]}\n");
+		file.close();
+
+		TFE_System::logWrite(LOG_MSG, "Profiler", "Wrote %u trace events to '%s'.", (u32)eventCount, s_capturePath.c_str());
+		if (dropped)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Profiler", "%u zones were dropped because a thread trace buffer was full.", dropped);
+		}
+		s_traceEvents.clear();
+		s_traceEvents.shrink_to_fit();
+	}
+
 	void frameBegin()
 	{
 		std::swap(s_readBuffer, s_writeBuffer);
@@ -185,6 +472,7 @@ namespace TFE_Profiler
 		s_level = 0;
 		s_maxLevel = 0;
 		s_roots.clear();
+		s_frameThread = std::this_thread::get_id();
 
 		// Swap buffers, s_readBuffer is safe to read in the middle of the next frame.
 		const size_t zoneCount = s_zoneList.size();
@@ -202,6 +490,10 @@ namespace TFE_Profiler
 		}
 
 		s_frameBegin = TFE_System::getCurrentTimeInTicks();
+		if (s_captureRequested)
+		{
+			startCapture();
+		}
 	}
 
 	void traverseZoneTree(u32 id)
@@ -266,6 +558,10 @@ namespace TFE_Profiler
 		}
 
 		s_currentFrame++;
+		if (isCapturing())
+		{
+			captureFrame();
+		}
 	}
 
 	u32 getZoneCount()
@@ -3,7 +3,16 @@
 // The Force Engine Profiler
 // Simple "zone" based profiler.
 // Add TFE_PROFILE_ENABLED to preprocessor defines in the build to enable.
-// Currently does not respect the call path, that is TODO.
+//
+// Zone times are accumulated per call path on the thread driving the
+// frame, so the same zone name under different parents is tracked
+// separately.
+//
+// A trace capture records the zones from every thread, plus the
+// counters sampled once per frame, for a number of frames and writes
+// them out as Chrome trace JSON (chrome://tracing or Perfetto). Each
+// thread writes to its own lock-free ring buffer which is drained by
+// the frame thread at the end of each frame.
 //////////////////////////////////////////////////////////////////////
 
 #include "types.h"
@@ -20,6 +29,7 @@
 #define TFE_FRAME_BEGIN() TFE_Profiler::frameBegin()
 #define TFE_FRAME_END() TFE_Profiler::frameEnd()
 #define TFE_COUNTER(varName, name) TFE_Profiler::addCounter(name, &varName)
+#define TFE_THREAD_NAME(name) TFE_Profiler::setThreadName(name)
 #else
 #define TFE_ZONE(name)
 #define TFE_ZONE_BEGIN(varName, name)
@@ -27,6 +37,7 @@
 #define TFE_FRAME_BEGIN()
 #define TFE_FRAME_END()
 #define TFE_COUNTER(varName, name)
+#define TFE_THREAD_NAME(name)
 #endif
 
 #define NULL_ZONE 0xffffffff
@@ -58,9 +69,20 @@ namespace TFE_Profiler
 		
 	void frameBegin();
 	void frameEnd();
+	// Frees the per-thread trace buffers, called at shutdown after the other threads have stopped.
+	void destroy();
 
 	void addCounter(const char* name, s32* counter);
 
+	// Trace capture.
+	// Records the next 'frameCount' frames and writes the trace to 'path' once done.
+	bool beginCapture(u32 frameCount, const char* path);
+	bool isCapturing();
+	// Name shown for the calling thread in traces, 'name' must remain valid (use a literal).
+	void setThreadName(const char* name);
+	// Called when a zone ends on any thread while capturing.
+	void recordZone(const char* name, u64 startTicks, u64 durationTicks);
+
 	// Profile data API, this is used directly.
 	f64  getTimeInFrame();
 
@@ -76,6 +98,7 @@ class TFE_Profiler_Zone
 public:
 	TFE_Profiler_Zone(const char* name, const char* func, u32 lineNumber)
 	{
+		m_name = name;
 		m_time = TFE_System::getCurrentTimeInTicks();
 		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
 	}
@@ -84,8 +107,13 @@ public:
 	{
 		const u64 deltaTime = TFE_System::getCurrentTimeInTicks() - m_time;
 		TFE_Profiler::endZone(m_id, deltaTime);
+		if (TFE_Profiler::isCapturing())
+		{
+			TFE_Profiler::recordZone(m_name, m_time, deltaTime);
+		}
 	}
 private:
+	const char* m_name;
 	u64 m_time;
 	s32 m_id;
 };
@@ -95,6 +123,7 @@ class TFE_Profiler_ZoneManual
 public:
 	TFE_Profiler_ZoneManual(const char* name, const char* func, u32 lineNumber)
 	{
+		m_name = name;
 		m_time = TFE_System::getCurrentTimeInTicks();
 		m_id = TFE_Profiler::beginZone(name, func, lineNumber);
 	}
@@ -103,8 +132,13 @@ public:
 	{
 		const u64 deltaTime = TFE_System::getCurrentTimeInTicks() - m_time;
 		TFE_Profiler::endZone(m_id, deltaTime);
+		if (TFE_Profiler::isCapturing())
+		{
+			TFE_Profiler::recordZone(m_name, m_time, deltaTime);
+		}
 	}
 private:
+	const char* m_name;
 	u64 m_time;
 	s32 m_id;
 };
@@ -0,0 +1,65 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Single Producer / Single Consumer Queue
+// Fixed size lock-free ring buffer for passing small items from one
+// thread to another without either thread waiting on the other.
+//
+// Exactly one thread may call push() and exactly one thread may call
+// pop(). The capacity must be a power of two.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+template <typename T, u32 Capacity>
+class SpscQueue
+{
+public:
+	SpscQueue() : m_head(0), m_tail(0) {}
+
+	// Not thread safe, only call when neither the producer or consumer are running.
+	void clear()
+	{
+		m_head.store(0, std::memory_order_relaxed);
+		m_tail.store(0, std::memory_order_relaxed);
+	}
+
+	// Producer: returns false if the queue is full.
+	bool push(const T& item)
+	{
+		const u32 tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+		m_items[tail & c_mask] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer: returns false if the queue is empty.
+	bool pop(T* item)
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		*item = m_items[head & c_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Approximate when called while the other thread is active.
+	u32 getCount() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+	static const u32 c_mask = Capacity - 1;
+
+	T m_items[Capacity];
+	// Keep the consumer and producer indices on separate cache lines.
+	alignas(64) atomic_u32 m_head;
+	alignas(64) atomic_u32 m_tail;
+};
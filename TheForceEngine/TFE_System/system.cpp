@@ -38,6 +38,7 @@ namespace TFE_System
 	static const f64 c_maxDt = 0.05;	// 20 fps
 
 	static bool s_synced = false;
+	static bool s_manualTime = false;
 	static bool s_resetStartTime = false;
 	static bool s_quitMessagePosted = false;
 	static bool s_systemUiRequestPosted = false;
@@ -104,6 +105,8 @@ namespace TFE_System
 
 	void update()
 	{
+		if (s_manualTime) { return; }
+
 		// This assumes that SDL_GetPerformanceCounter() is monotonic.
 		// However if errors do occur, the dt clamp later should limit the side effects.
 		const u64 curTime = SDL_GetPerformanceCounter();
@@ -174,6 +177,31 @@ namespace TFE_System
 		return f64(uDt) * s_freq;
 	}
 	
+	void setManualTime(bool enable)
+	{
+		if (s_manualTime && !enable)
+		{
+			// Continue from the manual time so that getTime() does not jump.
+			const u64 curTime = SDL_GetPerformanceCounter();
+			s_startTime += curTime - s_time;
+			s_time = curTime;
+		}
+		s_manualTime = enable;
+	}
+
+	bool isManualTime()
+	{
+		return s_manualTime;
+	}
+
+	void stepTime(f64 dt)
+	{
+		if (!s_manualTime) { return; }
+		s_dt = dt;
+		s_dtRaw = dt;
+		s_time += u64(dt / s_freq + 0.5);
+	}
+
 	u64 getCurrentTimeInTicks()
 	{
 		return SDL_GetPerformanceCounter() - s_startTime;
@@ -48,6 +48,12 @@ namespace TFE_System
 	// Get the absolute time since the last start time, in seconds.
 	f64 getTime();
 
+	// Manual time, used for deterministic playback. While enabled update() ignores the system timer
+	// and the frame time only advances through stepTime(). getCurrentTimeInTicks() is not affected.
+	void setManualTime(bool enable);
+	bool isManualTime();
+	void stepTime(f64 dt);
+
 	u64 getCurrentTimeInTicks();
 	f64 convertFromTicksToSeconds(u64 ticks);
 	f64 microsecondsToSeconds(f64 mu);
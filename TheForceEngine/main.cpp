@@ -7,6 +7,9 @@
 #include <TFE_Archive/gobArchive.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Game/saveSystem.h>
+#include <TFE_Game/rewind.h>
+#include <TFE_Game/demo.h>
+#include <TFE_Game/fastForward.h>
 #include <TFE_Game/reticle.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_FileSystem/fileutil.h>
@@ -19,8 +22,11 @@
 #include <TFE_System/system.h>
 #include <TFE_System/CrashHandler/crashHandler.h>
 #include <TFE_System/frameLimiter.h>
+#include <TFE_System/jobSystem.h>
 #include <TFE_System/tfeMessage.h>
 #include <TFE_Jedi/Task/task.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
+#include <TFE_Jedi/Renderer/virtualFramebuffer.h>
 #include <TFE_RenderShared/texturePacker.h>
 #include <TFE_Asset/paletteAsset.h>
 #include <TFE_Asset/imageAsset.h>
@@ -28,6 +34,8 @@
 #include <TFE_FrontEndUI/frontEndUi.h>
 #include <TFE_FrontEndUI/modLoader.h>
 #include <TFE_A11y/accessibility.h>
+#include <TFE_DarkForces/benchmark.h>
+#include <TFE_DarkForces/hdTextureConvert.h>
 #include <algorithm>
 #include <cinttypes>
 #include <time.h>
@@ -79,6 +87,18 @@ static char s_screenshotTime[TFE_MAX_PATH];
 static s32  s_startupGame = -1;
 static IGame* s_curGame = nullptr;
 static const char* s_loadRequestFilename = nullptr;
+// Headless benchmark, see runBenchmark().
+static const char* s_benchmarkLevel  = nullptr;
+static const char* s_benchmarkOutput = nullptr;
+static s32 s_benchmarkFrames = 1000;
+static s32 s_benchmarkWidth  = 0;
+static s32 s_benchmarkHeight = 0;
+static bool s_benchmarkScaling = false;
+// Headless demo playback, see runDemo().
+static const char* s_demoPath = nullptr;
+// HD texture pack conversion, see runHdTextureConvert().
+static const char* s_convertHdSrc = nullptr;
+static const char* s_convertHdDst = nullptr;
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName);
 bool validatePath();
@@ -272,6 +292,25 @@ bool sdlInit()
 static AppState s_curState = APP_STATE_UNINIT;
 static bool s_soundPaused = false;
 
+// A save game, rewind snapshot or demo is loaded by recreating the game, see APP_STATE_LOAD.
+bool hasLoadRequest()
+{
+	return s_loadRequestFilename || TFE_Rewind::hasRestoreRequest() || TFE_Demo::hasPlaybackRequest();
+}
+
+bool loadRequestedState()
+{
+	if (s_loadRequestFilename)
+	{
+		return TFE_SaveSystem::loadGame(s_loadRequestFilename);
+	}
+	else if (TFE_Rewind::hasRestoreRequest())
+	{
+		return TFE_Rewind::restoreRequest();
+	}
+	return TFE_Demo::startPlayback();
+}
+
 void setAppState(AppState newState, int argc, char* argv[])
 {
 	const TFE_Settings_Graphics* config = TFE_Settings::getGraphicsSettings();
@@ -304,7 +343,13 @@ void setAppState(AppState newState, int argc, char* argv[])
 	case APP_STATE_LOAD:
 	{
 		bool pathIsValid = validatePath();
-		if (pathIsValid && s_loadRequestFilename)
+		// Decode the rewind snapshot before the running game is freed, so a bad snapshot does not lose the session.
+		if (pathIsValid && s_curGame && TFE_Rewind::hasRestoreRequest() && !TFE_Rewind::prepareRestore())
+		{
+			TFE_System::logWrite(LOG_ERROR, "AppMain", "Cannot restore the rewind snapshot, the current game continues.");
+			newState = s_curState;
+		}
+		else if (pathIsValid && hasLoadRequest())
 		{
 			newState = APP_STATE_GAME;
 			TFE_FrontEndUI::setAppState(APP_STATE_GAME);
@@ -318,12 +363,14 @@ void setAppState(AppState newState, int argc, char* argv[])
 			s_soundPaused = false;
 			s_curGame = createGame(gameInfo->id);
 			TFE_SaveSystem::setCurrentGame(s_curGame);
+			TFE_Rewind::setCurrentGame(s_curGame);
+			TFE_Demo::setCurrentGame(s_curGame);
 			if (!s_curGame)
 			{
 				TFE_System::logWrite(LOG_ERROR, "AppMain", "Cannot create game '%s'.", gameInfo->game);
 				newState = APP_STATE_CANNOT_RUN;
 			}
-			else if (!TFE_SaveSystem::loadGame(s_loadRequestFilename))
+			else if (!loadRequestedState())
 			{
 				TFE_System::logWrite(LOG_ERROR, "AppMain", "Cannot run game '%s'.", gameInfo->game);
 				freeGame(s_curGame);
@@ -359,6 +406,8 @@ void setAppState(AppState newState, int argc, char* argv[])
 				}
 				s_curGame = createGame(gameInfo->id);
 				TFE_SaveSystem::setCurrentGame(s_curGame);
+				TFE_Rewind::setCurrentGame(s_curGame);
+				TFE_Demo::setCurrentGame(s_curGame);
 				if (!s_curGame)
 				{
 					TFE_System::logWrite(LOG_ERROR, "AppMain", "Cannot create game '%s'.", gameInfo->game);
@@ -494,6 +543,191 @@ bool validatePath()
 	return TFE_Paths::hasPath(PATH_SOURCE_DATA);
 }
 
+// Renders a level with the software renderer without a window, GPU or audio device and writes a JSON report.
+// --benchmark <level> [--frames N] [--benchmark_res <width> <height>] [--benchmark_out <file.json>] [--benchmark_scaling]
+int runBenchmark()
+{
+	TFE_System::logWrite(LOG_MSG, "Main", "Running headless benchmark.");
+	if (!validatePath())
+	{
+		TFE_System::logClose();
+		return PROGRAM_ERROR;
+	}
+
+	// Only the timer is required, no video subsystem is created.
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		TFE_System::logWrite(LOG_CRITICAL, "SDL", "Cannot initialize SDL.");
+		TFE_System::logClose();
+		return PROGRAM_ERROR;
+	}
+	TFE_System::init(0.0f, false, c_gitVersion);
+	TFE_Jobs::init();
+	TFE_Audio::init(s_nullAudioDevice);
+	game_init();
+
+	char outputPath[TFE_MAX_PATH];
+	if (s_benchmarkOutput)
+	{
+		strcpy(outputPath, s_benchmarkOutput);
+	}
+	else
+	{
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "benchmark.json", outputPath);
+	}
+
+	TFE_DarkForces::BenchmarkParams params =
+	{
+		s_benchmarkLevel,
+		s_benchmarkFrames,
+		s_benchmarkWidth,
+		s_benchmarkHeight,
+		outputPath,
+		s_benchmarkScaling,
+	};
+	const bool result = TFE_DarkForces::benchmark_run(&params);
+
+	game_destroy();
+	TFE_Audio::shutdown();
+	TFE_Jobs::destroy();
+	TFE_Profiler::destroy();
+	SDL_Quit();
+
+	TFE_System::logClose();
+	TFE_System::freeMessages();
+	return result ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+}
+
+// Converts the .raw HD textures in a directory to packed .hdt files, without a window.
+// --convert_hd <srcDir> [dstDir]
+int runHdTextureConvert()
+{
+	TFE_System::logWrite(LOG_MSG, "Main", "Converting HD textures from '%s'.", s_convertHdSrc);
+	if (!validatePath())
+	{
+		TFE_System::logClose();
+		return PROGRAM_ERROR;
+	}
+
+	TFE_Jobs::init();
+	const bool result = TFE_DarkForces::hdTexture_convertDirectory(s_convertHdSrc, s_convertHdDst ? s_convertHdDst : s_convertHdSrc);
+	TFE_Jobs::destroy();
+	TFE_Profiler::destroy();
+
+	TFE_System::logClose();
+	TFE_System::freeMessages();
+	return result ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+}
+
+// Plays back a demo as fast as possible without a window, GPU or audio device and logs the timing.
+// --demo <file>
+int runDemo()
+{
+	TFE_System::logWrite(LOG_MSG, "Main", "Running headless demo playback.");
+	if (!validatePath())
+	{
+		TFE_System::logClose();
+		return PROGRAM_ERROR;
+	}
+
+	// Only the timer is required, no video subsystem is created.
+	if (SDL_Init(SDL_INIT_TIMER) != 0)
+	{
+		TFE_System::logWrite(LOG_CRITICAL, "SDL", "Cannot initialize SDL.");
+		TFE_System::logClose();
+		return PROGRAM_ERROR;
+	}
+	TFE_System::init(0.0f, false, c_gitVersion);
+	TFE_Jobs::init();
+	TFE_Audio::init(s_nullAudioDevice);
+	game_init();
+	inputMapping_startup();
+	TFE_Demo::init();
+	// Headless playback is used to verify demos, so the stored state hashes are always checked.
+	TFE_Demo::enableStateCheck(true);
+
+	// Render with the software renderer at the original resolution into an offscreen framebuffer.
+	// The settings are not saved in this mode.
+	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+	graphics->rendererIndex = RENDERER_SOFTWARE;
+	graphics->colorMode = COLORMODE_8BIT;
+	graphics->gameResolution = { 320, 200 };
+	graphics->widescreen = false;
+	TFE_Jedi::vfb_setHeadless(JTRUE);
+
+	bool result = false;
+	TFE_Demo::DemoInfo info;
+	if (TFE_Demo::postPlaybackRequest(s_demoPath) && TFE_Demo::getInfo(&info))
+	{
+		s_curGame = createGame(info.gameId);
+		TFE_Demo::setCurrentGame(s_curGame);
+		if (s_curGame && TFE_Demo::startPlayback())
+		{
+			const u64 startTime = TFE_System::getCurrentTimeInTicks();
+			u32 frameCount = 0;
+			bool consoleOpen = false;
+			while (true)
+			{
+				TFE_FRAME_BEGIN();
+				TFE_Demo::beginFrame();
+				if (TFE_Demo::getState() != TFE_Demo::DEMO_PLAYING) { break; }
+				frameCount++;
+				inputMapping_updateInput();
+
+				// The console pauses the game, follow the console key the same way as the game loop.
+				if (TFE_Jedi::task_canRun())
+				{
+					if (consoleOpen && TFE_Input::keyPressed(KEY_ESCAPE))
+					{
+						consoleOpen = false;
+						TFE_Input::clearKeyPressed(KEY_ESCAPE);
+						inputMapping_clearKeyBinding(KEY_ESCAPE);
+						s_curGame->pauseGame(false);
+					}
+					else if (inputMapping_getActionState(IAS_CONSOLE) == STATE_PRESSED)
+					{
+						consoleOpen = !consoleOpen;
+						s_curGame->pauseGame(consoleOpen);
+					}
+				}
+
+				s_curGame->loopGame();
+				const bool tasksRan = TFE_Jedi::task_run() != 0;
+				TFE_Demo::endFrame(tasksRan);
+				if (tasksRan)
+				{
+					TFE_Input::endFrame();
+					inputMapping_endFrame();
+					TFE_FRAME_END();
+				}
+			}
+
+			const f64 wallTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTime);
+			TFE_System::logWrite(LOG_MSG, "Demo", "Played %u of %u frames, %.2f seconds of game time in %.2f seconds (%.1fx real time).",
+				frameCount, info.frameCount, info.duration, wallTime, wallTime > 0.0 ? info.duration / wallTime : 0.0);
+			result = frameCount == info.frameCount && !TFE_Demo::hasDiverged();
+		}
+		if (s_curGame)
+		{
+			freeGame(s_curGame);
+			s_curGame = nullptr;
+		}
+	}
+
+	TFE_Demo::destroy();
+	TFE_Jedi::vfb_setHeadless(JFALSE);
+	inputMapping_shutdown();
+	game_destroy();
+	TFE_Audio::shutdown();
+	TFE_Jobs::destroy();
+	TFE_Profiler::destroy();
+	SDL_Quit();
+
+	TFE_System::logClose();
+	TFE_System::freeMessages();
+	return result ? PROGRAM_SUCCESS : PROGRAM_ERROR;
+}
+
 int main(int argc, char* argv[])
 {
 	#if INSTALL_CRASH_HANDLER
@@ -537,6 +771,7 @@ int main(int argc, char* argv[])
 
 	// Override settings with command line options.
 	parseCommandLine(argc, argv);
+	Archive::setMemoryMapping(TFE_Settings::getSystemSettings()->memoryMapArchives);
 
 	// Setup game paths.
 	// Get the current game.
@@ -570,6 +805,19 @@ int main(int argc, char* argv[])
 	}
 	generateScreenshotTime();
 
+	if (s_benchmarkLevel)
+	{
+		return runBenchmark();
+	}
+	if (s_convertHdSrc)
+	{
+		return runHdTextureConvert();
+	}
+	if (s_demoPath)
+	{
+		return runDemo();
+	}
+
 	// Initialize SDL
 	if (!sdlInit())
 	{
@@ -580,6 +828,7 @@ int main(int argc, char* argv[])
 	TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
 	TFE_System::init(s_refreshRate, graphics->vsync, c_gitVersion);
+	TFE_Jobs::init();
 	
 	// Setup the GPU Device and Window.
 	u32 windowFlags = 0;
@@ -618,6 +867,9 @@ int main(int argc, char* argv[])
 	game_init();
 	inputMapping_startup();
 	TFE_SaveSystem::init();
+	TFE_Rewind::init();
+	TFE_Demo::init();
+	TFE_FastForward::init();
 	TFE_A11Y::init();
 
 	// Uncomment to test memory region allocator.
@@ -692,6 +944,7 @@ int main(int argc, char* argv[])
 		SDL_GetMouseState(&mouseAbsX, &mouseAbsY);
 		TFE_Input::setRelativeMousePos(mouseX, mouseY);
 		TFE_Input::setMousePos(mouseAbsX, mouseAbsY);
+		TFE_Demo::beginFrame();
 		inputMapping_updateInput();
 
 		// Can we save?
@@ -700,7 +953,7 @@ int main(int argc, char* argv[])
 		// Update the System UI.
 		AppState appState = TFE_FrontEndUI::update();
 		s_loadRequestFilename = TFE_SaveSystem::loadRequestFilename();
-		if (s_loadRequestFilename)
+		if (hasLoadRequest())
 		{
 			appState = APP_STATE_LOAD;
 		}
@@ -718,6 +971,8 @@ int main(int argc, char* argv[])
 					freeGame(s_curGame);
 					s_curGame = nullptr;
 				}
+				TFE_Demo::setCurrentGame(nullptr);
+				TFE_FastForward::enable(false, 0);
 				s_soundPaused = false;
 				appState = APP_STATE_MENU;
 			}
@@ -742,6 +997,7 @@ int main(int argc, char* argv[])
 		if (TFE_A11Y::hasPendingFont()) { TFE_A11Y::loadPendingFont(); } // Can't load new fonts between TFE_Ui::begin() and TFE_Ui::render();
 		TFE_Ui::begin();
 		TFE_System::update();
+		TFE_Audio::update();
 
 		// Update
 		if (TFE_FrontEndUI::uiControlsEnabled() && task_canRun())
@@ -877,8 +1133,31 @@ int main(int argc, char* argv[])
 			else
 			{
 				TFE_SaveSystem::update();
-				s_curGame->loopGame();
-				endInputFrame = TFE_Jedi::task_run() != 0;
+
+				// Fast-forward runs several simulation steps per displayed frame, otherwise this loop runs once.
+				TFE_FastForward::beginFrame(!isConsoleOpen && !s_curGame->isPaused());
+				for (s32 step = 0; ; step++)
+				{
+					if (step > 0)
+					{
+						TFE_Demo::beginFrame();
+						inputMapping_updateInput();
+					}
+					TFE_FastForward::beginStep(step);
+					TFE_Rewind::update();
+					s_curGame->loopGame();
+					endInputFrame = TFE_Jedi::task_run() != 0;
+					TFE_Demo::endFrame(endInputFrame);
+					if (!TFE_FastForward::endStep(step, endInputFrame && !s_curGame->isPaused()))
+					{
+						break;
+					}
+
+					// Clear transitory input state between steps.
+					TFE_Input::endFrame();
+					inputMapping_endFrame();
+				}
+				TFE_FastForward::endFrame(s_curGame->getTick());
 			}
 		}
 		else
@@ -948,6 +1227,11 @@ int main(int argc, char* argv[])
 	TFE_Jedi::texturepacker_freeGlobal();
 	TFE_RenderBackend::destroy();
 	TFE_SaveSystem::destroy();
+	TFE_Rewind::destroy();
+	TFE_FastForward::destroy();
+	TFE_Demo::destroy();
+	TFE_Jobs::destroy();
+	TFE_Profiler::destroy();
 	SDL_Quit();
 
 	#ifdef ENABLE_FORCE_SCRIPT
@@ -1013,5 +1297,44 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 		{
 			TFE_Settings::getTempSettings()->skipLoadDelay = true;
 		}
+		else if (strcasecmp(name, "benchmark") == 0 && values.size() >= 1)
+		{
+			// --benchmark SECBASE
+			s_benchmarkLevel = values[0];
+			s_nullAudioDevice = true;
+		}
+		else if (strcasecmp(name, "frames") == 0 && values.size() >= 1)
+		{
+			// --frames 1000
+			s_benchmarkFrames = max(1, atoi(values[0]));
+		}
+		else if (strcasecmp(name, "benchmark_res") == 0 && values.size() >= 2)
+		{
+			// --benchmark_res 640 400
+			s_benchmarkWidth  = atoi(values[0]);
+			s_benchmarkHeight = atoi(values[1]);
+		}
+		else if (strcasecmp(name, "benchmark_out") == 0 && values.size() >= 1)
+		{
+			// --benchmark_out results.json
+			s_benchmarkOutput = values[0];
+		}
+		else if (strcasecmp(name, "benchmark_scaling") == 0)
+		{
+			// --benchmark_scaling
+			s_benchmarkScaling = true;
+		}
+		else if (strcasecmp(name, "demo") == 0 && values.size() >= 1)
+		{
+			// --demo Demos/e1m1.tfd
+			s_demoPath = values[0];
+			s_nullAudioDevice = true;
+		}
+		else if (strcasecmp(name, "convert_hd") == 0 && values.size() >= 1)
+		{
+			// --convert_hd Mods/HdTextures [Mods/HdTexturesPacked]
+			s_convertHdSrc = values[0];
+			s_convertHdDst = values.size() >= 2 ? values[1] : nullptr;
+		}
 	}
 }
\ No newline at end of file